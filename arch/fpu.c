@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "fpu.h"
+
+#include "buddy.h"
+#include "offsets.h"
+#include "processor.h"
+#include "registers.h"
+#include "sched.h"
+#include "slab.h"
+#include "smp.h"
+#include "stddef.h"
+
+#ifdef CONFIG_FPU
+
+// _fpu_save and _fpu_restore use the offsets of the context
+_Static_assert(sizeof(fpu_context_t) == FPU_CONTEXT_LENGTH,
+               "fpu context layout");
+_Static_assert(offsetof(fpu_context_t, fcsr) == FPU_CONTEXT_FCSR,
+               "fpu context layout");
+_Static_assert(offsetof(vector_context_t, regs) == VECTOR_CONTEXT_REGS,
+               "vector context layout");
+
+/*******************************************************************************
+ * major opcodes and csrs of the floating point and vector instructions
+ ******************************************************************************/
+#define FPU_OPCODE_MASK     0x7F
+#define FPU_OPCODE_LOAD_FP  0x07
+#define FPU_OPCODE_STORE_FP 0x27
+#define FPU_OPCODE_FMADD    0x43
+#define FPU_OPCODE_FMSUB    0x47
+#define FPU_OPCODE_FNMSUB   0x4B
+#define FPU_OPCODE_FNMADD   0x4F
+#define FPU_OPCODE_OP_FP    0x53
+#define FPU_OPCODE_OP_V     0x57
+#define FPU_OPCODE_SYSTEM   0x73
+
+#define FPU_CSR_FFLAGS 0x001
+#define FPU_CSR_FCSR   0x003
+#define FPU_CSR_VSTART 0x008
+#define FPU_CSR_VCSR   0x00F
+#define FPU_CSR_VL     0xC20
+#define FPU_CSR_VLENB  0xC22
+
+// without the vector context the vector unit is left as the boot set it, it
+// may be owned by the kernel
+#ifdef CONFIG_VECTOR
+#define FPU_STATE_MASK (MSTATUS_FS_MASK | MSTATUS_VS_MASK)
+#else
+#define FPU_STATE_MASK MSTATUS_FS_MASK
+#endif
+
+/*******************************************************************************
+ * @enum fpu_unit_t
+ * @brief unit of an instruction
+ ******************************************************************************/
+typedef enum fpu_unit_t {
+  FPU_UNIT_NONE,
+  FPU_UNIT_FPU,
+  FPU_UNIT_VECTOR,
+} fpu_unit_t;
+
+/*******************************************************************************
+ * @struct fpu_hart_t
+ * @brief tasks whose context was last loaded in the units of a hart
+ ******************************************************************************/
+typedef struct fpu_hart_t {
+  task_t *fpu;
+  task_t *vector;
+} __attribute__((aligned(CACHE_LINE_SIZE))) fpu_hart_t;
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+extern void _fpu_save(fpu_context_t *);
+extern void _fpu_restore(fpu_context_t *);
+
+#ifdef CONFIG_VECTOR
+extern void _vector_save(vector_context_t *);
+extern void _vector_restore(vector_context_t *);
+#endif
+
+static fpu_hart_t fpu_harts[CONFIG_HART_MAX_NB];
+
+// contexts of the tasks which have used the floating point unit
+static slab_cache_t fpu_cache;
+
+// the vector registers are only known at boot, a null size when the harts
+// don't have the vector unit
+static uint64_t vector_size  = 0;
+static uint8_t  vector_order = 0;
+
+/******************************************************************************
+ * @brief get the unit of an instruction
+ *
+ * The floating point loads and stores encode their width as the vector ones,
+ * the compressed instructions are the loads and stores of the d registers.
+ *
+ * @param address of the instruction
+ * @return unit of the instruction, FPU_UNIT_NONE for the other instructions
+ ******************************************************************************/
+static fpu_unit_t fpu_decode(uint64_t epc) {
+  // instructions are only aligned on 16 bits
+  uint32_t insn = *(uint16_t *)epc;
+  uint32_t funct3;
+  uint32_t csr;
+
+  if ((insn & 0x3) != 0x3) {
+    funct3 = insn >> 13;
+    if ((insn & 0x3) != 0x1 && (funct3 == 0x1 || funct3 == 0x5)) {
+      return FPU_UNIT_FPU;
+    }
+    return FPU_UNIT_NONE;
+  }
+
+  insn  |= (uint32_t)(*(uint16_t *)(epc + 2)) << 16;
+  funct3 = (insn >> 12) & 0x7;
+  csr    = insn >> 20;
+
+  switch (insn & FPU_OPCODE_MASK) {
+  case FPU_OPCODE_LOAD_FP:
+  case FPU_OPCODE_STORE_FP:
+    return (funct3 >= 0x1 && funct3 <= 0x4) ? FPU_UNIT_FPU : FPU_UNIT_VECTOR;
+  case FPU_OPCODE_FMADD:
+  case FPU_OPCODE_FMSUB:
+  case FPU_OPCODE_FNMSUB:
+  case FPU_OPCODE_FNMADD:
+  case FPU_OPCODE_OP_FP:
+    return FPU_UNIT_FPU;
+  case FPU_OPCODE_OP_V:
+    return FPU_UNIT_VECTOR;
+  case FPU_OPCODE_SYSTEM:
+    if (funct3 == 0 || funct3 == 0x4) {
+      return FPU_UNIT_NONE;
+    }
+    if (csr >= FPU_CSR_FFLAGS && csr <= FPU_CSR_FCSR) {
+      return FPU_UNIT_FPU;
+    }
+    if ((csr >= FPU_CSR_VSTART && csr <= FPU_CSR_VCSR) ||
+        (csr >= FPU_CSR_VL && csr <= FPU_CSR_VLENB)) {
+      return FPU_UNIT_VECTOR;
+    }
+    return FPU_UNIT_NONE;
+  default:
+    return FPU_UNIT_NONE;
+  }
+}
+
+/******************************************************************************
+ * @brief set the state of the units in mstatus
+ * @param MSTATUS_FS_* and MSTATUS_VS_* states
+ * @return none
+ ******************************************************************************/
+static inline void fpu_set_state(uint64_t state) {
+  csr_clear(CSR_MSTATUS, FPU_STATE_MASK);
+  csr_set(CSR_MSTATUS, state);
+}
+
+/******************************************************************************
+ * @brief load the floating point context of a task, the first one is null
+ * @param hart running the task
+ * @param task to load
+ * @return K_OK, or K_ERROR if there is no memory left for the context
+ ******************************************************************************/
+static k_return_t fpu_load(uint64_t hart, task_t *task) {
+  uint64_t *word;
+
+  if (task->fpu == NULL) {
+    task->fpu = slab_alloc(&fpu_cache);
+    if (task->fpu == NULL) {
+      return K_ERROR;
+    }
+
+    for (word = (uint64_t *)task->fpu; word < (uint64_t *)(task->fpu + 1);
+         word++) {
+      *word = 0;
+    }
+  }
+
+  // the restore makes the unit dirty, its registers now match the context
+  csr_set(CSR_MSTATUS, MSTATUS_FS_CLEAN);
+  _fpu_restore(task->fpu);
+  csr_clear(CSR_MSTATUS, MSTATUS_FS_MASK);
+  csr_set(CSR_MSTATUS, MSTATUS_FS_CLEAN);
+
+  fpu_harts[hart].fpu = task;
+  task->fpu_hart      = hart;
+
+  return K_OK;
+}
+
+#ifdef CONFIG_VECTOR
+/******************************************************************************
+ * @brief load the vector context of a task, the first one is null
+ * @param hart running the task
+ * @param task to load
+ * @return K_OK, or K_ERROR if there is no memory left for the context
+ ******************************************************************************/
+static k_return_t vector_load(uint64_t hart, task_t *task) {
+  uint64_t *word;
+
+  if (task->vector == NULL) {
+    task->vector = buddy_alloc(vector_order);
+    if (task->vector == NULL) {
+      return K_ERROR;
+    }
+
+    for (word = (uint64_t *)task->vector;
+         word < (uint64_t *)((uint8_t *)task->vector + vector_size); word++) {
+      *word = 0;
+    }
+  }
+
+  csr_set(CSR_MSTATUS, MSTATUS_VS_CLEAN);
+  _vector_restore(task->vector);
+  csr_clear(CSR_MSTATUS, MSTATUS_VS_MASK);
+  csr_set(CSR_MSTATUS, MSTATUS_VS_CLEAN);
+
+  fpu_harts[hart].vector = task;
+  task->vector_hart      = hart;
+
+  return K_OK;
+}
+#endif
+
+/******************************************************************************
+ * @brief get the size of the vector registers and set up the context caches
+ *
+ * vlenb can only be read while the vector unit is on, the units are switched
+ * off again for the first task.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void fpu_init() {
+  slab_cache_init(&fpu_cache, "fpu", sizeof(fpu_context_t), NULL);
+
+#ifdef CONFIG_VECTOR
+  if (csr_read(misa) & MISA_V) {
+    csr_set(CSR_MSTATUS, MSTATUS_VS_INITIAL);
+    // vlenb by number, the kernel is not built with the vector extension
+    vector_size = sizeof(vector_context_t) + 32 * csr_read(FPU_CSR_VLENB);
+    csr_clear(CSR_MSTATUS, MSTATUS_VS_MASK);
+
+    vector_order = buddy_order(vector_size);
+  }
+#endif
+}
+
+/******************************************************************************
+ * @brief save the units used by the previous task and switch them off unless
+ * they still hold the context of the next task
+ *
+ * A unit is only on while the task whose context it holds runs. A dirty unit
+ * is saved when its task leaves the hart, so the task can resume on any hart,
+ * a clean one is just switched off: a task which has not used a unit since it
+ * was switched in costs nothing.
+ *
+ * @param hart running the tasks
+ * @param previous task
+ * @param next task
+ * @return none
+ ******************************************************************************/
+void fpu_switch(uint64_t hart, task_t *prev, task_t *next) {
+  fpu_hart_t *owner  = &fpu_harts[hart];
+  uint64_t    status = csr_read(CSR_MSTATUS);
+  uint64_t    state  = MSTATUS_FS_OFF | MSTATUS_VS_OFF;
+
+  if ((status & MSTATUS_FS_MASK) == MSTATUS_FS_DIRTY) {
+    _fpu_save(prev->fpu);
+  }
+
+#ifdef CONFIG_VECTOR
+  if ((status & MSTATUS_VS_MASK) == MSTATUS_VS_DIRTY) {
+    _vector_save(prev->vector);
+  }
+#endif
+
+  // no other task has used the unit since the next task left the hart
+  if (owner->fpu == next && next->fpu_hart == hart) {
+    state |= MSTATUS_FS_CLEAN;
+  }
+
+  if (owner->vector == next && next->vector_hart == hart) {
+    state |= MSTATUS_VS_CLEAN;
+  }
+
+  fpu_set_state(state);
+}
+
+/******************************************************************************
+ * @brief load the context of the current task in a unit on its first
+ * instruction since it was switched in
+ * @param address of the instruction which trapped
+ * @return K_OK, or K_ERROR if the instruction doesn't belong to a unit which
+ * is off or the context can't be allocated
+ ******************************************************************************/
+k_return_t fpu_trap(uint64_t epc) {
+  task_t    *task   = sched_get_current_task();
+  uint64_t   status = csr_read(CSR_MSTATUS);
+  uint64_t   hart   = hart_id_get();
+  k_return_t ret    = K_ERROR;
+  uint64_t   flags;
+
+  // the kernel doesn't use the units before the first task runs
+  if (task == NULL) {
+    return K_ERROR;
+  }
+
+  flags = smp_lock();
+
+  switch (fpu_decode(epc)) {
+  case FPU_UNIT_FPU:
+    if ((status & MSTATUS_FS_MASK) == MSTATUS_FS_OFF) {
+      ret = fpu_load(hart, task);
+    }
+    break;
+#ifdef CONFIG_VECTOR
+  case FPU_UNIT_VECTOR:
+    if (vector_size && (status & MSTATUS_VS_MASK) == MSTATUS_VS_OFF) {
+      ret = vector_load(hart, task);
+    }
+    break;
+#endif
+  default:
+    break;
+  }
+
+  smp_unlock(flags);
+
+  return ret;
+}
+
+/******************************************************************************
+ * @brief give back the contexts of a task
+ *
+ * The caller must hold the kernel lock. The harts forget the task, its control
+ * block may be used by a new task.
+ *
+ * @param task released
+ * @return none
+ ******************************************************************************/
+void fpu_release(task_t *task) {
+  if (task->fpu_hart != FPU_NO_HART &&
+      fpu_harts[task->fpu_hart].fpu == task) {
+    fpu_harts[task->fpu_hart].fpu = NULL;
+  }
+
+  if (task->vector_hart != FPU_NO_HART &&
+      fpu_harts[task->vector_hart].vector == task) {
+    fpu_harts[task->vector_hart].vector = NULL;
+  }
+
+  if (task->fpu != NULL) {
+    slab_free(&fpu_cache, task->fpu);
+    task->fpu = NULL;
+  }
+
+  if (task->vector != NULL) {
+    buddy_free(task->vector, vector_order);
+    task->vector = NULL;
+  }
+
+  task->fpu_hart    = FPU_NO_HART;
+  task->vector_hart = FPU_NO_HART;
+}
+
+#endif
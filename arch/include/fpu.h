@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef FPU_H
+#define FPU_H
+
+#include "common.h"
+#include "task.h"
+
+/******************************************************************************
+ * hart of a task whose context is not loaded in any register file
+ ******************************************************************************/
+#define FPU_NO_HART 0xFF
+
+/******************************************************************************
+ * @struct fpu_context_t
+ * @brief floating point registers of a task, saved by _fpu_save()
+ ******************************************************************************/
+typedef struct fpu_context_t {
+  uint64_t f[32];
+  uint64_t fcsr;
+} fpu_context_t;
+
+/******************************************************************************
+ * @struct vector_context_t
+ * @brief vector registers of a task, saved by _vector_save()
+ *
+ * The 32 registers follow the control registers, their size is only known at
+ * boot from vlenb.
+ ******************************************************************************/
+typedef struct vector_context_t {
+  uint64_t vstart;
+  uint64_t vl;
+  uint64_t vtype;
+  uint64_t vcsr;
+  uint8_t  regs[];
+} vector_context_t;
+
+/******************************************************************************
+ * @brief get the size of the vector registers and set up the context caches
+ * @param none
+ * @return none
+ ******************************************************************************/
+void fpu_init();
+
+/******************************************************************************
+ * @brief save the units used by the previous task and switch them off unless
+ * they still hold the context of the next task
+ *
+ * The caller must hold the kernel lock, the previous task is the current task
+ * of the hart.
+ *
+ * @param hart running the tasks
+ * @param previous task
+ * @param next task
+ * @return none
+ ******************************************************************************/
+void fpu_switch(uint64_t, task_t *, task_t *);
+
+/******************************************************************************
+ * @brief load the context of the current task in a unit on its first
+ * instruction since it was switched in
+ * @param address of the instruction which trapped
+ * @return K_OK, or K_ERROR if the instruction doesn't belong to a unit which
+ * is off or the context can't be allocated
+ ******************************************************************************/
+k_return_t fpu_trap(uint64_t);
+
+/******************************************************************************
+ * @brief give back the contexts of a task
+ * @param task released
+ * @return none
+ ******************************************************************************/
+void fpu_release(task_t *);
+
+#endif
@@ -17,6 +17,12 @@
 #ifndef IRQ_ARCH_H
 #define IRQ_ARCH_H
 
+#include "common.h"
+#include "interrupt.h"
+#include "registers.h"
+
+struct task_t;
+
 #define RISCV_INTERRUPT_SUPERVISOR_SOFTWARE 1
 #define RISCV_INTERRUPT_MACHINE_SOFTWARE    MIE_SIE_OFFSET
 #define RISCV_INTERRUPT_SUPERVISOR_TIMER    5
@@ -24,8 +30,193 @@
 #define RISCV_INTERRUPT_SUPERVISOR_EXTERNAL 9
 #define RISCV_INTERRUPT_MACHINE_EXTERNAL    MIE_EIE_OFFSET
 
+/******************************************************************************
+ * interrupt levels: a handler only lets the interrupts of a higher level nest
+ * in it. External sources have the levels of the controller, the processor
+ * local interrupts a level set in the configuration. IRQ_LEVEL_MAX is above
+ * all sources.
+ ******************************************************************************/
+#define IRQ_LEVEL_MAX 8
+
+#ifndef CONFIG_IRQ_SOFTWARE_LEVEL
+#define CONFIG_IRQ_SOFTWARE_LEVEL IRQ_LEVEL_MAX
+#endif
+
+#ifndef CONFIG_IRQ_TIMER_LEVEL
+#define CONFIG_IRQ_TIMER_LEVEL IRQ_LEVEL_MAX
+#endif
+
+/******************************************************************************
+ * hart taking the interrupts: the plic context 0, the msip and the mtimecmp
+ * of the kernel timers are the ones of hart 0
+ ******************************************************************************/
+#define IRQ_ARCH_HART 0
+
 #define TIMER_BASE_ADDR     0x02000000
+#define CLINT_MSIP_ADDR     TIMER_BASE_ADDR
+#define CLINT_MSIP_SIZE     4
 #define TIMER_MTIMECMP_ADDR TIMER_BASE_ADDR + 0x4000
 #define TIMER_MTIME_ADDR    TIMER_BASE_ADDR + 0xbff8
 
+/******************************************************************************
+ * @brief disable interrupts on the current hart
+ *
+ * Used to protect short kernel sections which can't be preempted by an
+ * interrupt, such as run queue updates and context switches.
+ *
+ * @param none
+ * @return previous interrupt enable state to give to irq_arch_restore()
+ ******************************************************************************/
+static inline uint64_t irq_arch_disable() {
+  return csr_read_clear(CSR_MSTATUS, MACHINE_INTERRUPT_ENABLE) &
+         MACHINE_INTERRUPT_ENABLE;
+}
+
+/******************************************************************************
+ * @brief restore the interrupt enable state saved by irq_arch_disable()
+ * @param previous interrupt enable state
+ * @return none
+ ******************************************************************************/
+static inline void irq_arch_restore(uint64_t flags) {
+  csr_set(CSR_MSTATUS, flags);
+}
+
+/******************************************************************************
+ * @brief enable interrupts on the current hart
+ * @param none
+ * @return none
+ ******************************************************************************/
+static inline void irq_arch_enable() {
+  csr_set(CSR_MSTATUS, MACHINE_INTERRUPT_ENABLE);
+}
+
+/******************************************************************************
+ * @brief check if an enabled interrupt is pending on the current hart
+ * @param none
+ * @return true if an interrupt would be taken once interrupts are enabled
+ ******************************************************************************/
+static inline bool irq_arch_pending() {
+  return (csr_read(CSR_MIP) & csr_read(CSR_MIE)) != 0;
+}
+
+/******************************************************************************
+ * @brief raise the software interrupt of a hart
+ *
+ * Each hart has its own msip register in the CLINT, the interrupt is pending
+ * until the target hart clears it.
+ *
+ * @param target hart identifier
+ * @return none
+ ******************************************************************************/
+static inline void irq_arch_send_ipi(uint64_t hart_id) {
+  // the data posted for the target hart is visible before the interrupt
+  __asm__ volatile("fence w, o" ::: "memory");
+  reg_write_word(CLINT_MSIP_ADDR + hart_id * CLINT_MSIP_SIZE, 1);
+}
+
+/******************************************************************************
+ * @brief acknowledge the software interrupt of a hart
+ * @param hart identifier
+ * @return none
+ ******************************************************************************/
+static inline void irq_arch_clear_ipi(uint64_t hart_id) {
+  reg_write_word(CLINT_MSIP_ADDR + hart_id * CLINT_MSIP_SIZE, 0);
+}
+
+/******************************************************************************
+ * @brief stop the hart until an interrupt is pending
+ *
+ * wfi resumes as soon as an interrupt enabled in mie is pending, even if
+ * interrupts are globally disabled. This allows to check for ready tasks and
+ * go to sleep without any interrupt being lost in between.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+static inline void irq_arch_wait() {
+  __asm__ volatile("wfi" ::: "memory");
+}
+
+/******************************************************************************
+ * @struct irq_controller_t
+ * @brief external interrupt controller operations
+ *
+ * enable and disable attach or detach a source, its priority is given with
+ * the one of the attached task. mask and unmask temporarily block a source
+ * between its notification and the next wait. level gives the interrupt
+ * level of a source, from 1 to IRQ_LEVEL_MAX - 1, and set_level only lets the
+ * sources above a level interrupt the hart.
+ ******************************************************************************/
+typedef struct irq_controller_t {
+  void (*enable)(uint32_t source, uint8_t prio);
+  void (*disable)(uint32_t source);
+  void (*mask)(uint32_t source);
+  void (*unmask)(uint32_t source);
+  uint32_t (*claim)(void);
+  void (*complete)(uint32_t source);
+  uint32_t (*level)(uint32_t source);
+  void (*set_level)(uint32_t level);
+} irq_controller_t;
+
+/******************************************************************************
+ * @brief register the external interrupt controller
+ * @param controller operations
+ * @return None
+ ******************************************************************************/
+void interrupt_set_controller(const irq_controller_t *);
+
+/******************************************************************************
+ * @brief attach an in-kernel top half to an interrupt
+ * @param interrupt identifier
+ * @param top half callback, NULL to remove it
+ * @return None
+ ******************************************************************************/
+void interrupt_set_top_half(interrupt_id_t, interrupt_top_half_t);
+
+/******************************************************************************
+ * @brief serve an external source in the kernel, without any attached task
+ *
+ * Used by the kernel drivers, the top half serves the device in the interrupt
+ * context of hart 0 and its return value is ignored.
+ *
+ * @param interrupt identifier of an external source
+ * @param top half callback
+ * @param priority of the source, as a task priority
+ * @return K_OK, or K_ERROR if the source doesn't exist or there is no
+ * controller
+ ******************************************************************************/
+k_return_t interrupt_attach(interrupt_id_t, interrupt_top_half_t, uint8_t);
+
+/******************************************************************************
+ * @brief bind an interrupt to its task waiting for it with wait_any()
+ * @param interrupt identifier
+ * @param task attached to the interrupt
+ * @param ready bit of the interrupt in the task
+ * @return K_OK, or K_ERROR if the interrupt is not attached to the task
+ ******************************************************************************/
+k_return_t interrupt_watch(interrupt_id_t, struct task_t *, uint64_t);
+
+/******************************************************************************
+ * @brief unbind an interrupt from its task waiting for it with wait_any()
+ * @param interrupt identifier
+ * @param task attached to the interrupt
+ * @return none
+ ******************************************************************************/
+void interrupt_unwatch(interrupt_id_t, struct task_t *);
+
+/******************************************************************************
+ * @brief consume the pending notification of an interrupt
+ * @param interrupt identifier
+ * @return true if a notification was pending
+ ******************************************************************************/
+bool interrupt_take(interrupt_id_t);
+
+/******************************************************************************
+ * @brief unmask an interrupt consumed by wait_any() once its task waits again
+ * @param interrupt identifier
+ * @param task attached to the interrupt
+ * @return none
+ ******************************************************************************/
+void interrupt_rearm(interrupt_id_t, struct task_t *);
+
 #endif
\ No newline at end of file
@@ -17,7 +17,8 @@
 #ifndef OFFSETS_H
 #define OFFSETS_H
 
-#define TASK_THREAD_SP 0
+#define TASK_THREAD_SP            0
+#define TASK_THREAD_MSG_DEPOSITED 8
 
 #define CALLEE_STACK_FRAME_LENGTH 96
 #define CALLEE_STACK_FRAME_S0     0
@@ -33,25 +34,45 @@
 #define CALLEE_STACK_FRAME_S10    80
 #define CALLEE_STACK_FRAME_S11    88
 
-#define CALLER_STACK_FRAME_LENGTH 128
-#define CALLER_STACK_FRAME_T0     8
-#define CALLER_STACK_FRAME_T1     16
-#define CALLER_STACK_FRAME_T2     24
-#define CALLER_STACK_FRAME_T3     32
-#define CALLER_STACK_FRAME_T4     40
-#define CALLER_STACK_FRAME_T5     48
-#define CALLER_STACK_FRAME_T6     56
-#define CALLER_STACK_FRAME_A0     64
-#define CALLER_STACK_FRAME_A1     72
-#define CALLER_STACK_FRAME_A2     80
-#define CALLER_STACK_FRAME_A3     88
-#define CALLER_STACK_FRAME_A4     96
-#define CALLER_STACK_FRAME_A5     104
-#define CALLER_STACK_FRAME_A6     112
-#define CALLER_STACK_FRAME_A7     120
+#define TRAP_FRAME_LENGTH 144
+#define TRAP_FRAME_MEPC   0
+#define TRAP_FRAME_RA     8
+#define TRAP_FRAME_T0     16
+#define TRAP_FRAME_T1     24
+#define TRAP_FRAME_T2     32
+#define TRAP_FRAME_T3     40
+#define TRAP_FRAME_T4     48
+#define TRAP_FRAME_T5     56
+#define TRAP_FRAME_T6     64
+#define TRAP_FRAME_A0     72
+#define TRAP_FRAME_A1     80
+#define TRAP_FRAME_A2     88
+#define TRAP_FRAME_A3     96
+#define TRAP_FRAME_A4     104
+#define TRAP_FRAME_A5     112
+#define TRAP_FRAME_A6     120
+#define TRAP_FRAME_A7     128
 
 #define KERNEL_STACK_FRAME_LENGTH 16
 #define KERNEL_STACK_FRAME_MEPC   0
 #define KERNEL_STACK_FRAME_RA     8
 
+#define USER_FRAME_LENGTH 32
+#define USER_FRAME_MEPC   0
+#define USER_FRAME_SP     8
+#define USER_FRAME_TP     16
+#define USER_FRAME_T0     24
+
+#define USER_KERNEL_STACK_TASK 0
+
+#define FPU_CONTEXT_LENGTH 264
+#define FPU_CONTEXT_F(n)   ((n) * 8)
+#define FPU_CONTEXT_FCSR   256
+
+#define VECTOR_CONTEXT_VSTART 0
+#define VECTOR_CONTEXT_VL     8
+#define VECTOR_CONTEXT_VTYPE  16
+#define VECTOR_CONTEXT_VCSR   24
+#define VECTOR_CONTEXT_REGS   32
+
 #endif
\ No newline at end of file
@@ -29,13 +29,24 @@ static inline void hang_processor() {
 
 /******************************************************************************
  * @brief print debug message ang hang processor
+ *
+ * The message is printed right away, after the deferred printk records which
+ * led to it.
+ *
  * @param string to print
  * @return none
  ******************************************************************************/
 static inline void panic(const char* format, ...) {
   va_list va;
+
+#ifdef CONFIG_PRINTK_DEFERRED
+  for (uint64_t hart = 0; hart < CONFIG_HART_MAX_NB; hart++) {
+    log_drain(hart);
+  }
+#endif
+
   va_start(va, format);
-  printk(format, va);
+  vprintf(format, va);
   va_end(va);
   hang_processor();
 }
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef PMP_H
+#define PMP_H
+
+#include "common.h"
+#include "task.h"
+
+/******************************************************************************
+ * place a function or a variable in the default region set of user tasks
+ ******************************************************************************/
+#define __user_text __attribute__((section(".text.user")))
+#define __user_data __attribute__((section(".data.user")))
+
+/*******************************************************************************
+ * region set of the code and data placed with __user_text and __user_data, the
+ * syscall stubs included
+ ******************************************************************************/
+extern task_region_t pmp_user_region;
+
+/******************************************************************************
+ * @brief program the pmp entries of the task elected on a hart
+ *
+ * A kernel task runs in machine mode and doesn't need any entry, the entries
+ * of a user task are left as they are: only the stack entries are written
+ * when the stack changed and the region set entries when the region set
+ * changed since they were last written on the hart.
+ *
+ * @param hart running the task
+ * @param task elected
+ * @return none
+ ******************************************************************************/
+void pmp_switch(uint64_t, task_t *);
+
+#endif
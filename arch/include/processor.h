@@ -17,16 +17,85 @@
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
 
-#define STACK_SIZE 4096
+#define STACK_SIZE     4096
+#define STACK_MIN_SIZE 1024
+#define PAGE_SIZE  4096
+#define PAGE_SHIFT 12
+
+// top of the stack of a user task kept for the kernel, out of its pmp entries
+// or, with virtual memory, out of its mapped pages
+#ifdef CONFIG_VM
+#define USER_KERNEL_STACK_SIZE PAGE_SIZE
+#define USER_STACK_ALIGN       PAGE_SIZE
+#else
+#define USER_KERNEL_STACK_SIZE 2048
+#define USER_STACK_ALIGN       16
+#endif
+#define USER_STACK_SIZE (STACK_SIZE + USER_KERNEL_STACK_SIZE)
 #define DWORD_SIZE 8
 #define LWORD_SIZE 16
 
+#define CACHE_LINE_SIZE 64
+
 /******************************************************************************
  * @struct thread_t
  * @brief structure used for thread local storage
+ *
+ * msg_deposited is set when a channel peer running on an another hart has
+ * already copied the message in the task buffer, it's not passed in
+ * registers by a direct switch.
  ******************************************************************************/
 typedef struct thread_t {
   uint64_t sp;
+  uint64_t msg_deposited;
 } thread_t;
 
+/******************************************************************************
+ * @brief read the thread pointer, it holds the current task
+ * @param none
+ * @return tp register value
+ ******************************************************************************/
+static inline uint64_t thread_pointer_get() {
+  uint64_t tp;
+
+  __asm__ volatile("mv %0, tp" : "=r"(tp));
+
+  return tp;
+}
+
+/******************************************************************************
+ * @brief read the identifier of the hart running the caller
+ * @param none
+ * @return mhartid register value
+ ******************************************************************************/
+static inline uint64_t hart_id_get() {
+  uint64_t hart_id;
+
+  __asm__ volatile("csrr %0, mhartid" : "=r"(hart_id));
+
+  return hart_id;
+}
+
+/******************************************************************************
+ * @brief read the number of cycles run by the hart
+ * @param none
+ * @return mcycle register value
+ ******************************************************************************/
+static inline uint64_t cycle_counter_get() {
+  uint64_t cycles;
+
+  __asm__ volatile("rdcycle %0" : "=r"(cycles));
+
+  return cycles;
+}
+
+/******************************************************************************
+ * @brief write the thread pointer, _switch_to loads it on each task switch
+ * @param new tp register value
+ * @return none
+ ******************************************************************************/
+static inline void thread_pointer_set(uint64_t tp) {
+  __asm__ volatile("mv tp, %0" : : "r"(tp));
+}
+
 #endif
\ No newline at end of file
@@ -37,6 +37,24 @@
 #define MACHINE_EXTERNAL_INTERRUPT_ENABLE  (0x1 << 11)
 #define MACHINE_EXTERNAL_INTERRUPT_DISABLE (0x0 << 11)
 
+/*
+ * state of the floating point and vector units in mstatus, a unit which is
+ * off traps on its first instruction
+ */
+#define MSTATUS_VS_MASK    (0x3 << 9)
+#define MSTATUS_VS_OFF     (0x0 << 9)
+#define MSTATUS_VS_INITIAL (0x1 << 9)
+#define MSTATUS_VS_CLEAN   (0x2 << 9)
+#define MSTATUS_VS_DIRTY   (0x3 << 9)
+
+#define MSTATUS_FS_MASK    (0x3 << 13)
+#define MSTATUS_FS_OFF     (0x0 << 13)
+#define MSTATUS_FS_INITIAL (0x1 << 13)
+#define MSTATUS_FS_CLEAN   (0x2 << 13)
+#define MSTATUS_FS_DIRTY   (0x3 << 13)
+
+#define MISA_V (0x1 << ('V' - 'A'))
+
 #define RISCV_PTR_LENGTH      4
 #define SHIFT_8_BYTES_ADDRESS 3
 
@@ -53,6 +71,68 @@
 
 #define CSR_MCAUSE_INTERRUPT_MASK 0xFF
 
+#define MCAUSE_ILLEGAL_INSTRUCTION 2
+#define MCAUSE_USER_ECALL          8
+#define MCAUSE_MACHINE_ECALL       11
+
+/*
+ * pmp entries of a user task, pmpcfg0 is written once per hart:
+ * entries 0-1 are the user stack, 2-3 the text and 4-5 the data of the
+ * region set, each pair is a top of range entry with the base in the first
+ * address register
+ */
+#define PMP_R   (0x1 << 0)
+#define PMP_W   (0x1 << 1)
+#define PMP_X   (0x1 << 2)
+#define PMP_TOR (0x1 << 3)
+
+#define PMP_NAPOT (0x3 << 3)
+
+#define PMP_ADDR_SHIFT 2
+
+/*
+ * with virtual memory the user tasks are confined by their page tables, a
+ * single napot entry opens the whole address space to the user mode and to
+ * the page table walks
+ */
+#ifdef CONFIG_VM
+#define PMP_CFG0 (PMP_NAPOT | PMP_R | PMP_W | PMP_X)
+#define PMP_ADDR0_ALL (-1)
+#else
+#define PMP_CFG0                              \
+  (((PMP_TOR | PMP_R | PMP_W) << 8) |         \
+   ((PMP_TOR | PMP_R | PMP_X) << 24) |        \
+   ((PMP_TOR | PMP_R | PMP_W) << 40))
+#endif
+
+/*
+ * satp of an Sv39 address space: mode, asid and physical page number of the
+ * root page table
+ */
+#define SATP_MODE_SV39   (0x8UL << 60)
+#define SATP_ASID_SHIFT  44
+#define SATP_ASID_MASK   0xFFFFUL
+#define SATP_PPN_SHIFT   12
+
+/*
+ * Sv39 page table entries
+ */
+#define PTE_V (0x1 << 0)
+#define PTE_R (0x1 << 1)
+#define PTE_W (0x1 << 2)
+#define PTE_X (0x1 << 3)
+#define PTE_U (0x1 << 4)
+#define PTE_G (0x1 << 5)
+#define PTE_A (0x1 << 6)
+#define PTE_D (0x1 << 7)
+
+#define PTE_PPN_SHIFT 10
+
+/*
+ * user mode reads the cycle, time and instret counters
+ */
+#define MCOUNTEREN_USER 0x7
+
 #define STRINGIFY(x) #x
 
 /******************************************************************************
@@ -80,6 +160,23 @@
     __asm__ volatile("csrc " STRINGIFY(csr) ", %0" ::"rK"(__val) : "memory"); \
   })
 
+/******************************************************************************
+ * @brief clear bits in the csr register and return its previous value
+ * @param csr register identifier
+ * @param bits to clear in the register
+ * @return csr value before bits are cleared
+ ******************************************************************************/
+#define csr_read_clear(csr, bits)                                  \
+  ({                                                               \
+    unsigned long __v;                                             \
+    unsigned long __val = bits;                                    \
+    __asm__ volatile("csrrc  %0, " STRINGIFY(csr) ", %1"           \
+                     : "=r"(__v)                                   \
+                     : "rK"(__val)                                 \
+                     : "memory");                                  \
+    __v;                                                           \
+  })
+
 /******************************************************************************
  * @brief write a 64bits value to the csr register
  * @param csr register identifier
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef TIMER_ARCH_H
+#define TIMER_ARCH_H
+
+#include "common.h"
+#include "irq_arch.h"
+
+/******************************************************************************
+ * machine timer frequency on the qemu virt platform
+ ******************************************************************************/
+#define TIMER_ARCH_RATE         10000000UL
+#define TIMER_ARCH_TICKS_PER_US (TIMER_ARCH_RATE / 1000000UL)
+#define TIMER_ARCH_NS_PER_TICK  (1000000000UL / TIMER_ARCH_RATE)
+
+/******************************************************************************
+ * reciprocal of TIMER_ARCH_TICKS_PER_US used to convert ticks without any
+ * division: ticks / 10 == (ticks * 0xCCCCCCCCCCCCCCCD) >> 67 for all 64-bit
+ * values, these constants must be updated if the timer rate changes
+ ******************************************************************************/
+#define TIMER_ARCH_US_MULT  0xCCCCCCCCCCCCCCCDUL
+#define TIMER_ARCH_US_SHIFT 3
+
+/******************************************************************************
+ * comparator value which never fires
+ ******************************************************************************/
+#define TIMER_ARCH_NEVER 0xFFFFFFFFFFFFFFFFUL
+
+/******************************************************************************
+ * @brief read the machine timer counter
+ * @param none
+ * @return mtime value
+ ******************************************************************************/
+static inline uint64_t timer_arch_get_time() {
+  return reg_read_double_word(TIMER_MTIME_ADDR);
+}
+
+/******************************************************************************
+ * @brief convert machine timer ticks in microseconds
+ *
+ * The high part of the 128-bit product is given by a single mulhu instruction.
+ *
+ * @param number of ticks
+ * @return duration in us
+ ******************************************************************************/
+static inline uint64_t timer_arch_ticks_to_us(uint64_t ticks) {
+  uint64_t high = (uint64_t)(((unsigned __int128)ticks * TIMER_ARCH_US_MULT) >>
+                             64);
+
+  return high >> TIMER_ARCH_US_SHIFT;
+}
+
+/******************************************************************************
+ * @brief program the machine timer comparator
+ *
+ * The timer interrupt is pending as long as mtime >= mtimecmp, writing a new
+ * value in the future acknowledges it.
+ *
+ * @param mtime value at which the timer interrupt fires
+ * @return none
+ ******************************************************************************/
+static inline void timer_arch_set_compare(uint64_t date) {
+  reg_write_double_word(TIMER_MTIMECMP_ADDR, date);
+}
+
+/******************************************************************************
+ * @brief disarm the machine timer comparator
+ * @param none
+ * @return none
+ ******************************************************************************/
+static inline void timer_arch_stop() {
+  timer_arch_set_compare(TIMER_ARCH_NEVER);
+}
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef VM_H
+#define VM_H
+
+#include "common.h"
+#include "task.h"
+
+#ifndef CONFIG_VM_SPACE_MAX_NB
+#define CONFIG_VM_SPACE_MAX_NB 16
+#endif
+
+/******************************************************************************
+ * @struct vm_space_t
+ * @brief Sv39 address space of a region set
+ *
+ * The kernel runs in machine mode and is never translated, an address space
+ * only holds the identity mappings of its region set and of the user stacks
+ * of its tasks. The generation is incremented each time a mapping changes,
+ * a hart flushes the translations of the asid when it differs from the last
+ * generation it has seen.
+ ******************************************************************************/
+typedef struct vm_space_t {
+  task_region_t *region;
+  uint64_t      *root;
+  uint64_t       satp;
+  uint64_t       generation;
+} vm_space_t;
+
+/******************************************************************************
+ * @brief find out if the harts can tag their translations with the address
+ * space identifiers
+ * @param none
+ * @return none
+ ******************************************************************************/
+void vm_init();
+
+/******************************************************************************
+ * @brief map the user part of a task stack in the address space of its region
+ * set
+ *
+ * The address space is built by the first task of the region set. The region
+ * set and the stack must be page aligned, the stack out of the region set and
+ * of the stacks already mapped.
+ *
+ * @param region set of the task
+ * @param stack start address of the task
+ * @param stack size in bytes
+ * @return address space identifier, or 0 if the space table or the heap is
+ * full or the ranges are not valid
+ ******************************************************************************/
+uint32_t vm_map_stack(task_region_t *, void *, uint64_t);
+
+/******************************************************************************
+ * @brief unmap a stack mapped by vm_map_stack()
+ * @param address space identifier
+ * @param stack start address of the task
+ * @param stack size in bytes
+ * @return none
+ ******************************************************************************/
+void vm_unmap_stack(uint32_t, void *, uint64_t);
+
+/******************************************************************************
+ * @brief switch to the address space of the task elected on a hart
+ *
+ * A kernel task runs in machine mode and doesn't need any, satp is only
+ * written when the task belongs to an another address space than the last
+ * one set on the hart, so the threads of a process never write it.
+ *
+ * @param hart running the task
+ * @param task elected
+ * @return none
+ ******************************************************************************/
+void vm_switch(uint64_t, task_t *);
+
+#endif
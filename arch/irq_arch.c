@@ -18,39 +18,137 @@
 
 #include "common.h"
 #include "interrupt.h"
+#include "irqsoff.h"
+#include "ktimer.h"
 #include "panic.h"
 #include "printk.h"
+#include "profile.h"
 #include "registers.h"
 #include "sched.h"
+#include "smp.h"
 #include "task.h"
+#include "trace.h"
+#include "wait_any.h"
 
-#define NB_INTERRUPT 3
+/******************************************************************************
+ * @struct irq_handler_t
+ * @brief task attached to an interrupt and its delivery state
+ *
+ * pending is set when the interrupt is delivered while the task is not
+ * waiting for it, the next interrupt_wait() returns immediatly. watch is the
+ * ready bit set in the task when it waits for the interrupt with wait_any().
+ ******************************************************************************/
+typedef struct irq_handler_t {
+  task_t               *task;
+  interrupt_top_half_t  top_half;
+  bool                  pending;
+  bool                  waiting;
+  uint64_t              watch;
+} irq_handler_t;
 
 // define a table to save all interrupt handlers
-task_t *irq_table[NB_INTERRUPT] = {NULL};
+irq_handler_t irq_table[NB_INTERRUPT];
+
+/******************************************************************************
+ * mie bits of the processor local interrupts, the machine timer is owned by
+ * the kernel timers and can't be requested
+ ******************************************************************************/
+static const uint64_t irq_local_mie[EXTERNAL_INTERRUPT] = {
+    [SOFTWARE_INTERRUPT] = MACHINE_SOFTWARE_INTERRUPT_ENABLE,
+    [TIMER_INTERRUPT]    = 0,
+};
+
+/******************************************************************************
+ * external interrupt controller registered by its driver
+ ******************************************************************************/
+static const irq_controller_t *irq_controller = NULL;
+
+/******************************************************************************
+ * @struct irq_hart_t
+ * @brief interrupt state of a hart
+ *
+ * level is the level of the external source served on the hart, 0 out of
+ * any external handler. depth is the number of nested handlers.
+ ******************************************************************************/
+typedef struct irq_hart_t {
+  uint32_t level;
+  uint32_t depth;
+} __attribute__((aligned(CACHE_LINE_SIZE))) irq_hart_t;
+
+static irq_hart_t irq_harts[CONFIG_HART_MAX_NB];
+
+/******************************************************************************
+ * @brief check if an interrupt identifier is an external source
+ * @param interrupt identifier
+ * @return true for external sources
+ ******************************************************************************/
+static inline bool irq_is_external(interrupt_id_t interrupt_id) {
+  return interrupt_id > EXTERNAL_INTERRUPT;
+}
+
+/******************************************************************************
+ * @brief check if an interrupt can be requested
+ * @param interrupt identifier
+ * @return true if the interrupt can be attached to a task
+ ******************************************************************************/
+static bool irq_is_valid(interrupt_id_t interrupt_id) {
+  if (interrupt_id >= NB_INTERRUPT) {
+    return false;
+  }
+
+  if (irq_is_external(interrupt_id)) {
+    return irq_controller != NULL;
+  }
+
+  return (interrupt_id < EXTERNAL_INTERRUPT) && irq_local_mie[interrupt_id];
+}
+
+/******************************************************************************
+ * @brief register the external interrupt controller
+ * @param controller operations
+ * @return None
+ ******************************************************************************/
+void interrupt_set_controller(const irq_controller_t *controller) {
+  irq_controller = controller;
+
+  // external sources are individually enabled in the controller
+  csr_set(CSR_MIE, MACHINE_EXTERNAL_INTERRUPT_ENABLE);
+}
 
 /******************************************************************************
  * @brief enable the interrupt in IE register
+ *
+ * The requesting task is pinned to IRQ_ARCH_HART, which takes the interrupts:
+ * it's woken up from the interrupt context without any inter-processor
+ * interrupt.
+ *
  * @param interrupt identifier
  * @return None
  ******************************************************************************/
 void interrupt_request(interrupt_id_t interrupt_id) {
-  uint64_t reg_value;
+  irq_handler_t *handler = &irq_table[interrupt_id];
+  task_t        *task    = sched_get_current_task();
 
-  // translate kernel interrupt number to riscv arch interrupt register offset
-  switch (interrupt_id) {
-    case TIMER_INTERRUPT:
-      reg_value = 1 << MIE_TIE_OFFSET;
-      break;
-    default:
-      break;
+  if (!irq_is_valid(interrupt_id)) {
+    return;
   }
 
-  // configure interrupt enable register
-  csr_set(CSR_MIE, reg_value);
-
   // register the task in the dedicated interrupt handler
-  irq_table[interrupt_id] = sched_get_current_task();
+  handler->task    = task;
+  handler->pending = false;
+  handler->waiting = false;
+  handler->watch   = 0;
+
+  // the task moves to the hart of the interrupt and must not be stolen
+  task_set_affinity(task, TASK_AFFINITY_HART(IRQ_ARCH_HART));
+
+  // the source priority follows the priority of the attached task
+  if (irq_is_external(interrupt_id)) {
+    irq_controller->enable(INTERRUPT_EXTERNAL_SOURCE(interrupt_id),
+                           task->prio);
+  } else {
+    csr_set(CSR_MIE, irq_local_mie[interrupt_id]);
+  }
 }
 
 /******************************************************************************
@@ -59,74 +157,414 @@ void interrupt_request(interrupt_id_t interrupt_id) {
  * @return None
  ******************************************************************************/
 void interrupt_release(interrupt_id_t interrupt_id) {
-  uint64_t reg_value;
-
-  // translate kernel interrupt number to riscv arch interrupt register offset
-  switch (interrupt_id) {
-    case TIMER_INTERRUPT:
-      reg_value = 1 << MIE_TIE_OFFSET;
-      break;
-    default:
-      break;
+  if (!irq_is_valid(interrupt_id)) {
+    return;
   }
 
-  // reset interrupt enable register
-  csr_clear(CSR_MIE, reg_value);
+  // the software interrupt also carries the inter-processor interrupts, it
+  // stays enabled
+  if (irq_is_external(interrupt_id)) {
+    irq_controller->disable(INTERRUPT_EXTERNAL_SOURCE(interrupt_id));
+  } else {
+    csr_clear(CSR_MIE, irq_local_mie[interrupt_id] &
+                           ~MACHINE_SOFTWARE_INTERRUPT_ENABLE);
+  }
 
   // clear the interrupt handler pointer
-  irq_table[interrupt_id] = NULL;
+  irq_table[interrupt_id].task  = NULL;
+  irq_table[interrupt_id].watch = 0;
 }
 
 /******************************************************************************
- * @brief dispatch interrupt according to its source
- * @param none
+ * @brief attach an in-kernel top half to an interrupt
+ *
+ * The top half runs in the interrupt context before the task is notified. It
+ * can acknowledge the device and returns false if the task does not need to
+ * be notified.
+ *
+ * @param interrupt identifier
+ * @param top half callback, NULL to remove it
+ * @return None
+ ******************************************************************************/
+void interrupt_set_top_half(interrupt_id_t       interrupt_id,
+                            interrupt_top_half_t top_half) {
+  if (interrupt_id < NB_INTERRUPT) {
+    irq_table[interrupt_id].top_half = top_half;
+  }
+}
+
+/******************************************************************************
+ * @brief serve an external source in the kernel, without any attached task
+ * @param interrupt identifier of an external source
+ * @param top half callback
+ * @param priority of the source, as a task priority
+ * @return K_OK, or K_ERROR if the source doesn't exist or there is no
+ * controller
+ ******************************************************************************/
+k_return_t interrupt_attach(interrupt_id_t       interrupt_id,
+                            interrupt_top_half_t top_half, uint8_t prio) {
+  if (!irq_is_external(interrupt_id) || !irq_is_valid(interrupt_id)) {
+    return K_ERROR;
+  }
+
+  irq_table[interrupt_id].top_half = top_half;
+  irq_table[interrupt_id].task     = NULL;
+  irq_table[interrupt_id].watch    = 0;
+
+  // without any task the source is never masked by its delivery
+  irq_controller->enable(INTERRUPT_EXTERNAL_SOURCE(interrupt_id), prio);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief block the current task until the interrupt is delivered
+ * @param interrupt identifier
+ * @return None
+ ******************************************************************************/
+void interrupt_wait(interrupt_id_t interrupt_id) {
+  irq_handler_t *handler = &irq_table[interrupt_id];
+  task_t        *task    = sched_get_current_task();
+  uint64_t       flags;
+
+  // only the attached task can wait for the interrupt
+  if (!irq_is_valid(interrupt_id) || (handler->task != task)) {
+    return;
+  }
+
+  flags = smp_lock();
+
+  // an external source is masked from its notification to the next wait
+  if (irq_is_external(interrupt_id)) {
+    irq_controller->unmask(INTERRUPT_EXTERNAL_SOURCE(interrupt_id));
+  }
+
+  if (!handler->pending) {
+    handler->waiting = true;
+    task_set_state(task, BLOCKED);
+    sched_remove_task(task);
+    sched_run();
+  }
+
+  handler->pending = false;
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief bind an interrupt to its task waiting for it with wait_any()
+ *
+ * An external source is unmasked as by interrupt_wait(), a pending
+ * notification sets the ready bit right away.
+ *
+ * @param interrupt identifier
+ * @param task attached to the interrupt
+ * @param ready bit of the interrupt in the task
+ * @return K_OK, or K_ERROR if the interrupt is not attached to the task
+ ******************************************************************************/
+k_return_t interrupt_watch(interrupt_id_t interrupt_id, task_t *task,
+                           uint64_t bit) {
+  irq_handler_t *handler = &irq_table[interrupt_id];
+  uint64_t       flags;
+
+  if (!irq_is_valid(interrupt_id) || (handler->task != task)) {
+    return K_ERROR;
+  }
+
+  flags = smp_lock();
+
+  handler->watch = bit;
+
+  if (handler->pending) {
+    wait_any_signal(task, bit);
+  } else if (irq_is_external(interrupt_id)) {
+    irq_controller->unmask(INTERRUPT_EXTERNAL_SOURCE(interrupt_id));
+  }
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief unbind an interrupt from its task waiting for it with wait_any()
+ * @param interrupt identifier
+ * @param task attached to the interrupt
  * @return none
  ******************************************************************************/
-static inline void handle_timer_interrupt() {
-  // disable timer interrupt
-  csr_clear(CSR_MIE, MIE_TIE);
-
-  if (irq_table[TIMER_INTERRUPT]) {
-    // wake up registered interrupt handler
-    // this will add the interrupt handler
-    // in the run queue and run the scheduler
-    // it will immediatly jump to the task if it
-    // has the highest priority
-    task_wakeup(irq_table[TIMER_INTERRUPT]);
-    // re-enable global interrupts after having
-    // woke up the driver task but before switching to it
-    csr_set(CSR_MSTATUS, MACHINE_INTERRUPT_ENABLE);
-    // switch to the interrupt handler task
-    task_yield();
+void interrupt_unwatch(interrupt_id_t interrupt_id, task_t *task) {
+  if (irq_is_valid(interrupt_id) && (irq_table[interrupt_id].task == task)) {
+    irq_table[interrupt_id].watch = 0;
+  }
+}
+
+/******************************************************************************
+ * @brief consume the pending notification of an interrupt
+ * @param interrupt identifier
+ * @return true if a notification was pending
+ ******************************************************************************/
+bool interrupt_take(interrupt_id_t interrupt_id) {
+  irq_handler_t *handler = &irq_table[interrupt_id];
+  bool           pending = handler->pending;
+
+  handler->pending = false;
+
+  return pending;
+}
+
+/******************************************************************************
+ * @brief unmask an interrupt consumed by wait_any() once its task waits again
+ * @param interrupt identifier
+ * @param task attached to the interrupt
+ * @return none
+ ******************************************************************************/
+void interrupt_rearm(interrupt_id_t interrupt_id, task_t *task) {
+  if (irq_is_valid(interrupt_id) && irq_is_external(interrupt_id) &&
+      (irq_table[interrupt_id].task == task)) {
+    irq_controller->unmask(INTERRUPT_EXTERNAL_SOURCE(interrupt_id));
+  }
+}
+
+/******************************************************************************
+ * @brief notify the task attached to an interrupt
+ *
+ * The task is directly woken up from the interrupt context, no other task is
+ * involved in the delivery. A task of an another hart is preempted there by
+ * the scheduler.
+ *
+ * @param interrupt identifier
+ * @return true if the notified task has to preempt the current one
+ ******************************************************************************/
+static bool irq_deliver(interrupt_id_t interrupt_id) {
+  irq_handler_t *handler = &irq_table[interrupt_id];
+  bool           preempt;
+  uint64_t       flags;
+
+  if (handler->top_half && !handler->top_half(interrupt_id)) {
+    return false;
+  }
+
+  if (!handler->task) {
+    return false;
+  }
+
+  // a level triggered device keeps its line asserted until the task serves
+  // it, the source stays masked until the task waits again
+  if (irq_is_external(interrupt_id)) {
+    irq_controller->mask(INTERRUPT_EXTERNAL_SOURCE(interrupt_id));
+  }
+
+  // the task may check pending and block on an another hart, the handshake
+  // is done under the lock as in interrupt_wait()
+  flags = smp_lock();
+
+  if (!handler->waiting) {
+    handler->pending = true;
+
+    // the task may wait for several objects with wait_any()
+    preempt = handler->watch && wait_any_signal(handler->task, handler->watch);
   } else {
-    panic("Timer interrupt handler not defined\n");
+    handler->waiting = false;
+    task_wakeup(handler->task);
+
+    preempt = sched_preempts_current(handler->task);
   }
+
+  smp_unlock(flags);
+
+  return preempt;
 }
 
 /******************************************************************************
- * @brief dispatch interrupt according to its source
+ * @brief get the processor local interrupts which can't nest in a handler
+ * @param level of the handler
+ * @return mie bits of the local interrupts at or below the level
+ ******************************************************************************/
+static inline uint64_t irq_local_masked(uint32_t level) {
+  uint64_t masked = 0;
+
+  if (CONFIG_IRQ_SOFTWARE_LEVEL <= level) {
+    masked |= MACHINE_SOFTWARE_INTERRUPT_ENABLE;
+  }
+
+  if (CONFIG_IRQ_TIMER_LEVEL <= level) {
+    masked |= MACHINE_TIMER_INTERRUPT_ENABLE;
+  }
+
+  return masked;
+}
+
+/******************************************************************************
+ * @brief notify the task attached to an external source with interrupts of a
+ * higher level enabled
+ *
+ * The level of the hart is raised to the one of the source: the controller
+ * only signals the sources above it and the local interrupts at or below it
+ * are masked. A nested interrupt returns to the handler, it never switches
+ * the task. The kernel lock sections of the handler still run with interrupts
+ * disabled.
+ *
+ * @param interrupt identifier of an external source
+ * @param claimed source number
+ * @return true if the notified task has to preempt the current one
+ ******************************************************************************/
+static bool irq_deliver_nested(interrupt_id_t interrupt_id, uint32_t source) {
+#ifdef CONFIG_IRQ_NESTING
+  irq_hart_t *hart   = &irq_harts[hart_id_get()];
+  uint32_t    level  = irq_controller->level(source);
+  uint32_t    prev   = hart->level;
+  uint64_t    masked = csr_read(CSR_MIE) & irq_local_masked(level);
+  bool        preempt;
+
+  hart->level = level;
+  irq_controller->set_level(level);
+  csr_clear(CSR_MIE, masked);
+
+  IRQSOFF_END();
+  irq_arch_enable();
+
+  preempt = irq_deliver(interrupt_id);
+
+  irq_arch_disable();
+  IRQSOFF_BEGIN(IRQSOFF_SITE_IRQ(RISCV_INTERRUPT_MACHINE_EXTERNAL));
+
+  csr_set(CSR_MIE, masked);
+  irq_controller->set_level(prev);
+  hart->level = prev;
+
+  return preempt;
+#else
+  return irq_deliver(interrupt_id);
+#endif
+}
+
+/******************************************************************************
+ * @brief serve the expired kernel timers
  * @param none
- * @return none
+ * @return true if a woken up task has to preempt the current one
  ******************************************************************************/
-void dispatch_interrupt() {
-  // get the interrupt cause from registers
-  uint64_t cause = csr_read(CSR_MCAUSE) & CSR_MCAUSE_INTERRUPT_MASK;
+static inline bool handle_timer_interrupt() {
+  // the machine timer is shared by all kernel timers
+  return ktimer_expire();
+}
+
+/******************************************************************************
+ * @brief acknowledge the software interrupt and serve it
+ *
+ * The software interrupt is shared by the harts requests and the task which
+ * requested SOFTWARE_INTERRUPT. msip doesn't tell them apart, so the task is
+ * notified on every software interrupt of IRQ_ARCH_HART, even when a request
+ * of an another hart has raised it.
+ *
+ * @param trap frame of the interrupted code
+ * @param frame pointer of the interrupted code
+ * @return true if the current task has to be preempted
+ ******************************************************************************/
+static inline bool handle_software_interrupt(uint64_t frame, uint64_t fp) {
+  // the interrupt is pending as long as msip is set
+  uint64_t ipi = smp_ipi_take();
+  bool     preempt;
+
+#ifdef CONFIG_PROFILE
+  if (ipi & SMP_IPI_PROFILE) {
+    profile_sample(frame, fp);
+  }
+#endif
+
+  // the current task is preempted for a task queued by an another hart
+  preempt = ipi & SMP_IPI_RESCHED;
+
+  if (hart_id_get() == IRQ_ARCH_HART) {
+    preempt |= irq_deliver(SOFTWARE_INTERRUPT);
+  }
+
+  return preempt;
+}
+
+/******************************************************************************
+ * @brief claim all pending external sources and notify their tasks
+ *
+ * Sources are completed before switching to a notified task, so the
+ * controller can raise the next interrupts while the task runs.
+ *
+ * @param none
+ * @return true if a notified task has to preempt the current one
+ ******************************************************************************/
+static inline bool handle_external_interrupt() {
+  bool     preempt = false;
+  uint32_t source;
+
+  if (!irq_controller) {
+    panic("external interrupt without controller\n");
+  }
+
+  while ((source = irq_controller->claim())) {
+    if ((source < INTERRUPT_NB_EXTERNAL) &&
+        irq_deliver_nested(INTERRUPT_EXTERNAL_ID(source), source)) {
+      preempt = true;
+    }
+
+    irq_controller->complete(source);
+  }
+
+  return preempt;
+}
+
+/******************************************************************************
+ * @brief dispatch interrupt according to its source
+ *
+ * The task switch is not done here but by the interrupt entry once all
+ * handlers have returned: the interrupted task then only keeps its trap frame
+ * and the switch frame. A handler nested in an another one, or in a window of
+ * a kernel lock section, defers the preemption to the outermost handler or to
+ * the release of the lock.
+ *
+ * @param mcause value read by the interrupt entry
+ * @param trap frame of the interrupted code
+ * @param frame pointer of the interrupted code
+ * @return true if the current task has to be preempted
+ ******************************************************************************/
+bool dispatch_interrupt(uint64_t mcause, uint64_t frame, uint64_t fp) {
+  irq_hart_t *hart    = &irq_harts[hart_id_get()];
+  uint64_t    cause   = mcause & CSR_MCAUSE_INTERRUPT_MASK;
+  bool        preempt = false;
+
+  IRQSOFF_BEGIN(IRQSOFF_SITE_IRQ(cause));
+  TRACE(TRACE_IRQ_ENTRY, cause, 0);
+
+  hart->depth += 1;
 
   switch (cause) {
     case RISCV_INTERRUPT_MACHINE_SOFTWARE:
-      panic("interrupt machine software n°%d not handled\n", cause);
+      preempt = handle_software_interrupt(frame, fp);
       break;
 
     case RISCV_INTERRUPT_MACHINE_TIMER:
-      handle_timer_interrupt();
+      preempt = handle_timer_interrupt();
       break;
 
     case RISCV_INTERRUPT_MACHINE_EXTERNAL:
-      panic("interrupt machine external n°%d not handled\n", cause);
+      preempt = handle_external_interrupt();
       break;
 
     default:
       panic("interrupt n°%d not handled\n", cause);
       break;
   }
+
+  hart->depth -= 1;
+
+  if (hart->depth || smp_lock_held()) {
+    if (preempt) {
+      smp_preempt_defer();
+    }
+
+    preempt = false;
+  } else if (smp_preempt_take()) {
+    preempt = true;
+  }
+
+  TRACE(TRACE_IRQ_EXIT, cause, preempt);
+
+  return preempt;
 }
\ No newline at end of file
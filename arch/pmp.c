@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "pmp.h"
+#include "registers.h"
+
+#ifdef CONFIG_PMP
+
+/*******************************************************************************
+ * @struct pmp_hart_t
+ * @brief pmp entries last written on a hart, encoded as address registers
+ ******************************************************************************/
+typedef struct pmp_hart_t {
+  uint64_t       stack_base;
+  uint64_t       stack_top;
+  task_region_t *region;
+} __attribute__((aligned(CACHE_LINE_SIZE))) pmp_hart_t;
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+extern uint8_t _user_text_start[];
+extern uint8_t _user_text_end[];
+extern uint8_t _user_data_start[];
+extern uint8_t _user_data_end[];
+
+task_region_t pmp_user_region = {
+    .text_start = (uint64_t)_user_text_start,
+    .text_end   = (uint64_t)_user_text_end,
+    .data_start = (uint64_t)_user_data_start,
+    .data_end   = (uint64_t)_user_data_end,
+};
+
+// no region set is written at boot, the entries are empty ranges
+static pmp_hart_t pmp_harts[CONFIG_HART_MAX_NB];
+
+/******************************************************************************
+ * @brief program the pmp entries of the task elected on a hart
+ * @param hart running the task
+ * @param task elected
+ * @return none
+ ******************************************************************************/
+void pmp_switch(uint64_t hart, task_t *task) {
+  pmp_hart_t    *entries = &pmp_harts[hart];
+  task_region_t *region  = task->region;
+  uint64_t       base;
+  uint64_t       top;
+
+  if (region == NULL) {
+    return;
+  }
+
+  // the kernel stack at the top of the stack stays out of the entries
+  base = (uint64_t)task->stack >> PMP_ADDR_SHIFT;
+  top  = ((uint64_t)task->stack + task->stack_size - USER_KERNEL_STACK_SIZE) >>
+        PMP_ADDR_SHIFT;
+
+  if (entries->stack_base != base || entries->stack_top != top) {
+    csr_write(pmpaddr0, base);
+    csr_write(pmpaddr1, top);
+    entries->stack_base = base;
+    entries->stack_top  = top;
+  }
+
+  if (entries->region != region) {
+    csr_write(pmpaddr2, region->text_start >> PMP_ADDR_SHIFT);
+    csr_write(pmpaddr3, region->text_end >> PMP_ADDR_SHIFT);
+    csr_write(pmpaddr4, region->data_start >> PMP_ADDR_SHIFT);
+    csr_write(pmpaddr5, region->data_end >> PMP_ADDR_SHIFT);
+    entries->region = region;
+  }
+}
+
+#endif
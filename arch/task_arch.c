@@ -22,7 +22,20 @@
 /******************************************************************************
  * @brief used to switch from kernel mode to user mode at task startup
  ******************************************************************************/
-extern void (*_ret_from_interrupt)(void);
+extern void (*_ret_from_switch)(void);
+
+#ifdef CONFIG_PMP
+/******************************************************************************
+ * @brief used to enter user mode, a user task starts there from
+ * _ret_from_switch
+ ******************************************************************************/
+extern void (*_ret_to_user)(void);
+
+/******************************************************************************
+ * @brief a user task returns to the exit syscall stub, in its text
+ ******************************************************************************/
+extern void ax_task_exit(void);
+#endif
 
 /******************************************************************************
  * @brief initialize task stack
@@ -34,10 +47,6 @@ extern void (*_ret_from_interrupt)(void);
  * and sp is 128 bits aligned:
  *
  * ----------------------- stack_start
- * task_t start
- * ...
- * task_t end
- * -----------------------
  * ...
  * ...
  * ...
@@ -47,8 +56,10 @@ extern void (*_ret_from_interrupt)(void);
  * s10
  * s11
  * -----------
- * _ret_from_interrupt
+ * _ret_from_switch
  * -----------
+ * task_runtime
+ * ra
  * t0
  * ...
  * t6
@@ -56,55 +67,90 @@ extern void (*_ret_from_interrupt)(void);
  * ...
  * a6
  * a7
- * task_runtime
- * ra
  * -----------
  * ----------------------- stack_end
  *
- * @param stack start address pointer
- * @param size of the stack
+ * A user task starts in _ret_to_user instead of task_runtime, with a user
+ * frame and the task address at the top of the kernel stack. The user frame
+ * enters task_entry on the user stack, which ends at the kernel stack, and
+ * the task exits when task_entry returns to the ax_task_exit stub:
+ *
+ * -----------
+ * _ret_to_user
+ * ax_task_exit
+ * t0
+ * ...
+ * a7
+ * -----------
+ * task_entry
+ * user stack
+ * tp
+ * t0
+ * -----------
+ * task
+ * ----------------------- stack_end
+ *
+ * @param task owning the stack
  * @param function to run in the task context
- * @return top address of the initialized stack
+ * @return none
  ******************************************************************************/
-void task_stack_init(stack_t *stack, uint64_t stack_size,
-                     void (*task_entry)(void)) {
-  // get task pointer from the stack
-  task_t *task = (task_t *)stack;
-
+void task_stack_init(task_t *task, void (*task_entry)(void)) {
   // initialiaze SP at the end of the stack
   // and 16-bytes align it
-  task->thread.sp = (uint64_t)stack + stack_size - LWORD_SIZE;
+  task->thread.sp = (uint64_t)task->stack + task->stack_size - LWORD_SIZE;
+
+  // no message is waiting for the task
+  task->thread.msg_deposited = 0;
+
+#ifdef CONFIG_PMP
+  if (task->region != NULL) {
+    // the kernel finds the task at the top of its stack on a user trap
+    *(uint64_t *)(task->thread.sp + USER_KERNEL_STACK_TASK) = (uint64_t)task;
+
+    task->thread.sp -= USER_FRAME_LENGTH;
+    *(uint64_t *)(task->thread.sp + USER_FRAME_MEPC) = (uint64_t)task_entry;
+    *(uint64_t *)(task->thread.sp + USER_FRAME_SP) =
+        (uint64_t)task->stack + task->stack_size - USER_KERNEL_STACK_SIZE;
+    *(uint64_t *)(task->thread.sp + USER_FRAME_TP) = 0;
+    *(uint64_t *)(task->thread.sp + USER_FRAME_T0) = 0;
+
+    // _ret_from_switch returns to _ret_to_user which enters user mode
+    task->thread.sp -= TRAP_FRAME_LENGTH;
+    *(uint64_t *)(task->thread.sp + TRAP_FRAME_MEPC) = (uint64_t)&_ret_to_user;
+    *(uint64_t *)(task->thread.sp + TRAP_FRAME_RA)   = (uint64_t)ax_task_exit;
+    *(uint64_t *)(task->thread.sp + TRAP_FRAME_A0)   = 0;
+  } else
+#endif
+  {
+    // initialize the trap frame
+    // task_runtime will be loaded in pc register by _ret_from_switch
+    task->thread.sp -= TRAP_FRAME_LENGTH;
+    *(uint64_t *)(task->thread.sp + TRAP_FRAME_MEPC) = (uint64_t)task_runtime;
+    *(uint64_t *)(task->thread.sp + TRAP_FRAME_RA)   = 0;
 
-  // initialize kernel stack frame
-  // task_runtime will be loaded in pc register by _ret_from_interrupt
-  task->thread.sp -= KERNEL_STACK_FRAME_LENGTH;
-  *(uint64_t *)(task->thread.sp + KERNEL_STACK_FRAME_MEPC) =
-      (uint64_t)task_runtime;
-  *(uint64_t *)(task->thread.sp + KERNEL_STACK_FRAME_RA) = 0;
+    // a0 is loaded by _ret_from_switch and is used as first
+    // argument of task_runtime
+    *(uint64_t *)(task->thread.sp + TRAP_FRAME_A0) = (uint64_t)task_entry;
+  }
 
-  // initialize caller-saved stack frame
-  // a0 is loaded by _ret_from_interrupt and is used as first
-  // argument of task_runtime
-  task->thread.sp -= CALLER_STACK_FRAME_LENGTH;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_T0) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_T1) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_T2) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_T3) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_T4) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_T5) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_T6) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_A0) = (uint64_t)task_entry;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_A1) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_A2) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_A3) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_A4) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_A5) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_A6) = 0;
-  *(uint64_t *)(task->thread.sp + CALLER_STACK_FRAME_A7) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_T0) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_T1) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_T2) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_T3) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_T4) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_T5) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_T6) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_A1) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_A2) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_A3) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_A4) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_A5) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_A6) = 0;
+  *(uint64_t *)(task->thread.sp + TRAP_FRAME_A7) = 0;
 
-  // move up sp and save _ret_from_interrupt
+  // move up sp and save _ret_from_switch
   task->thread.sp -= LWORD_SIZE;
-  *(uint64_t *)(task->thread.sp + DWORD_SIZE) = (uint64_t)&_ret_from_interrupt;
+  *(uint64_t *)(task->thread.sp + DWORD_SIZE) = (uint64_t)&_ret_from_switch;
 
   // move up sp to initialize callee-saved registers
   task->thread.sp -= CALLEE_STACK_FRAME_LENGTH;
@@ -15,9 +15,14 @@
  * not, see https://www.gnu.org/licenses/
  */
 #include "common.h"
+#include "fpu.h"
+#include "offsets.h"
 #include "panic.h"
 #include "printk.h"
+#include "processor.h"
 #include "registers.h"
+#include "sched.h"
+#include "task.h"
 
 /******************************************************************************
  * @brief handle unknown exceptions
@@ -26,20 +31,89 @@
 void handle_unknown_exception() {
   uint64_t cause = csr_read(CSR_MCAUSE) & CSR_MCAUSE_INTERRUPT_MASK;
   // get the cause of the exception
-  printk("exception not handled / mcause : %d\r\n", cause);
+  panic("exception not handled / mcause : %d\r\n", cause);
+}
+
+#ifdef CONFIG_PMP
+/******************************************************************************
+ * @brief kill a user task on a fault, an access out of its pmp entries or any
+ * other exception than a syscall
+ * @param exception cause
+ * @param address of the faulting instruction
+ * @param faulting address or instruction
+ * @return none
+ ******************************************************************************/
+void handle_user_fault(uint64_t cause, uint64_t epc, uint64_t tval) {
+  task_t *task = sched_get_current_task();
+
+  printk("task %d killed / mcause : %d mepc : 0x%lx mtval : 0x%lx\r\n",
+         task_get_tid(task), cause, epc, tval);
+
+  task_exit();
+}
+#endif
+
+#ifdef CONFIG_FPU
+extern void _ret_to_user();
+
+/******************************************************************************
+ * @brief load the floating point or vector context of the current task on its
+ * first instruction of the unit, any other illegal instruction is a fault
+ *
+ * A trap from user mode resumes at _ret_to_user, the instruction address is
+ * the one saved in the user frame at the top of the task stack.
+ *
+ * @param address of the instruction
+ * @return none
+ ******************************************************************************/
+void handle_illegal_instruction(uint64_t epc) {
+#ifdef CONFIG_PMP
+  task_t  *task = sched_get_current_task();
+  uint64_t frame;
+
+  if (epc == (uint64_t)&_ret_to_user) {
+    frame = (uint64_t)task->stack + task->stack_size - LWORD_SIZE -
+            USER_FRAME_LENGTH;
+    epc   = *(uint64_t *)(frame + USER_FRAME_MEPC);
+
+    if (fpu_trap(epc) != K_OK) {
+      handle_user_fault(MCAUSE_ILLEGAL_INSTRUCTION, epc, csr_read(mtval));
+    }
+    return;
+  }
+#endif
 
-  hang_processor();
+  if (fpu_trap(epc) != K_OK) {
+    handle_unknown_exception();
+  }
 }
+#endif
 
 /******************************************************************************
  * @brief handle unused syscalls
+ *
+ * A user task is killed as on a fault, only a kernel task panics.
+ *
  * @param syscall number
  * @return none
  ******************************************************************************/
 void sys_default(uint64_t arg1, uint64_t arg2, uint64_t arg3, uint64_t arg4,
                  uint64_t arg5, uint64_t arg6, uint64_t arg7,
                  uint64_t syscall_number) {
-  printk("syscall nb° %d is not implemented.\n ", syscall_number);
+#ifdef CONFIG_PMP
+  task_t *task = sched_get_current_task();
+
+  if (task->region != NULL) {
+    // a fast syscall parks ra in mscratch, it must be null again in machine
+    // mode as the task never returns
+    csr_write(mscratch, 0);
+
+    printk("task %d killed / syscall nb° %d is not implemented\r\n",
+           task_get_tid(task), syscall_number);
+
+    task_exit();
+  }
+#endif
 
-  hang_processor();
+  panic("syscall nb° %d is not implemented.\n ", syscall_number);
 }
@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "vm.h"
+
+#include "buddy.h"
+#include "registers.h"
+#include "smp.h"
+
+#ifdef CONFIG_VM
+
+#define VM_LEVELS         3
+#define VM_LEVEL_BITS     9
+#define VM_LEVEL_ENTRIES  (1UL << VM_LEVEL_BITS)
+#define VM_LEVEL_SHIFT(l) (PAGE_SHIFT + (l) * VM_LEVEL_BITS)
+#define VM_LEVEL_SIZE(l)  (1UL << VM_LEVEL_SHIFT(l))
+
+#define VM_PTE_LEAF  (PTE_R | PTE_W | PTE_X)
+#define VM_PTE_USER  (PTE_V | PTE_U | PTE_A | PTE_D)
+#define VM_PTE_TEXT  (VM_PTE_USER | PTE_R | PTE_X)
+#define VM_PTE_DATA  (VM_PTE_USER | PTE_R | PTE_W)
+#define VM_PTE_TABLE PTE_V
+
+/*******************************************************************************
+ * @struct vm_hart_t
+ * @brief address space last set on a hart and generations of the translations
+ * it may hold for each asid
+ ******************************************************************************/
+typedef struct vm_hart_t {
+  uint32_t vms_id;
+  uint64_t generation[CONFIG_VM_SPACE_MAX_NB];
+} __attribute__((aligned(CACHE_LINE_SIZE))) vm_hart_t;
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+// the space n + 1 is saved in slot n, 0 is the identifier of the kernel tasks
+static vm_space_t vm_spaces[CONFIG_VM_SPACE_MAX_NB];
+static uint32_t   vm_nb_spaces = 0;
+
+static vm_hart_t vm_harts[CONFIG_HART_MAX_NB];
+
+// the harts tag their translations with the space identifiers
+static bool vm_asid = false;
+
+/******************************************************************************
+ * @brief flush the translations of an address space on the current hart
+ * @param asid, 0 if the harts don't tag their translations
+ * @return none
+ ******************************************************************************/
+static inline void vm_flush(uint64_t asid) {
+  __asm__ volatile("sfence.vma zero, %0" : : "r"(asid) : "memory");
+}
+
+/******************************************************************************
+ * @brief allocate an empty page table
+ * @param none
+ * @return page table, or NULL if the heap is full
+ ******************************************************************************/
+static uint64_t *vm_table_alloc() {
+  uint64_t *table = buddy_alloc(buddy_order(PAGE_SIZE));
+
+  if (table != NULL) {
+    for (uint64_t index = 0; index < VM_LEVEL_ENTRIES; index++) {
+      table[index] = 0;
+    }
+  }
+
+  return table;
+}
+
+/******************************************************************************
+ * @brief find the entry of an address at a given level of a page table
+ * @param address space
+ * @param virtual address
+ * @param level of the entry, 0 for a 4K page
+ * @param allocate the missing tables
+ * @return entry, or NULL if a table is missing or a larger page holds the
+ * address
+ ******************************************************************************/
+static uint64_t *vm_walk(vm_space_t *space, uint64_t addr, uint8_t level,
+                         bool alloc) {
+  uint64_t *table = space->root;
+  uint64_t *pte;
+  uint64_t *next;
+
+  for (uint8_t l = VM_LEVELS - 1; l > level; l--) {
+    pte = &table[(addr >> VM_LEVEL_SHIFT(l)) & (VM_LEVEL_ENTRIES - 1)];
+
+    if (*pte & VM_PTE_LEAF) {
+      return NULL;
+    }
+
+    if (!(*pte & PTE_V)) {
+      if (!alloc || (next = vm_table_alloc()) == NULL) {
+        return NULL;
+      }
+      *pte = ((uint64_t)next >> PAGE_SHIFT) << PTE_PPN_SHIFT | VM_PTE_TABLE;
+    }
+
+    table = (uint64_t *)((*pte >> PTE_PPN_SHIFT) << PAGE_SHIFT);
+  }
+
+  return &table[(addr >> VM_LEVEL_SHIFT(level)) & (VM_LEVEL_ENTRIES - 1)];
+}
+
+/******************************************************************************
+ * @brief get the level of the largest page starting at an address and held
+ * by a range
+ * @param start address of the range
+ * @param end address of the range
+ * @return page level, 0 for a 4K page
+ ******************************************************************************/
+static uint8_t vm_page_level(uint64_t start, uint64_t end) {
+  uint8_t level = VM_LEVELS - 1;
+
+  while (level > 0 && ((start & (VM_LEVEL_SIZE(level) - 1)) ||
+                       end - start < VM_LEVEL_SIZE(level))) {
+    level--;
+  }
+
+  return level;
+}
+
+/******************************************************************************
+ * @brief unmap a range mapped by vm_map(), the page tables are kept
+ * @param address space
+ * @param start address, page aligned
+ * @param end address, page aligned
+ * @return none
+ ******************************************************************************/
+static void vm_unmap(vm_space_t *space, uint64_t start, uint64_t end) {
+  uint64_t *pte;
+  uint8_t   level;
+
+  while (start < end) {
+    level = vm_page_level(start, end);
+
+    pte = vm_walk(space, start, level, false);
+    if (pte != NULL) {
+      *pte = 0;
+    }
+
+    start += VM_LEVEL_SIZE(level);
+  }
+}
+
+/******************************************************************************
+ * @brief map a range to the same physical addresses
+ *
+ * The range is mapped with the largest pages it can hold, 1G, 2M or 4K, so a
+ * region set only takes a few entries of the tlb.
+ *
+ * @param address space
+ * @param start address, page aligned
+ * @param end address, page aligned
+ * @param entry flags
+ * @return K_OK, or K_ERROR if the heap is full or a page is already mapped
+ ******************************************************************************/
+static k_return_t vm_map(vm_space_t *space, uint64_t start, uint64_t end,
+                         uint64_t flags) {
+  uint64_t  addr = start;
+  uint64_t *pte;
+  uint8_t   level;
+
+  while (addr < end) {
+    level = vm_page_level(addr, end);
+
+    pte = vm_walk(space, addr, level, true);
+    if (pte == NULL || (*pte & PTE_V)) {
+      // vm_unmap() finds the same pages in the part already mapped
+      vm_unmap(space, start, addr);
+      return K_ERROR;
+    }
+
+    *pte = (addr >> PAGE_SHIFT) << PTE_PPN_SHIFT | flags;
+    addr += VM_LEVEL_SIZE(level);
+  }
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief check a range is page aligned
+ * @param start address
+ * @param end address
+ * @return true if both ends are page aligned
+ ******************************************************************************/
+static inline bool vm_is_aligned(uint64_t start, uint64_t end) {
+  return !((start | end) & (PAGE_SIZE - 1)) && start <= end;
+}
+
+/******************************************************************************
+ * @brief get the address space of a region set, it's built on first use
+ *
+ * The caller must hold the kernel lock.
+ *
+ * @param region set
+ * @return address space identifier, or 0 if the space can't be built
+ ******************************************************************************/
+static uint32_t vm_space_get(task_region_t *region) {
+  vm_space_t *space;
+  uint64_t    asid;
+
+  for (uint32_t index = 0; index < vm_nb_spaces; index++) {
+    if (vm_spaces[index].region == region) {
+      return index + 1;
+    }
+  }
+
+  if (vm_nb_spaces == CONFIG_VM_SPACE_MAX_NB ||
+      !vm_is_aligned(region->text_start, region->text_end) ||
+      !vm_is_aligned(region->data_start, region->data_end)) {
+    return 0;
+  }
+
+  space       = &vm_spaces[vm_nb_spaces];
+  space->root = vm_table_alloc();
+  if (space->root == NULL) {
+    return 0;
+  }
+
+  // the tables of a region set which can't be mapped are not given back, its
+  // slot is used by the next space
+  if (vm_map(space, region->text_start, region->text_end, VM_PTE_TEXT) !=
+          K_OK ||
+      vm_map(space, region->data_start, region->data_end, VM_PTE_DATA) !=
+          K_OK) {
+    return 0;
+  }
+
+  // the identifier is the asid, the translations of each space are kept in
+  // the tlb across switches
+  vm_nb_spaces += 1;
+  asid = vm_asid ? vm_nb_spaces : 0;
+
+  space->region     = region;
+  space->generation = 1;
+  space->satp       = SATP_MODE_SV39 | asid << SATP_ASID_SHIFT |
+                ((uint64_t)space->root >> PAGE_SHIFT);
+
+  return vm_nb_spaces;
+}
+
+/******************************************************************************
+ * @brief find out if the harts can tag their translations with the address
+ * space identifiers
+ *
+ * The asid bits which can't be set read as zero, satp doesn't translate the
+ * machine mode accesses so any root can be written.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void vm_init() {
+  uint64_t asid_max;
+
+  csr_write(satp, SATP_MODE_SV39 | SATP_ASID_MASK << SATP_ASID_SHIFT);
+  asid_max = (csr_read(satp) >> SATP_ASID_SHIFT) & SATP_ASID_MASK;
+  csr_write(satp, 0);
+
+  vm_asid = asid_max >= CONFIG_VM_SPACE_MAX_NB;
+}
+
+/******************************************************************************
+ * @brief map the user part of a task stack in the address space of its region
+ * set
+ * @param region set of the task
+ * @param stack start address of the task
+ * @param stack size in bytes
+ * @return address space identifier, or 0 if the space table or the heap is
+ * full or the ranges are not valid
+ ******************************************************************************/
+uint32_t vm_map_stack(task_region_t *region, void *stack, uint64_t stack_size) {
+  uint64_t    start = (uint64_t)stack;
+  uint64_t    end   = start + stack_size - USER_KERNEL_STACK_SIZE;
+  uint64_t    flags = smp_lock();
+  uint32_t    id    = vm_space_get(region);
+  vm_space_t *space;
+
+  if (id != 0) {
+    space = &vm_spaces[id - 1];
+
+    if (!vm_is_aligned(start, end) ||
+        vm_map(space, start, end, VM_PTE_DATA) != K_OK) {
+      id = 0;
+    }
+
+    // the hart may have cached the pages as invalid
+    space->generation += 1;
+  }
+
+  smp_unlock(flags);
+
+  return id;
+}
+
+/******************************************************************************
+ * @brief unmap a stack mapped by vm_map_stack()
+ * @param address space identifier
+ * @param stack start address of the task
+ * @param stack size in bytes
+ * @return none
+ ******************************************************************************/
+void vm_unmap_stack(uint32_t id, void *stack, uint64_t stack_size) {
+  vm_space_t *space = &vm_spaces[id - 1];
+  uint64_t    start = (uint64_t)stack;
+  uint64_t    flags = smp_lock();
+
+  vm_unmap(space, start, start + stack_size - USER_KERNEL_STACK_SIZE);
+  space->generation += 1;
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief switch to the address space of the task elected on a hart
+ *
+ * Each space has its own asid, the translations of the other spaces stay in
+ * the tlb and a switch doesn't flush anything unless the mappings of the space
+ * have changed. When the harts don't have enough asid bits, all spaces share
+ * the asid 0 and a switch to an another space flushes the tlb.
+ *
+ * @param hart running the task
+ * @param task elected
+ * @return none
+ ******************************************************************************/
+void vm_switch(uint64_t hart, task_t *task) {
+  vm_hart_t  *cache = &vm_harts[hart];
+  uint32_t    id    = task->task_id.vms_id;
+  vm_space_t *space;
+
+  if (id == 0) {
+    return;
+  }
+
+  space = &vm_spaces[id - 1];
+
+  if (cache->vms_id == id && cache->generation[id - 1] == space->generation) {
+    return;
+  }
+
+  csr_write(satp, space->satp);
+
+  if (!vm_asid || cache->generation[id - 1] != space->generation) {
+    vm_flush((space->satp >> SATP_ASID_SHIFT) & SATP_ASID_MASK);
+    cache->generation[id - 1] = space->generation;
+  }
+
+  cache->vms_id = id;
+}
+
+#endif
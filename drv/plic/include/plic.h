@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef PLIC_H
+#define PLIC_H
+
+#include "common.h"
+
+/******************************************************************************
+ * Definitions
+ ******************************************************************************/
+#define PLIC_BASE_ADDR        0x0c000000
+#define PLIC_PRIORITY_OFFSET  0x0
+#define PLIC_ENABLE_OFFSET    0x2000
+#define PLIC_THRESHOLD_OFFSET 0x200000
+#define PLIC_CLAIM_OFFSET     0x200004
+
+// hart 0 machine mode context
+#define PLIC_CONTEXT        0
+#define PLIC_ENABLE_STRIDE  0x80
+#define PLIC_CONTEXT_STRIDE 0x1000
+#define PLIC_MAX_PRIORITY   7
+#define PLIC_MIN_PRIORITY   1
+
+/******************************************************************************
+ * @brief initialize the plic and route external interrupts to the kernel
+ * @param None
+ * @return None
+ ******************************************************************************/
+void plic_init();
+
+/******************************************************************************
+ * @brief set the priority threshold of the hart
+ *
+ * Sources with a priority lower or equal to the threshold are not signaled to
+ * the hart.
+ *
+ * @param threshold from 0 (all sources) to PLIC_MAX_PRIORITY (none)
+ * @return None
+ ******************************************************************************/
+void plic_set_threshold(uint32_t);
+
+#endif
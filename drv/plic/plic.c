@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "plic.h"
+
+#include "interrupt.h"
+#include "irq_arch.h"
+
+#define PLIC_PRIORITY_ADDR(_source) \
+  (PLIC_BASE_ADDR + PLIC_PRIORITY_OFFSET + 4 * (_source))
+#define PLIC_ENABLE_ADDR(_source)                                            \
+  (PLIC_BASE_ADDR + PLIC_ENABLE_OFFSET + PLIC_CONTEXT * PLIC_ENABLE_STRIDE + \
+   4 * ((_source) / 32))
+#define PLIC_THRESHOLD_ADDR \
+  (PLIC_BASE_ADDR + PLIC_THRESHOLD_OFFSET + PLIC_CONTEXT * PLIC_CONTEXT_STRIDE)
+#define PLIC_CLAIM_ADDR \
+  (PLIC_BASE_ADDR + PLIC_CLAIM_OFFSET + PLIC_CONTEXT * PLIC_CONTEXT_STRIDE)
+
+/******************************************************************************
+ * @brief set or clear the enable bit of a source for the hart context
+ * @param source number
+ * @param true to enable the source
+ * @return None
+ ******************************************************************************/
+static void plic_set_enable(uint32_t source, bool enable) {
+  uint32_t mask  = 1U << (source % 32);
+  uint32_t value = reg_read_word(PLIC_ENABLE_ADDR(source));
+
+  if (enable) {
+    value |= mask;
+  } else {
+    value &= ~mask;
+  }
+
+  reg_write_word(PLIC_ENABLE_ADDR(source), value);
+}
+
+/******************************************************************************
+ * @brief attach a source, its priority follows the task priority
+ *
+ * The 256 task priorities are spread on the 7 plic priorities so a source
+ * attached to a higher priority task is never served after a source attached
+ * to a lower priority task.
+ *
+ * @param source number
+ * @param priority of the attached task
+ * @return None
+ ******************************************************************************/
+static void plic_enable(uint32_t source, uint8_t prio) {
+  uint32_t priority =
+      PLIC_MIN_PRIORITY +
+      (prio * (PLIC_MAX_PRIORITY - PLIC_MIN_PRIORITY)) / 255;
+
+  reg_write_word(PLIC_PRIORITY_ADDR(source), priority);
+  plic_set_enable(source, true);
+}
+
+/******************************************************************************
+ * @brief detach a source, a null priority never interrupts the hart
+ * @param source number
+ * @return None
+ ******************************************************************************/
+static void plic_disable(uint32_t source) {
+  plic_set_enable(source, false);
+  reg_write_word(PLIC_PRIORITY_ADDR(source), 0);
+}
+
+/******************************************************************************
+ * @brief mask a source until its task waits for it again
+ * @param source number
+ * @return None
+ ******************************************************************************/
+static void plic_mask(uint32_t source) {
+  plic_set_enable(source, false);
+}
+
+/******************************************************************************
+ * @brief unmask a source masked by plic_mask()
+ * @param source number
+ * @return None
+ ******************************************************************************/
+static void plic_unmask(uint32_t source) {
+  plic_set_enable(source, true);
+}
+
+/******************************************************************************
+ * @brief claim the highest priority pending source
+ * @param None
+ * @return source number, 0 if no source is pending
+ ******************************************************************************/
+static uint32_t plic_claim() {
+  return reg_read_word(PLIC_CLAIM_ADDR);
+}
+
+/******************************************************************************
+ * @brief signal the end of a source handling
+ * @param source number
+ * @return None
+ ******************************************************************************/
+static void plic_complete(uint32_t source) {
+  reg_write_word(PLIC_CLAIM_ADDR, source);
+}
+
+/******************************************************************************
+ * @brief get the interrupt level of a source, its plic priority
+ * @param source number
+ * @return priority of the source
+ ******************************************************************************/
+static uint32_t plic_level(uint32_t source) {
+  return reg_read_word(PLIC_PRIORITY_ADDR(source));
+}
+
+/******************************************************************************
+ * plic operations used by the kernel to route external interrupts, the
+ * interrupt level of the hart is its threshold
+ ******************************************************************************/
+static const irq_controller_t plic_controller = {
+    .enable    = plic_enable,
+    .disable   = plic_disable,
+    .mask      = plic_mask,
+    .unmask    = plic_unmask,
+    .claim     = plic_claim,
+    .complete  = plic_complete,
+    .level     = plic_level,
+    .set_level = plic_set_threshold,
+};
+
+/******************************************************************************
+ * @brief set the priority threshold of the hart
+ * @param threshold from 0 (all sources) to PLIC_MAX_PRIORITY (none)
+ * @return None
+ ******************************************************************************/
+void plic_set_threshold(uint32_t threshold) {
+  reg_write_word(PLIC_THRESHOLD_ADDR, threshold);
+}
+
+/******************************************************************************
+ * @brief initialize the plic and route external interrupts to the kernel
+ * @param None
+ * @return None
+ ******************************************************************************/
+void plic_init() {
+  // all sources are detached until a task requests them
+  for (uint32_t source = 1; source < INTERRUPT_NB_EXTERNAL; source++) {
+    plic_disable(source);
+  }
+
+  plic_set_threshold(0);
+
+  interrupt_set_controller(&plic_controller);
+}
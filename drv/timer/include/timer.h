@@ -17,13 +17,79 @@
 #ifndef TIMER_H
 #define TIMER_H
 
+#include "common.h"
+#include "timer_arch.h"
+
 #define ONE_MS_IN_US     1000UL
 #define ONE_SECOND_IN_US 1000000UL
 
-#define TIMER_TASK_PRIORITY 254
-
-#define ARCH_TIMER_RATE 10000000UL
+#define ARCH_TIMER_RATE TIMER_ARCH_RATE
 
 #define time_t uint64_t
 
+/******************************************************************************
+ * @brief read the monotonic clock in nanoseconds
+ * @param None
+ * @return time since boot in ns
+ ******************************************************************************/
+static inline time_t clock_get_ns() {
+  return timer_arch_get_time() * TIMER_ARCH_NS_PER_TICK;
+}
+
+/******************************************************************************
+ * @brief read the monotonic clock in microseconds
+ * @param None
+ * @return time since boot in us
+ ******************************************************************************/
+static inline time_t clock_get_us() {
+  return timer_arch_ticks_to_us(timer_arch_get_time());
+}
+
+/******************************************************************************
+ * @brief compute a deadline from now
+ *
+ * Deadlines are absolute dates in us since boot, they can be given to
+ * ax_task_sleep_until().
+ *
+ * @param duration before the deadline in us
+ * @return deadline in us since boot
+ ******************************************************************************/
+static inline time_t clock_deadline(time_t duration_in_us) {
+  return clock_get_us() + duration_in_us;
+}
+
+/******************************************************************************
+ * @brief check if a deadline is reached
+ * @param deadline in us since boot
+ * @return true if the deadline is reached
+ ******************************************************************************/
+static inline bool clock_deadline_reached(time_t deadline_in_us) {
+  return clock_get_us() >= deadline_in_us;
+}
+
+/******************************************************************************
+ * @brief compute the time left before a deadline
+ * @param deadline in us since boot
+ * @return time left in us, 0 if the deadline is reached
+ ******************************************************************************/
+static inline time_t clock_time_left(time_t deadline_in_us) {
+  time_t now = clock_get_us();
+
+  return (deadline_in_us > now) ? deadline_in_us - now : 0;
+}
+
+/******************************************************************************
+ * @brief set a timer which wakes up the calling task
+ * @param time duration before the timer will fire in us
+ * @return None
+ ******************************************************************************/
+void timer_set(time_t);
+
+/******************************************************************************
+ * @brief read the monotonic clock from the processor
+ * @param None
+ * @return monotonic clock in us
+ ******************************************************************************/
+time_t clock_get();
+
 #endif
\ No newline at end of file
@@ -17,31 +17,33 @@
 
 #include "timer.h"
 
-#include "app.h"
-#include "ax_syscall.h"
 #include "irq_arch.h"
-#include "printf.h"
+#include "ktimer.h"
 #include "sched.h"
 #include "task.h"
+#include "timer_arch.h"
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
-stack_t timer_driver_stack;
-task_t* task_handler;
+static bool timer_expire(ktimer_t* timer);
+
+task_t*  task_handler;
+ktimer_t timer_driver_timer = KTIMER_INIT(timer_expire);
 
 /******************************************************************************
- * @brief Initialization of the uart peripheral
- * @param None
- * @return None
+ * @brief top half of the timer, wake up the registered task
+ *
+ * Runs in the timer interrupt context: the registered task is directly woken
+ * up without any intermediate driver task.
+ *
+ * @param driver kernel timer
+ * @return true if the registered task has to preempt the current one
  ******************************************************************************/
-void timer_driver_handler() {
-  while (1) {
-    // get this task to sleep, it will be wake up by the interrupt
-    ax_task_sleep();
+static bool timer_expire(ktimer_t* timer) {
+  task_wakeup(task_handler);
 
-    ax_task_wakeup(task_handler);
-  }
+  return task_handler->prio > sched_get_current_task()->prio;
 }
 
 /******************************************************************************
@@ -53,12 +55,10 @@ void timer_set(time_t time_in_us) {
   // register the task to wake up with the timer
   task_handler = sched_get_current_task();
 
-  // set the timer
-  uint64_t timer_period_in_s = 1;
-  reg_write_double_word(TIMER_MTIMECMP_ADDR, time_in_us * ARCH_TIMER_RATE);
-
-  // enable the interrupt in csr register
-  ax_interrupt_request(TIMER_INTERRUPT);
+  // the machine timer is shared through the kernel timers, a pending
+  // timer is re-armed with the new duration
+  ktimer_start(&timer_driver_timer,
+               timer_arch_get_time() + time_in_us * TIMER_ARCH_TICKS_PER_US);
 }
 
 /******************************************************************************
@@ -67,10 +67,5 @@ void timer_set(time_t time_in_us) {
  * @return monotonic clock in us
  ******************************************************************************/
 time_t clock_get() {
-  uint64_t clock_in_s =
-      reg_read_double_word(TIMER_MTIME_ADDR) / ARCH_TIMER_RATE;
-  return clock_in_s * ONE_SECOND_IN_US;
-}
-
-REGISTER_APP("timer_driver_task", timer_driver_handler, timer_driver_stack,
-             TIMER_TASK_PRIORITY);
\ No newline at end of file
+  return clock_get_us();
+}
\ No newline at end of file
@@ -14,6 +14,8 @@
  * the GNU Lesser General Public License along with this program.  If
  * not, see https://www.gnu.org/licenses/
  */
+#ifndef UART_H
+#define UART_H
 
 #include "common.h"
 
@@ -21,22 +23,78 @@
  * Definitions
  ******************************************************************************/
 #define UART_BASE_ADDR     0x10000000
+#define UART_LSR_OFFSET    5
 #define UART_LCR_OFFSET    3
+#define UART_IIR_OFFSET    2
 #define UART_FIFO_OFFSET   2
 #define UART_RCV_IT_OFFSET 1
 #define UART_RX_TX_OFFSET  0
 
+// interrupt enable register
+#define UART_IER_RX_READY (1 << 0)
+#define UART_IER_TX_EMPTY (1 << 1)
+
+// fifo control register
+#define UART_FCR_ENABLE   (1 << 0)
+#define UART_FCR_RX_CLEAR (1 << 1)
+#define UART_FCR_TX_CLEAR (1 << 2)
+
+// line control register, 8 data bits, no parity, 1 stop bit
+#define UART_LCR_8N1 ((1 << 0) | (1 << 1))
+
+// line status register
+#define UART_LSR_RX_READY (1 << 0)
+#define UART_LSR_TX_EMPTY (1 << 5)
+
+// the transmit fifo is written by bursts once it's empty
+#define UART_FIFO_DEPTH 16
+
+// plic source of the uart on the qemu virt platform
+#define UART_IRQ_SOURCE 10
+
 /******************************************************************************
  * @brief Initialization of the uart peripheral
+ *
+ * The uart is served by its interrupt once the interrupt controller is
+ * initialized, it's polled otherwise.
+ *
  * @param None
  * @return None
  ******************************************************************************/
 void uart_init();
 
+/******************************************************************************
+ * @brief copy data to the transmit buffer without waiting
+ *
+ * The buffer is sent by the uart interrupt, the bytes which don't fit in it
+ * are not written. Before the interrupt is attached, e.g. during the boot, or
+ * when the caller runs with interrupts disabled, e.g. a panic, the buffer is
+ * drained right away.
+ *
+ * @param pointer to data to send
+ * @param size of the data to send
+ * @return number of bytes written to the buffer
+ ******************************************************************************/
+uint64_t uart_write(const uint8_t *data, const uint64_t size);
+
 /******************************************************************************
  * @brief send data through the uart
+ *
+ * Wait for room in the transmit buffer until all the data is written to it,
+ * the data is sent once the function returns.
+ *
  * @param pointer to data to send
  * @param size of the data to send
  * @return None
  ******************************************************************************/
-void uart_send(const uint8_t *data, const uint64_t size);
\ No newline at end of file
+void uart_send(const uint8_t *data, const uint64_t size);
+
+/******************************************************************************
+ * @brief read the bytes received so far without waiting
+ * @param buffer to copy the bytes in
+ * @param size of the buffer
+ * @return number of bytes read, 0 if none has been received
+ ******************************************************************************/
+uint64_t uart_read(uint8_t *data, const uint64_t size);
+
+#endif
@@ -14,18 +14,245 @@
  * the GNU Lesser General Public License along with this program.  If
  * not, see https://www.gnu.org/licenses/
  */
-
 #include "uart.h"
 
+#include "interrupt.h"
+#include "irq_arch.h"
+#include "spinlock.h"
+
+#ifndef CONFIG_UART_TX_BUFFER_SIZE
+#define CONFIG_UART_TX_BUFFER_SIZE 4096
+#endif
+
+#ifndef CONFIG_UART_RX_BUFFER_SIZE
+#define CONFIG_UART_RX_BUFFER_SIZE 256
+#endif
+
+_Static_assert((CONFIG_UART_TX_BUFFER_SIZE &
+                (CONFIG_UART_TX_BUFFER_SIZE - 1)) == 0,
+               "the uart transmit buffer size must be a power of two");
+_Static_assert((CONFIG_UART_RX_BUFFER_SIZE &
+                (CONFIG_UART_RX_BUFFER_SIZE - 1)) == 0,
+               "the uart receive buffer size must be a power of two");
+
+// the uart is served after the sources attached to the tasks
+#define UART_IRQ_PRIO 0
+
+/******************************************************************************
+ * @struct uart_ring_t
+ * @brief bytes waiting to be sent or read, head and tail only increase
+ ******************************************************************************/
+typedef struct uart_ring_t {
+  uint64_t head;
+  uint64_t tail;
+  uint8_t *data;
+  uint64_t size;
+} uart_ring_t;
+
+static uint8_t uart_tx_data[CONFIG_UART_TX_BUFFER_SIZE];
+static uint8_t uart_rx_data[CONFIG_UART_RX_BUFFER_SIZE];
+
+static uart_ring_t uart_tx = {.data = uart_tx_data,
+                              .size = CONFIG_UART_TX_BUFFER_SIZE};
+static uart_ring_t uart_rx = {.data = uart_rx_data,
+                              .size = CONFIG_UART_RX_BUFFER_SIZE};
+
+// the rings are shared by the harts and the interrupt, taken with interrupts
+// disabled
+static spinlock_t uart_lock;
+
+// set once the interrupt is attached, the transmit interrupt is only enabled
+// while the transmit ring holds data
+static bool    uart_irq     = false;
+static uint8_t uart_ier     = 0;
+static bool    uart_tx_busy = false;
+
+/******************************************************************************
+ * @brief get the number of bytes in a ring
+ * @param ring to check
+ * @return number of bytes
+ ******************************************************************************/
+static inline uint64_t uart_ring_count(uart_ring_t *ring) {
+  return ring->head - ring->tail;
+}
+
+/******************************************************************************
+ * @brief take the uart lock
+ * @param None
+ * @return previous interrupt state
+ ******************************************************************************/
+static inline uint64_t uart_lock_take() {
+  uint64_t flags = irq_arch_disable();
+
+  spin_lock(&uart_lock);
+
+  return flags;
+}
+
+/******************************************************************************
+ * @brief release the uart lock
+ * @param previous interrupt state
+ * @return None
+ ******************************************************************************/
+static inline void uart_lock_give(uint64_t flags) {
+  spin_unlock(&uart_lock);
+  irq_arch_restore(flags);
+}
+
+/******************************************************************************
+ * @brief write the interrupt enable register
+ * @param interrupts to enable
+ * @return None
+ ******************************************************************************/
+static inline void uart_set_ier(uint8_t ier) {
+  if (ier != uart_ier) {
+    uart_ier = ier;
+    reg_write_byte(UART_BASE_ADDR, UART_RCV_IT_OFFSET, ier);
+  }
+}
+
+/******************************************************************************
+ * @brief fill the transmit fifo from the ring once it's empty
+ *
+ * The line status is read once per burst instead of once per byte.
+ *
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void uart_tx_fill() {
+  uint64_t nb = uart_ring_count(&uart_tx);
+
+  if (!nb ||
+      !(reg_read_byte(UART_BASE_ADDR, UART_LSR_OFFSET) & UART_LSR_TX_EMPTY)) {
+    return;
+  }
+
+  if (nb > UART_FIFO_DEPTH) {
+    nb = UART_FIFO_DEPTH;
+  }
+
+  while (nb--) {
+    reg_write_byte(UART_BASE_ADDR, UART_RX_TX_OFFSET,
+                   uart_tx.data[uart_tx.tail % uart_tx.size]);
+    uart_tx.tail += 1;
+  }
+}
+
+/******************************************************************************
+ * @brief move the received bytes from the fifo to the ring
+ *
+ * The bytes which don't fit in the ring are dropped.
+ *
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void uart_rx_drain() {
+  while (reg_read_byte(UART_BASE_ADDR, UART_LSR_OFFSET) & UART_LSR_RX_READY) {
+    uint8_t byte = reg_read_byte(UART_BASE_ADDR, UART_RX_TX_OFFSET);
+
+    if (uart_ring_count(&uart_rx) < uart_rx.size) {
+      uart_rx.data[uart_rx.head % uart_rx.size] = byte;
+      uart_rx.head += 1;
+    }
+  }
+}
+
+/******************************************************************************
+ * @brief serve the uart in the interrupt context
+ *
+ * The transmit interrupt is disabled once the ring is empty, the next write
+ * enables it again.
+ *
+ * @param uart interrupt identifier
+ * @return false, no task is attached to the uart
+ ******************************************************************************/
+static bool uart_top_half(interrupt_id_t interrupt_id) {
+  uint64_t flags;
+
+  (void)interrupt_id;
+
+  // the handler runs with interrupts enabled when nesting is configured
+  flags = uart_lock_take();
+
+  // reading the identification acknowledges the transmit interrupt
+  reg_read_byte(UART_BASE_ADDR, UART_IIR_OFFSET);
+
+  uart_rx_drain();
+  uart_tx_fill();
+
+  if (!uart_ring_count(&uart_tx)) {
+    uart_tx_busy = false;
+    uart_set_ier(UART_IER_RX_READY);
+  }
+
+  uart_lock_give(flags);
+
+  return false;
+}
+
 /******************************************************************************
  * @brief Initialization of the uart peripheral
  * @param None
  * @return None
  ******************************************************************************/
 void uart_init() {
-  reg_write_byte(UART_BASE_ADDR, UART_RCV_IT_OFFSET, (1 << 0));
-  reg_write_byte(UART_BASE_ADDR, UART_FIFO_OFFSET, (1 << 0));
-  reg_write_byte(UART_BASE_ADDR, UART_LCR_OFFSET, (1 << 0) | (1 << 1));
+  spin_init(&uart_lock);
+
+  reg_write_byte(UART_BASE_ADDR, UART_LCR_OFFSET, UART_LCR_8N1);
+  reg_write_byte(UART_BASE_ADDR, UART_FIFO_OFFSET,
+                 UART_FCR_ENABLE | UART_FCR_RX_CLEAR | UART_FCR_TX_CLEAR);
+
+  uart_irq = interrupt_attach(INTERRUPT_EXTERNAL_ID(UART_IRQ_SOURCE),
+                              uart_top_half, UART_IRQ_PRIO) == K_OK;
+
+  // received bytes are buffered by the interrupt
+  uart_ier = 0;
+  uart_set_ier(uart_irq ? UART_IER_RX_READY : 0);
+}
+
+/******************************************************************************
+ * @brief copy data to the transmit buffer without waiting
+ *
+ * A caller which runs with interrupts disabled waits for its data to be sent,
+ * the interrupt may not be served until it returns.
+ *
+ * @param pointer to data to send
+ * @param size of the data to send
+ * @return number of bytes written to the buffer
+ ******************************************************************************/
+uint64_t uart_write(const uint8_t *data, const uint64_t size) {
+  uint64_t flags = uart_lock_take();
+  uint64_t nb    = uart_tx.size - uart_ring_count(&uart_tx);
+
+  if (nb > size) {
+    nb = size;
+  }
+
+  for (uint64_t i = 0; i < nb; i++) {
+    uart_tx.data[uart_tx.head % uart_tx.size] = data[i];
+    uart_tx.head += 1;
+  }
+
+  if (!uart_irq || !flags) {
+    // without interrupt, e.g. during the boot or a panic, the data is sent
+    // before returning
+    while (uart_ring_count(&uart_tx)) {
+      uart_tx_fill();
+    }
+  } else if (!uart_tx_busy) {
+    // the interrupt refills the fifo while it's busy, the first burst is
+    // written here
+    uart_tx_fill();
+
+    if (uart_ring_count(&uart_tx)) {
+      uart_tx_busy = true;
+      uart_set_ier(UART_IER_RX_READY | UART_IER_TX_EMPTY);
+    }
+  }
+
+  uart_lock_give(flags);
+
+  return nb;
 }
 
 /******************************************************************************
@@ -35,11 +262,50 @@ void uart_init() {
  * @return None
  ******************************************************************************/
 void uart_send(const uint8_t *data, const uint64_t size) {
-  uint32_t byte_index = 0;
+  uint64_t written = 0;
+
+  while (written < size) {
+    uint64_t nb = uart_write(data + written, size - written);
+
+    // the ring is full, e.g. the interrupt is masked: serve it by polling
+    if (nb < size - written) {
+      uint64_t flags = uart_lock_take();
+
+      uart_tx_fill();
 
-  while (byte_index < size) {
-    reg_write_byte(UART_BASE_ADDR, UART_RX_TX_OFFSET, data[byte_index]);
+      uart_lock_give(flags);
+    }
 
-    byte_index += 1;
+    written += nb;
   }
-}
\ No newline at end of file
+}
+
+/******************************************************************************
+ * @brief read the bytes received so far without waiting
+ * @param buffer to copy the bytes in
+ * @param size of the buffer
+ * @return number of bytes read, 0 if none has been received
+ ******************************************************************************/
+uint64_t uart_read(uint8_t *data, const uint64_t size) {
+  uint64_t flags = uart_lock_take();
+  uint64_t nb;
+
+  // without interrupt the fifo is only read here
+  if (!uart_irq) {
+    uart_rx_drain();
+  }
+
+  nb = uart_ring_count(&uart_rx);
+  if (nb > size) {
+    nb = size;
+  }
+
+  for (uint64_t i = 0; i < nb; i++) {
+    data[i] = uart_rx.data[uart_rx.tail % uart_rx.size];
+    uart_rx.tail += 1;
+  }
+
+  uart_lock_give(flags);
+
+  return nb;
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "virtio_blk.h"
+
+#include "app.h"
+#include "ax_syscall.h"
+#include "interrupt.h"
+#include "printk.h"
+#include "virtio.h"
+
+#ifdef CONFIG_VIRTIO_BLK
+
+#define VIRTIO_BLK_PRIO  20
+#define VIRTIO_BLK_QUEUE 0
+
+// request types of the device
+#define VIRTIO_BLK_T_IN  0
+#define VIRTIO_BLK_T_OUT 1
+
+#define VIRTIO_BLK_S_OK 0
+
+// capacity in sectors, the first field of the configuration
+#define VIRTIO_BLK_CONFIG_CAPACITY 0
+
+#define VIRTIO_BLK_MSG_WORDS 4
+
+/******************************************************************************
+ * @struct virtio_blk_req_t
+ * @brief header of a request, read by the device
+ ******************************************************************************/
+typedef struct virtio_blk_req_t {
+  uint32_t type;
+  uint32_t reserved;
+  uint64_t sector;
+} virtio_blk_req_t;
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t virtio_blk_stack;
+
+static virtio_dev_t virtio_blk_dev;
+static virtq_mem_t  virtio_blk_mem;
+static virtq_t      virtio_blk_queue;
+static uint64_t     virtio_blk_capacity;
+
+static virtio_blk_req_t virtio_blk_req;
+static uint8_t          virtio_blk_status;
+
+// the requests are served with an error when there is no device
+REGISTER_CHANNEL(virtio_blk_channel, "virtio_blk")
+
+/******************************************************************************
+ * @brief set up the device
+ * @param none
+ * @return K_OK, or K_ERROR if there is no device or it can't be set up
+ ******************************************************************************/
+static k_return_t virtio_blk_init() {
+  if (virtio_find(VIRTIO_ID_BLK, &virtio_blk_dev) != K_OK ||
+      virtio_setup(&virtio_blk_dev, VIRTIO_F_EVENT_IDX) != K_OK) {
+    return K_ERROR;
+  }
+
+  virtq_setup(&virtio_blk_queue, &virtio_blk_mem,
+              virtio_blk_dev.features & VIRTIO_F_EVENT_IDX);
+  if (virtq_attach(&virtio_blk_dev, &virtio_blk_queue, VIRTIO_BLK_QUEUE) !=
+      K_OK) {
+    return K_ERROR;
+  }
+
+  virtio_blk_capacity =
+      virtio_config_read(&virtio_blk_dev, VIRTIO_BLK_CONFIG_CAPACITY) |
+      (uint64_t)virtio_config_read(&virtio_blk_dev,
+                                   VIRTIO_BLK_CONFIG_CAPACITY + 4)
+          << 32;
+
+  virtio_ready(&virtio_blk_dev);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief transfer sectors between the device and the buffer of a client
+ *
+ * The data descriptor points to the client buffer, the task waits for the
+ * interrupt of the request. A request which is completed before the
+ * interrupt is armed is taken without waiting.
+ *
+ * @param VIRTIO_BLK_T_IN or VIRTIO_BLK_T_OUT
+ * @param first sector
+ * @param buffer of the client
+ * @param length in bytes, a multiple of the sector size
+ * @return K_OK, or K_ERROR if the request is not valid or fails
+ ******************************************************************************/
+static k_return_t virtio_blk_transfer(uint32_t type, uint64_t sector,
+                                      void *buffer, uint64_t len) {
+  interrupt_id_t interrupt_id =
+      INTERRUPT_EXTERNAL_ID(virtio_blk_dev.irq_source);
+  virtq_buf_t chain[3];
+  void       *token;
+  uint32_t    used_len;
+
+  if (buffer == NULL || !len || len % VIRTIO_BLK_SECTOR_SIZE ||
+      sector + len / VIRTIO_BLK_SECTOR_SIZE > virtio_blk_capacity) {
+    return K_ERROR;
+  }
+
+  virtio_blk_req.type     = type;
+  virtio_blk_req.reserved = 0;
+  virtio_blk_req.sector   = sector;
+  virtio_blk_status       = 0xFF;
+
+  chain[0] = (virtq_buf_t){&virtio_blk_req, sizeof(virtio_blk_req), false};
+  chain[1] = (virtq_buf_t){buffer, len, type == VIRTIO_BLK_T_IN};
+  chain[2] = (virtq_buf_t){&virtio_blk_status, sizeof(virtio_blk_status),
+                           true};
+
+  if (virtq_add(&virtio_blk_queue, chain, 3, buffer) != K_OK) {
+    return K_ERROR;
+  }
+  virtq_kick(&virtio_blk_queue);
+
+  while (!virtq_get_used(&virtio_blk_queue, &token, &used_len)) {
+    if (virtq_arm(&virtio_blk_queue)) {
+      continue;
+    }
+
+    ax_interrupt_wait(interrupt_id);
+    virtio_ack(&virtio_blk_dev);
+  }
+
+  return virtio_blk_status == VIRTIO_BLK_S_OK ? K_OK : K_ERROR;
+}
+
+/******************************************************************************
+ * @brief serve a request of a client
+ * @param request
+ * @param request length in bytes
+ * @param reply, the first word is set by the caller
+ * @return status of the request
+ ******************************************************************************/
+static k_return_t virtio_blk_request(uint64_t *msg, uint64_t len,
+                                     uint64_t *reply) {
+  if (len < sizeof(uint64_t)) {
+    return K_ERROR;
+  }
+
+  if (msg[0] == VIRTIO_BLK_INFO) {
+    reply[1] = virtio_blk_capacity;
+    return K_OK;
+  }
+
+  if (len < VIRTIO_BLK_MSG_WORDS * sizeof(uint64_t)) {
+    return K_ERROR;
+  }
+
+  switch (msg[0]) {
+    case VIRTIO_BLK_READ:
+      return virtio_blk_transfer(VIRTIO_BLK_T_IN, msg[1], (void *)msg[2],
+                                 msg[3]);
+    case VIRTIO_BLK_WRITE:
+      return virtio_blk_transfer(VIRTIO_BLK_T_OUT, msg[1], (void *)msg[2],
+                                 msg[3]);
+    default:
+      return K_ERROR;
+  }
+}
+
+/******************************************************************************
+ * @brief serve the requests of the clients, one at a time
+ * @param none
+ * @return none
+ ******************************************************************************/
+static void virtio_blk_run(void) {
+  uint64_t msg[VIRTIO_BLK_MSG_WORDS];
+  uint64_t reply[2] = {0};
+  uint64_t len;
+  bool     ready = virtio_blk_init() == K_OK;
+
+  if (ready) {
+    ax_interrupt_request(INTERRUPT_EXTERNAL_ID(virtio_blk_dev.irq_source));
+  } else {
+    printk("virtio-blk: no device\r\n");
+  }
+
+  // there is no caller yet, only wait for the first request
+  len = sizeof(msg);
+  ax_channel_reply_wait(virtio_blk_channel.handler, reply, 0, msg, &len);
+
+  while (true) {
+    reply[0] = ready ? virtio_blk_request(msg, len, reply) : K_ERROR;
+
+    len = sizeof(msg);
+    ax_channel_reply_wait(virtio_blk_channel.handler, reply, sizeof(reply),
+                          msg, &len);
+  }
+}
+
+REGISTER_APP_ON("virtio_blk", virtio_blk_run, virtio_blk_stack,
+                VIRTIO_BLK_PRIO, 0)
+
+#endif
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef VIRTIO_H
+#define VIRTIO_H
+
+#include "common.h"
+#include "processor.h"
+#include "stddef.h"
+
+#ifndef CONFIG_VIRTIO_QUEUE_SIZE
+#define CONFIG_VIRTIO_QUEUE_SIZE 64
+#endif
+
+/******************************************************************************
+ * virtio mmio transports of the qemu virt platform, slot n is served by the
+ * plic source n + 1
+ ******************************************************************************/
+#define VIRTIO_MMIO_BASE_ADDR   0x10001000
+#define VIRTIO_MMIO_STRIDE      0x1000
+#define VIRTIO_MMIO_NB          8
+#define VIRTIO_MMIO_IRQ_SOURCE  1
+#define VIRTIO_MMIO_MAGIC_VALUE 0x74726976
+
+// registers of the transport, the legacy ones are only used by version 1
+#define VIRTIO_MMIO_MAGIC               0x000
+#define VIRTIO_MMIO_VERSION             0x004
+#define VIRTIO_MMIO_DEVICE_ID           0x008
+#define VIRTIO_MMIO_DEVICE_FEATURES     0x010
+#define VIRTIO_MMIO_DEVICE_FEATURES_SEL 0x014
+#define VIRTIO_MMIO_DRIVER_FEATURES     0x020
+#define VIRTIO_MMIO_DRIVER_FEATURES_SEL 0x024
+#define VIRTIO_MMIO_GUEST_PAGE_SIZE     0x028
+#define VIRTIO_MMIO_QUEUE_SEL           0x030
+#define VIRTIO_MMIO_QUEUE_NUM_MAX       0x034
+#define VIRTIO_MMIO_QUEUE_NUM           0x038
+#define VIRTIO_MMIO_QUEUE_ALIGN         0x03c
+#define VIRTIO_MMIO_QUEUE_PFN           0x040
+#define VIRTIO_MMIO_QUEUE_READY         0x044
+#define VIRTIO_MMIO_QUEUE_NOTIFY        0x050
+#define VIRTIO_MMIO_INTERRUPT_STATUS    0x060
+#define VIRTIO_MMIO_INTERRUPT_ACK       0x064
+#define VIRTIO_MMIO_STATUS              0x070
+#define VIRTIO_MMIO_QUEUE_DESC_LOW      0x080
+#define VIRTIO_MMIO_QUEUE_DESC_HIGH     0x084
+#define VIRTIO_MMIO_QUEUE_AVAIL_LOW     0x090
+#define VIRTIO_MMIO_QUEUE_AVAIL_HIGH    0x094
+#define VIRTIO_MMIO_QUEUE_USED_LOW      0x0a0
+#define VIRTIO_MMIO_QUEUE_USED_HIGH     0x0a4
+#define VIRTIO_MMIO_CONFIG              0x100
+
+// device status
+#define VIRTIO_STATUS_ACKNOWLEDGE (1 << 0)
+#define VIRTIO_STATUS_DRIVER      (1 << 1)
+#define VIRTIO_STATUS_DRIVER_OK   (1 << 2)
+#define VIRTIO_STATUS_FEATURES_OK (1 << 3)
+#define VIRTIO_STATUS_FAILED      (1 << 7)
+
+// device types
+#define VIRTIO_ID_NET 1
+#define VIRTIO_ID_BLK 2
+
+// features common to all devices
+#define VIRTIO_F_ANY_LAYOUT (1UL << 27)
+#define VIRTIO_F_EVENT_IDX  (1UL << 29)
+#define VIRTIO_F_VERSION_1  (1UL << 32)
+
+// interrupt status
+#define VIRTIO_INT_USED   (1 << 0)
+#define VIRTIO_INT_CONFIG (1 << 1)
+
+// descriptor flags
+#define VIRTQ_DESC_F_NEXT  (1 << 0)
+#define VIRTQ_DESC_F_WRITE (1 << 1)
+
+// ring flags, only used when the event indexes are not negotiated
+#define VIRTQ_AVAIL_F_NO_INTERRUPT (1 << 0)
+#define VIRTQ_USED_F_NO_NOTIFY     (1 << 0)
+
+// end of the free descriptor list
+#define VIRTQ_NO_DESC 0xFFFF
+
+_Static_assert((CONFIG_VIRTIO_QUEUE_SIZE & (CONFIG_VIRTIO_QUEUE_SIZE - 1)) ==
+                   0,
+               "the virtqueue size must be a power of two");
+
+/******************************************************************************
+ * @struct virtq_desc_t
+ * @brief buffer given to the device, chained with next
+ ******************************************************************************/
+typedef struct virtq_desc_t {
+  uint64_t addr;
+  uint32_t len;
+  uint16_t flags;
+  uint16_t next;
+} virtq_desc_t;
+
+/******************************************************************************
+ * @struct virtq_avail_t
+ * @brief chains given to the device, used_event is the used index at which
+ * the driver wants to be interrupted
+ ******************************************************************************/
+typedef struct virtq_avail_t {
+  uint16_t flags;
+  uint16_t idx;
+  uint16_t ring[CONFIG_VIRTIO_QUEUE_SIZE];
+  uint16_t used_event;
+} virtq_avail_t;
+
+/******************************************************************************
+ * @struct virtq_used_t
+ * @brief chains given back by the device, avail_event is the available index
+ * at which the device wants to be notified
+ ******************************************************************************/
+typedef struct virtq_used_elem_t {
+  uint32_t id;
+  uint32_t len;
+} virtq_used_elem_t;
+
+typedef struct virtq_used_t {
+  uint16_t          flags;
+  uint16_t          idx;
+  virtq_used_elem_t ring[CONFIG_VIRTIO_QUEUE_SIZE];
+  uint16_t          avail_event;
+} virtq_used_t;
+
+/******************************************************************************
+ * @struct virtq_mem_t
+ * @brief split ring shared with the device
+ *
+ * The layout is the legacy one, the used ring on its own page, so the same
+ * memory is given to the version 1 and 2 transports.
+ ******************************************************************************/
+typedef struct virtq_mem_t {
+  virtq_desc_t  desc[CONFIG_VIRTIO_QUEUE_SIZE];
+  virtq_avail_t avail;
+  virtq_used_t  used __attribute__((aligned(PAGE_SIZE)));
+} __attribute__((aligned(PAGE_SIZE))) virtq_mem_t;
+
+/******************************************************************************
+ * @struct virtq_t
+ * @brief driver side of a virtqueue
+ *
+ * The driver keeps the indexes it has published and consumed, the rings are
+ * only read for the indexes of the device. Each chain gets back the token it
+ * was added with, e.g. the buffer it points to. A virtqueue is not locked,
+ * it's used by a single task or under a lock of the driver.
+ ******************************************************************************/
+typedef struct virtq_t {
+  virtq_mem_t *mem;
+  void        *token[CONFIG_VIRTIO_QUEUE_SIZE];
+  uint64_t     notify;
+  uint32_t     index;
+  uint16_t     free_head;
+  uint16_t     nb_free;
+  uint16_t     avail_idx;
+  uint16_t     kicked_idx;
+  uint16_t     used_idx;
+  bool         event_idx;
+} virtq_t;
+
+/******************************************************************************
+ * @struct virtq_buf_t
+ * @brief part of a chain, written by the device when write is set
+ ******************************************************************************/
+typedef struct virtq_buf_t {
+  void    *addr;
+  uint32_t len;
+  bool     write;
+} virtq_buf_t;
+
+/******************************************************************************
+ * @struct virtio_dev_t
+ * @brief virtio mmio transport of a device
+ ******************************************************************************/
+typedef struct virtio_dev_t {
+  uint64_t base;
+  uint32_t version;
+  uint32_t irq_source;
+  uint64_t features;
+} virtio_dev_t;
+
+/******************************************************************************
+ * @brief find the first transport of a device type
+ * @param device type, VIRTIO_ID_*
+ * @param transport found
+ * @return K_OK, or K_ERROR if no transport holds such a device
+ ******************************************************************************/
+k_return_t virtio_find(uint32_t, virtio_dev_t *);
+
+/******************************************************************************
+ * @brief reset a device and negotiate its features
+ *
+ * VIRTIO_F_VERSION_1 is accepted for a version 2 transport, the legacy ones
+ * don't offer it.
+ *
+ * @param device
+ * @param features the driver supports
+ * @return K_OK, or K_ERROR if the device doesn't accept the features
+ ******************************************************************************/
+k_return_t virtio_setup(virtio_dev_t *, uint64_t);
+
+/******************************************************************************
+ * @brief tell the device the queues are set up, it can start using them
+ * @param device
+ * @return none
+ ******************************************************************************/
+void virtio_ready(virtio_dev_t *);
+
+/******************************************************************************
+ * @brief read and acknowledge the interrupt of a device
+ * @param device
+ * @return VIRTIO_INT_* causes
+ ******************************************************************************/
+uint32_t virtio_ack(virtio_dev_t *);
+
+/******************************************************************************
+ * @brief read the configuration space of a device
+ * @param device
+ * @param offset in the configuration space
+ * @return 32-bit value
+ ******************************************************************************/
+uint32_t virtio_config_read(virtio_dev_t *, uint64_t);
+
+/******************************************************************************
+ * @brief set up a virtqueue in memory, all descriptors are free
+ * @param virtqueue
+ * @param shared ring
+ * @param true if VIRTIO_F_EVENT_IDX has been negotiated
+ * @return none
+ ******************************************************************************/
+void virtq_setup(virtq_t *, virtq_mem_t *, bool);
+
+/******************************************************************************
+ * @brief give a virtqueue to a device, after virtio_setup()
+ * @param device
+ * @param virtqueue set up by virtq_setup()
+ * @param index of the queue in the device
+ * @return K_OK, or K_ERROR if the device queue is smaller than the ring
+ ******************************************************************************/
+k_return_t virtq_attach(virtio_dev_t *, virtq_t *, uint32_t);
+
+/******************************************************************************
+ * @brief make a chain of buffers available to the device
+ *
+ * The descriptors point to the buffers themselves, nothing is copied. The
+ * device only sees the chain once it's published by virtq_kick().
+ *
+ * @param virtqueue
+ * @param buffers of the chain
+ * @param number of buffers
+ * @param token given back with the chain by virtq_get_used()
+ * @return K_OK, or K_ERROR if there are not enough free descriptors
+ ******************************************************************************/
+k_return_t virtq_add(virtq_t *, const virtq_buf_t *, uint16_t, void *);
+
+/******************************************************************************
+ * @brief publish the chains added since the last call
+ *
+ * With event indexes, the device is only notified when it asked for one of
+ * the published chains: a device which is still working on the ring doesn't
+ * need a notification for each of them.
+ *
+ * @param virtqueue
+ * @return true if the device has to be notified
+ ******************************************************************************/
+bool virtq_publish(virtq_t *);
+
+/******************************************************************************
+ * @brief publish the chains added and notify the device if it needs it
+ * @param virtqueue attached to a device
+ * @return none
+ ******************************************************************************/
+void virtq_kick(virtq_t *);
+
+/******************************************************************************
+ * @brief take a chain given back by the device, its descriptors are freed
+ * @param virtqueue
+ * @param token the chain was added with
+ * @param number of bytes written by the device
+ * @return true if a chain was used, false if there is none
+ ******************************************************************************/
+bool virtq_get_used(virtq_t *, void **, uint32_t *);
+
+/******************************************************************************
+ * @brief ask for an interrupt at the next chain used by the device
+ *
+ * The chains used from now on are seen by the caller either with the
+ * interrupt or with the value returned.
+ *
+ * @param virtqueue
+ * @return true if chains were used meanwhile, they have to be taken first
+ ******************************************************************************/
+bool virtq_arm(virtq_t *);
+
+/******************************************************************************
+ * @brief ask for no interrupt, the used chains are taken by polling
+ * @param virtqueue
+ * @return none
+ ******************************************************************************/
+void virtq_disarm(virtq_t *);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef VIRTIO_BLK_H
+#define VIRTIO_BLK_H
+
+#include "app.h"
+#include "common.h"
+
+/******************************************************************************
+ * requests to the virtio_blk app, made with ax_channel_call() on
+ * virtio_blk_channel: the first word of the request is the operation, the
+ * first word of the reply a k_return_t
+ *
+ * VIRTIO_BLK_INFO  {op}                      -> {status, sectors}
+ * VIRTIO_BLK_READ  {op, sector, buffer, len} -> {status}
+ * VIRTIO_BLK_WRITE {op, sector, buffer, len} -> {status}
+ *
+ * The device reads or writes the buffer of the client itself, the length is
+ * a multiple of the sector size.
+ ******************************************************************************/
+#define VIRTIO_BLK_INFO  0
+#define VIRTIO_BLK_READ  1
+#define VIRTIO_BLK_WRITE 2
+
+#define VIRTIO_BLK_SECTOR_SIZE 512
+
+// channel of the requests, created at boot
+extern app_channel_t virtio_blk_channel;
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef VIRTIO_NET_H
+#define VIRTIO_NET_H
+
+#include "app.h"
+#include "common.h"
+#include "ring.h"
+
+/******************************************************************************
+ * requests to the virtio_net app, made with ax_channel_call() on
+ * virtio_net_channel: the first word of the request is the operation, the
+ * first word of the reply a k_return_t
+ *
+ * VIRTIO_NET_OPEN       {op, ring_t *}            -> {status, mac}
+ * VIRTIO_NET_TX_ALLOC   {op}                      -> {status, buffer}
+ * VIRTIO_NET_TX_SEND    {op, buffer, len, more}   -> {status}
+ * VIRTIO_NET_RX_RELEASE {op, buffer}              -> {status}
+ ******************************************************************************/
+#define VIRTIO_NET_OPEN       0
+#define VIRTIO_NET_TX_ALLOC   1
+#define VIRTIO_NET_TX_SEND    2
+#define VIRTIO_NET_RX_RELEASE 3
+
+// ethernet frame without its checksum, the payload of a buffer
+#define VIRTIO_NET_FRAME_SIZE  1514
+#define VIRTIO_NET_BUFFER_SIZE 2048
+
+/******************************************************************************
+ * @struct virtio_net_frame_t
+ * @brief frame received in a buffer of the driver, element of the ring given
+ * with VIRTIO_NET_OPEN
+ *
+ * The frame stays in the receive buffer the device has written, the client
+ * reads it in place and gives the buffer back with VIRTIO_NET_RX_RELEASE.
+ ******************************************************************************/
+typedef struct virtio_net_frame_t {
+  uint8_t *data;
+  uint64_t len;
+} virtio_net_frame_t;
+
+// channel of the requests, created at boot
+extern app_channel_t virtio_net_channel;
+
+#endif
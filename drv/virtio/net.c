@@ -0,0 +1,432 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "virtio_net.h"
+
+#include "app.h"
+#include "ax_syscall.h"
+#include "interrupt.h"
+#include "mutex.h"
+#include "printk.h"
+#include "virtio.h"
+
+#ifdef CONFIG_VIRTIO_NET
+
+// the interrupt task takes the received frames before the server runs
+#define VIRTIO_NET_PRIO     20
+#define VIRTIO_NET_IRQ_PRIO 21
+
+#define VIRTIO_NET_RX_QUEUE 0
+#define VIRTIO_NET_TX_QUEUE 1
+
+#define VIRTIO_NET_F_MAC (1UL << 5)
+
+// the header precedes the frame in each buffer, num_buffers is only part of
+// it for a version 1 device
+#define VIRTIO_NET_HDR_LEN        12
+#define VIRTIO_NET_LEGACY_HDR_LEN 10
+
+#define VIRTIO_NET_MSG_WORDS 4
+
+/******************************************************************************
+ * @struct virtio_net_buffer_t
+ * @brief buffer given to the device, a header and a frame
+ ******************************************************************************/
+typedef struct virtio_net_buffer_t {
+  uint8_t data[VIRTIO_NET_BUFFER_SIZE];
+} __attribute__((aligned(CACHE_LINE_SIZE))) virtio_net_buffer_t;
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t virtio_net_stack;
+stack_t virtio_net_irq_stack;
+
+static virtio_dev_t virtio_net_dev;
+static uint64_t     virtio_net_hdr_len;
+static uint64_t     virtio_net_mac;
+
+static virtq_mem_t virtio_net_rx_mem;
+static virtq_mem_t virtio_net_tx_mem;
+static virtq_t     virtio_net_rx;
+static virtq_t     virtio_net_tx;
+
+static virtio_net_buffer_t virtio_net_rx_buffers[CONFIG_VIRTIO_QUEUE_SIZE];
+static virtio_net_buffer_t virtio_net_tx_buffers[CONFIG_VIRTIO_QUEUE_SIZE];
+
+// transmit buffers which are neither in the queue nor given to the client
+static virtio_net_buffer_t *virtio_net_tx_free[CONFIG_VIRTIO_QUEUE_SIZE];
+static uint64_t             virtio_net_nb_tx_free = 0;
+
+// the receive queue and the client ring are shared by the server and the
+// interrupt task
+static mutex_t  virtio_net_lock;
+static ring_t  *virtio_net_client = NULL;
+static task_t  *virtio_net_irq_task;
+
+// the requests are served with an error when there is no device
+REGISTER_CHANNEL(virtio_net_channel, "virtio_net")
+
+/******************************************************************************
+ * @brief find the buffer of a pool holding a frame given to the client
+ * @param pool of buffers
+ * @param address of the frame
+ * @return buffer, or NULL if the address is not a frame of the pool
+ ******************************************************************************/
+static virtio_net_buffer_t *virtio_net_buffer(virtio_net_buffer_t *pool,
+                                              uint64_t             frame) {
+  uint64_t offset = frame - virtio_net_hdr_len - (uint64_t)pool;
+
+  if (frame < (uint64_t)pool + virtio_net_hdr_len ||
+      offset >= CONFIG_VIRTIO_QUEUE_SIZE * sizeof(virtio_net_buffer_t) ||
+      offset % sizeof(virtio_net_buffer_t)) {
+    return NULL;
+  }
+
+  return &pool[offset / sizeof(virtio_net_buffer_t)];
+}
+
+/******************************************************************************
+ * @brief give a receive buffer to the device
+ *
+ * The caller must hold the driver lock and kick the queue.
+ *
+ * @param buffer
+ * @return none
+ ******************************************************************************/
+static void virtio_net_rx_post(virtio_net_buffer_t *buffer) {
+  virtq_buf_t buf = {.addr  = buffer,
+                     .len   = sizeof(virtio_net_buffer_t),
+                     .write = true};
+
+  // there are as many buffers as descriptors
+  virtq_add(&virtio_net_rx, &buf, 1, buffer);
+}
+
+/******************************************************************************
+ * @brief hand the received frames to the client
+ *
+ * The frames are given in place, only their address goes through the ring.
+ * Without client the buffers go back to the device, while the client ring is
+ * full they stay in the used ring: the device drops the next frames once it
+ * has no buffer left.
+ *
+ * The caller must hold the driver lock.
+ *
+ * @param none
+ * @return true if all the used buffers have been taken
+ ******************************************************************************/
+static bool virtio_net_rx_drain() {
+  virtio_net_buffer_t *buffer;
+  virtio_net_frame_t   frame;
+  uint32_t             len;
+  bool                 drained = true;
+
+  while (true) {
+    // the producer of the ring checks it has room before taking a buffer
+    if (virtio_net_client != NULL &&
+        virtio_net_client->head - ring_load(virtio_net_client->tail) >
+            virtio_net_client->mask) {
+      drained = false;
+      break;
+    }
+
+    if (!virtq_get_used(&virtio_net_rx, (void **)&buffer, &len)) {
+      break;
+    }
+
+    if (virtio_net_client == NULL || len <= virtio_net_hdr_len) {
+      virtio_net_rx_post(buffer);
+      continue;
+    }
+
+    frame.data = buffer->data + virtio_net_hdr_len;
+    frame.len  = len - virtio_net_hdr_len;
+    ring_try_put(virtio_net_client, &frame);
+  }
+
+  virtq_kick(&virtio_net_rx);
+
+  return drained;
+}
+
+/******************************************************************************
+ * @brief take the received frames until the next interrupt is armed
+ *
+ * The interrupt is only armed once the used ring is empty: the frames which
+ * arrive while the task drains the ring don't raise any.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+static void virtio_net_rx_serve() {
+  mutex_lock(&virtio_net_lock);
+
+  while (virtio_net_rx_drain() && virtq_arm(&virtio_net_rx)) {
+  }
+
+  mutex_unlock(&virtio_net_lock);
+}
+
+/******************************************************************************
+ * @brief serve the device interrupt
+ * @param none
+ * @return none
+ ******************************************************************************/
+static void virtio_net_irq_run(void) {
+  interrupt_id_t interrupt_id =
+      INTERRUPT_EXTERNAL_ID(virtio_net_dev.irq_source);
+
+  ax_interrupt_request(interrupt_id);
+
+  while (true) {
+    ax_interrupt_wait(interrupt_id);
+
+    virtio_ack(&virtio_net_dev);
+    virtio_net_rx_serve();
+  }
+}
+
+/******************************************************************************
+ * @brief get a transmit buffer back from the device or the free list
+ *
+ * The sent buffers are only taken back here, the transmit queue never
+ * interrupts.
+ *
+ * @param none
+ * @return buffer, or NULL if all of them are in flight or given
+ ******************************************************************************/
+static virtio_net_buffer_t *virtio_net_tx_alloc() {
+  virtio_net_buffer_t *buffer;
+  uint32_t             len;
+
+  while (virtq_get_used(&virtio_net_tx, (void **)&buffer, &len)) {
+    virtio_net_tx_free[virtio_net_nb_tx_free++] = buffer;
+  }
+  virtq_disarm(&virtio_net_tx);
+
+  if (!virtio_net_nb_tx_free) {
+    return NULL;
+  }
+
+  return virtio_net_tx_free[--virtio_net_nb_tx_free];
+}
+
+/******************************************************************************
+ * @brief send a frame written by the client in a transmit buffer
+ *
+ * The device is notified once for a batch of frames sent with more set, and
+ * only if it waits for one of them.
+ *
+ * @param frame address given by VIRTIO_NET_TX_ALLOC
+ * @param length of the frame
+ * @param true if more frames follow
+ * @return K_OK, or K_ERROR if the frame is not valid
+ ******************************************************************************/
+static k_return_t virtio_net_tx_send(uint64_t frame, uint64_t len,
+                                     bool more) {
+  virtio_net_buffer_t *buffer =
+      virtio_net_buffer(virtio_net_tx_buffers, frame);
+  virtq_buf_t buf;
+
+  if (buffer == NULL || len > VIRTIO_NET_FRAME_SIZE) {
+    return K_ERROR;
+  }
+
+  // no checksum nor segmentation offload
+  for (uint64_t i = 0; i < virtio_net_hdr_len; i++) {
+    buffer->data[i] = 0;
+  }
+
+  buf.addr  = buffer;
+  buf.len   = virtio_net_hdr_len + len;
+  buf.write = false;
+  if (virtq_add(&virtio_net_tx, &buf, 1, buffer) != K_OK) {
+    return K_ERROR;
+  }
+
+  if (!more) {
+    virtq_kick(&virtio_net_tx);
+  }
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief serve a request of a client
+ * @param request
+ * @param request length in bytes
+ * @param reply, the first word is set by the caller
+ * @return status of the request
+ ******************************************************************************/
+static k_return_t virtio_net_request(uint64_t *msg, uint64_t len,
+                                     uint64_t *reply) {
+  virtio_net_buffer_t *buffer;
+  ring_t              *ring;
+
+  if (len < sizeof(uint64_t)) {
+    return K_ERROR;
+  }
+
+  switch (msg[0]) {
+    case VIRTIO_NET_OPEN:
+      ring = (ring_t *)msg[1];
+      if (len < 2 * sizeof(uint64_t) || ring == NULL ||
+          ring->elem_size != sizeof(virtio_net_frame_t)) {
+        return K_ERROR;
+      }
+
+      mutex_lock(&virtio_net_lock);
+      virtio_net_client = ring;
+      ring->producer    = virtio_net_irq_task;
+      mutex_unlock(&virtio_net_lock);
+
+      reply[1] = virtio_net_mac;
+      return K_OK;
+
+    case VIRTIO_NET_TX_ALLOC:
+      buffer = virtio_net_tx_alloc();
+      if (buffer == NULL) {
+        return K_ERROR;
+      }
+
+      reply[1] = (uint64_t)buffer->data + virtio_net_hdr_len;
+      return K_OK;
+
+    case VIRTIO_NET_TX_SEND:
+      if (len < VIRTIO_NET_MSG_WORDS * sizeof(uint64_t)) {
+        return K_ERROR;
+      }
+      return virtio_net_tx_send(msg[1], msg[2], msg[3]);
+
+    case VIRTIO_NET_RX_RELEASE:
+      buffer = virtio_net_buffer(virtio_net_rx_buffers, msg[1]);
+      if (len < 2 * sizeof(uint64_t) || buffer == NULL) {
+        return K_ERROR;
+      }
+
+      // the frames held back by a full ring can now be handed
+      mutex_lock(&virtio_net_lock);
+      virtio_net_rx_post(buffer);
+      mutex_unlock(&virtio_net_lock);
+
+      virtio_net_rx_serve();
+      return K_OK;
+
+    default:
+      return K_ERROR;
+  }
+}
+
+/******************************************************************************
+ * @brief set up the device, all the receive buffers are given to it
+ * @param none
+ * @return K_OK, or K_ERROR if there is no device or it can't be set up
+ ******************************************************************************/
+static k_return_t virtio_net_init() {
+  bool event_idx;
+
+  if (virtio_find(VIRTIO_ID_NET, &virtio_net_dev) != K_OK ||
+      virtio_setup(&virtio_net_dev, VIRTIO_NET_F_MAC | VIRTIO_F_ANY_LAYOUT |
+                                        VIRTIO_F_EVENT_IDX) != K_OK) {
+    return K_ERROR;
+  }
+
+  // a legacy device without any layout wants the header in its own buffer
+  if (virtio_net_dev.version == 1 &&
+      !(virtio_net_dev.features & VIRTIO_F_ANY_LAYOUT)) {
+    return K_ERROR;
+  }
+
+  virtio_net_hdr_len = (virtio_net_dev.features & VIRTIO_F_VERSION_1)
+                           ? VIRTIO_NET_HDR_LEN
+                           : VIRTIO_NET_LEGACY_HDR_LEN;
+
+  event_idx = virtio_net_dev.features & VIRTIO_F_EVENT_IDX;
+  virtq_setup(&virtio_net_rx, &virtio_net_rx_mem, event_idx);
+  virtq_setup(&virtio_net_tx, &virtio_net_tx_mem, event_idx);
+
+  if (virtq_attach(&virtio_net_dev, &virtio_net_rx, VIRTIO_NET_RX_QUEUE) !=
+          K_OK ||
+      virtq_attach(&virtio_net_dev, &virtio_net_tx, VIRTIO_NET_TX_QUEUE) !=
+          K_OK) {
+    return K_ERROR;
+  }
+
+  if (virtio_net_dev.features & VIRTIO_NET_F_MAC) {
+    for (uint64_t i = 0; i < 6; i++) {
+      virtio_net_mac |= (uint64_t)reg_read_byte(virtio_net_dev.base,
+                                                VIRTIO_MMIO_CONFIG + i)
+                        << (8 * i);
+    }
+  }
+
+  for (uint64_t i = 0; i < CONFIG_VIRTIO_QUEUE_SIZE; i++) {
+    virtio_net_rx_post(&virtio_net_rx_buffers[i]);
+    virtio_net_tx_free[i] = &virtio_net_tx_buffers[i];
+  }
+  virtio_net_nb_tx_free = CONFIG_VIRTIO_QUEUE_SIZE;
+
+  virtq_arm(&virtio_net_rx);
+  virtq_disarm(&virtio_net_tx);
+
+  virtio_ready(&virtio_net_dev);
+  virtq_kick(&virtio_net_rx);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief serve the requests of the clients
+ *
+ * The buffers are never copied: the client writes its frames in the transmit
+ * buffers and reads the received ones where the device has written them.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+static void virtio_net_run(void) {
+  uint64_t msg[VIRTIO_NET_MSG_WORDS];
+  uint64_t reply[2] = {0};
+  uint64_t len;
+  bool     ready = virtio_net_init() == K_OK;
+
+  if (ready) {
+    mutex_init(&virtio_net_lock);
+    virtio_net_irq_task = ax_task_create(
+        "virtio_net_irq", virtio_net_irq_run, &virtio_net_irq_stack,
+        sizeof(virtio_net_irq_stack), VIRTIO_NET_IRQ_PRIO);
+  } else {
+    printk("virtio-net: no device\r\n");
+  }
+
+  // there is no caller yet, only wait for the first request
+  len = sizeof(msg);
+  ax_channel_reply_wait(virtio_net_channel.handler, reply, 0, msg, &len);
+
+  while (true) {
+    reply[0] = ready ? virtio_net_request(msg, len, reply) : K_ERROR;
+
+    len = sizeof(msg);
+    ax_channel_reply_wait(virtio_net_channel.handler, reply, sizeof(reply),
+                          msg, &len);
+  }
+}
+
+REGISTER_APP_ON("virtio_net", virtio_net_run, virtio_net_stack,
+                VIRTIO_NET_PRIO, 0)
+
+#endif
@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "virtio.h"
+
+/******************************************************************************
+ * @brief read a register of a transport
+ * @param device
+ * @param offset of the register
+ * @return 32-bit value
+ ******************************************************************************/
+static inline uint32_t virtio_read(virtio_dev_t *dev, uint64_t offset) {
+  return reg_read_word(dev->base + offset);
+}
+
+/******************************************************************************
+ * @brief write a register of a transport
+ * @param device
+ * @param offset of the register
+ * @param 32-bit value
+ * @return none
+ ******************************************************************************/
+static inline void virtio_write(virtio_dev_t *dev, uint64_t offset,
+                                uint32_t value) {
+  reg_write_word(dev->base + offset, value);
+}
+
+/******************************************************************************
+ * @brief check if an index is in the window published since the last event
+ *
+ * The indexes wrap at 16 bits, an event is crossed when it's in [old, new).
+ *
+ * @param index the other side waits for
+ * @param new index
+ * @param index at the last event
+ * @return true if the other side has to be told
+ ******************************************************************************/
+static inline bool virtq_need_event(uint16_t event, uint16_t new,
+                                    uint16_t old) {
+  return (uint16_t)(new - event - 1) < (uint16_t)(new - old);
+}
+
+/******************************************************************************
+ * @brief find the first transport of a device type
+ *
+ * An empty transport has a device identifier 0.
+ *
+ * @param device type, VIRTIO_ID_*
+ * @param transport found
+ * @return K_OK, or K_ERROR if no transport holds such a device
+ ******************************************************************************/
+k_return_t virtio_find(uint32_t device_id, virtio_dev_t *dev) {
+  for (uint32_t slot = 0; slot < VIRTIO_MMIO_NB; slot++) {
+    dev->base       = VIRTIO_MMIO_BASE_ADDR + slot * VIRTIO_MMIO_STRIDE;
+    dev->irq_source = VIRTIO_MMIO_IRQ_SOURCE + slot;
+    dev->version    = virtio_read(dev, VIRTIO_MMIO_VERSION);
+    dev->features   = 0;
+
+    if (virtio_read(dev, VIRTIO_MMIO_MAGIC) == VIRTIO_MMIO_MAGIC_VALUE &&
+        virtio_read(dev, VIRTIO_MMIO_DEVICE_ID) == device_id &&
+        (dev->version == 1 || dev->version == 2)) {
+      return K_OK;
+    }
+  }
+
+  return K_ERROR;
+}
+
+/******************************************************************************
+ * @brief reset a device and negotiate its features
+ * @param device
+ * @param features the driver supports
+ * @return K_OK, or K_ERROR if the device doesn't accept the features
+ ******************************************************************************/
+k_return_t virtio_setup(virtio_dev_t *dev, uint64_t features) {
+  uint64_t offered;
+
+  virtio_write(dev, VIRTIO_MMIO_STATUS, 0);
+  virtio_write(dev, VIRTIO_MMIO_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+  virtio_write(dev, VIRTIO_MMIO_STATUS,
+               VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+  virtio_write(dev, VIRTIO_MMIO_DEVICE_FEATURES_SEL, 0);
+  offered = virtio_read(dev, VIRTIO_MMIO_DEVICE_FEATURES);
+  virtio_write(dev, VIRTIO_MMIO_DEVICE_FEATURES_SEL, 1);
+  offered |= (uint64_t)virtio_read(dev, VIRTIO_MMIO_DEVICE_FEATURES) << 32;
+
+  if (dev->version == 2) {
+    features |= VIRTIO_F_VERSION_1;
+  }
+  dev->features = features & offered;
+
+  virtio_write(dev, VIRTIO_MMIO_DRIVER_FEATURES_SEL, 0);
+  virtio_write(dev, VIRTIO_MMIO_DRIVER_FEATURES, (uint32_t)dev->features);
+  virtio_write(dev, VIRTIO_MMIO_DRIVER_FEATURES_SEL, 1);
+  virtio_write(dev, VIRTIO_MMIO_DRIVER_FEATURES,
+               (uint32_t)(dev->features >> 32));
+
+  // a modern device must keep FEATURES_OK, a legacy one has no such step
+  if (dev->version == 1) {
+    virtio_write(dev, VIRTIO_MMIO_GUEST_PAGE_SIZE, PAGE_SIZE);
+    return K_OK;
+  }
+
+  if (!(dev->features & VIRTIO_F_VERSION_1)) {
+    return K_ERROR;
+  }
+
+  virtio_write(dev, VIRTIO_MMIO_STATUS,
+               VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER |
+                   VIRTIO_STATUS_FEATURES_OK);
+
+  if (!(virtio_read(dev, VIRTIO_MMIO_STATUS) & VIRTIO_STATUS_FEATURES_OK)) {
+    virtio_write(dev, VIRTIO_MMIO_STATUS, VIRTIO_STATUS_FAILED);
+    return K_ERROR;
+  }
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief tell the device the queues are set up, it can start using them
+ * @param device
+ * @return none
+ ******************************************************************************/
+void virtio_ready(virtio_dev_t *dev) {
+  virtio_write(dev, VIRTIO_MMIO_STATUS,
+               virtio_read(dev, VIRTIO_MMIO_STATUS) |
+                   VIRTIO_STATUS_DRIVER_OK);
+}
+
+/******************************************************************************
+ * @brief read and acknowledge the interrupt of a device
+ * @param device
+ * @return VIRTIO_INT_* causes
+ ******************************************************************************/
+uint32_t virtio_ack(virtio_dev_t *dev) {
+  uint32_t status = virtio_read(dev, VIRTIO_MMIO_INTERRUPT_STATUS);
+
+  virtio_write(dev, VIRTIO_MMIO_INTERRUPT_ACK, status);
+
+  return status;
+}
+
+/******************************************************************************
+ * @brief read the configuration space of a device
+ * @param device
+ * @param offset in the configuration space
+ * @return 32-bit value
+ ******************************************************************************/
+uint32_t virtio_config_read(virtio_dev_t *dev, uint64_t offset) {
+  return virtio_read(dev, VIRTIO_MMIO_CONFIG + offset);
+}
+
+/******************************************************************************
+ * @brief set up a virtqueue in memory, all descriptors are free
+ * @param virtqueue
+ * @param shared ring
+ * @param true if VIRTIO_F_EVENT_IDX has been negotiated
+ * @return none
+ ******************************************************************************/
+void virtq_setup(virtq_t *queue, virtq_mem_t *mem, bool event_idx) {
+  queue->mem        = mem;
+  queue->notify     = 0;
+  queue->index      = 0;
+  queue->free_head  = 0;
+  queue->nb_free    = CONFIG_VIRTIO_QUEUE_SIZE;
+  queue->avail_idx  = 0;
+  queue->kicked_idx = 0;
+  queue->used_idx   = 0;
+  queue->event_idx  = event_idx;
+
+  for (uint16_t index = 0; index < CONFIG_VIRTIO_QUEUE_SIZE; index++) {
+    mem->desc[index].next  = index + 1;
+    mem->desc[index].flags = 0;
+    queue->token[index]    = NULL;
+  }
+  mem->desc[CONFIG_VIRTIO_QUEUE_SIZE - 1].next = VIRTQ_NO_DESC;
+
+  mem->avail.flags      = 0;
+  mem->avail.idx        = 0;
+  mem->avail.used_event = 0;
+  mem->used.flags       = 0;
+  mem->used.idx         = 0;
+  mem->used.avail_event = 0;
+}
+
+/******************************************************************************
+ * @brief give a virtqueue to a device, after virtio_setup()
+ * @param device
+ * @param virtqueue set up by virtq_setup()
+ * @param index of the queue in the device
+ * @return K_OK, or K_ERROR if the device queue is smaller than the ring
+ ******************************************************************************/
+k_return_t virtq_attach(virtio_dev_t *dev, virtq_t *queue, uint32_t index) {
+  uint64_t desc  = (uint64_t)queue->mem->desc;
+  uint64_t avail = (uint64_t)&queue->mem->avail;
+  uint64_t used  = (uint64_t)&queue->mem->used;
+
+  virtio_write(dev, VIRTIO_MMIO_QUEUE_SEL, index);
+
+  if (virtio_read(dev, VIRTIO_MMIO_QUEUE_NUM_MAX) < CONFIG_VIRTIO_QUEUE_SIZE) {
+    return K_ERROR;
+  }
+
+  virtio_write(dev, VIRTIO_MMIO_QUEUE_NUM, CONFIG_VIRTIO_QUEUE_SIZE);
+
+  if (dev->version == 1) {
+    // the legacy transport finds the rings from the page of the descriptors
+    virtio_write(dev, VIRTIO_MMIO_QUEUE_ALIGN, PAGE_SIZE);
+    virtio_write(dev, VIRTIO_MMIO_QUEUE_PFN, desc / PAGE_SIZE);
+  } else {
+    virtio_write(dev, VIRTIO_MMIO_QUEUE_DESC_LOW, (uint32_t)desc);
+    virtio_write(dev, VIRTIO_MMIO_QUEUE_DESC_HIGH, (uint32_t)(desc >> 32));
+    virtio_write(dev, VIRTIO_MMIO_QUEUE_AVAIL_LOW, (uint32_t)avail);
+    virtio_write(dev, VIRTIO_MMIO_QUEUE_AVAIL_HIGH, (uint32_t)(avail >> 32));
+    virtio_write(dev, VIRTIO_MMIO_QUEUE_USED_LOW, (uint32_t)used);
+    virtio_write(dev, VIRTIO_MMIO_QUEUE_USED_HIGH, (uint32_t)(used >> 32));
+    virtio_write(dev, VIRTIO_MMIO_QUEUE_READY, 1);
+  }
+
+  queue->notify = dev->base + VIRTIO_MMIO_QUEUE_NOTIFY;
+  queue->index  = index;
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief make a chain of buffers available to the device
+ * @param virtqueue
+ * @param buffers of the chain
+ * @param number of buffers
+ * @param token given back with the chain by virtq_get_used()
+ * @return K_OK, or K_ERROR if there are not enough free descriptors
+ ******************************************************************************/
+k_return_t virtq_add(virtq_t *queue, const virtq_buf_t *bufs, uint16_t nb,
+                     void *token) {
+  virtq_mem_t  *mem  = queue->mem;
+  uint16_t      head = queue->free_head;
+  uint16_t      index;
+  virtq_desc_t *desc = NULL;
+
+  if (!nb || nb > queue->nb_free) {
+    return K_ERROR;
+  }
+
+  index = head;
+  for (uint16_t i = 0; i < nb; i++) {
+    desc        = &mem->desc[index];
+    desc->addr  = (uint64_t)bufs[i].addr;
+    desc->len   = bufs[i].len;
+    desc->flags = (bufs[i].write ? VIRTQ_DESC_F_WRITE : 0) |
+                  (i + 1 < nb ? VIRTQ_DESC_F_NEXT : 0);
+    index       = desc->next;
+  }
+
+  queue->free_head   = index;
+  queue->nb_free    -= nb;
+  queue->token[head] = token;
+
+  // the chain is only visible to the device once the index is published
+  mem->avail.ring[queue->avail_idx % CONFIG_VIRTIO_QUEUE_SIZE] = head;
+  queue->avail_idx += 1;
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief publish the chains added since the last call
+ * @param virtqueue
+ * @return true if the device has to be notified
+ ******************************************************************************/
+bool virtq_publish(virtq_t *queue) {
+  virtq_mem_t *mem = queue->mem;
+  uint16_t     old = queue->kicked_idx;
+  uint16_t     new = queue->avail_idx;
+
+  if (old == new) {
+    return false;
+  }
+
+  // the descriptors and the ring entries are written before the index
+  __atomic_store_n(&mem->avail.idx, new, __ATOMIC_RELEASE);
+  queue->kicked_idx = new;
+
+  // the index is visible before the device wish is read: a device which
+  // asks for a notification meanwhile sees the new chains
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  if (queue->event_idx) {
+    return virtq_need_event(
+        __atomic_load_n(&mem->used.avail_event, __ATOMIC_RELAXED), new, old);
+  }
+
+  return !(__atomic_load_n(&mem->used.flags, __ATOMIC_RELAXED) &
+           VIRTQ_USED_F_NO_NOTIFY);
+}
+
+/******************************************************************************
+ * @brief publish the chains added and notify the device if it needs it
+ * @param virtqueue attached to a device
+ * @return none
+ ******************************************************************************/
+void virtq_kick(virtq_t *queue) {
+  if (virtq_publish(queue)) {
+    __asm__ volatile("fence w, o" ::: "memory");
+    reg_write_word(queue->notify, queue->index);
+  }
+}
+
+/******************************************************************************
+ * @brief take a chain given back by the device, its descriptors are freed
+ * @param virtqueue
+ * @param token the chain was added with
+ * @param number of bytes written by the device
+ * @return true if a chain was used, false if there is none
+ ******************************************************************************/
+bool virtq_get_used(virtq_t *queue, void **token, uint32_t *len) {
+  virtq_mem_t       *mem = queue->mem;
+  virtq_used_elem_t *elem;
+  uint16_t           head;
+  uint16_t           index;
+
+  // the entry is read after the index which published it
+  if (queue->used_idx == __atomic_load_n(&mem->used.idx, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+
+  elem   = &mem->used.ring[queue->used_idx % CONFIG_VIRTIO_QUEUE_SIZE];
+  head   = (uint16_t)elem->id;
+  *token = queue->token[head];
+  *len   = elem->len;
+
+  queue->used_idx   += 1;
+  queue->token[head] = NULL;
+
+  // give the chain back to the free list
+  index           = head;
+  queue->nb_free += 1;
+  while (mem->desc[index].flags & VIRTQ_DESC_F_NEXT) {
+    index           = mem->desc[index].next;
+    queue->nb_free += 1;
+  }
+  mem->desc[index].next = queue->free_head;
+  queue->free_head      = head;
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief ask for an interrupt at the next chain used by the device
+ * @param virtqueue
+ * @return true if chains were used meanwhile, they have to be taken first
+ ******************************************************************************/
+bool virtq_arm(virtq_t *queue) {
+  virtq_mem_t *mem = queue->mem;
+
+  if (queue->event_idx) {
+    __atomic_store_n(&mem->avail.used_event, queue->used_idx,
+                     __ATOMIC_RELAXED);
+  } else {
+    __atomic_store_n(&mem->avail.flags, 0, __ATOMIC_RELAXED);
+  }
+
+  // the wish is visible before the used index is checked again
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  return queue->used_idx != __atomic_load_n(&mem->used.idx, __ATOMIC_ACQUIRE);
+}
+
+/******************************************************************************
+ * @brief ask for no interrupt, the used chains are taken by polling
+ *
+ * With event indexes, the event is set just behind the used index: the
+ * device would have to use a full 16-bit round of chains to reach it.
+ *
+ * @param virtqueue
+ * @return none
+ ******************************************************************************/
+void virtq_disarm(virtq_t *queue) {
+  virtq_mem_t *mem = queue->mem;
+
+  if (queue->event_idx) {
+    __atomic_store_n(&mem->avail.used_event, (uint16_t)(queue->used_idx - 1),
+                     __ATOMIC_RELAXED);
+  } else {
+    __atomic_store_n(&mem->avail.flags, VIRTQ_AVAIL_F_NO_INTERRUPT,
+                     __ATOMIC_RELAXED);
+  }
+}
@@ -21,7 +21,7 @@
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
-stack_t helloworld_stack;
+DECLARE_STACK(helloworld_stack, STACK_MIN_SIZE);
 
 /******************************************************************************
  * @brief just create a thread and return from it
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "buddy.h"
+
+#include "bitops.h"
+#include "list.h"
+#include "smp.h"
+#include "stddef.h"
+
+#define BUDDY_MASK(_order) ((1UL << (_order)) - 1)
+
+/******************************************************************************
+ * @struct buddy_heap_t
+ * @brief heap state, block offsets are relative to the heap base address
+ *
+ * The base address is aligned on the biggest block size so blocks are
+ * naturally aligned, the memory below the heap start is never released.
+ * Each order has a free list and a bitmap with one bit per pair of buddies.
+ * A pair bit is the XOR of the free state of both buddies, so it's enough to
+ * know if the buddy of a released block is free too. The free_orders bitmap
+ * flags the non-empty free lists to find the best fit in a single scan.
+ ******************************************************************************/
+typedef struct {
+  uint8_t    *base;
+  uint64_t    size;
+  uint64_t    free_size;
+  uint64_t    free_orders;
+  list_node_t free_lists[BUDDY_NB_ORDERS];
+  uint64_t   *pairs[BUDDY_NB_ORDERS];
+} buddy_heap_t;
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+extern uint8_t _heap_start;
+extern uint8_t _heap_end;
+
+static buddy_heap_t heap;
+
+/******************************************************************************
+ * @brief get the free list of an order
+ * @param block order
+ * @return free list head
+ ******************************************************************************/
+static inline list_node_t *buddy_list(uint8_t order) {
+  return &heap.free_lists[order - BUDDY_MIN_ORDER];
+}
+
+/******************************************************************************
+ * @brief invert the pair bit of a block, tracking the state of both buddies
+ * @param block offset
+ * @param block order
+ * @return true if only one of the buddies is free
+ ******************************************************************************/
+static inline bool buddy_toggle(uint64_t offset, uint8_t order) {
+  uint64_t pair = offset >> (order + 1);
+
+  return bit_toggle(&heap.pairs[order - BUDDY_MIN_ORDER][pair / 64], pair % 64);
+}
+
+/******************************************************************************
+ * @brief add a block to the free list of its order
+ * @param block offset
+ * @param block order
+ * @return none
+ ******************************************************************************/
+static inline void buddy_push(uint64_t offset, uint8_t order) {
+  list_add_tail((list_node_t *)(heap.base + offset), buddy_list(order));
+  bit_set(&heap.free_orders, order);
+}
+
+/******************************************************************************
+ * @brief remove a block from the free list of its order
+ * @param block offset
+ * @param block order
+ * @return none
+ ******************************************************************************/
+static inline void buddy_pull(uint64_t offset, uint8_t order) {
+  list_remove((list_node_t *)(heap.base + offset));
+
+  if (list_is_empty(buddy_list(order))) {
+    bit_clear(&heap.free_orders, order);
+  }
+}
+
+/******************************************************************************
+ * @brief release a block and merge it with its free buddies
+ * @param block offset
+ * @param block order
+ * @return none
+ ******************************************************************************/
+static void buddy_release(uint64_t offset, uint8_t order) {
+  heap.free_size += 1UL << order;
+
+  // at most one merge per order, whatever the heap size
+  while (order < BUDDY_MAX_ORDER && !buddy_toggle(offset, order)) {
+    buddy_pull(offset ^ (1UL << order), order);
+    offset &= ~(1UL << order);
+    order  += 1;
+  }
+
+  buddy_push(offset, order);
+}
+
+/******************************************************************************
+ * @brief initialize the heap with the memory left after the bss section
+ * @param none
+ * @return none
+ ******************************************************************************/
+void buddy_init() {
+  uint8_t *start  = &_heap_start;
+  uint64_t base   = (uint64_t)start & ~BUDDY_MASK(BUDDY_MAX_ORDER);
+  uint64_t offset = 0;
+
+  heap.base        = (uint8_t *)base;
+  heap.size        = (&_heap_end - heap.base) & ~BUDDY_MASK(BUDDY_MIN_ORDER);
+  heap.free_size   = 0;
+  heap.free_orders = 0;
+
+  // pair bitmaps are stored at the beginning of the heap
+  for (uint8_t order = BUDDY_MIN_ORDER; order <= BUDDY_MAX_ORDER; order++) {
+    uint64_t nb_words = (heap.size >> (order + 1)) / 64 + 1;
+
+    heap.pairs[order - BUDDY_MIN_ORDER] = (uint64_t *)start;
+
+    // every block is allocated until the heap is filled below
+    for (uint64_t word = 0; word < nb_words; word++) {
+      ((uint64_t *)start)[word] = 0;
+    }
+
+    start += nb_words * sizeof(uint64_t);
+
+    list_init(buddy_list(order));
+  }
+
+  // split the free memory in the biggest aligned blocks
+  offset = start - heap.base + BUDDY_MASK(BUDDY_MIN_ORDER);
+  offset = offset & ~BUDDY_MASK(BUDDY_MIN_ORDER);
+  while (offset < heap.size) {
+    uint8_t order = BUDDY_MAX_ORDER;
+
+    while ((offset & BUDDY_MASK(order)) ||
+           offset + (1UL << order) > heap.size) {
+      order -= 1;
+    }
+
+    buddy_release(offset, order);
+    offset += 1UL << order;
+  }
+}
+
+/******************************************************************************
+ * @brief get the order of the smallest block holding a given size
+ * @param size in bytes
+ * @return block order, above BUDDY_MAX_ORDER if the size is too big
+ ******************************************************************************/
+uint8_t buddy_order(uint64_t size) {
+  if (size <= (1UL << BUDDY_MIN_ORDER)) {
+    return BUDDY_MIN_ORDER;
+  }
+
+  return bit_find_last_set(size - 1) + 1;
+}
+
+/******************************************************************************
+ * @brief allocate a block, it's aligned on its own size
+ * @param block order
+ * @return block address, or NULL if there is no free block big enough
+ ******************************************************************************/
+void *buddy_alloc(uint8_t order) {
+  uint64_t flags = 0;
+  uint64_t fits  = 0;
+  uint64_t offset;
+  uint8_t  found;
+
+  if (order > BUDDY_MAX_ORDER) {
+    return NULL;
+  }
+
+  if (order < BUDDY_MIN_ORDER) {
+    order = BUDDY_MIN_ORDER;
+  }
+
+  flags = smp_lock();
+
+  // smallest non-empty free list holding the requested order
+  fits = heap.free_orders & ~BUDDY_MASK(order);
+  if (!fits) {
+    smp_unlock(flags);
+    return NULL;
+  }
+
+  found  = bit_find_first_set(fits);
+  offset = (uint8_t *)list_first(buddy_list(found)) - heap.base;
+  buddy_pull(offset, found);
+
+  if (found < BUDDY_MAX_ORDER) {
+    buddy_toggle(offset, found);
+  }
+
+  // give the upper halves back until the block has the requested order
+  while (found > order) {
+    found -= 1;
+    buddy_toggle(offset, found);
+    buddy_push(offset + (1UL << found), found);
+  }
+
+  heap.free_size -= 1UL << order;
+
+  smp_unlock(flags);
+
+  return heap.base + offset;
+}
+
+/******************************************************************************
+ * @brief release a block allocated with buddy_alloc()
+ * @param block address
+ * @param block order given to buddy_alloc()
+ * @return none
+ ******************************************************************************/
+void buddy_free(void *block, uint8_t order) {
+  uint64_t flags;
+
+  if (block == NULL || order > BUDDY_MAX_ORDER) {
+    return;
+  }
+
+  if (order < BUDDY_MIN_ORDER) {
+    order = BUDDY_MIN_ORDER;
+  }
+
+  flags = smp_lock();
+  buddy_release((uint8_t *)block - heap.base, order);
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief get the amount of free memory in the heap
+ * @param none
+ * @return free memory in bytes
+ ******************************************************************************/
+uint64_t buddy_free_size() {
+  return heap.free_size;
+}
@@ -16,74 +16,233 @@
  */
 #include "channel.h"
 
+#include "inherit.h"
 #include "printk.h"
 #include "sched.h"
+#include "smp.h"
 #include "stddef.h"
 #include "string.h"
 #include "task.h"
+#include "trace.h"
+#include "wait_any.h"
+#include "wait_queue.h"
 
-#define MAX_NB_CHANNEL          10
-#define MAX_CHANNEL_NAME_LENGTH 20
+#ifndef CONFIG_CHANNEL_MAX_NB
+#define CONFIG_CHANNEL_MAX_NB 64
+#endif
+
+#ifndef CONFIG_CHANNEL_NAME_LENGTH
+#define CONFIG_CHANNEL_NAME_LENGTH 32
+#endif
+
+// number of message words passed in registers by _channel_snd
+#define CHANNEL_MSG_REG_NB 8
+
+// bulk copies let the pending interrupts in every chunk
+#ifndef CONFIG_CHANNEL_COPY_CHUNK
+#define CONFIG_CHANNEL_COPY_CHUNK 512
+#endif
+
+// the name hash table is kept half empty to bound the probe sequences
+#define CHANNEL_HASH_SIZE    (2 * CONFIG_CHANNEL_MAX_NB)
+#define CHANNEL_HASH_FREE    0
+#define CHANNEL_HASH_DELETED 0xFFFFFFFF
+
+// a handler holds the channel generation and its index in the table
+#define CHANNEL_HANDLER(_index, _generation) \
+  (((uint64_t)(_generation) << 32) | (_index))
+#define CHANNEL_HANDLER_INDEX(_handler)      ((_handler)&0xFFFFFFFF)
+#define CHANNEL_HANDLER_GENERATION(_handler) ((_handler) >> 32)
+
+#define FNV_OFFSET_BASIS 0x811C9DC5
+#define FNV_PRIME        0x01000193
 
 typedef struct channel_t {
-  char    name[MAX_CHANNEL_NAME_LENGTH];
-  task_t *in;
-  task_t *out;
-  bool    rcv_rdy;
-  bool    snd_rdy;
+  char        name[CONFIG_CHANNEL_NAME_LENGTH];
+  uint32_t    hash;
+  uint32_t    generation;
+  bool        used;
+  list_node_t senders;
+  list_node_t receivers;
+  task_t     *server;
+  list_node_t server_node;
+  task_t     *watcher;
+  uint64_t    watch_bit;
 } channel_t;
 
-channel_t channel[MAX_NB_CHANNEL];
-uint64_t  channel_index = 0;
+/******************************************************************************
+ * @struct channel_registry_t
+ * @brief channels and their names lookup table
+ *
+ * Names are hashed once at creation and saved in an open-addressed table which
+ * holds the channel index plus one, zero being a free entry. A lookup compares
+ * the hashes before the names and only scans the colliding entries.
+ *
+ * The generation of a channel is incremented when it's destroyed, so a handler
+ * to a destroyed channel is rejected even if its entry has been reused.
+ ******************************************************************************/
+typedef struct channel_registry_t {
+  channel_t channels[CONFIG_CHANNEL_MAX_NB];
+  uint32_t  hash_table[CHANNEL_HASH_SIZE];
+} channel_registry_t;
+
+static channel_registry_t channel_registry;
 
 /******************************************************************************
  * channel snd / rcv procedures
  ******************************************************************************/
-extern void _channel_snd(task_t *, task_t *, const uint64_t *);
-extern void _channel_rcv(const uint64_t *);
+extern void     _channel_snd(thread_t *, thread_t *, const uint64_t *, uint64_t,
+                             uint64_t);
+extern uint64_t _channel_rcv(thread_t *, thread_t *, uint64_t *);
+extern uint64_t _channel_call(thread_t *, thread_t *, const uint64_t *,
+                              uint64_t, uint64_t, uint64_t *);
+
+/******************************************************************************
+ * @brief hash a channel name
+ * @param channel name
+ * @return 32-bit FNV-1a hash of the name
+ ******************************************************************************/
+static uint32_t channel_hash(const char *name) {
+  uint32_t hash = FNV_OFFSET_BASIS;
+
+  while (*name) {
+    hash ^= (uint8_t)*name++;
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
+
+/******************************************************************************
+ * @brief find the hash table entry of a channel name
+ * @param channel name
+ * @param hash of the channel name
+ * @return entry index, or -1 if the name is not registered
+ ******************************************************************************/
+static int64_t channel_lookup(const char *name, uint32_t hash) {
+  uint64_t   entry = hash % CHANNEL_HASH_SIZE;
+  uint32_t   value;
+  channel_t *channel;
+
+  for (uint64_t probe = 0; probe < CHANNEL_HASH_SIZE; probe++) {
+    value = channel_registry.hash_table[entry];
+
+    // the end of the probe sequence is reached
+    if (value == CHANNEL_HASH_FREE) {
+      break;
+    }
+
+    if (value != CHANNEL_HASH_DELETED) {
+      channel = &channel_registry.channels[value - 1];
+
+      if (channel->hash == hash && strcmp(channel->name, name) == 0) {
+        return entry;
+      }
+    }
+
+    entry = (entry + 1) % CHANNEL_HASH_SIZE;
+  }
+
+  return -1;
+}
 
 /******************************************************************************
  * @brief get the channel struct from the channel handler
  * @param channel handler
- * @return none
+ * @return channel, or NULL if the handler is not valid
  ******************************************************************************/
 static inline channel_t *channel_get_from_handler(
     const uint64_t channel_handler) {
-  return &channel[channel_handler];
+  uint64_t   index = CHANNEL_HANDLER_INDEX(channel_handler);
+  channel_t *channel;
+
+  if (index >= CONFIG_CHANNEL_MAX_NB) {
+    return NULL;
+  }
+
+  channel = &channel_registry.channels[index];
+
+  // the channel may have been destroyed
+  if (!channel->used ||
+      channel->generation != CHANNEL_HANDLER_GENERATION(channel_handler)) {
+    return NULL;
+  }
+
+  return channel;
 }
 
 /******************************************************************************
  * @brief create a communication channel between two tasks
  * @param channel handler
  * @param channel name
- * @return none
+ * @return K_OK if the channel is created, K_ERROR otherwise
  ******************************************************************************/
 k_return_t channel_create(uint64_t *channel_handler, const char *name) {
-  if (channel_index >= MAX_NB_CHANNEL) {
-    // we reached the maximum number of available channel
+  uint32_t   hash;
+  uint64_t   entry;
+  uint64_t   index;
+  uint64_t   flags;
+  channel_t *channel;
+
+  // the name must fit in the channel
+  if (strlen(name) >= CONFIG_CHANNEL_NAME_LENGTH) {
     return K_ERROR;
   }
 
-  // register the channel name
-  if (strlen(name) < MAX_CHANNEL_NAME_LENGTH) {
-    strcpy(channel[channel_index].name, name);
-  } else {
+  hash = channel_hash(name);
+
+  // the registry is shared by the harts
+  flags = smp_lock();
+
+  // a name identifies a single channel
+  if (channel_lookup(name, hash) >= 0) {
+    smp_unlock(flags);
     return K_ERROR;
   }
 
-  // create a channel
-  channel[channel_index].in  = NULL;
-  channel[channel_index].out = NULL;
+  // find a free channel
+  for (index = 0; index < CONFIG_CHANNEL_MAX_NB; index++) {
+    if (!channel_registry.channels[index].used) {
+      break;
+    }
+  }
+
+  if (index == CONFIG_CHANNEL_MAX_NB) {
+    // we reached the maximum number of available channel
+    smp_unlock(flags);
+    return K_ERROR;
+  }
 
-  // initialize channel access flag
-  channel[channel_index].rcv_rdy = false;
-  channel[channel_index].snd_rdy = false;
+  channel = &channel_registry.channels[index];
+
+  // register the channel name
+  strcpy(channel->name, name);
+  channel->hash = hash;
+  channel->used = true;
+
+  // no task is waiting on the channel yet
+  list_init(&channel->senders);
+  list_init(&channel->receivers);
+
+  // no task serves nor waits for the channel with wait_any()
+  channel->server  = NULL;
+  channel->watcher = NULL;
+  list_node_init(&channel->server_node);
+
+  // the table always has free entries as it's twice the
+  // maximum number of channels
+  entry = hash % CHANNEL_HASH_SIZE;
+  while (channel_registry.hash_table[entry] != CHANNEL_HASH_FREE &&
+         channel_registry.hash_table[entry] != CHANNEL_HASH_DELETED) {
+    entry = (entry + 1) % CHANNEL_HASH_SIZE;
+  }
+
+  channel_registry.hash_table[entry] = index + 1;
 
   // return the channel ID to the calling thread
-  *channel_handler = channel_index;
+  *channel_handler = CHANNEL_HANDLER(index, channel->generation);
 
-  // update next available channel index
-  channel_index += 1;
+  smp_unlock(flags);
 
   return K_OK;
 };
@@ -92,112 +251,831 @@ k_return_t channel_create(uint64_t *channel_handler, const char *name) {
  * @brief return the channel handler corresponding to the given name if any
  * @param channel handler
  * @param channel name
- * @return none
+ * @return K_OK if the channel is found, K_ERROR otherwise
  ******************************************************************************/
 k_return_t channel_get(uint64_t *channel_handler, const char *name) {
-  uint64_t chan_index = 0;
-  while (chan_index <= MAX_NB_CHANNEL) {
-    if (strcmp(channel[chan_index].name, name) == 0) {
-      // we found the channel corresponding to the given name
-      *channel_handler = chan_index;
-
-      return K_OK;
-    } else {
-      chan_index += 1;
-    }
+  uint32_t   hash  = channel_hash(name);
+  uint64_t   flags = smp_lock();
+  int64_t    entry = channel_lookup(name, hash);
+  channel_t *channel;
+  uint64_t   index;
+
+  if (entry < 0) {
+    smp_unlock(flags);
+    return K_ERROR;
   }
 
-  return K_ERROR;
+  // we found the channel corresponding to the given name
+  index   = channel_registry.hash_table[entry] - 1;
+  channel = &channel_registry.channels[index];
+
+  *channel_handler = CHANNEL_HANDLER(index, channel->generation);
+
+  smp_unlock(flags);
+
+  return K_OK;
 };
 
+/******************************************************************************
+ * @brief destroy a channel, its name can be registered again
+ * @param channel handler
+ * @return K_OK if the channel is destroyed, K_ERROR if the handler is not
+ * valid or if tasks are waiting on the channel
+ ******************************************************************************/
+k_return_t channel_destroy(const uint64_t channel_handler) {
+  uint64_t   flags   = smp_lock();
+  channel_t *channel = channel_get_from_handler(channel_handler);
+  int64_t    entry;
+
+  if (channel == NULL || !list_is_empty(&channel->senders) ||
+      !list_is_empty(&channel->receivers)) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  // the entry can't be freed as it may be in the middle of a probe sequence
+  entry = channel_lookup(channel->name, channel->hash);
+  channel_registry.hash_table[entry] = CHANNEL_HASH_DELETED;
+
+  if (channel->server != NULL) {
+    list_remove(&channel->server_node);
+    channel->server = NULL;
+  }
+
+  // all handlers to this channel are now obsolete
+  channel->watcher     = NULL;
+  channel->used        = false;
+  channel->generation += 1;
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief make a task the server of a channel
+ *
+ * The server is the last task which received from the channel, it inherits
+ * the priority of the senders blocked on the channel.
+ *
+ * @param channel
+ * @param receiving task
+ * @return none
+ ******************************************************************************/
+static void channel_set_server(channel_t *channel, task_t *task) {
+  task_t *server = channel->server;
+
+  if (server == task) {
+    return;
+  }
+
+  // the channel moves to the list of the new server
+  if (server != NULL) {
+    list_remove(&channel->server_node);
+  }
+
+  channel->server = task;
+  list_add_tail(&channel->server_node, &task->ipc_channels);
+
+  // the previous server no longer inherits from the senders
+  if (server != NULL) {
+    inherit_update_prio(server);
+  }
+}
+
+/******************************************************************************
+ * @brief bind a channel to a task waiting for it with wait_any()
+ *
+ * A single task waits for a channel, it gets the ready bit each time a sender
+ * blocks on the channel.
+ *
+ * @param channel handler
+ * @param task waiting for the channel
+ * @param ready bit of the channel in the task
+ * @return K_OK, K_ERROR if the handler is not valid or an another task waits
+ * for the channel
+ ******************************************************************************/
+k_return_t channel_watch(const uint64_t channel_handler, task_t *task,
+                         uint64_t bit) {
+  uint64_t   flags   = smp_lock();
+  channel_t *channel = channel_get_from_handler(channel_handler);
+
+  if (channel == NULL ||
+      (channel->watcher != NULL && channel->watcher != task)) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  channel->watcher   = task;
+  channel->watch_bit = bit;
+
+  // the task waits for the channel to receive from it
+  channel_set_server(channel, task);
+
+  // senders may already be blocked
+  if (!list_is_empty(&channel->senders)) {
+    wait_any_signal(task, bit);
+  }
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief unbind a channel from the task waiting for it with wait_any()
+ * @param channel handler
+ * @param task waiting for the channel
+ * @return none
+ ******************************************************************************/
+void channel_unwatch(const uint64_t channel_handler, task_t *task) {
+  uint64_t   flags   = smp_lock();
+  channel_t *channel = channel_get_from_handler(channel_handler);
+
+  if (channel != NULL && channel->watcher == task) {
+    channel->watcher = NULL;
+  }
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief check if a sender is blocked on a channel
+ * @param channel handler
+ * @return true if a receive doesn't block
+ ******************************************************************************/
+bool channel_has_sender(const uint64_t channel_handler) {
+  uint64_t   flags   = smp_lock();
+  channel_t *channel = channel_get_from_handler(channel_handler);
+  bool       ready   = channel && !list_is_empty(&channel->senders);
+
+  smp_unlock(flags);
+
+  return ready;
+}
+
+/******************************************************************************
+ * @brief queue a sender on a channel and signal the task serving it
+ *
+ * The server inherits the priority of the sender and the task waiting for the
+ * channel with wait_any() is woken up. The sender blocks right after, the
+ * signaled task is elected by its scheduler.
+ *
+ * @param channel
+ * @param blocked sender
+ * @return none
+ ******************************************************************************/
+static void channel_queue_sender(channel_t *channel, task_t *sender) {
+  sender->ipc_channel = channel;
+  sender->ipc_sending = true;
+  wait_queue_add(&channel->senders, sender);
+
+  if (channel->server != NULL) {
+    inherit_update_prio(channel->server);
+  }
+
+  if (channel->watcher) {
+    wait_any_signal(channel->watcher, channel->watch_bit);
+  }
+}
+
+/******************************************************************************
+ * @brief queue a receiver on a channel
+ * @param channel
+ * @param blocked receiver
+ * @return none
+ ******************************************************************************/
+static inline void channel_queue_receiver(channel_t *channel,
+                                          task_t    *receiver) {
+  receiver->ipc_channel = channel;
+  receiver->ipc_sending = false;
+  wait_queue_add(&channel->receivers, receiver);
+}
+
+/******************************************************************************
+ * @brief remove the highest priority task from a channel wait queue
+ * @param senders or receivers wait queue
+ * @return removed task or NULL if the wait queue is empty
+ ******************************************************************************/
+static inline task_t *channel_pop(list_node_t *queue) {
+  task_t *task = wait_queue_pop(queue);
+
+  if (task != NULL) {
+    task->ipc_channel = NULL;
+  }
+
+  return task;
+}
+
+/******************************************************************************
+ * @brief make a receiver serve a caller until it replies
+ *
+ * The receiver runs at the priority of the caller, so that a task of a lower
+ * priority than the caller can't delay the reply.
+ *
+ * @param receiving task
+ * @param caller waiting for the reply, or NULL for a plain message
+ * @return none
+ ******************************************************************************/
+static inline void channel_serve(task_t *receiver, task_t *caller) {
+  receiver->ipc_caller = caller;
+
+  if (caller != NULL) {
+    caller->ipc_server = receiver;
+  }
+
+  inherit_update_prio(receiver);
+}
+
+/******************************************************************************
+ * @brief get the highest priority a task inherits from the tasks it serves
+ *
+ * A task inherits the priority of the caller it serves until it replies, and
+ * the one of the highest priority sender blocked on the channels it serves.
+ *
+ * @param server task
+ * @return highest inherited priority, 0 if no task waits for the server
+ ******************************************************************************/
+uint8_t channel_inherited_prio(task_t *task) {
+  uint8_t      prio = 0;
+  list_node_t *node;
+  task_t      *sender;
+
+  if (task->ipc_caller != NULL) {
+    prio = task->ipc_caller->prio;
+  }
+
+  list_for_each(node, &task->ipc_channels) {
+    sender = wait_queue_first(
+        &container_of(node, channel_t, server_node)->senders);
+
+    if (sender != NULL && sender->prio > prio) {
+      prio = sender->prio;
+    }
+  }
+
+  return prio;
+}
+
+/******************************************************************************
+ * @brief move a task whose priority changed in its channel wait queue
+ * @param task blocked on a channel
+ * @return task which inherits the new priority: the server of the channel
+ * for a sender, the server handling the call of a caller waiting for its
+ * reply, NULL otherwise
+ ******************************************************************************/
+task_t *channel_requeue(task_t *task) {
+  channel_t *channel = task->ipc_channel;
+
+  // a caller whose request has been received waits for the reply
+  if (channel == NULL) {
+    return task->ipc_server;
+  }
+
+  list_remove(&task->wait);
+
+  if (!task->ipc_sending) {
+    wait_queue_add(&channel->receivers, task);
+    return NULL;
+  }
+
+  wait_queue_add(&channel->senders, task);
+
+  return channel->server;
+}
+
+/******************************************************************************
+ * @brief stop waiting on a channel and serving channels, used when a task is
+ * destroyed
+ *
+ * A server handling the call of the task won't reply to it and gives the
+ * priority of the task back.
+ *
+ * @param task to remove from the channels
+ * @return none
+ ******************************************************************************/
+void channel_cancel_wait(task_t *task) {
+  uint64_t     flags   = smp_lock();
+  channel_t   *channel = task->ipc_channel;
+  task_t      *server  = task->ipc_server;
+  list_node_t *node;
+
+  if (channel != NULL) {
+    list_remove(&task->wait);
+    task->ipc_channel = NULL;
+
+    // the server may have inherited the priority of the sender
+    if (task->ipc_sending && channel->server != NULL) {
+      inherit_update_prio(channel->server);
+    }
+  }
+
+  if (server != NULL && server->ipc_caller == task) {
+    server->ipc_caller = NULL;
+    inherit_update_prio(server);
+  }
+
+  task->ipc_server = NULL;
+
+  // the channels served by the task are left without server
+  while ((node = list_first(&task->ipc_channels)) != NULL) {
+    list_remove(node);
+    container_of(node, channel_t, server_node)->server = NULL;
+  }
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief copy a bulk message under the kernel lock
+ *
+ * The copy is split in chunks with an interrupt window in between: the length
+ * of a message doesn't bound the interrupt latency of the hart. The blocked
+ * peer is out of the channel queues, an interrupt handler can't reach it.
+ *
+ * @param destination buffer
+ * @param source buffer
+ * @param length in bytes
+ * @return none
+ ******************************************************************************/
+static void channel_copy(void *dst, const void *src, uint64_t len) {
+  uint8_t       *to   = dst;
+  const uint8_t *from = src;
+  uint64_t       chunk;
+
+  while (len) {
+    chunk = len < CONFIG_CHANNEL_COPY_CHUNK ? len : CONFIG_CHANNEL_COPY_CHUNK;
+
+    memcpy(to, from, chunk);
+
+    to   += chunk;
+    from += chunk;
+    len  -= chunk;
+
+    if (len) {
+      smp_irq_window();
+    }
+  }
+}
+
+/******************************************************************************
+ * @brief compute how a message is transferred to a waiting receiver
+ *
+ * The message is truncated to the receiver buffer size. Short messages are
+ * passed in registers, longer ones are copied from the sender buffer to the
+ * receiver buffer.
+ *
+ * @param receiver task
+ * @param msg pointer
+ * @param length of the message, updated with the transferred length
+ * @return number of words to pass in registers
+ ******************************************************************************/
+static uint64_t channel_transfer(task_t *receiver, const uint64_t *msg,
+                                 uint64_t *msg_len) {
+  uint64_t nb_words;
+
+  // the message is truncated to the receiver buffer size
+  if (*msg_len > receiver->ipc_len) {
+    *msg_len = receiver->ipc_len;
+  }
+
+  // number of words needed to hold the message
+  nb_words = (*msg_len + DOUBLE_WORD_SIZE - 1) / DOUBLE_WORD_SIZE;
+
+  if (nb_words > CHANNEL_MSG_REG_NB ||
+      nb_words * DOUBLE_WORD_SIZE > receiver->ipc_len) {
+    // bulk path, both tasks are rendezvoused so the message is copied
+    // from the sender buffer to the receiver buffer
+    channel_copy(receiver->ipc_msg, msg, *msg_len);
+    nb_words = 0;
+  }
+
+  return nb_words;
+}
+
+/******************************************************************************
+ * @brief copy the message of a blocked sender in the receiver buffer
+ *
+ * A plain sender is made ready again. A caller stays blocked until the
+ * receiver replies, its reply buffer becomes the buffer to transfer into. The
+ * receiver gives up the priority of the sender, unless it serves its call.
+ *
+ * @param receiving task
+ * @param blocked sender
+ * @param msg pointer
+ * @param size of the msg buffer, updated with the received message length
+ * @return none
+ ******************************************************************************/
+static void channel_pull(task_t *receiver, task_t *sender, uint64_t *msg,
+                         uint64_t *msg_len) {
+  if (*msg_len > sender->ipc_len) {
+    *msg_len = sender->ipc_len;
+  }
+
+  channel_copy(msg, sender->ipc_msg, *msg_len);
+
+  if (sender->ipc_call) {
+    sender->ipc_msg = sender->ipc_reply;
+    sender->ipc_len = sender->ipc_reply_len;
+    channel_serve(receiver, sender);
+  } else {
+    channel_serve(receiver, NULL);
+    task_set_state(sender, READY);
+    sched_add_task(sender);
+  }
+}
+
+/******************************************************************************
+ * @brief check if a blocked peer can be switched to from this hart
+ *
+ * A direct switch runs the peer on the hart of the current task, it's limited
+ * to peers queued on this hart so that no task migrates.
+ *
+ * @param current task
+ * @param blocked peer
+ * @return true if the peer is queued on the hart of the current task
+ ******************************************************************************/
+static inline bool channel_is_local(task_t *task, task_t *peer) {
+  return peer->hart == task->hart;
+}
+
+/******************************************************************************
+ * @brief deposit a message in the buffer of a peer from an another hart
+ *
+ * The message is copied in the buffer registered in the peer task, which is
+ * woken up on its own hart by an inter-processor interrupt. The current task
+ * keeps its cpu.
+ *
+ * @param blocked peer
+ * @param msg pointer
+ * @param length of the message
+ * @return none
+ ******************************************************************************/
+static void channel_deposit(task_t *peer, const uint64_t *msg,
+                            uint64_t msg_len) {
+  // the message is truncated to the peer buffer size
+  if (msg_len > peer->ipc_len) {
+    msg_len = peer->ipc_len;
+  }
+
+  channel_copy(peer->ipc_msg, msg, msg_len);
+
+  // the peer reads the length once resumed by its scheduler
+  peer->ipc_len              = msg_len;
+  peer->thread.msg_deposited = true;
+
+  task_set_state(peer, READY);
+  sched_add_task(peer);
+}
+
+/******************************************************************************
+ * @brief get the length of the message received by a resumed task
+ * @param resumed task
+ * @param length of the message passed by a direct switch
+ * @return length of the received message
+ ******************************************************************************/
+static inline uint64_t channel_received(task_t *task, uint64_t msg_len) {
+  if (task->thread.msg_deposited) {
+    task->thread.msg_deposited = false;
+    return task->ipc_len;
+  }
+
+  return msg_len;
+}
+
+/******************************************************************************
+ * @brief make a blocked receiver the current task
+ * @param current task, which stays ready
+ * @param receiving task, queued on the same hart
+ * @return none
+ ******************************************************************************/
+static inline void channel_hand_over(task_t *task, task_t *receiver) {
+  task_set_state(task, READY);
+  sched_add_task(receiver);
+  task_set_state(receiver, RUNNING);
+  sched_set_current_task(receiver);
+}
+
+/******************************************************************************
+ * @brief block the current task until a message is switched to it
+ * @param current task
+ * @param msg pointer
+ * @return length of the received message
+ ******************************************************************************/
+static uint64_t channel_block_rcv(task_t *task, uint64_t *msg) {
+  task_t  *next_task;
+  uint64_t msg_len;
+
+  // release the cpu
+  task_set_state(task, BLOCKED);
+  sched_remove_task(task);
+
+  // the task is resumed by the sender direct switch,
+  // in _channel_rcv, with the message
+  next_task = sched_elect_task();
+
+  msg_len = _channel_rcv(&task->thread, &next_task->thread, msg);
+
+  return channel_received(task, msg_len);
+}
+
 /******************************************************************************
  * @brief send a message through a communication channel
  * @param channel handler
  * @param msg pointer
  * @param length of message to send
- * @return none
+ * @return K_OK, K_ERROR if the handler is not valid
  ******************************************************************************/
-void channel_snd(const uint64_t channel_handler, const uint64_t *msg,
-                 uint64_t msg_len) {
-  // find channel from handler ID
-  channel_t *channel = channel_get_from_handler(channel_handler);
+k_return_t channel_snd(const uint64_t channel_handler, const uint64_t *msg,
+                       uint64_t msg_len) {
+  task_t  *sender = sched_get_current_task();
+  task_t  *receiver;
+  uint64_t nb_words;
+  uint64_t flags;
 
-  // register the sender task
-  channel->in = sched_get_current_task();
+  channel_t *channel;
 
-  // set the task as ready to send
-  channel->snd_rdy = true;
+  // the channel may be destroyed from an another hart until the lock is
+  // held, wait queues are also updated by tasks woken up from interrupts
+  flags = smp_lock();
 
-  // block until a rcv task is ready
-  // we may be awaken up by another task
-  while (!channel->rcv_rdy) {
-    // there is no waiting task, go to BLOCKED state and
-    // release the cpu
-    task_set_state(channel->in, BLOCKED);
-    // remove it from the run queue
-    sched_remove_task(channel->in);
+  // find channel from handler ID
+  channel = channel_get_from_handler(channel_handler);
 
-    sched_run();
+  if (channel == NULL) {
+    smp_unlock(flags);
+    return K_ERROR;
   }
 
-  // snd task is in RUNNING state, set it to READY state
-  task_set_state(channel->in, READY);
+  TRACE(TRACE_CHANNEL_SND, channel_handler, msg_len);
+  sender->ipc_sent += 1;
+
+  receiver = channel_pop(&channel->receivers);
 
-  // there is a waiting task so switch to it
-  sched_add_task(channel->out);
-  task_set_state(channel->out, RUNNING);
-  sched_set_current_task(channel->out);
+  if (receiver == NULL) {
+    // there is no waiting task, the first receiver copies the message
+    // from the sender buffer
+    sender->ipc_msg = (uint64_t *)msg;
+    sender->ipc_len = msg_len;
+    channel_queue_sender(channel, sender);
 
-  if (msg_len <= DOUBLE_WORD_SIZE) {
-    // fast path for short messages
-    // direct switch without calling the scheduler
-    _channel_snd(channel->in, channel->out, msg);
+    // go to BLOCKED state and release the cpu
+    task_set_state(sender, BLOCKED);
+    sched_remove_task(sender);
+    sched_run();
+  } else if (!channel_is_local(sender, receiver)) {
+    // the receiver is woken up on its hart, the sender goes on
+    channel_serve(receiver, NULL);
+    channel_deposit(receiver, msg, msg_len);
   } else {
-    // slow path
-    // need to be implemented
+    nb_words = channel_transfer(receiver, msg, &msg_len);
+    channel_serve(receiver, NULL);
+
+    // there is a waiting task so switch to it
+    channel_hand_over(sender, receiver);
+
+    // direct switch without calling the scheduler, short messages
+    // are passed in registers
+    _channel_snd(&sender->thread, &receiver->thread, msg, nb_words, msg_len);
   }
 
-  // set the task as ready to send
-  channel->snd_rdy = false;
+  smp_unlock(flags);
+
+  return K_OK;
 };
 
 /******************************************************************************
  * @brief receive a message through a communication channel
  * @param channel handler
  * @param msg pointer
- * @param length of message to send
- * @return none
+ * @param size of the msg buffer, updated with the received message length
+ * @return K_OK, K_ERROR if the handler is not valid
  ******************************************************************************/
-void channel_rcv(const uint64_t channel_handler, const uint64_t *msg,
-                 uint64_t *msg_len) {
+k_return_t channel_rcv(const uint64_t channel_handler, uint64_t *msg,
+                       uint64_t *msg_len) {
+  task_t  *receiver = sched_get_current_task();
+  task_t  *sender;
+  uint64_t flags;
+
+  channel_t *channel;
+
+  // the channel may be destroyed from an another hart until the lock is
+  // held, wait queues are also updated by tasks woken up from interrupts
+  flags = smp_lock();
+
   // find channel from handler ID
-  channel_t *channel = channel_get_from_handler(channel_handler);
+  channel = channel_get_from_handler(channel_handler);
+
+  if (channel == NULL) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  // the receiver inherits the priority of the next senders
+  channel_set_server(channel, receiver);
 
-  // register the rcv task
-  channel->out = sched_get_current_task();
+  sender = channel_pop(&channel->senders);
 
-  // set the task as ready to receive
-  channel->rcv_rdy = true;
+  if (sender != NULL) {
+    // the highest priority sender is blocked, copy its message
+    channel_pull(receiver, sender, msg, msg_len);
 
-  if (channel->snd_rdy) {
-    // snd task is blocked, waiting to send its message
-    task_set_state(channel->in, READY);
-    // add it to the run queue
-    sched_add_task(channel->in);
+    // the sender may have a higher priority
+    task_set_state(receiver, READY);
+    sched_run();
+  } else {
+    // register the buffer the sender writes into
+    receiver->ipc_msg = msg;
+    receiver->ipc_len = *msg_len;
+    channel_queue_receiver(channel, receiver);
+
+    *msg_len = channel_block_rcv(receiver, msg);
   }
 
-  // release the cpu
-  task_set_state(channel->out, BLOCKED);
+  TRACE(TRACE_CHANNEL_RCV, channel_handler, *msg_len);
+  receiver->ipc_received += 1;
+
+  smp_unlock(flags);
+
+  return K_OK;
+};
+
+/******************************************************************************
+ * @brief send a request through a channel and wait for the reply
+ * @param channel handler
+ * @param request pointer
+ * @param length of the request
+ * @param reply pointer
+ * @param size of the reply buffer, updated with the reply length
+ * @return K_OK, K_ERROR if the handler is not valid
+ ******************************************************************************/
+k_return_t channel_call(const uint64_t channel_handler, const uint64_t *msg,
+                        uint64_t msg_len, uint64_t *reply,
+                        uint64_t *reply_len) {
+  task_t  *caller = sched_get_current_task();
+  task_t  *receiver;
+  uint64_t nb_words;
+  uint64_t flags;
+
+  channel_t *channel;
+
+  // the channel may be destroyed from an another hart until the lock is
+  // held, wait queues are also updated by tasks woken up from interrupts
+  flags = smp_lock();
+
+  // find channel from handler ID
+  channel = channel_get_from_handler(channel_handler);
+
+  if (channel == NULL) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  TRACE(TRACE_CHANNEL_SND, channel_handler, msg_len);
+  caller->ipc_sent += 1;
+
+  // the receiver replies in this buffer
+  caller->ipc_call      = true;
+  caller->ipc_reply     = reply;
+  caller->ipc_reply_len = *reply_len;
+
+  receiver = channel_pop(&channel->receivers);
+
+  if (receiver == NULL) {
+    // the first receiver copies the request and keeps the caller blocked
+    caller->ipc_msg = (uint64_t *)msg;
+    caller->ipc_len = msg_len;
+    channel_queue_sender(channel, caller);
+
+    *reply_len = channel_block_rcv(caller, reply);
+  } else if (!channel_is_local(caller, receiver)) {
+    // the receiver is woken up on its hart, the caller waits for the reply
+    // like a receiver
+    channel_serve(receiver, caller);
+    channel_deposit(receiver, msg, msg_len);
+
+    caller->ipc_msg = reply;
+    caller->ipc_len = *reply_len;
+    *reply_len      = channel_block_rcv(caller, reply);
+  } else {
+    nb_words = channel_transfer(receiver, msg, &msg_len);
+    channel_serve(receiver, caller);
+
+    // the caller blocks until the reply
+    caller->ipc_msg = reply;
+    caller->ipc_len = *reply_len;
+    channel_hand_over(caller, receiver);
+    task_set_state(caller, BLOCKED);
+    sched_remove_task(caller);
+
+    // send the request and wait for the reply with a single switch
+    *reply_len = _channel_call(&caller->thread, &receiver->thread, msg,
+                               nb_words, msg_len, reply);
+    *reply_len = channel_received(caller, *reply_len);
+  }
+
+  TRACE(TRACE_CHANNEL_RCV, channel_handler, *reply_len);
+  caller->ipc_received += 1;
+
+  caller->ipc_call   = false;
+  caller->ipc_server = NULL;
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief reply to the last caller and wait for the next request
+ * @param channel handler
+ * @param reply pointer
+ * @param length of the reply
+ * @param request pointer
+ * @param size of the request buffer, updated with the request length
+ * @return K_OK, K_ERROR if the handler is not valid
+ ******************************************************************************/
+k_return_t channel_reply_wait(const uint64_t  channel_handler,
+                              const uint64_t *reply, uint64_t reply_len,
+                              uint64_t *msg, uint64_t *msg_len) {
+  task_t  *receiver = sched_get_current_task();
+  task_t  *caller;
+  task_t  *sender;
+  uint64_t nb_words;
+  uint64_t flags;
+
+  channel_t *channel;
 
-  // remove it from the run queue
-  sched_remove_task(channel->out);
+  // the channel may be destroyed from an another hart until the lock is
+  // held, wait queues are also updated by tasks woken up from interrupts
+  flags = smp_lock();
 
-  _channel_rcv(msg);
+  // the caller may be cancelled and destroyed from an another hart, it's
+  // only read under the lock
+  caller = receiver->ipc_caller;
 
-  // the message has been copied but not consumed. We can unblock
-  // the snd thread but we uncheck the rcv_rdy flag to avoid the snd thread
-  // to re-send a message.
-  channel->rcv_rdy = false;
+  // there is no one to reply to, only wait for a request
+  if (caller == NULL) {
+    smp_unlock(flags);
+    return channel_rcv(channel_handler, msg, msg_len);
+  }
+
+  // find channel from handler ID
+  channel = channel_get_from_handler(channel_handler);
+
+  if (channel == NULL) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  TRACE(TRACE_CHANNEL_SND, channel_handler, reply_len);
+  receiver->ipc_sent += 1;
+
+  // the caller gets its reply, the receiver gives its priority back
+  caller->ipc_server = NULL;
+  channel_set_server(channel, receiver);
+
+  if (!channel_is_local(receiver, caller)) {
+    // the reply is deposited for the caller, this task goes on with the next
+    // request
+    channel_serve(receiver, NULL);
+    channel_deposit(caller, reply, reply_len);
+
+    smp_unlock(flags);
+
+    return channel_rcv(channel_handler, msg, msg_len);
+  }
 
-  // !!! unlock snd task here !!!
-};
\ No newline at end of file
+  nb_words = channel_transfer(caller, reply, &reply_len);
+  sender   = channel_pop(&channel->senders);
+
+  if (sender != NULL) {
+    // the next request is already there, copy it then give the
+    // reply to the caller, this task stays ready
+    channel_pull(receiver, sender, msg, msg_len);
+    channel_hand_over(receiver, caller);
+
+    _channel_snd(&receiver->thread, &caller->thread, reply, nb_words,
+                 reply_len);
+  } else {
+    // wait for the next request while the reply is switched to the caller
+    channel_serve(receiver, NULL);
+    receiver->ipc_msg = msg;
+    receiver->ipc_len = *msg_len;
+    channel_queue_receiver(channel, receiver);
+
+    channel_hand_over(receiver, caller);
+    task_set_state(receiver, BLOCKED);
+    sched_remove_task(receiver);
+
+    *msg_len = _channel_call(&receiver->thread, &caller->thread, reply,
+                             nb_words, reply_len, msg);
+    *msg_len = channel_received(receiver, *msg_len);
+  }
+
+  TRACE(TRACE_CHANNEL_RCV, channel_handler, *msg_len);
+  receiver->ipc_received += 1;
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
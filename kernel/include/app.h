@@ -20,17 +20,67 @@
 
 #include "task.h"
 
-#define _app_section __attribute__((section(".data.apps")))
-
-#define REGISTER_APP(_entry_name, _entry, _entry_stack, _prio) \
-  app_info_t app_##_entry = {                                  \
-      .name  = _entry_name,                                    \
-      .stack = &_entry_stack,                                  \
-      .prio  = _prio,                                          \
-      .entry = _entry,                                         \
-  };                                                           \
+#define _app_section     __attribute__((section(".data.apps")))
+#define _channel_section __attribute__((section(".data.channels")))
+
+/**
+ * @brief register an app started on hart 0, it can run on any hart
+ */
+#define REGISTER_APP(_entry_name, _entry, _entry_stack, _prio)          \
+  _REGISTER_APP(_entry_name, _entry, _entry_stack, _prio, 0,            \
+                TASK_AFFINITY_ALL)
+
+/**
+ * @brief register an app pinned to a given hart, the tasks it creates are
+ * pinned to the same hart
+ */
+#define REGISTER_APP_ON(_entry_name, _entry, _entry_stack, _prio, _hart) \
+  _REGISTER_APP(_entry_name, _entry, _entry_stack, _prio, _hart,         \
+                TASK_AFFINITY_HART(_hart))
+
+/**
+ * @brief register an earliest deadline first app, pinned to hart 0, with its
+ * period, budget and relative deadline in us
+ */
+#define REGISTER_APP_EDF(_entry_name, _entry, _entry_stack, _period_us,   \
+                         _budget_us, _deadline_us)                        \
+  app_info_t app_##_entry = {                                             \
+      .name       = _entry_name,                                          \
+      .stack      = &_entry_stack,                                        \
+      .stack_size = sizeof(_entry_stack),                                 \
+      .hart       = 0,                                                    \
+      .affinity   = TASK_AFFINITY_HART(0),                                \
+      .edf        = {.period_us   = _period_us,                           \
+                     .budget_us   = _budget_us,                           \
+                     .deadline_us = _deadline_us},                        \
+      .entry      = _entry,                                               \
+  };                                                                      \
+  _app_section app_info_t *app_##_entry##_pt = &app_##_entry;
+
+#define _REGISTER_APP(_entry_name, _entry, _entry_stack, _prio, _hart, \
+                      _affinity)                                       \
+  app_info_t app_##_entry = {                                          \
+      .name       = _entry_name,                                       \
+      .stack      = &_entry_stack,                                     \
+      .stack_size = sizeof(_entry_stack),                              \
+      .prio       = _prio,                                             \
+      .hart       = _hart,                                             \
+      .affinity   = _affinity,                                         \
+      .entry      = _entry,                                            \
+  };                                                                   \
   _app_section app_info_t *app_##_entry##_pt = &app_##_entry;
 
+/**
+ * @brief register a channel created at boot before the apps, its handler is
+ * read from the descriptor without any syscall
+ */
+#define REGISTER_CHANNEL(_var, _name)      \
+  app_channel_t _var = {                   \
+      .name    = _name,                    \
+      .handler = 0,                        \
+  };                                       \
+  _channel_section app_channel_t *_var##_pt = &_var;
+
 /**
  * @brief structure to save apps parameters
  * @param None
@@ -38,9 +88,21 @@
  */
 typedef struct {
   const char *name;
-  stack_t    *stack;
+  void       *stack;
+  uint64_t    stack_size;
   uint8_t     prio;
+  uint64_t    hart;
+  uint64_t    affinity;
+  task_edf_t  edf;
   void        (*entry)(void);
 } app_info_t;
 
+/**
+ * @brief structure to save a static channel, the handler is set at boot
+ */
+typedef struct {
+  const char *name;
+  uint64_t    handler;
+} app_channel_t;
+
 #endif
\ No newline at end of file
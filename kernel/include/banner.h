@@ -27,7 +27,8 @@
  * @return None
  */
 void banner_display(void) {
-  printk("Anckor OS build " BUILD_VERSION " - " BUILD_DATE " " BUILD_HOUR
+  // printed right away, before the output of the apps
+  printf("Anckor OS build " BUILD_VERSION " - " BUILD_DATE " " BUILD_HOUR
          "\r\n");
 }
 
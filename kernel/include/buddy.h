@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef BUDDY_H
+#define BUDDY_H
+
+#include "common.h"
+
+/******************************************************************************
+ * block orders handled by the allocator, a block of order n is 2^n bytes
+ ******************************************************************************/
+#define BUDDY_MIN_ORDER 6
+#define BUDDY_MAX_ORDER 23
+#define BUDDY_NB_ORDERS (BUDDY_MAX_ORDER - BUDDY_MIN_ORDER + 1)
+
+/******************************************************************************
+ * @brief initialize the heap with the memory left after the bss section
+ * @param none
+ * @return none
+ ******************************************************************************/
+void buddy_init();
+
+/******************************************************************************
+ * @brief get the order of the smallest block holding a given size
+ * @param size in bytes
+ * @return block order, above BUDDY_MAX_ORDER if the size is too big
+ ******************************************************************************/
+uint8_t buddy_order(uint64_t);
+
+/******************************************************************************
+ * @brief allocate a block, it's aligned on its own size
+ * @param block order
+ * @return block address, or NULL if there is no free block big enough
+ ******************************************************************************/
+void *buddy_alloc(uint8_t);
+
+/******************************************************************************
+ * @brief release a block allocated with buddy_alloc()
+ * @param block address
+ * @param block order given to buddy_alloc()
+ * @return none
+ ******************************************************************************/
+void buddy_free(void *, uint8_t);
+
+/******************************************************************************
+ * @brief get the amount of free memory in the heap
+ * @param none
+ * @return free memory in bytes
+ ******************************************************************************/
+uint64_t buddy_free_size();
+
+#endif
@@ -20,6 +20,8 @@
 #include "common.h"
 #include "processor.h"
 
+struct task_t;
+
 /******************************************************************************
  * @brief create a communication channel between two tasks
  * @param channel handler
@@ -35,22 +37,100 @@ k_return_t channel_create(uint64_t *, const char *);
  ******************************************************************************/
 k_return_t channel_get(uint64_t *channel_handler, const char *name);
 
+/******************************************************************************
+ * @brief destroy a channel, its name can be registered again
+ * @param channel handler
+ * @return K_OK, K_ERROR if the handler is not valid or tasks are waiting
+ ******************************************************************************/
+k_return_t channel_destroy(const uint64_t);
+
 /******************************************************************************
  * @brief send a message through a communication channel
  * @param channel handler
  * @param msg pointer
  * @param length of message to send
- * @return none
+ * @return K_OK, K_ERROR if the handler is not valid
  ******************************************************************************/
-void channel_snd(const uint64_t, const uint64_t *, uint64_t);
+k_return_t channel_snd(const uint64_t, const uint64_t *, uint64_t);
 
 /******************************************************************************
  * @brief receive a message through a communication channel
  * @param channel handler
  * @param msg pointer
- * @param length of received message
+ * @param size of the msg buffer, updated with the received message length
+ * @return K_OK, K_ERROR if the handler is not valid
+ ******************************************************************************/
+k_return_t channel_rcv(const uint64_t, uint64_t *, uint64_t *);
+
+/******************************************************************************
+ * @brief send a request through a channel and wait for the reply
+ * @param channel handler
+ * @param request pointer
+ * @param length of the request
+ * @param reply pointer
+ * @param size of the reply buffer, updated with the reply length
+ * @return K_OK, K_ERROR if the handler is not valid
+ ******************************************************************************/
+k_return_t channel_call(const uint64_t, const uint64_t *, uint64_t, uint64_t *,
+                        uint64_t *);
+
+/******************************************************************************
+ * @brief reply to the last caller and wait for the next request
+ * @param channel handler
+ * @param reply pointer
+ * @param length of the reply
+ * @param request pointer
+ * @param size of the request buffer, updated with the request length
+ * @return K_OK, K_ERROR if the handler is not valid
+ ******************************************************************************/
+k_return_t channel_reply_wait(const uint64_t, const uint64_t *, uint64_t,
+                              uint64_t *, uint64_t *);
+
+/******************************************************************************
+ * @brief bind a channel to a task waiting for it with wait_any()
+ * @param channel handler
+ * @param task waiting for the channel
+ * @param ready bit of the channel in the task
+ * @return K_OK, K_ERROR if the handler is not valid or an another task waits
+ * for the channel
+ ******************************************************************************/
+k_return_t channel_watch(const uint64_t, struct task_t *, uint64_t);
+
+/******************************************************************************
+ * @brief unbind a channel from the task waiting for it with wait_any()
+ * @param channel handler
+ * @param task waiting for the channel
+ * @return none
+ ******************************************************************************/
+void channel_unwatch(const uint64_t, struct task_t *);
+
+/******************************************************************************
+ * @brief check if a sender is blocked on a channel
+ * @param channel handler
+ * @return true if a receive doesn't block
+ ******************************************************************************/
+bool channel_has_sender(const uint64_t);
+
+/******************************************************************************
+ * @brief get the highest priority a task inherits from the tasks it serves
+ * @param server task
+ * @return highest inherited priority, 0 if no task waits for the server
+ ******************************************************************************/
+uint8_t channel_inherited_prio(struct task_t *);
+
+/******************************************************************************
+ * @brief move a task whose priority changed in its channel wait queue
+ * @param task blocked on a channel
+ * @return task which inherits the new priority, or NULL
+ ******************************************************************************/
+struct task_t *channel_requeue(struct task_t *);
+
+/******************************************************************************
+ * @brief stop waiting on a channel and serving channels, used when a task is
+ * destroyed
+ * @param task to remove from the channels
  * @return none
  ******************************************************************************/
-void channel_rcv(const uint64_t, const uint64_t *, uint64_t *);
+void channel_cancel_wait(struct task_t *);
 
 #endif
\ No newline at end of file
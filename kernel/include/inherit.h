@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef INHERIT_H
+#define INHERIT_H
+
+#include "common.h"
+#include "task.h"
+
+/******************************************************************************
+ * @brief give a task the highest priority inherited from the tasks it blocks
+ *
+ * A task inherits the priority of the waiters of the mutexes it owns, of the
+ * caller it serves and of the senders blocked on the channels it serves. The
+ * new priority is propagated along the chain of tasks the updated task is
+ * blocked on: the owner of the mutex it waits for, the server of the channel
+ * it's queued on, or the server handling its call. The caller holds the
+ * kernel lock.
+ *
+ * @param task to update
+ * @return none
+ ******************************************************************************/
+void inherit_update_prio(task_t *);
+
+#endif
@@ -18,10 +18,10 @@
 #define INIT_H
 
 /******************************************************************************
- * @brief create the init task
+ * @brief create the registered channels and apps in one pass at boot
  * @param None
  * @return None
  ******************************************************************************/
-void init_create(void);
+void init_run(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef IRQSOFF_H
+#define IRQSOFF_H
+
+#include "common.h"
+#include "processor.h"
+#include "timer_arch.h"
+
+#ifndef CONFIG_HART_MAX_NB
+#define CONFIG_HART_MAX_NB 4
+#endif
+
+// an interval opened by an interrupt records its mcause as site
+#define IRQSOFF_SITE_IRQ(_cause) ((1UL << 63) | (_cause))
+
+/******************************************************************************
+ * @struct irqsoff_stats_t
+ * @brief intervals a hart has run with interrupts disabled
+ *
+ * Durations are in mtime ticks. The site of the longest interval is the
+ * caller of smp_lock() which disabled the interrupts, or IRQSOFF_SITE_IRQ()
+ * of the interrupt which was served.
+ ******************************************************************************/
+typedef struct irqsoff_stats_t {
+  uint64_t max;
+  uint64_t max_site;
+  uint64_t total;
+  uint64_t count;
+} irqsoff_stats_t;
+
+/******************************************************************************
+ * @struct irqsoff_hart_t
+ * @brief interval being measured on a hart
+ *
+ * Only the hart itself writes its state, always with interrupts disabled.
+ ******************************************************************************/
+typedef struct irqsoff_hart_t {
+  uint64_t        since;
+  uint64_t        site;
+  bool            active;
+  irqsoff_stats_t stats;
+} __attribute__((aligned(CACHE_LINE_SIZE))) irqsoff_hart_t;
+
+extern irqsoff_hart_t irqsoff_harts[CONFIG_HART_MAX_NB];
+
+#ifdef CONFIG_IRQSOFF
+/******************************************************************************
+ * the interrupts of the hart have just been disabled, and the end of an
+ * interval once they are about to be enabled again. Measure points compiled
+ * out don't evaluate their arguments.
+ ******************************************************************************/
+#define IRQSOFF_BEGIN(_site) irqsoff_begin((uint64_t)(_site))
+#define IRQSOFF_END()        irqsoff_end()
+#else
+#define IRQSOFF_BEGIN(_site) \
+  do {                       \
+  } while (0)
+#define IRQSOFF_END() \
+  do {                \
+  } while (0)
+#endif
+
+/******************************************************************************
+ * @brief start an interval, an interval already started goes on
+ * @param code which disabled the interrupts
+ * @return none
+ ******************************************************************************/
+static inline void irqsoff_begin(uint64_t site) {
+  irqsoff_hart_t *hart = &irqsoff_harts[hart_id_get()];
+
+  if (!hart->active) {
+    hart->active = true;
+    hart->site   = site;
+    hart->since  = timer_arch_get_time();
+  }
+}
+
+/******************************************************************************
+ * @brief end the interval of the hart and account it
+ * @param none
+ * @return none
+ ******************************************************************************/
+static inline void irqsoff_end() {
+  irqsoff_hart_t *hart = &irqsoff_harts[hart_id_get()];
+  uint64_t        length;
+
+  if (!hart->active) {
+    return;
+  }
+
+  length       = timer_arch_get_time() - hart->since;
+  hart->active = false;
+
+  hart->stats.total += length;
+  hart->stats.count += 1;
+
+  if (length > hart->stats.max) {
+    hart->stats.max      = length;
+    hart->stats.max_site = hart->site;
+  }
+}
+
+/******************************************************************************
+ * @brief end the interval of the hart before the return from an interrupt
+ * @param none
+ * @return none
+ ******************************************************************************/
+void irqsoff_exit();
+
+/******************************************************************************
+ * @brief read the intervals measured on a hart
+ * @param hart identifier
+ * @param statistics to fill
+ * @return K_OK, or K_ERROR if the hart doesn't exist or the measure is
+ * compiled out
+ ******************************************************************************/
+k_return_t irqsoff_read(uint64_t, irqsoff_stats_t *);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef KMUTEX_H
+#define KMUTEX_H
+
+#include "common.h"
+#include "mutex.h"
+#include "task.h"
+
+/******************************************************************************
+ * @brief take a contended mutex, block until it's handed over
+ * @param mutex to take
+ * @return K_OK or K_ERROR if the current task already owns the mutex
+ ******************************************************************************/
+k_return_t kmutex_lock(mutex_t *);
+
+/******************************************************************************
+ * @brief release a mutex and hand it over to its highest priority waiter
+ * @param mutex to release
+ * @return K_OK or K_ERROR if the current task doesn't own the mutex
+ ******************************************************************************/
+k_return_t kmutex_unlock(mutex_t *);
+
+/******************************************************************************
+ * @brief stop waiting for a mutex, used when a blocked task is destroyed
+ * @param task to remove from its mutex wait queue
+ * @return none
+ ******************************************************************************/
+void kmutex_cancel_wait(task_t *);
+
+/******************************************************************************
+ * @brief get the priority of the highest priority waiter of the mutexes a
+ * task owns
+ * @param owner task
+ * @return highest waiter priority, 0 if no task waits
+ ******************************************************************************/
+uint8_t kmutex_inherited_prio(task_t *);
+
+/******************************************************************************
+ * @brief move a waiter whose priority changed in its mutex wait queue
+ * @param task waiting for a mutex
+ * @return owner of the mutex, which inherits the new priority
+ ******************************************************************************/
+task_t *kmutex_requeue(task_t *);
+
+#endif
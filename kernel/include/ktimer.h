@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef KTIMER_H
+#define KTIMER_H
+
+#include "common.h"
+
+/******************************************************************************
+ * index of a timer which is not armed
+ ******************************************************************************/
+#define KTIMER_NOT_ARMED -1
+
+/******************************************************************************
+ * static initializer of a kernel timer, equivalent to ktimer_setup()
+ ******************************************************************************/
+#define KTIMER_INIT(_expire) \
+  { .deadline = 0, .index = KTIMER_NOT_ARMED, .expire = _expire }
+
+/******************************************************************************
+ * @struct ktimer_t
+ * @brief kernel timer multiplexed on the machine timer comparator
+ *
+ * The expire callback runs in the timer interrupt context with interrupts
+ * disabled. It returns true when the current task has to be preempted.
+ ******************************************************************************/
+typedef struct ktimer_t {
+  uint64_t deadline;
+  int64_t  index;
+  bool (*expire)(struct ktimer_t *);
+} ktimer_t;
+
+/******************************************************************************
+ * @brief initialize the kernel timers and take the machine timer
+ * @param none
+ * @return none
+ ******************************************************************************/
+void ktimer_init();
+
+/******************************************************************************
+ * @brief initialize a kernel timer, it's not armed
+ * @param timer to initialize
+ * @param function called when the timer expires
+ * @return none
+ ******************************************************************************/
+void ktimer_setup(ktimer_t *, bool (*)(ktimer_t *));
+
+/******************************************************************************
+ * @brief arm a kernel timer, re-arm it if it's already pending
+ * @param timer to arm
+ * @param mtime value at which the timer expires
+ * @return K_OK or K_ERROR if there is no room left for a new timer
+ ******************************************************************************/
+k_return_t ktimer_start(ktimer_t *, uint64_t);
+
+/******************************************************************************
+ * @brief disarm a kernel timer, nothing is done if it's not armed
+ * @param timer to disarm
+ * @return none
+ ******************************************************************************/
+void ktimer_cancel(ktimer_t *);
+
+/******************************************************************************
+ * @brief check if a kernel timer is pending
+ * @param timer to check
+ * @return true if the timer is armed
+ ******************************************************************************/
+static inline bool ktimer_is_armed(const ktimer_t *timer) {
+  return timer->index != KTIMER_NOT_ARMED;
+}
+
+/******************************************************************************
+ * @brief run all expired timers, called from the timer interrupt
+ * @param none
+ * @return true if the current task has to be preempted
+ ******************************************************************************/
+bool ktimer_expire();
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef LOG_H
+#define LOG_H
+
+#include "common.h"
+#include "irq_arch.h"
+#include "processor.h"
+
+#ifndef CONFIG_PRINTK_RECORDS
+#define CONFIG_PRINTK_RECORDS 64
+#endif
+
+_Static_assert((CONFIG_PRINTK_RECORDS & (CONFIG_PRINTK_RECORDS - 1)) == 0,
+               "the number of printk records must be a power of two");
+
+/******************************************************************************
+ * maximum number of arguments of a deferred printk
+ ******************************************************************************/
+#define LOG_ARGS_MAX 8
+
+/******************************************************************************
+ * count the arguments given after the format of printk
+ ******************************************************************************/
+#define LOG_NARGS(...) _LOG_NARGS(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define _LOG_NARGS(_0, _1, _2, _3, _4, _5, _6, _7, _8, _n, ...) _n
+
+/******************************************************************************
+ * @struct log_record_t
+ * @brief printk call waiting to be formatted by the log server
+ *
+ * The arguments are saved as raw 64-bit words, as they are passed to a
+ * variadic function. A string argument is read when the record is printed,
+ * it must not be a temporary buffer.
+ ******************************************************************************/
+typedef struct log_record_t {
+  const char *format;
+  uint64_t    args[LOG_ARGS_MAX];
+} log_record_t;
+
+/******************************************************************************
+ * @struct log_ring_t
+ * @brief printk records of a hart waiting to be printed
+ *
+ * Each hart is the only writer of its ring and never waits: a record which
+ * doesn't fit is dropped and counted. head and tail are free running
+ * counters.
+ ******************************************************************************/
+typedef struct log_ring_t {
+  uint64_t     head;
+  uint64_t     tail;
+  uint64_t     dropped;
+  log_record_t records[CONFIG_PRINTK_RECORDS];
+} __attribute__((aligned(CACHE_LINE_SIZE))) log_ring_t;
+
+extern log_ring_t log_rings[CONFIG_HART_MAX_NB];
+
+/******************************************************************************
+ * @brief save a printk call in the ring of the current hart
+ *
+ * Interrupts are disabled so a printk from an interrupt can't take the slot
+ * of the interrupted one. The format is only read by the log server.
+ *
+ * @param format of the message
+ * @param number of arguments, at most LOG_ARGS_MAX
+ * @param arguments of the format
+ * @return none
+ ******************************************************************************/
+void log_printk(const char *, uint64_t, ...);
+
+/******************************************************************************
+ * @brief print the records waiting in the ring of a hart
+ *
+ * Used by the log server, and by a panic to print the messages which led to
+ * it before its own.
+ *
+ * @param hart which has saved the records
+ * @return number of records printed
+ ******************************************************************************/
+uint64_t log_drain(uint64_t);
+
+/******************************************************************************
+ * @brief get the number of records waiting in the ring of a hart
+ * @param hart which has saved the records
+ * @return number of records not printed yet
+ ******************************************************************************/
+uint64_t log_pending(uint64_t);
+
+/******************************************************************************
+ * @brief get the number of records a hart has dropped
+ * @param hart which has saved the records
+ * @return number of records which didn't fit in the ring
+ ******************************************************************************/
+uint64_t log_dropped(uint64_t);
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef NOTIFY_H
+#define NOTIFY_H
+
+#include "common.h"
+#include "task.h"
+
+/******************************************************************************
+ * @brief set notification bits of a task, wake it up if it waits for one
+ *
+ * This function doesn't call the scheduler and can be used in interrupt
+ * context, e.g. from a top half or a kernel timer callback.
+ *
+ * @param task to notify
+ * @param notification bits to set
+ * @return true if the notified task has to preempt the current task
+ ******************************************************************************/
+bool notify_signal(task_t *, uint64_t);
+
+/******************************************************************************
+ * @brief set notification bits of a task without waiting for it
+ * @param task to notify
+ * @param notification bits to set
+ * @return none
+ ******************************************************************************/
+void notify(task_t *, uint64_t);
+
+/******************************************************************************
+ * @brief wait for at least one notification bit of a mask
+ * @param mask of the notification bits to wait for
+ * @return pending bits of the mask, they are cleared
+ ******************************************************************************/
+uint64_t notify_wait(uint64_t);
+
+#endif
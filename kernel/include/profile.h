@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "common.h"
+#include "processor.h"
+
+#ifndef CONFIG_PROFILE_SAMPLES
+#define CONFIG_PROFILE_SAMPLES 512
+#endif
+
+_Static_assert((CONFIG_PROFILE_SAMPLES & (CONFIG_PROFILE_SAMPLES - 1)) == 0,
+               "the number of profile samples must be a power of two");
+
+/******************************************************************************
+ * number of callers saved by the stack walk of a sample
+ ******************************************************************************/
+#define PROFILE_DEPTH 6
+
+/******************************************************************************
+ * first bytes of a profile frame, "AXPF" on the wire
+ ******************************************************************************/
+#define PROFILE_FRAME_MAGIC   0x46505841
+#define PROFILE_FRAME_VERSION 1
+
+/******************************************************************************
+ * @struct profile_sample_t
+ * @brief code interrupted on a hart by the sampling interrupt
+ *
+ * The callers are the return addresses found by walking the frame pointers
+ * from the interrupted frame, the closest caller first. The task is the one
+ * running on the hart, the idle task when the hart has nothing to do.
+ ******************************************************************************/
+typedef struct profile_sample_t {
+  uint32_t task_id;
+  uint16_t hart;
+  uint16_t depth;
+  uint64_t pc;
+  uint64_t callers[PROFILE_DEPTH];
+} profile_sample_t;
+
+/******************************************************************************
+ * @struct profile_ring_t
+ * @brief samples of a hart waiting to be read
+ *
+ * Each hart is the only writer of its ring, from its software interrupt, and
+ * never waits: a sample which doesn't fit is dropped and counted. The readers
+ * serialize with the kernel lock, head and tail are free running counters.
+ ******************************************************************************/
+typedef struct profile_ring_t {
+  uint64_t         head;
+  uint64_t         tail;
+  uint64_t         dropped;
+  profile_sample_t samples[CONFIG_PROFILE_SAMPLES];
+} __attribute__((aligned(CACHE_LINE_SIZE))) profile_ring_t;
+
+/******************************************************************************
+ * @struct profile_frame_header_t
+ * @brief header of a profile frame sent over the uart
+ *
+ * The header is followed by nb_samples profile_sample_t records of a single
+ * hart and by the 32-bit sum of all the bytes of the header and the records.
+ * All fields are little endian, the period is in mtime ticks and dropped
+ * counts all the samples the hart has lost since boot.
+ ******************************************************************************/
+typedef struct profile_frame_header_t {
+  uint32_t magic;
+  uint8_t  version;
+  uint8_t  hart;
+  uint16_t nb_samples;
+  uint32_t period;
+  uint32_t sample_size;
+  uint64_t dropped;
+} profile_frame_header_t;
+
+_Static_assert(sizeof(profile_frame_header_t) == 24,
+               "the frame header is decoded by the host");
+_Static_assert(sizeof(profile_sample_t) == 64,
+               "the samples are decoded by the host");
+
+/******************************************************************************
+ * @brief start sampling all harts periodically
+ * @param none
+ * @return K_OK, or K_ERROR if no kernel timer is left
+ ******************************************************************************/
+k_return_t profile_start();
+
+/******************************************************************************
+ * @brief stop sampling, the samples already taken can still be read
+ * @param none
+ * @return none
+ ******************************************************************************/
+void profile_stop();
+
+/******************************************************************************
+ * @brief save the code interrupted on the current hart in its ring
+ *
+ * Called from the software interrupt with interrupts disabled.
+ *
+ * @param trap frame of the interrupted code
+ * @param frame pointer of the interrupted code
+ * @return none
+ ******************************************************************************/
+void profile_sample(uint64_t, uint64_t);
+
+/******************************************************************************
+ * @brief read the oldest samples of a hart
+ * @param hart which has taken the samples
+ * @param buffer to copy the samples in
+ * @param maximum number of samples to read
+ * @return number of samples read
+ ******************************************************************************/
+uint64_t profile_read(uint64_t, profile_sample_t *, uint64_t);
+
+/******************************************************************************
+ * @brief get the number of samples a hart has dropped
+ * @param hart which has taken the samples
+ * @return number of samples which didn't fit in the ring
+ ******************************************************************************/
+uint64_t profile_dropped(uint64_t);
+
+/******************************************************************************
+ * @brief send the samples of a hart over the uart as a single frame
+ * @param hart which has taken the samples
+ * @return number of samples in the frame
+ ******************************************************************************/
+uint64_t profile_dump(uint64_t);
+
+#endif
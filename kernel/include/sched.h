@@ -57,6 +57,13 @@ __no_inline void sched_switch(task_t *prev_task, task_t *new_task);
  ******************************************************************************/
 void sched_init();
 
+/******************************************************************************
+ * @brief make the idle task of the current hart its running task
+ * @param none
+ * @return none
+ ******************************************************************************/
+void sched_init_hart();
+
 /******************************************************************************
  * @brief main function to run the scheduler
  * @param none
@@ -64,6 +71,13 @@ void sched_init();
  ******************************************************************************/
 void sched_run();
 
+/******************************************************************************
+ * @brief release the kernel lock on the first run of a new task
+ * @param none
+ * @return none
+ ******************************************************************************/
+void sched_task_start();
+
 /******************************************************************************
  * @brief add a new task to the run queue
  * @param task to add in the run queue
@@ -78,6 +92,90 @@ void sched_add_task(task_t *);
  ******************************************************************************/
 void sched_remove_task(task_t *);
 
+/******************************************************************************
+ * @brief move a task at the end of its priority level in the run queue
+ * @param task to move
+ * @return none
+ ******************************************************************************/
+void sched_rotate_task(task_t *);
+
+/******************************************************************************
+ * @brief change the priority of a task, a ready task moves to its new level
+ * @param task to modify
+ * @param new priority
+ * @return none
+ ******************************************************************************/
+void sched_set_prio(task_t *, uint8_t);
+
+/******************************************************************************
+ * @brief move a task which doesn't run to the run queue of an another hart
+ * @param task to move
+ * @param hart the task is queued on from now
+ * @return none
+ ******************************************************************************/
+void sched_migrate_task(task_t *, uint64_t);
+
+/******************************************************************************
+ * @brief wake up an idle hart a waiting task can run on
+ * @param task waiting for the cpu
+ * @return none
+ ******************************************************************************/
+void sched_kick_idle(task_t *);
+
+/******************************************************************************
+ * @brief check if a woken up task preempts the current task of this hart
+ * @param task woken up
+ * @return true if the task is queued here with a higher priority or an
+ * earlier deadline
+ ******************************************************************************/
+bool sched_preempts_current(task_t *);
+
+/******************************************************************************
+ * @brief charge the current task of this hart the cpu time used up to now
+ * @param none
+ * @return none
+ ******************************************************************************/
+void sched_charge_current();
+
+/******************************************************************************
+ * @brief reserve the bandwidth of an EDF task on a hart
+ * @param hart running the task
+ * @param budget of a job in mtime ticks
+ * @param relative deadline in mtime ticks
+ * @return K_OK, or K_ERROR if the hart can't hold the task
+ ******************************************************************************/
+k_return_t sched_edf_reserve(uint64_t, uint64_t, uint64_t);
+
+/******************************************************************************
+ * @brief give back the bandwidth of an EDF task
+ * @param hart running the task
+ * @param budget of a job in mtime ticks
+ * @param relative deadline in mtime ticks
+ * @return none
+ ******************************************************************************/
+void sched_edf_release(uint64_t, uint64_t, uint64_t);
+
+/******************************************************************************
+ * @brief elect the next task to run and make it the current task
+ * @param none
+ * @return elected task
+ ******************************************************************************/
+task_t *sched_elect_task();
+
+/******************************************************************************
+ * @brief check if the current task would lose the cpu by yielding
+ * @param none
+ * @return true if another ready task has the same or a higher priority
+ ******************************************************************************/
+bool sched_yield_needed();
+
+/******************************************************************************
+ * @brief put the hart to sleep when no other task than idle is ready
+ * @param none
+ * @return none
+ ******************************************************************************/
+void sched_idle();
+
 /******************************************************************************
  * @brief find the current running task
  * @param none
@@ -86,10 +184,17 @@ void sched_remove_task(task_t *);
 task_t *sched_get_current_task();
 
 /******************************************************************************
- * @brief set the current running task
+ * @brief set the current running task of the current hart
  * @param current_task address pointer
  * @return none
  ******************************************************************************/
 void sched_set_current_task(task_t *);
 
+/******************************************************************************
+ * @brief check if a task is the current task of its hart
+ * @param task to check
+ * @return true if the task runs
+ ******************************************************************************/
+bool sched_task_is_running(task_t *);
+
 #endif
\ No newline at end of file
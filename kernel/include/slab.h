@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "common.h"
+
+/******************************************************************************
+ * minimum number of objects carved in a slab
+ ******************************************************************************/
+#define SLAB_MIN_OBJECTS 8
+
+/******************************************************************************
+ * @struct slab_object_t
+ * @brief link saved in the last word of a free object
+ ******************************************************************************/
+typedef struct slab_object_t {
+  struct slab_object_t *next;
+} slab_object_t;
+
+/******************************************************************************
+ * @struct slab_cache_t
+ * @brief cache of fixed size objects carved in buddy blocks
+ *
+ * The constructor is called once on each object when its slab is carved, a
+ * released object must be given back in its constructed state. Only the last
+ * word of an object is overwritten while it's free.
+ ******************************************************************************/
+typedef struct slab_cache_t {
+  const char    *name;
+  uint64_t       object_size;
+  uint8_t        order;
+  void (*ctor)(void *);
+  slab_object_t *free;
+  uint64_t       nb_objects;
+  uint64_t       nb_free;
+} slab_cache_t;
+
+/******************************************************************************
+ * @brief initialize an empty cache, no memory is allocated
+ * @param cache to initialize
+ * @param cache name
+ * @param size of the objects in bytes
+ * @param constructor called on new objects, can be NULL
+ * @return none
+ ******************************************************************************/
+void slab_cache_init(slab_cache_t *, const char *, uint64_t, void (*)(void *));
+
+/******************************************************************************
+ * @brief allocate an object, a new slab is carved if the cache is empty
+ * @param cache to allocate from
+ * @return object address, or NULL if the heap is full
+ ******************************************************************************/
+void *slab_alloc(slab_cache_t *);
+
+/******************************************************************************
+ * @brief give an object back to its cache
+ * @param cache the object was allocated from
+ * @param object address
+ * @return none
+ ******************************************************************************/
+void slab_free(slab_cache_t *, void *);
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef SMP_H
+#define SMP_H
+
+#include "common.h"
+
+#ifndef CONFIG_HART_MAX_NB
+#define CONFIG_HART_MAX_NB 4
+#endif
+
+/******************************************************************************
+ * inter-processor interrupt requests, delivered with the software interrupt
+ ******************************************************************************/
+#define SMP_IPI_RESCHED (1UL << 0)
+#define SMP_IPI_PROFILE (1UL << 1)
+
+/******************************************************************************
+ * @brief take the kernel lock
+ *
+ * The kernel lock protects the kernel objects shared by the harts: run queues,
+ * wait queues, channels, timers and allocators. It disables interrupts on the
+ * current hart and can be nested by the task which holds it. A section is
+ * bounded: a long one opens interrupt windows with smp_irq_window().
+ *
+ * @param none
+ * @return previous interrupt enable state to give to smp_unlock()
+ ******************************************************************************/
+uint64_t smp_lock();
+
+/******************************************************************************
+ * @brief release the kernel lock taken by smp_lock()
+ * @param previous interrupt enable state
+ * @return none
+ ******************************************************************************/
+void smp_unlock(uint64_t);
+
+/******************************************************************************
+ * @brief serve the pending interrupts in a kernel lock section, preemption
+ * stays disabled until the lock is released
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_irq_window();
+
+/******************************************************************************
+ * @brief check if the current task holds the kernel lock
+ * @param none
+ * @return true if the lock is held
+ ******************************************************************************/
+bool smp_lock_held();
+
+/******************************************************************************
+ * @brief defer the preemption of the current task of the hart
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_preempt_defer();
+
+/******************************************************************************
+ * @brief take the preemption deferred on the hart
+ * @param none
+ * @return true if the current task has to be preempted
+ ******************************************************************************/
+bool smp_preempt_take();
+
+/******************************************************************************
+ * @brief release the kernel lock inherited by a new task from the scheduler
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_lock_drop();
+
+/******************************************************************************
+ * @brief post a request to a hart and raise its software interrupt
+ * @param target hart identifier
+ * @param SMP_IPI_* requests
+ * @return none
+ ******************************************************************************/
+void smp_send_ipi(uint64_t, uint64_t);
+
+/******************************************************************************
+ * @brief acknowledge the software interrupt and take the posted requests
+ * @param none
+ * @return SMP_IPI_* requests sent to the current hart, 0 if none
+ ******************************************************************************/
+uint64_t smp_ipi_take();
+
+/******************************************************************************
+ * @brief check if a hart has been started and schedules tasks
+ * @param hart identifier
+ * @return true if the hart is online
+ ******************************************************************************/
+bool smp_is_online(uint64_t);
+
+/******************************************************************************
+ * @brief get the idle stack of a hart
+ * @param hart identifier
+ * @return idle stack base address
+ ******************************************************************************/
+void *smp_idle_stack(uint64_t);
+
+/******************************************************************************
+ * @brief release the secondary harts, called once the kernel is initialized
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_start();
+
+/******************************************************************************
+ * @brief make the current secondary hart available to the other harts
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_hart_online();
+
+#endif
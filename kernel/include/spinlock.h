@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include "common.h"
+
+/******************************************************************************
+ * @struct spinlock_t
+ * @brief lock shared by the harts, busy waits until it's free
+ *
+ * A spinlock only protects short sections and must be taken with interrupts
+ * disabled: a hart interrupted while holding it would make the other harts
+ * spin during the whole interrupt.
+ ******************************************************************************/
+typedef struct spinlock_t {
+  uint32_t locked;
+} spinlock_t;
+
+/******************************************************************************
+ * @brief initialize a free spinlock
+ * @param spinlock to initialize
+ * @return none
+ ******************************************************************************/
+static inline void spin_init(spinlock_t *lock) {
+  lock->locked = 0;
+}
+
+/******************************************************************************
+ * @brief take a spinlock, busy wait until it's free
+ *
+ * The lock word is only read while it's taken so the waiting harts keep the
+ * cache line shared until the owner releases it.
+ *
+ * @param spinlock to take
+ * @return none
+ ******************************************************************************/
+static inline void spin_lock(spinlock_t *lock) {
+  while (__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE)) {
+    while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED)) {
+    }
+  }
+}
+
+/******************************************************************************
+ * @brief try to take a spinlock without waiting
+ * @param spinlock to take
+ * @return true if the lock has been taken
+ ******************************************************************************/
+static inline bool spin_trylock(spinlock_t *lock) {
+  return !__atomic_exchange_n(&lock->locked, 1, __ATOMIC_ACQUIRE);
+}
+
+/******************************************************************************
+ * @brief check if a spinlock is taken, without any ordering
+ * @param spinlock to check
+ * @return true if the lock is taken
+ ******************************************************************************/
+static inline bool spin_is_locked(spinlock_t *lock) {
+  return __atomic_load_n(&lock->locked, __ATOMIC_RELAXED);
+}
+
+/******************************************************************************
+ * @brief release a spinlock
+ * @param spinlock to release
+ * @return none
+ ******************************************************************************/
+static inline void spin_unlock(spinlock_t *lock) {
+  __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include "common.h"
+#include "task.h"
+
+/******************************************************************************
+ * first bytes of a statistics frame, "AXST" on the wire
+ ******************************************************************************/
+#define STATS_FRAME_MAGIC   0x54535841
+#define STATS_FRAME_VERSION 1
+
+/******************************************************************************
+ * @struct stats_frame_header_t
+ * @brief header of a statistics frame sent over the uart
+ *
+ * The header is followed by nb_tasks task_stats_t records and by the 32-bit
+ * sum of all the bytes of the header and the records. All fields are little
+ * endian, the times are in mtime ticks at timebase ticks per second.
+ ******************************************************************************/
+typedef struct stats_frame_header_t {
+  uint32_t magic;
+  uint8_t  version;
+  uint8_t  nb_harts;
+  uint16_t nb_tasks;
+  uint32_t timebase;
+  uint32_t record_size;
+  uint64_t timestamp;
+} stats_frame_header_t;
+
+_Static_assert(sizeof(stats_frame_header_t) == 24,
+               "the frame header is decoded by the host");
+_Static_assert(sizeof(task_stats_t) == 88,
+               "the task records are decoded by the host");
+
+/******************************************************************************
+ * @brief add the bytes of a buffer to the checksum of a frame
+ * @param checksum so far
+ * @param buffer to add
+ * @param size in bytes
+ * @return new checksum
+ ******************************************************************************/
+uint32_t stats_sum(uint32_t, const void *, uint64_t);
+
+/******************************************************************************
+ * @brief send the counters of all tasks over the uart as a single frame
+ * @param none
+ * @return number of tasks in the frame
+ ******************************************************************************/
+uint64_t stats_dump();
+
+#endif
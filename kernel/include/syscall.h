@@ -17,19 +17,49 @@
 #ifndef SYSCALL_H
 #define SYSCALL_H
 
-#define SYSCALL_MAX_NB 32
+#define SYSCALL_MAX_NB 48
 
-#define SYSCALL_TASK_CREATE       0
-#define SYSCALL_TASK_DESTROY      1
-#define SYSCALL_TASK_YIELD        2
-#define SYSCALL_TASK_SLEEP        3
-#define SYSCALL_TASK_WAKEUP       4
-#define SYSCALL_TASK_EXIT         5
-#define SYSCALL_INTERRUPT_REQUEST 6
-#define SYSCALL_INTERRUPT_RELEASE 7
-#define SYSCALL_CHANNEL_CREATE    8
-#define SYSCALL_CHANNEL_GET       9
-#define SYSCALL_CHANNEL_SND       10
-#define SYSCALL_CHANNEL_RCV       11
+#define SYSCALL_TASK_CREATE        0
+#define SYSCALL_TASK_DESTROY       1
+#define SYSCALL_TASK_YIELD         2
+#define SYSCALL_TASK_SLEEP         3
+#define SYSCALL_TASK_WAKEUP        4
+#define SYSCALL_TASK_EXIT          5
+#define SYSCALL_INTERRUPT_REQUEST  6
+#define SYSCALL_INTERRUPT_RELEASE  7
+#define SYSCALL_CHANNEL_CREATE     8
+#define SYSCALL_CHANNEL_GET        9
+#define SYSCALL_CHANNEL_SND        10
+#define SYSCALL_CHANNEL_RCV        11
+#define SYSCALL_TASK_SET_QUANTUM   12
+#define SYSCALL_TASK_SLEEP_UNTIL   13
+#define SYSCALL_TASK_SLEEP_FOR     14
+#define SYSCALL_INTERRUPT_WAIT     15
+#define SYSCALL_CHANNEL_CALL       16
+#define SYSCALL_CHANNEL_REPLY_WAIT 17
+#define SYSCALL_CHANNEL_DESTROY    18
+#define SYSCALL_NOTIFY             19
+#define SYSCALL_WAIT               20
+#define SYSCALL_TASK_SPAWN         21
+#define SYSCALL_TASK_STACK_USAGE   22
+#define SYSCALL_MUTEX_LOCK         23
+#define SYSCALL_MUTEX_UNLOCK       24
+#define SYSCALL_TASK_CREATE_ON     25
+#define SYSCALL_TASK_SET_AFFINITY  26
+#define SYSCALL_TASK_CREATE_EDF    27
+#define SYSCALL_TASK_WAIT_PERIOD   28
+#define SYSCALL_TASK_SET_BUDGET    29
+#define SYSCALL_TRACE_READ         30
+#define SYSCALL_TASK_GET_STATS     31
+#define SYSCALL_WAIT_ANY           32
+#define SYSCALL_IRQSOFF_READ       33
+
+// fast syscalls never block nor switch, they are dispatched from the trap
+// entry with interrupts disabled and without any stack frame
+#define SYSCALL_FAST_BASE   SYSCALL_MAX_NB
+#define SYSCALL_FAST_MAX_NB 8
+
+#define SYSCALL_FAST_TASK_YIELD_NEEDED (SYSCALL_FAST_BASE + 0)
+#define SYSCALL_FAST_TASK_SELF         (SYSCALL_FAST_BASE + 1)
 
 #endif
\ No newline at end of file
@@ -18,9 +18,45 @@
 #define TASK_H
 
 #include "common.h"
+#include "ktimer.h"
+#include "list.h"
 #include "processor.h"
+#include "smp.h"
 
-typedef uint8_t stack_t[STACK_SIZE];
+typedef uint8_t stack_t[STACK_SIZE] __attribute__((aligned(LWORD_SIZE)));
+
+/******************************************************************************
+ * declare a stack of a given size
+ ******************************************************************************/
+#define DECLARE_STACK(_name, _size) \
+  uint8_t _name[_size] __attribute__((aligned(LWORD_SIZE)))
+
+/******************************************************************************
+ * declare the stack of a user task, aligned for its pmp entries or its pages
+ ******************************************************************************/
+#define DECLARE_USER_STACK(_name, _size) \
+  uint8_t _name[_size] __attribute__((aligned(USER_STACK_ALIGN)))
+
+/******************************************************************************
+ * pattern painted on free stack words to measure the stack usage
+ ******************************************************************************/
+#define STACK_CANARY 0xA5A5A5A5A5A5A5A5UL
+
+/******************************************************************************
+ * affinity masks, bit n allows the task to run on hart n
+ ******************************************************************************/
+#define TASK_AFFINITY_HART(_hart) (1UL << (_hart))
+#define TASK_AFFINITY_ALL         ((1UL << CONFIG_HART_MAX_NB) - 1)
+
+/******************************************************************************
+ * bytes of the task name kept in its statistics, it may not end with a null
+ ******************************************************************************/
+#define TASK_STATS_NAME_LENGTH 16
+
+/******************************************************************************
+ * heap index of a task which is not in the deadline queue of its hart
+ ******************************************************************************/
+#define TASK_EDF_NOT_QUEUED -1
 
 /******************************************************************************
  * @enum task_state_t
@@ -41,28 +77,245 @@ typedef struct task_id_t {
   uint32_t thread_id;
 } task_id_t;
 
+/******************************************************************************
+ * @struct task_edf_t
+ * @brief timing parameters of an earliest deadline first task
+ *
+ * A job is released every period and must complete within the relative
+ * deadline, a null deadline is the period. The budget is the worst case
+ * execution time of a job, used for the admission and enforced like a task
+ * budget.
+ ******************************************************************************/
+typedef struct task_edf_t {
+  uint64_t period_us;
+  uint64_t budget_us;
+  uint64_t deadline_us;
+} task_edf_t;
+
+/******************************************************************************
+ * @struct task_budget_t
+ * @brief cpu budget of a task, replenished every period
+ *
+ * A task which has used its budget is throttled until the next period, the
+ * handler task is notified with the given bits. A null budget removes the
+ * limit.
+ ******************************************************************************/
+typedef struct task_budget_t {
+  uint64_t       budget_us;
+  uint64_t       period_us;
+  struct task_t *handler;
+  uint64_t       notify;
+} task_budget_t;
+
+/******************************************************************************
+ * @struct task_stats_t
+ * @brief snapshot of the counters of a task, read with task_get_stats()
+ *
+ * Times are in mtime ticks, the cycles are read from the cycle counter of the
+ * harts the task ran on. A switch is preempted when it's forced on the task
+ * by task_preempt(), e.g. from an interrupt or an ipi, or by its budget. The
+ * other switches, yields included, are voluntary.
+ ******************************************************************************/
+typedef struct task_stats_t {
+  uint32_t task_id;
+  uint8_t  prio;
+  uint8_t  hart;
+  uint8_t  state;
+  uint8_t  reserved;
+  char     name[TASK_STATS_NAME_LENGTH];
+  uint64_t runtime;
+  uint64_t cycles;
+  uint64_t switches;
+  uint64_t preemptions;
+  uint64_t ready_time;
+  uint64_t ready_max;
+  uint64_t ipc_sent;
+  uint64_t ipc_received;
+} task_stats_t;
+
+/******************************************************************************
+ * @struct task_region_t
+ * @brief memory a user task can reach besides its stack
+ *
+ * The text is readable and executable, the data readable and writable. Tasks
+ * which share a region set share the same structure: the pmp entries of the
+ * set are not written again on a switch between them. A region set must not
+ * change while a task uses it.
+ ******************************************************************************/
+typedef struct task_region_t {
+  uint64_t text_start;
+  uint64_t text_end;
+  uint64_t data_start;
+  uint64_t data_end;
+} task_region_t;
+
 /******************************************************************************
  * @struct task_t
  * @brief structure to manage common thread and processes informations
+ *
+ * Control blocks are saved in the task table, apart from the stacks. Fields
+ * used by the scheduler on every switch fill the first cache line, fields
+ * only read at creation or for debug are kept at the end.
  ******************************************************************************/
 typedef struct task_t {
-  const char  *name;
-  task_id_t    task_id;
-  uint8_t      prio;
-  task_state_t state;
-  stack_t     *stack;
-  thread_t     thread;
-} task_t;
+  thread_t                 thread;
+  list_node_t              node;
+  uint8_t                  prio;
+  uint8_t                  base_prio;
+  uint8_t                  hart;
+  task_state_t             state;
+  uint32_t                 quantum;
+  uint32_t                 ticks_left;
+  uint32_t                 lock_depth;
+  uint32_t                 lock_flags;
+  uint64_t                 affinity;
+  uint64_t                 deadline;
+  int64_t                  edf_index;
+  uint64_t                 budget_left;
+  uint64_t                 switch_in;
+  uint64_t                 cycle_in;
+  bool                     throttled;
+  bool                     preempted;
+  list_node_t              wait;
+  uint64_t                *ipc_msg;
+  uint64_t                 ipc_len;
+  uint64_t                *ipc_reply;
+  uint64_t                 ipc_reply_len;
+  bool                     ipc_call;
+  struct task_t           *ipc_caller;
+  struct task_t           *ipc_server;
+  struct channel_t        *ipc_channel;
+  bool                     ipc_sending;
+  list_node_t              ipc_channels;
+  uint64_t                 notify_pending;
+  uint64_t                 notify_mask;
+  struct wait_object_t    *wait_objects;
+  uint64_t                 wait_nb;
+  uint64_t                 wait_ready;
+  uint64_t                 wait_rearm;
+  uint64_t                 wait_notify;
+  uint64_t                 wait_notify_mask;
+  bool                     wait_blocked;
+  list_node_t              mutexes;
+  struct mutex_t          *mutex_wait;
+  ktimer_t                 timer;
+  uint64_t                 period;
+  uint64_t                 budget;
+  uint64_t                 relative_deadline;
+  uint64_t                 release;
+  uint64_t                 deadline_misses;
+  uint64_t                 runtime;
+  uint64_t                 job_runtime;
+  uint64_t                 wcet;
+  uint64_t                 overruns;
+  struct task_t           *overrun_handler;
+  uint64_t                 overrun_notify;
+  uint64_t                 cycles;
+  uint64_t                 switches;
+  uint64_t                 preemptions;
+  uint64_t                 ready_since;
+  uint64_t                 ready_time;
+  uint64_t                 ready_max;
+  uint64_t                 ipc_sent;
+  uint64_t                 ipc_received;
+  struct fpu_context_t    *fpu;
+  struct vector_context_t *vector;
+  uint8_t                  fpu_hart;
+  uint8_t                  vector_hart;
+  const char              *name;
+  task_id_t                task_id;
+  void                    *stack;
+  uint64_t                 stack_size;
+  task_region_t           *region;
+  bool                     spawned;
+  list_node_t              zombie;
+} __attribute__((aligned(CACHE_LINE_SIZE))) task_t;
+
+/******************************************************************************
+ * @brief initialize the task table and the cache of task stacks
+ * @param none
+ * @return none
+ ******************************************************************************/
+void task_init();
 
 /******************************************************************************
  * @brief initialize a task and schedule it
  * @param id of the task
  * @param function to run in the task
  * @param stack start address of the task
+ * @param stack size in bytes, at least STACK_MIN_SIZE
  * @param priority for the new task
- * @return none
+ * @return new task, or NULL if the stack is too small or the table is full
+ ******************************************************************************/
+task_t *task_create(const char *, void (*)(void), void *, uint64_t, uint8_t);
+
+/******************************************************************************
+ * @brief initialize a task and schedule it on a given hart
+ *
+ * The new task is pinned to the hart, its affinity can be widened with
+ * task_set_affinity().
+ *
+ * @param id of the task
+ * @param function to run in the task
+ * @param stack start address of the task
+ * @param stack size in bytes, at least STACK_MIN_SIZE
+ * @param priority for the new task
+ * @param hart running the task
+ * @return new task, or NULL if the hart doesn't exist, the stack is too small
+ * or the table is full
+ ******************************************************************************/
+task_t *task_create_on(const char *, void (*)(void), void *, uint64_t, uint8_t,
+                       uint64_t);
+
+/******************************************************************************
+ * @brief initialize an earliest deadline first task and schedule it
+ *
+ * The task is pinned to its hart and runs at the sched_edf_prio level, its
+ * first job is released right away. It's only created if the bandwidth left
+ * on the hart can hold it.
+ *
+ * @param id of the task
+ * @param function to run in the task
+ * @param stack start address of the task
+ * @param stack size in bytes, at least STACK_MIN_SIZE
+ * @param timing parameters of the task
+ * @param hart running the task
+ * @return new task, or NULL if the parameters are not valid, the hart is
+ * overloaded or the table is full
+ ******************************************************************************/
+task_t *task_create_edf(const char *, void (*)(void), void *, uint64_t,
+                        const task_edf_t *, uint64_t);
+
+/******************************************************************************
+ * @brief initialize a user mode task and schedule it
+ *
+ * The task is confined to its stack and its region set by the pmp, the top
+ * USER_KERNEL_STACK_SIZE bytes of the stack are kept for the kernel. It runs
+ * on the hart of its creator and inherits its affinity, the tasks it creates
+ * share its region set.
+ *
+ * @param id of the task
+ * @param function to run in the task, in the region set text
+ * @param stack start address of the task
+ * @param stack size in bytes, at least STACK_MIN_SIZE plus the kernel stack
+ * @param priority for the new task
+ * @param region set of the task
+ * @return new task, or NULL if the stack is too small or the table is full
  ******************************************************************************/
-void task_create(const char *, void (*)(void), stack_t *, uint8_t);
+task_t *task_create_user(const char *, void (*)(void), void *, uint64_t,
+                         uint8_t, task_region_t *);
+
+/******************************************************************************
+ * @brief create a task with a stack allocated from the task cache
+ *
+ * The stack is given back to the cache when the task exits or is destroyed.
+ *
+ * @param name of the task
+ * @param function to run in the task
+ * @param priority for the new task
+ * @return new task, or NULL if there is no memory left
+ ******************************************************************************/
+task_t *task_spawn(const char *, void (*)(void), uint8_t);
 
 /******************************************************************************
  * @brief task destroy
@@ -90,12 +343,22 @@ void task_runtime(void (*)(void));
 /******************************************************************************
  * @brief initialize task stack
  *
- * @param stack start address pointer
- * @param size of the stack
+ * @param task owning the stack
  * @param function to run in the task context
- * @return top address of the initialized stack
+ * @return none
  ******************************************************************************/
-void task_stack_init(stack_t *, uint64_t, void (*)(void));
+void task_stack_init(task_t *, void (*)(void));
+
+/******************************************************************************
+ * @brief get the stack high-water mark of a task
+ *
+ * The stack is painted with STACK_CANARY when the task is created, the usage
+ * is the distance from the top of the stack to the deepest overwritten word.
+ *
+ * @param task to measure
+ * @return maximum number of stack bytes used since the task creation
+ ******************************************************************************/
+uint64_t task_stack_usage(task_t *);
 
 /******************************************************************************
  * @brief yield the cpu to an another task
@@ -118,6 +381,106 @@ void task_sleep();
  ******************************************************************************/
 void task_wakeup(task_t *);
 
+/******************************************************************************
+ * @brief put the current task to sleep until a date
+ * @param wake up date in us since boot
+ * @return none
+ ******************************************************************************/
+void task_sleep_until(uint64_t);
+
+/******************************************************************************
+ * @brief put the current task to sleep during a given time
+ * @param sleep duration in us
+ * @return none
+ ******************************************************************************/
+void task_sleep_for(uint64_t);
+
+/******************************************************************************
+ * @brief complete the current job and wait for the next release
+ *
+ * The next job is released one period after the current one, with a new
+ * absolute deadline. A late job is released right away.
+ *
+ * @param none
+ * @return K_OK, or K_ERROR if the current task is not an EDF task
+ ******************************************************************************/
+k_return_t task_wait_period();
+
+/******************************************************************************
+ * @brief give the cpu to a higher priority task from an interrupt
+ * @param none
+ * @return none
+ ******************************************************************************/
+void task_preempt();
+
+/******************************************************************************
+ * @brief set the time slice given to a task when time slicing is enabled
+ * @param task to modify
+ * @param number of scheduler ticks in the time slice
+ * @return none
+ ******************************************************************************/
+void task_set_quantum(task_t *, uint32_t);
+
+/******************************************************************************
+ * @brief set the harts a task is allowed to run on
+ *
+ * A task out of its new affinity moves to the first hart allowed. A task
+ * running on an another hart moves at its next switch.
+ *
+ * @param task to modify
+ * @param affinity mask, bit n allows hart n
+ * @return K_OK, or K_ERROR if the mask doesn't hold any existing hart
+ ******************************************************************************/
+k_return_t task_set_affinity(task_t *, uint64_t);
+
+/******************************************************************************
+ * @brief limit the cpu time a task uses in each period
+ *
+ * The budget and period of an EDF task are its timing parameters, only the
+ * handler is taken for it.
+ *
+ * @param task to modify
+ * @param budget, period and overrun handler
+ * @return K_OK, or K_ERROR if the budget exceeds the period
+ ******************************************************************************/
+k_return_t task_set_budget(task_t *, const task_budget_t *);
+
+/******************************************************************************
+ * @brief read the counters of a task of the task table
+ *
+ * The slots of the table are read in turn to list all tasks, the runtime of a
+ * running task is counted up to now, its cycles up to its last switch.
+ *
+ * @param slot of the task table, from 0 to task_max_nb - 1
+ * @param statistics of the task
+ * @return K_OK, or K_ERROR if the slot is free or doesn't exist
+ ******************************************************************************/
+k_return_t task_get_stats(uint64_t, task_stats_t *);
+
+/******************************************************************************
+ * @brief check a user task can reach a memory range given to a syscall
+ *
+ * The syscalls run in machine mode, which the pmp doesn't check: a pointer
+ * given by a user task must lie in the user part of its stack or in its
+ * region set, its text only if the kernel doesn't write it.
+ *
+ * @param task making the syscall
+ * @param start address of the range
+ * @param size of the range in bytes
+ * @param true if the kernel writes the range
+ * @return true if the task can reach the range, always true for a kernel task
+ ******************************************************************************/
+bool task_user_range(const task_t *, const void *, uint64_t, bool);
+
+/******************************************************************************
+ * @brief check a task handle given to a syscall by a user task
+ * @param task making the syscall
+ * @param handle to check
+ * @return true if the handle is a task of the task table, always true for a
+ * kernel task
+ ******************************************************************************/
+bool task_user_handle(const task_t *, const task_t *);
+
 /******************************************************************************
  * @brief task exit
  *
@@ -148,6 +511,15 @@ inline task_state_t task_get_state(task_t *task) {
   return task->state;
 }
 
+/******************************************************************************
+ * @brief check if a task is scheduled by its deadlines
+ * @param task to check
+ * @return true for earliest deadline first tasks
+ ******************************************************************************/
+inline bool task_is_edf(task_t *task) {
+  return task->relative_deadline != 0;
+}
+
 /******************************************************************************
  * @brief get the unique ID of a task
  * @param task from the id is read
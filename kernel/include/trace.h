@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "common.h"
+#include "irq_arch.h"
+#include "processor.h"
+#include "task.h"
+#include "timer_arch.h"
+
+#ifndef CONFIG_TRACE_RECORDS
+#define CONFIG_TRACE_RECORDS 256
+#endif
+
+_Static_assert((CONFIG_TRACE_RECORDS & (CONFIG_TRACE_RECORDS - 1)) == 0,
+               "the number of trace records must be a power of two");
+
+/******************************************************************************
+ * @enum trace_event_t
+ * @brief events recorded by the kernel trace points
+ ******************************************************************************/
+typedef enum trace_event_t {
+  TRACE_SWITCH,
+  TRACE_WAKEUP,
+  TRACE_CHANNEL_SND,
+  TRACE_CHANNEL_RCV,
+  TRACE_IRQ_ENTRY,
+  TRACE_IRQ_EXIT,
+} trace_event_t;
+
+/******************************************************************************
+ * @struct trace_record_t
+ * @brief binary trace record
+ *
+ * The timestamp is read from mtime, it's shared by all harts. The task is the
+ * one running on the hart when the event is recorded, 0 before the scheduler
+ * runs on the hart.
+ ******************************************************************************/
+typedef struct trace_record_t {
+  uint64_t timestamp;
+  uint32_t event;
+  uint32_t task_id;
+  uint64_t args[2];
+} trace_record_t;
+
+/******************************************************************************
+ * @struct trace_ring_t
+ * @brief records of a hart waiting to be read
+ *
+ * Each hart is the only writer of its ring and never waits: a record which
+ * doesn't fit is dropped and counted. The readers serialize with the kernel
+ * lock, head and tail are free running counters.
+ ******************************************************************************/
+typedef struct trace_ring_t {
+  uint64_t       head;
+  uint64_t       tail;
+  uint64_t       dropped;
+  trace_record_t records[CONFIG_TRACE_RECORDS];
+} __attribute__((aligned(CACHE_LINE_SIZE))) trace_ring_t;
+
+extern trace_ring_t trace_rings[CONFIG_HART_MAX_NB];
+
+#ifdef CONFIG_TRACE
+/******************************************************************************
+ * record an event with two arguments, trace points compiled out don't
+ * evaluate their arguments
+ ******************************************************************************/
+#define TRACE(_event, _arg0, _arg1) \
+  trace_write(_event, (uint64_t)(_arg0), (uint64_t)(_arg1))
+#else
+#define TRACE(_event, _arg0, _arg1) \
+  do {                              \
+  } while (0)
+#endif
+
+/******************************************************************************
+ * @brief save a record in the ring of the current hart
+ *
+ * Interrupts are disabled so an interrupt trace point can't take the slot of
+ * the interrupted one.
+ *
+ * @param event to record
+ * @param first argument of the event
+ * @param second argument of the event
+ * @return none
+ ******************************************************************************/
+static inline void trace_write(trace_event_t event, uint64_t arg0,
+                               uint64_t arg1) {
+  uint64_t        flags = irq_arch_disable();
+  trace_ring_t   *ring  = &trace_rings[hart_id_get()];
+  uint64_t        head  = ring->head;
+  task_t         *task  = (task_t *)thread_pointer_get();
+  trace_record_t *record;
+
+  if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >=
+      CONFIG_TRACE_RECORDS) {
+    ring->dropped += 1;
+    irq_arch_restore(flags);
+    return;
+  }
+
+  record            = &ring->records[head & (CONFIG_TRACE_RECORDS - 1)];
+  record->timestamp = timer_arch_get_time();
+  record->event     = event;
+  record->task_id   = task != NULL ? task_get_tid(task) : 0;
+  record->args[0]   = arg0;
+  record->args[1]   = arg1;
+
+  // the record is complete before a reader can see it
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+  irq_arch_restore(flags);
+}
+
+/******************************************************************************
+ * @brief read the oldest records of a hart
+ * @param hart which has recorded the events
+ * @param buffer to copy the records in
+ * @param maximum number of records to read
+ * @return number of records read
+ ******************************************************************************/
+uint64_t trace_read(uint64_t, trace_record_t *, uint64_t);
+
+/******************************************************************************
+ * @brief get the number of records a hart has dropped
+ * @param hart which has recorded the events
+ * @return number of records which didn't fit in the ring
+ ******************************************************************************/
+uint64_t trace_dropped(uint64_t);
+
+#endif
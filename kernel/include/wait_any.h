@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef WAIT_ANY_H
+#define WAIT_ANY_H
+
+#include "common.h"
+#include "task.h"
+
+/******************************************************************************
+ * maximum number of objects a task waits for, each one owns a ready bit
+ ******************************************************************************/
+#define WAIT_ANY_MAX_NB 64
+
+/******************************************************************************
+ * @enum wait_object_type_t
+ * @brief kind of object a task can wait for with wait_any()
+ ******************************************************************************/
+typedef enum wait_object_type_t {
+  WAIT_CHANNEL,
+  WAIT_NOTIFY,
+  WAIT_INTERRUPT,
+} wait_object_type_t;
+
+/******************************************************************************
+ * @struct wait_object_t
+ * @brief object a task waits for
+ *
+ * The handle is a channel handler, a mask of notification bits or an
+ * interrupt identifier, according to the type.
+ ******************************************************************************/
+typedef struct wait_object_t {
+  wait_object_type_t type;
+  uint64_t           handle;
+} wait_object_t;
+
+/******************************************************************************
+ * @brief block until one of the given objects is ready
+ *
+ * The objects are bound to the task on the first wait and stay bound while
+ * the same array is given, the array must not be modified meanwhile. A bound
+ * object sets its ready bit in the task when it fires, a wait doesn't scan
+ * the array.
+ *
+ * A ready channel has a blocked sender and a ready notification a pending bit
+ * of its mask: they are received with channel_rcv() and notify_wait(), which
+ * then return without blocking. A ready interrupt is consumed like with
+ * interrupt_wait(), its source is unmasked at the next wait.
+ *
+ * @param objects to wait for, at most WAIT_ANY_MAX_NB
+ * @param number of objects
+ * @return index of the ready object with the lowest index, or K_ERROR if an
+ * object can't be waited for
+ ******************************************************************************/
+int64_t wait_any(const wait_object_t *, uint64_t);
+
+/******************************************************************************
+ * @brief set a ready bit of a task, wake it up if it waits in wait_any()
+ *
+ * This function doesn't call the scheduler and can be used in interrupt
+ * context. The caller holds the kernel lock.
+ *
+ * @param task to signal
+ * @param ready bit of the object
+ * @return true if the signaled task has to preempt the current task
+ ******************************************************************************/
+bool wait_any_signal(task_t *, uint64_t);
+
+/******************************************************************************
+ * @brief unbind the objects a task waits for
+ * @param task to release
+ * @return none
+ ******************************************************************************/
+void wait_any_release(task_t *);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef WAIT_QUEUE_H
+#define WAIT_QUEUE_H
+
+#include "common.h"
+#include "list.h"
+#include "task.h"
+
+/******************************************************************************
+ * A wait queue links blocked tasks through their wait node. Tasks are ordered
+ * by decreasing priority and tasks of the same priority are served in their
+ * arrival order. The run queue node is left free as a blocked task is not in
+ * the run queue anyway.
+ *
+ * Wait queues are not protected, the caller must disable interrupts.
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief add a task in a wait queue according to its priority
+ * @param wait queue head
+ * @param task to add
+ * @return none
+ ******************************************************************************/
+static inline void wait_queue_add(list_node_t *head, task_t *task) {
+  list_node_t *node;
+
+  // insert the task after the last one with the same or a higher priority
+  list_for_each(node, head) {
+    if (container_of(node, task_t, wait)->prio < task->prio) {
+      break;
+    }
+  }
+
+  list_add_tail(&task->wait, node);
+}
+
+/******************************************************************************
+ * @brief get the highest priority task of a wait queue without removing it
+ * @param wait queue head
+ * @return first task or NULL if the wait queue is empty
+ ******************************************************************************/
+static inline task_t *wait_queue_first(const list_node_t *head) {
+  list_node_t *node = list_first(head);
+
+  return node ? container_of(node, task_t, wait) : NULL;
+}
+
+/******************************************************************************
+ * @brief remove the highest priority task from a wait queue
+ * @param wait queue head
+ * @return removed task or NULL if the wait queue is empty
+ ******************************************************************************/
+static inline task_t *wait_queue_pop(list_node_t *head) {
+  task_t *task = wait_queue_first(head);
+
+  if (task) {
+    list_remove(&task->wait);
+  }
+
+  return task;
+}
+
+/******************************************************************************
+ * @brief remove a task from the wait queue it's waiting in, if any
+ * @param task to remove
+ * @return none
+ ******************************************************************************/
+static inline void wait_queue_remove(task_t *task) {
+  if (list_is_linked(&task->wait)) {
+    list_remove(&task->wait);
+  }
+}
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "inherit.h"
+
+#include "channel.h"
+#include "kmutex.h"
+#include "sched.h"
+
+/******************************************************************************
+ * @brief give a task the highest priority inherited from the tasks it blocks
+ * @param task to update
+ * @return none
+ ******************************************************************************/
+void inherit_update_prio(task_t *task) {
+  uint8_t prio;
+  uint8_t inherited;
+
+  while (task != NULL) {
+    prio = task->base_prio;
+
+    inherited = kmutex_inherited_prio(task);
+    if (inherited > prio) {
+      prio = inherited;
+    }
+
+    inherited = channel_inherited_prio(task);
+    if (inherited > prio) {
+      prio = inherited;
+    }
+
+    if (prio == task->prio) {
+      break;
+    }
+
+    sched_set_prio(task, prio);
+
+    // keep the wait queue of the task sorted and update the next task
+    if (task->mutex_wait != NULL) {
+      task = kmutex_requeue(task);
+    } else {
+      task = channel_requeue(task);
+    }
+  }
+}
@@ -18,41 +18,59 @@
 #include "init.h"
 
 #include "app.h"
-#include "ax_syscall.h"
 #include "banner.h"
-#include "printk.h"
+#include "channel.h"
+#include "panic.h"
 #include "task.h"
 
-#define INIT_PRIO 1
-
-stack_t init_stack;
-
 extern uint64_t _apps_start;
 extern uint64_t _apps_end;
+extern uint64_t _channels_start;
+extern uint64_t _channels_end;
 
 /******************************************************************************
- * @brief Init task will launch all registered tasks in the system
+ * @brief create the registered channels and apps in one pass at boot
+ *
+ * The descriptors are static, the kernel creates the channels then the tasks
+ * straight from them with no syscall and no init task: the apps are queued
+ * before the first task switch and find their channels already created.
+ *
  * @param None
  * @return None
  ******************************************************************************/
 void init_run(void) {
+  // a static channel is part of the app interfaces, it must exist
+  for (uint64_t *chan_pt = &_channels_start; chan_pt < &_channels_end;
+       chan_pt += 1) {
+    app_channel_t *channel = (app_channel_t *)*chan_pt;
+
+    if (channel_create(&channel->handler, channel->name) != K_OK) {
+      panic("static channel %s can't be created\r\n", channel->name);
+    }
+  }
+
   // iterate over all app descriptors saved in the section(.data.apps)
   for (uint64_t *app_pt = &_apps_start; app_pt < &_apps_end; app_pt += 1) {
     // get the app descriptor from the current pointer
     app_info_t *app = (app_info_t *)*app_pt;
-    // create a task for the app
-    ax_task_create(app->name, app->entry, app->stack, app->prio);
+    task_t     *task;
+
+    // EDF apps are admitted on their hart, they stay pinned to it
+    if (app->edf.period_us) {
+      task_create_edf(app->name, app->entry, app->stack, app->stack_size,
+                      &app->edf, app->hart);
+      continue;
+    }
+
+    // create a task for the app on its hart, then let it move if allowed
+    task = task_create_on(app->name, app->entry, app->stack, app->stack_size,
+                          app->prio, app->hart);
+
+    if (task != NULL) {
+      task_set_affinity(task, app->affinity);
+    }
   }
 
   // display kernel banner at the end of the init stage
   banner_display();
 }
-
-/******************************************************************************
- * @brief create the init task
- * @param None
- * @return None
- ******************************************************************************/
-void init_create(void) {
-  ax_task_create("init_task", init_run, &init_stack, INIT_PRIO);
-}
\ No newline at end of file
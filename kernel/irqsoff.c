@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "irqsoff.h"
+
+#include "smp.h"
+
+#ifdef CONFIG_IRQSOFF
+
+irqsoff_hart_t irqsoff_harts[CONFIG_HART_MAX_NB];
+
+/******************************************************************************
+ * @brief end the interval of the hart before the return from an interrupt
+ *
+ * Called by the interrupt return path, for the interrupted code as well as
+ * for a task switched to by the interrupt.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void irqsoff_exit() {
+  irqsoff_end();
+}
+
+/******************************************************************************
+ * @brief read the intervals measured on a hart
+ *
+ * The statistics are copied under the kernel lock, the hart may update them
+ * while they are read from an another hart.
+ *
+ * @param hart identifier
+ * @param statistics to fill
+ * @return K_OK, or K_ERROR if the hart doesn't exist
+ ******************************************************************************/
+k_return_t irqsoff_read(uint64_t hart, irqsoff_stats_t *stats) {
+  uint64_t flags;
+
+  if (hart >= CONFIG_HART_MAX_NB) {
+    return K_ERROR;
+  }
+
+  flags  = smp_lock();
+  *stats = irqsoff_harts[hart].stats;
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+#else
+
+/******************************************************************************
+ * @brief read the intervals measured on a hart, the measure is compiled out
+ * @param hart identifier
+ * @param statistics to fill
+ * @return K_ERROR, nothing is measured
+ ******************************************************************************/
+k_return_t irqsoff_read(uint64_t hart, irqsoff_stats_t *stats) {
+  return K_ERROR;
+}
+#endif
@@ -16,11 +16,16 @@
  */
 
 #include "ax_syscall.h"
+#include "buddy.h"
 #include "common.h"
+#include "fpu.h"
 #include "init.h"
+#include "ktimer.h"
 #include "sched.h"
+#include "smp.h"
 #include "task.h"
 #include "uart.h"
+#include "vm.h"
 
 /******************************************************************************
  * @brief Idle routine runned when no other tasks are ready
@@ -29,7 +34,10 @@
  ******************************************************************************/
 void idle_run(void) {
   while (1) {
+    // give the cpu to the tasks woken up since the last call
     ax_task_yield();
+    // sleep until the next interrupt
+    sched_idle();
   }
 }
 
@@ -39,9 +47,41 @@ void idle_run(void) {
  * @return None
  ******************************************************************************/
 void kernel_init() {
+  // the kernel lock is taken in the idle task, it's set up first
   sched_init();
 
-  init_create();
+  buddy_init();
+
+#ifdef CONFIG_VM
+  vm_init();
+#endif
+
+#ifdef CONFIG_FPU
+  fpu_init();
+#endif
+
+  task_init();
+
+  ktimer_init();
+
+  smp_start();
+
+  // the apps are queued from the idle task, they run on its first yield
+  init_run();
+
+  idle_run();
+}
+
+/******************************************************************************
+ * @brief entry of the secondary harts once hart 0 has initialized the kernel
+ * @param None
+ * @return None
+ ******************************************************************************/
+void kernel_secondary_init() {
+  // from here the hart runs in its idle task context
+  sched_init_hart();
+
+  smp_hart_online();
 
   idle_run();
 }
\ No newline at end of file
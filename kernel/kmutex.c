@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "kmutex.h"
+
+#include "inherit.h"
+#include "sched.h"
+#include "smp.h"
+#include "stddef.h"
+#include "wait_queue.h"
+
+/******************************************************************************
+ * @brief get the task owning a mutex
+ * @param owner word of the mutex
+ * @return owner task, or NULL if the mutex is free
+ ******************************************************************************/
+static inline task_t *kmutex_owner(uint64_t owner) {
+  return (task_t *)(owner & ~MUTEX_CONTENDED);
+}
+
+/******************************************************************************
+ * @brief get the priority of the highest priority waiter of the mutexes a
+ * task owns
+ *
+ * Only contended mutexes are linked in the owner list, the walk is as long as
+ * the number of mutexes other tasks wait for.
+ *
+ * @param owner task
+ * @return highest waiter priority, 0 if no task waits
+ ******************************************************************************/
+uint8_t kmutex_inherited_prio(task_t *task) {
+  uint8_t      prio = 0;
+  list_node_t *node;
+  mutex_t     *mutex;
+
+  list_for_each(node, &task->mutexes) {
+    mutex = container_of(node, mutex_t, node);
+
+    if (wait_queue_first(&mutex->waiters)->prio > prio) {
+      prio = wait_queue_first(&mutex->waiters)->prio;
+    }
+  }
+
+  return prio;
+}
+
+/******************************************************************************
+ * @brief move a waiter whose priority changed in its mutex wait queue
+ * @param task waiting for a mutex
+ * @return owner of the mutex, which inherits the new priority
+ ******************************************************************************/
+task_t *kmutex_requeue(task_t *task) {
+  mutex_t *mutex = task->mutex_wait;
+
+  list_remove(&task->wait);
+  wait_queue_add(&mutex->waiters, task);
+
+  return kmutex_owner(mutex->owner);
+}
+
+/******************************************************************************
+ * @brief take a contended mutex, block until it's handed over
+ * @param mutex to take
+ * @return K_OK or K_ERROR if the current task already owns the mutex
+ ******************************************************************************/
+k_return_t kmutex_lock(mutex_t *mutex) {
+  task_t  *task  = sched_get_current_task();
+  uint64_t flags = smp_lock();
+  uint64_t owner = __atomic_load_n(&mutex->owner, __ATOMIC_ACQUIRE);
+
+  while (true) {
+    // the mutex has been released since the fast path
+    if (owner == 0) {
+      if (__atomic_compare_exchange_n(&mutex->owner, &owner, (uint64_t)task,
+                                      false, __ATOMIC_ACQUIRE,
+                                      __ATOMIC_ACQUIRE)) {
+        smp_unlock(flags);
+        return K_OK;
+      }
+      continue;
+    }
+
+    if (kmutex_owner(owner) == task) {
+      smp_unlock(flags);
+      return K_ERROR;
+    }
+
+    if (owner & MUTEX_CONTENDED) {
+      break;
+    }
+
+    // the owner will have to release the mutex through the kernel
+    if (__atomic_compare_exchange_n(&mutex->owner, &owner,
+                                    owner | MUTEX_CONTENDED, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+      list_add_tail(&mutex->node, &kmutex_owner(owner)->mutexes);
+      break;
+    }
+  }
+
+  task->mutex_wait = mutex;
+  wait_queue_add(&mutex->waiters, task);
+
+  // the owner inherits the priority of the new waiter
+  inherit_update_prio(kmutex_owner(owner));
+
+  task_set_state(task, BLOCKED);
+  sched_remove_task(task);
+  sched_run();
+
+  // the mutex has been handed over by kmutex_unlock()
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief release a mutex and hand it over to its highest priority waiter
+ * @param mutex to release
+ * @return K_OK or K_ERROR if the current task doesn't own the mutex
+ ******************************************************************************/
+k_return_t kmutex_unlock(mutex_t *mutex) {
+  task_t  *task  = sched_get_current_task();
+  uint64_t flags = smp_lock();
+  uint64_t owner = __atomic_load_n(&mutex->owner, __ATOMIC_ACQUIRE);
+  task_t  *next;
+
+  if (kmutex_owner(owner) != task) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  // nobody waits, the fast path has only been missed
+  if (!(owner & MUTEX_CONTENDED)) {
+    __atomic_store_n(&mutex->owner, 0, __ATOMIC_RELEASE);
+    smp_unlock(flags);
+    return K_OK;
+  }
+
+  list_remove(&mutex->node);
+
+  next             = wait_queue_pop(&mutex->waiters);
+  next->mutex_wait = NULL;
+
+  // the new owner inherits the priority of the remaining waiters
+  if (list_is_empty(&mutex->waiters)) {
+    __atomic_store_n(&mutex->owner, (uint64_t)next, __ATOMIC_RELEASE);
+  } else {
+    __atomic_store_n(&mutex->owner, (uint64_t)next | MUTEX_CONTENDED,
+                     __ATOMIC_RELEASE);
+    list_add_tail(&mutex->node, &next->mutexes);
+  }
+
+  // the inherited priority is given back
+  inherit_update_prio(task);
+
+  task_set_state(next, READY);
+  sched_add_task(next);
+  inherit_update_prio(next);
+
+  if (sched_preempts_current(next)) {
+    task_preempt();
+  }
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief stop waiting for a mutex, used when a blocked task is destroyed
+ * @param task to remove from its mutex wait queue
+ * @return none
+ ******************************************************************************/
+void kmutex_cancel_wait(task_t *task) {
+  uint64_t flags = smp_lock();
+  mutex_t *mutex = task->mutex_wait;
+
+  if (mutex != NULL) {
+    list_remove(&task->wait);
+    task->mutex_wait = NULL;
+
+    // the owner can release the mutex from the fast path again
+    if (list_is_empty(&mutex->waiters)) {
+      list_remove(&mutex->node);
+      __atomic_fetch_and(&mutex->owner, ~MUTEX_CONTENDED, __ATOMIC_RELEASE);
+    }
+
+    // the owner may have inherited the priority of the task
+    inherit_update_prio(kmutex_owner(mutex->owner));
+  }
+
+  smp_unlock(flags);
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ktimer.h"
+
+#include "smp.h"
+#include "stddef.h"
+#include "timer_arch.h"
+
+#ifndef CONFIG_KTIMER_MAX_NB
+#define CONFIG_KTIMER_MAX_NB 32
+#endif
+
+#define KTIMER_HEAP_ROOT 0
+
+#define ktimer_heap_parent(index) (((index)-1) / 2)
+#define ktimer_heap_left(index)   (2 * (index) + 1)
+
+/******************************************************************************
+ * @struct ktimer_heap_t
+ * @brief pending timers sorted by deadline
+ *
+ * Timers are saved in a binary min-heap: the root is always the closest
+ * deadline and is the only one programmed in the comparator. Arming and
+ * disarming a timer cost O(log n) whatever the number of pending timers.
+ ******************************************************************************/
+typedef struct ktimer_heap_t {
+  ktimer_t *timers[CONFIG_KTIMER_MAX_NB];
+  int64_t   size;
+} ktimer_heap_t;
+
+static ktimer_heap_t ktimer_heap;
+
+/******************************************************************************
+ * @brief save a timer in a heap slot
+ * @param slot index
+ * @param timer to save
+ * @return none
+ ******************************************************************************/
+static inline void ktimer_heap_set(int64_t index, ktimer_t *timer) {
+  ktimer_heap.timers[index] = timer;
+  timer->index              = index;
+}
+
+/******************************************************************************
+ * @brief move a timer up to its place in the heap
+ * @param heap index of the timer
+ * @return none
+ ******************************************************************************/
+static void ktimer_heap_up(int64_t index) {
+  ktimer_t *timer = ktimer_heap.timers[index];
+
+  while (index > KTIMER_HEAP_ROOT) {
+    ktimer_t *parent = ktimer_heap.timers[ktimer_heap_parent(index)];
+
+    if (parent->deadline <= timer->deadline) {
+      break;
+    }
+
+    ktimer_heap_set(index, parent);
+    index = ktimer_heap_parent(index);
+  }
+
+  ktimer_heap_set(index, timer);
+}
+
+/******************************************************************************
+ * @brief move a timer down to its place in the heap
+ * @param heap index of the timer
+ * @return none
+ ******************************************************************************/
+static void ktimer_heap_down(int64_t index) {
+  ktimer_t *timer = ktimer_heap.timers[index];
+  int64_t   child;
+
+  while ((child = ktimer_heap_left(index)) < ktimer_heap.size) {
+    // select the closest deadline among both children
+    if ((child + 1 < ktimer_heap.size) &&
+        (ktimer_heap.timers[child + 1]->deadline <
+         ktimer_heap.timers[child]->deadline)) {
+      child += 1;
+    }
+
+    if (timer->deadline <= ktimer_heap.timers[child]->deadline) {
+      break;
+    }
+
+    ktimer_heap_set(index, ktimer_heap.timers[child]);
+    index = child;
+  }
+
+  ktimer_heap_set(index, timer);
+}
+
+/******************************************************************************
+ * @brief remove a timer from the heap
+ * @param timer to remove
+ * @return none
+ ******************************************************************************/
+static void ktimer_heap_remove(ktimer_t *timer) {
+  int64_t   index = timer->index;
+  ktimer_t *last;
+  ktimer_t *parent;
+
+  timer->index = KTIMER_NOT_ARMED;
+
+  ktimer_heap.size -= 1;
+  if (index == ktimer_heap.size) {
+    return;
+  }
+
+  // fill the hole with the last timer and restore the heap order
+  last = ktimer_heap.timers[ktimer_heap.size];
+  ktimer_heap_set(index, last);
+
+  parent = ktimer_heap.timers[ktimer_heap_parent(index)];
+  if ((index > KTIMER_HEAP_ROOT) && (last->deadline < parent->deadline)) {
+    ktimer_heap_up(index);
+  } else {
+    ktimer_heap_down(index);
+  }
+}
+
+/******************************************************************************
+ * @brief program the comparator with the closest deadline
+ * @param none
+ * @return none
+ ******************************************************************************/
+static inline void ktimer_program() {
+  if (ktimer_heap.size) {
+    timer_arch_set_compare(ktimer_heap.timers[KTIMER_HEAP_ROOT]->deadline);
+  } else {
+    timer_arch_stop();
+  }
+}
+
+/******************************************************************************
+ * @brief initialize the kernel timers and take the machine timer
+ * @param none
+ * @return none
+ ******************************************************************************/
+void ktimer_init() {
+  ktimer_heap.size = 0;
+
+  timer_arch_stop();
+
+  // enable the machine timer interrupt, it's only fired by armed timers
+  csr_set(CSR_MIE, MIE_TIE);
+}
+
+/******************************************************************************
+ * @brief initialize a kernel timer, it's not armed
+ * @param timer to initialize
+ * @param function called when the timer expires
+ * @return none
+ ******************************************************************************/
+void ktimer_setup(ktimer_t *timer, bool (*expire)(ktimer_t *)) {
+  timer->deadline = 0;
+  timer->index    = KTIMER_NOT_ARMED;
+  timer->expire   = expire;
+}
+
+/******************************************************************************
+ * @brief arm a kernel timer, re-arm it if it's already pending
+ * @param timer to arm
+ * @param mtime value at which the timer expires
+ * @return K_OK or K_ERROR if there is no room left for a new timer
+ ******************************************************************************/
+k_return_t ktimer_start(ktimer_t *timer, uint64_t deadline) {
+  uint64_t flags = smp_lock();
+
+  if (ktimer_is_armed(timer)) {
+    ktimer_heap_remove(timer);
+  } else if (ktimer_heap.size == CONFIG_KTIMER_MAX_NB) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  timer->deadline = deadline;
+
+  ktimer_heap_set(ktimer_heap.size, timer);
+  ktimer_heap.size += 1;
+  ktimer_heap_up(timer->index);
+
+  // the comparator only changes if the new timer is the closest one
+  if (timer->index == KTIMER_HEAP_ROOT) {
+    ktimer_program();
+  }
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief disarm a kernel timer, nothing is done if it's not armed
+ * @param timer to disarm
+ * @return none
+ ******************************************************************************/
+void ktimer_cancel(ktimer_t *timer) {
+  uint64_t flags = smp_lock();
+
+  if (ktimer_is_armed(timer)) {
+    bool was_root = (timer->index == KTIMER_HEAP_ROOT);
+
+    ktimer_heap_remove(timer);
+
+    if (was_root) {
+      ktimer_program();
+    }
+  }
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief run all expired timers, called from the timer interrupt
+ *
+ * Timers which expire together are all served in the same interrupt. A
+ * callback can re-arm its own timer. The heap is walked under the kernel lock
+ * as the other harts arm and cancel timers.
+ *
+ * @param none
+ * @return true if the current task has to be preempted
+ ******************************************************************************/
+bool ktimer_expire() {
+  bool     preempt = false;
+  uint64_t flags   = smp_lock();
+  uint64_t now     = timer_arch_get_time();
+
+  while (ktimer_heap.size &&
+         (ktimer_heap.timers[KTIMER_HEAP_ROOT]->deadline <= now)) {
+    ktimer_t *timer = ktimer_heap.timers[KTIMER_HEAP_ROOT];
+
+    ktimer_heap_remove(timer);
+
+    if (timer->expire(timer)) {
+      preempt = true;
+    }
+  }
+
+  // acknowledge the interrupt with the next deadline
+  ktimer_program();
+
+  smp_unlock(flags);
+
+  return preempt;
+}
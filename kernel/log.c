@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "log.h"
+
+#include "app.h"
+#include "ax_syscall.h"
+#include "printf.h"
+#include "spinlock.h"
+#include "stdarg.h"
+
+#ifdef CONFIG_PRINTK_DEFERRED
+
+// the server runs on hart 0 when the application tasks leave its cpu, it
+// drains the rings of all harts at least once per period
+#define LOG_SERVER_PRIO      1
+#define LOG_SERVER_PERIOD_US 10000
+
+log_ring_t log_rings[CONFIG_HART_MAX_NB];
+
+// the readers copy the records one at a time, the writers never take it
+static spinlock_t log_lock;
+
+/******************************************************************************
+ * @brief save a printk call in the ring of the current hart
+ * @param format of the message
+ * @param number of arguments, at most LOG_ARGS_MAX
+ * @param arguments of the format
+ * @return none
+ ******************************************************************************/
+void log_printk(const char *format, uint64_t nb, ...) {
+  uint64_t      flags = irq_arch_disable();
+  log_ring_t   *ring  = &log_rings[hart_id_get()];
+  uint64_t      head  = ring->head;
+  log_record_t *record;
+  va_list       va;
+
+  if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >=
+      CONFIG_PRINTK_RECORDS) {
+    ring->dropped += 1;
+    irq_arch_restore(flags);
+    return;
+  }
+
+  record         = &ring->records[head & (CONFIG_PRINTK_RECORDS - 1)];
+  record->format = format;
+
+  // integers, pointers and doubles are all passed as 64-bit words
+  va_start(va, nb);
+  for (uint64_t i = 0; i < nb && i < LOG_ARGS_MAX; i++) {
+    record->args[i] = va_arg(va, uint64_t);
+  }
+  va_end(va);
+
+  // the record is complete before the server can see it
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+  irq_arch_restore(flags);
+}
+
+/******************************************************************************
+ * @brief print the records waiting in the ring of a hart
+ *
+ * A record is copied before its slot is given back to the writer, the lock is
+ * not held while it's formatted.
+ *
+ * @param hart which has saved the records
+ * @return number of records printed
+ ******************************************************************************/
+uint64_t log_drain(uint64_t hart) {
+  uint64_t     count = 0;
+  log_ring_t  *ring;
+  log_record_t record;
+  uint64_t     flags;
+  uint64_t     tail;
+
+  if (hart >= CONFIG_HART_MAX_NB) {
+    return 0;
+  }
+
+  ring = &log_rings[hart];
+
+  while (true) {
+    flags = irq_arch_disable();
+    spin_lock(&log_lock);
+
+    tail = ring->tail;
+    if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+      spin_unlock(&log_lock);
+      irq_arch_restore(flags);
+      break;
+    }
+
+    record = ring->records[tail & (CONFIG_PRINTK_RECORDS - 1)];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+
+    spin_unlock(&log_lock);
+    irq_arch_restore(flags);
+
+    printf(record.format, record.args[0], record.args[1], record.args[2],
+           record.args[3], record.args[4], record.args[5], record.args[6],
+           record.args[7]);
+    count += 1;
+  }
+
+  return count;
+}
+
+/******************************************************************************
+ * @brief get the number of records waiting in the ring of a hart
+ * @param hart which has saved the records
+ * @return number of records not printed yet
+ ******************************************************************************/
+uint64_t log_pending(uint64_t hart) {
+  if (hart >= CONFIG_HART_MAX_NB) {
+    return 0;
+  }
+
+  return __atomic_load_n(&log_rings[hart].head, __ATOMIC_ACQUIRE) -
+         __atomic_load_n(&log_rings[hart].tail, __ATOMIC_ACQUIRE);
+}
+
+/******************************************************************************
+ * @brief get the number of records a hart has dropped
+ * @param hart which has saved the records
+ * @return number of records which didn't fit in the ring
+ ******************************************************************************/
+uint64_t log_dropped(uint64_t hart) {
+  if (hart >= CONFIG_HART_MAX_NB) {
+    return 0;
+  }
+
+  return __atomic_load_n(&log_rings[hart].dropped, __ATOMIC_RELAXED);
+}
+
+stack_t log_stack;
+
+/******************************************************************************
+ * @brief format and print the records of all harts
+ * @param none
+ * @return none
+ ******************************************************************************/
+static void log_run(void) {
+  uint64_t dropped[CONFIG_HART_MAX_NB] = {0};
+
+  while (true) {
+    for (uint64_t hart = 0; hart < CONFIG_HART_MAX_NB; hart++) {
+      uint64_t lost = log_dropped(hart);
+
+      log_drain(hart);
+
+      // the lost messages are reported where they should have been
+      if (lost != dropped[hart]) {
+        printf("printk: %d messages dropped on hart %d\r\n",
+               lost - dropped[hart], hart);
+        dropped[hart] = lost;
+      }
+    }
+
+    ax_task_sleep_for(LOG_SERVER_PERIOD_US);
+  }
+}
+
+REGISTER_APP_ON("log_server", log_run, log_stack, LOG_SERVER_PRIO, 0)
+
+#else
+
+/******************************************************************************
+ * @brief print the records of a hart, printk is not deferred
+ * @param hart which has saved the records
+ * @return 0, nothing is saved
+ ******************************************************************************/
+uint64_t log_drain(uint64_t hart) {
+  return 0;
+}
+
+/******************************************************************************
+ * @brief get the records waiting on a hart, printk is not deferred
+ * @param hart which has saved the records
+ * @return 0, nothing is saved
+ ******************************************************************************/
+uint64_t log_pending(uint64_t hart) {
+  return 0;
+}
+
+/******************************************************************************
+ * @brief get the records dropped by a hart, printk is not deferred
+ * @param hart which has saved the records
+ * @return 0, nothing is saved
+ ******************************************************************************/
+uint64_t log_dropped(uint64_t hart) {
+  return 0;
+}
+
+#endif
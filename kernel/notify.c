@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "notify.h"
+
+#include "sched.h"
+#include "smp.h"
+#include "wait_any.h"
+
+/******************************************************************************
+ * @brief set notification bits of a task, wake it up if it waits for one
+ * @param task to notify
+ * @param notification bits to set
+ * @return true if the notified task has to preempt the current task
+ ******************************************************************************/
+bool notify_signal(task_t *task, uint64_t bits) {
+  bool     preempt = false;
+  uint64_t flags   = smp_lock();
+
+  // several notifications are coalesced until the task reads them
+  task->notify_pending |= bits;
+
+  if (task->notify_mask & task->notify_pending) {
+    // the task is blocked in notify_wait()
+    task->notify_mask = 0;
+    task_set_state(task, READY);
+    sched_add_task(task);
+
+    preempt = sched_preempts_current(task);
+  } else if (task->wait_notify_mask & bits) {
+    // the task may wait for the bits with wait_any()
+    preempt = wait_any_signal(task, task->wait_notify);
+  }
+
+  smp_unlock(flags);
+
+  return preempt;
+}
+
+/******************************************************************************
+ * @brief set notification bits of a task without waiting for it
+ * @param task to notify
+ * @param notification bits to set
+ * @return none
+ ******************************************************************************/
+void notify(task_t *task, uint64_t bits) {
+  if (notify_signal(task, bits)) {
+    task_preempt();
+  }
+}
+
+/******************************************************************************
+ * @brief wait for at least one notification bit of a mask
+ * @param mask of the notification bits to wait for
+ * @return pending bits of the mask, they are cleared
+ ******************************************************************************/
+uint64_t notify_wait(uint64_t mask) {
+  task_t  *task = sched_get_current_task();
+  uint64_t bits;
+  uint64_t flags;
+
+  // notify_signal() must not miss the task between the check and the block
+  flags = smp_lock();
+
+  if (!(task->notify_pending & mask)) {
+    task->notify_mask = mask;
+    task_set_state(task, BLOCKED);
+    sched_remove_task(task);
+    sched_run();
+
+    // the task may also have been woken up by task_wakeup()
+    task->notify_mask = 0;
+  }
+
+  bits = task->notify_pending & mask;
+  task->notify_pending &= ~bits;
+
+  smp_unlock(flags);
+
+  return bits;
+}
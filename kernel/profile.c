@@ -0,0 +1,405 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "profile.h"
+
+#include "app.h"
+#include "ax_syscall.h"
+#include "ktimer.h"
+#include "offsets.h"
+#include "smp.h"
+#include "stats.h"
+#include "task.h"
+#include "timer_arch.h"
+#include "uart.h"
+
+#ifdef CONFIG_PROFILE
+
+#ifndef CONFIG_PROFILE_PERIOD_US
+#define CONFIG_PROFILE_PERIOD_US 1000
+#endif
+
+#ifndef CONFIG_PROFILE_DUMP_PERIOD_MS
+#define CONFIG_PROFILE_DUMP_PERIOD_MS 0
+#endif
+
+#define PROFILE_PERIOD (CONFIG_PROFILE_PERIOD_US * TIMER_ARCH_TICKS_PER_US)
+
+// samples sent in a single frame
+#define PROFILE_DUMP_MAX 64
+
+// the dump preempts the application tasks as the statistics dump does
+#define PROFILE_PRIO 254
+
+static bool profile_tick(ktimer_t *);
+
+profile_ring_t profile_rings[CONFIG_HART_MAX_NB];
+
+static ktimer_t profile_timer   = KTIMER_INIT(profile_tick);
+static bool     profile_running = false;
+
+static profile_sample_t profile_buffer[PROFILE_DUMP_MAX];
+
+#ifdef CONFIG_PMP
+extern void _ret_to_user();
+#endif
+
+/******************************************************************************
+ * @brief ask all harts to take a sample and program the next period
+ *
+ * Kernel timers are served by hart 0, each online hart, hart 0 included, is
+ * sampled from its software interrupt where the interrupted frame is known.
+ *
+ * @param profile timer
+ * @return false, sampling never preempts the current task
+ ******************************************************************************/
+static bool profile_tick(ktimer_t *timer) {
+  uint64_t deadline = timer->deadline + PROFILE_PERIOD;
+  uint64_t now      = timer_arch_get_time();
+  uint64_t flags    = smp_lock();
+
+  // the timer may have been stopped by an another hart meanwhile
+  if (profile_running) {
+    // skip the periods we missed
+    if (deadline <= now) {
+      deadline = now + PROFILE_PERIOD;
+    }
+    ktimer_start(timer, deadline);
+
+    for (uint64_t hart = 0; hart < CONFIG_HART_MAX_NB; hart++) {
+      smp_send_ipi(hart, SMP_IPI_PROFILE);
+    }
+  }
+
+  smp_unlock(flags);
+
+  return false;
+}
+
+/******************************************************************************
+ * @brief check a frame pointer can be followed
+ * @param frame pointer
+ * @param stack start address
+ * @param stack end address
+ * @return true if the frame record lies in the stack
+ ******************************************************************************/
+static inline bool profile_fp_is_valid(uint64_t fp, uint64_t low,
+                                       uint64_t high) {
+  return !(fp & (sizeof(uint64_t) - 1)) && fp >= low + 2 * sizeof(uint64_t) &&
+         fp <= high;
+}
+
+/******************************************************************************
+ * @brief walk the frame pointers of the interrupted code
+ *
+ * A frame record is the return address at fp - 8 and the frame pointer of
+ * the caller at fp - 16. A leaf function only saves the frame pointer, at
+ * fp - 8: the slot then points into the stack and the first caller is the
+ * interrupted ra. The walk stops at the first frame out of the task stack or
+ * which doesn't go up, the code built without frame pointers ends it early.
+ *
+ * @param interrupted task
+ * @param frame pointer of the interrupted code
+ * @param return address of the interrupted code
+ * @param callers found, the closest first
+ * @return number of callers found
+ ******************************************************************************/
+static uint16_t profile_walk(const task_t *task, uint64_t fp, uint64_t ra,
+                             uint64_t *callers) {
+  uint64_t  low   = (uint64_t)task->stack;
+  uint64_t  high  = low + task->stack_size;
+  uint16_t  depth = 0;
+  uint64_t *record;
+  uint64_t  next;
+
+  while (depth < PROFILE_DEPTH && profile_fp_is_valid(fp, low, high)) {
+    record = (uint64_t *)fp;
+
+    if (depth == 0 && profile_fp_is_valid(record[-1], low, high)) {
+      callers[depth++] = ra;
+      next             = record[-1];
+    } else {
+      callers[depth++] = record[-1];
+      next             = record[-2];
+    }
+
+    if (next <= fp) {
+      break;
+    }
+    fp = next;
+  }
+
+  return depth;
+}
+
+/******************************************************************************
+ * @brief start sampling all harts periodically
+ * @param none
+ * @return K_OK, or K_ERROR if no kernel timer is left
+ ******************************************************************************/
+k_return_t profile_start() {
+  uint64_t   deadline = timer_arch_get_time() + PROFILE_PERIOD;
+  uint64_t   flags    = smp_lock();
+  k_return_t ret      = K_OK;
+
+  if (!profile_running) {
+    ret             = ktimer_start(&profile_timer, deadline);
+    profile_running = (ret == K_OK);
+  }
+
+  smp_unlock(flags);
+
+  return ret;
+}
+
+/******************************************************************************
+ * @brief stop sampling, the samples already taken can still be read
+ * @param none
+ * @return none
+ ******************************************************************************/
+void profile_stop() {
+  uint64_t flags = smp_lock();
+
+  profile_running = false;
+  ktimer_cancel(&profile_timer);
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief save the code interrupted on the current hart in its ring
+ *
+ * A user task is interrupted at _ret_to_user, its own pc is saved in the user
+ * frame right above the trap frame. The registers of the interrupted code
+ * are left as they were, so ra and s0 are still its own.
+ *
+ * @param trap frame of the interrupted code
+ * @param frame pointer of the interrupted code
+ * @return none
+ ******************************************************************************/
+void profile_sample(uint64_t frame, uint64_t fp) {
+  uint64_t          hart   = hart_id_get();
+  profile_ring_t   *ring   = &profile_rings[hart];
+  uint64_t          head   = ring->head;
+  task_t           *task   = (task_t *)thread_pointer_get();
+  uint64_t          pc     = *(uint64_t *)(frame + TRAP_FRAME_MEPC);
+  uint64_t          ra     = *(uint64_t *)(frame + TRAP_FRAME_RA);
+  profile_sample_t *sample;
+
+  // the scheduler doesn't run on the hart yet
+  if (task == NULL) {
+    return;
+  }
+
+  if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >=
+      CONFIG_PROFILE_SAMPLES) {
+    ring->dropped += 1;
+    return;
+  }
+
+#ifdef CONFIG_PMP
+  if (pc == (uint64_t)&_ret_to_user) {
+    pc = *(uint64_t *)(frame + TRAP_FRAME_LENGTH + USER_FRAME_MEPC);
+  }
+#endif
+
+  sample          = &ring->samples[head & (CONFIG_PROFILE_SAMPLES - 1)];
+  sample->task_id = task_get_tid(task);
+  sample->hart    = hart;
+  sample->pc      = pc;
+  sample->depth   = profile_walk(task, fp, ra, sample->callers);
+
+  // the sample is complete before a reader can see it
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ * @brief read the oldest samples of a hart
+ *
+ * The writer never takes the lock, the tail is only moved once the samples
+ * have been copied.
+ *
+ * @param hart which has taken the samples
+ * @param buffer to copy the samples in
+ * @param maximum number of samples to read
+ * @return number of samples read, 0 if the hart doesn't exist
+ ******************************************************************************/
+uint64_t profile_read(uint64_t hart, profile_sample_t *samples, uint64_t nb) {
+  profile_ring_t *ring;
+  uint64_t        head;
+  uint64_t        tail;
+  uint64_t        flags;
+  uint64_t        count = 0;
+
+  if (hart >= CONFIG_HART_MAX_NB) {
+    return 0;
+  }
+
+  ring  = &profile_rings[hart];
+  flags = smp_lock();
+
+  head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  tail = ring->tail;
+
+  for (; tail != head && count < nb; tail++, count++) {
+    samples[count] = ring->samples[tail & (CONFIG_PROFILE_SAMPLES - 1)];
+  }
+
+  // the slots can be written again
+  __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+  smp_unlock(flags);
+
+  return count;
+}
+
+/******************************************************************************
+ * @brief get the number of samples a hart has dropped
+ * @param hart which has taken the samples
+ * @return number of samples which didn't fit in the ring
+ ******************************************************************************/
+uint64_t profile_dropped(uint64_t hart) {
+  if (hart >= CONFIG_HART_MAX_NB) {
+    return 0;
+  }
+
+  return __atomic_load_n(&profile_rings[hart].dropped, __ATOMIC_RELAXED);
+}
+
+/******************************************************************************
+ * @brief send the samples of a hart over the uart as a single frame
+ *
+ * As for the statistics, the frame is written without any lock and the host
+ * drops the frames broken by a line of an another hart.
+ *
+ * @param hart which has taken the samples
+ * @return number of samples in the frame
+ ******************************************************************************/
+uint64_t profile_dump(uint64_t hart) {
+  profile_frame_header_t header;
+  uint64_t               nb_samples;
+  uint32_t               sum;
+
+  nb_samples = profile_read(hart, profile_buffer, PROFILE_DUMP_MAX);
+  if (nb_samples == 0) {
+    return 0;
+  }
+
+  header.magic       = PROFILE_FRAME_MAGIC;
+  header.version     = PROFILE_FRAME_VERSION;
+  header.hart        = hart;
+  header.nb_samples  = nb_samples;
+  header.period      = PROFILE_PERIOD;
+  header.sample_size = sizeof(profile_sample_t);
+  header.dropped     = profile_dropped(hart);
+
+  sum = stats_sum(0, &header, sizeof(header));
+  sum = stats_sum(sum, profile_buffer, nb_samples * sizeof(profile_sample_t));
+
+  uart_send((const uint8_t *)&header, sizeof(header));
+  uart_send((const uint8_t *)profile_buffer,
+            nb_samples * sizeof(profile_sample_t));
+  uart_send((const uint8_t *)&sum, sizeof(sum));
+
+  return nb_samples;
+}
+
+#if CONFIG_PROFILE_DUMP_PERIOD_MS
+
+stack_t profile_stack;
+
+/******************************************************************************
+ * @brief sample the harts from boot and dump the samples periodically
+ *
+ * A hart is drained at most by a ring of samples per period, the samples
+ * taken meanwhile are sent by the next period.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+static void profile_run(void) {
+  uint64_t next = timer_arch_ticks_to_us(timer_arch_get_time());
+
+  profile_start();
+
+  while (true) {
+    next += CONFIG_PROFILE_DUMP_PERIOD_MS * 1000;
+    ax_task_sleep_until(next);
+
+    for (uint64_t hart = 0; hart < CONFIG_HART_MAX_NB; hart++) {
+      for (uint64_t nb = 0; nb < CONFIG_PROFILE_SAMPLES;
+           nb += PROFILE_DUMP_MAX) {
+        if (profile_dump(hart) < PROFILE_DUMP_MAX) {
+          break;
+        }
+      }
+    }
+  }
+}
+
+REGISTER_APP_ON("profile", profile_run, profile_stack, PROFILE_PRIO, 0)
+
+#endif
+
+#else
+
+/******************************************************************************
+ * @brief start sampling, profiling is compiled out
+ * @param none
+ * @return K_ERROR, nothing is sampled
+ ******************************************************************************/
+k_return_t profile_start() {
+  return K_ERROR;
+}
+
+/******************************************************************************
+ * @brief stop sampling, profiling is compiled out
+ * @param none
+ * @return none
+ ******************************************************************************/
+void profile_stop() {
+}
+
+/******************************************************************************
+ * @brief read the oldest samples of a hart, profiling is compiled out
+ * @param hart which has taken the samples
+ * @param buffer to copy the samples in
+ * @param maximum number of samples to read
+ * @return 0, nothing is sampled
+ ******************************************************************************/
+uint64_t profile_read(uint64_t hart, profile_sample_t *samples, uint64_t nb) {
+  return 0;
+}
+
+/******************************************************************************
+ * @brief get the number of samples a hart has dropped, profiling is compiled
+ * out
+ * @param hart which has taken the samples
+ * @return 0, nothing is sampled
+ ******************************************************************************/
+uint64_t profile_dropped(uint64_t hart) {
+  return 0;
+}
+
+/******************************************************************************
+ * @brief send the samples of a hart, profiling is compiled out
+ * @param hart which has taken the samples
+ * @return 0, nothing is sampled
+ ******************************************************************************/
+uint64_t profile_dump(uint64_t hart) {
+  return 0;
+}
+#endif
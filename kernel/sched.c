@@ -17,13 +17,56 @@
 
 #include "sched.h"
 
+#include "bitops.h"
+#include "fpu.h"
+#include "irq_arch.h"
+#include "ktimer.h"
+#include "list.h"
+#include "notify.h"
+#include "pmp.h"
 #include "processor.h"
+#include "smp.h"
 #include "stddef.h"
+#include "timer_arch.h"
+#include "trace.h"
+#include "vm.h"
 
-#define MAX_PRIO  255
+#define MAX_PRIO  256
 #define IDLE_PRIO 0
 
-#define __idle_task_data __attribute__((section(".data.idle_task")))
+#define RUN_QUEUE_GROUP_SIZE 64
+#define RUN_QUEUE_NB_GROUPS  (MAX_PRIO / RUN_QUEUE_GROUP_SIZE)
+
+#ifndef CONFIG_SCHED_TICK_US
+#define CONFIG_SCHED_TICK_US 1000
+#endif
+
+#ifndef CONFIG_SCHED_QUANTUM_TICKS
+#define CONFIG_SCHED_QUANTUM_TICKS 10
+#endif
+
+#ifndef CONFIG_SCHED_EDF_PRIO
+#define CONFIG_SCHED_EDF_PRIO 128
+#endif
+
+#ifndef CONFIG_TASK_MAX_NB
+#define CONFIG_TASK_MAX_NB 64
+#endif
+
+#define SCHED_TICK_PERIOD (CONFIG_SCHED_TICK_US * TIMER_ARCH_TICKS_PER_US)
+
+// bandwidths are fixed point fractions of a hart
+#define SCHED_EDF_FULL (1UL << 20)
+
+#define SCHED_EDF_HEAP_ROOT 0
+
+#define sched_edf_heap_parent(index) (((index)-1) / 2)
+#define sched_edf_heap_left(index)   (2 * (index) + 1)
+
+// a peer is worth stealing from when a task waits behind its running task and
+// its idle task, the search for a task allowed here is bounded
+#define SCHED_STEAL_MIN_READY 3
+#define SCHED_STEAL_SCAN_MAX  16
 
 /******************************************************************************
  * context switch procedure
@@ -31,41 +74,303 @@
 extern void _switch_to(thread_t *prev_thread, thread_t *next_thread);
 
 /******************************************************************************
- * idle stack / task are statically defined
+ * @struct run_queue_t
+ * @brief ready tasks sorted by priority
+ *
+ * Each priority level holds a FIFO list of ready tasks. A two-level bitmap
+ * tracks non-empty levels: bit n of bitmap[g] is set when level g * 64 + n has
+ * at least one task and bit g of groups is set when bitmap[g] is not null.
+ * Finding the highest ready level costs two bit scans whatever the number of
+ * tasks in the system.
+ ******************************************************************************/
+typedef struct run_queue_t {
+  uint64_t    groups;
+  uint64_t    bitmap[RUN_QUEUE_NB_GROUPS];
+  list_node_t tasks[MAX_PRIO];
+} run_queue_t;
+
+/******************************************************************************
+ * @struct sched_edf_heap_t
+ * @brief ready earliest deadline first tasks sorted by absolute deadline
+ *
+ * The EDF tasks of a hart also stay in the list of the sched_edf_prio level,
+ * the heap only orders them: when this level is the highest ready one, the
+ * root of the heap runs. A task is in the heap while it's in the run queue at
+ * the EDF level, its index is saved in edf_index.
  ******************************************************************************/
-extern stack_t   idle_stack;
-task_t idle_task __idle_task_data = {
-    .task_id.vms_id    = (uint64_t)NULL,
-    .task_id.thread_id = (uint64_t)NULL,
-    .prio              = IDLE_PRIO,
-    .state             = READY,
-    .stack             = &idle_stack,
-};
+typedef struct sched_edf_heap_t {
+  task_t *tasks[CONFIG_TASK_MAX_NB];
+  int64_t size;
+} sched_edf_heap_t;
 
 /******************************************************************************
- * main run_queue used by the scheduler
+ * @struct sched_hart_t
+ * @brief scheduler state of a hart
+ *
+ * Each hart runs the tasks queued on it, a task is queued on the hart given by
+ * its hart field. The current task is the one elected by the hart, it's only
+ * loaded in tp by the switch which follows the election. nb_ready counts the
+ * queued tasks, the idle and current tasks included. edf_bandwidth sums the
+ * bandwidth reserved by the EDF tasks of the hart. The budget timer expires
+ * when the current task has used its budget.
  ******************************************************************************/
-static task_t *run_queue[MAX_PRIO];
-static task_t *current_task;
+typedef struct sched_hart_t {
+  run_queue_t      run_queue;
+  sched_edf_heap_t edf_heap;
+  uint64_t         edf_bandwidth;
+  uint64_t         nb_ready;
+  task_t          *current_task;
+  task_t           idle_task;
+  ktimer_t         budget_timer;
+#ifdef CONFIG_SCHED_TIME_SLICING
+  ktimer_t         tick_timer;
+#endif
+} sched_hart_t;
 
+static sched_hart_t sched_harts[CONFIG_HART_MAX_NB];
+
+#ifdef CONFIG_SCHED_TIME_SLICING
 /******************************************************************************
- * @brief find the next task to run
+ * the scheduler tick of a hart is only armed when its current task shares its
+ * priority level with another ready task
+ ******************************************************************************/
+static void sched_tick_update(sched_hart_t *hart);
+#endif
+
+/******************************************************************************
+ * @brief get the scheduler state of the current hart
+ *
+ * The caller holds the kernel lock, the task can't move to another hart.
+ *
  * @param none
- * @return task to run
+ * @return scheduler state of the hart
  ******************************************************************************/
-task_t *sched_get_next_task() {
-  // look over the run queue for a task to schedule
-  uint8_t prio_idx = MAX_PRIO - 1;
-  while (prio_idx >= 0) {
-    if (run_queue[prio_idx]) {
-      // there is a task to run
+static inline sched_hart_t *sched_hart() {
+  return &sched_harts[hart_id_get()];
+}
+
+/******************************************************************************
+ * @brief get the identifier of a hart from its scheduler state
+ * @param scheduler state of the hart
+ * @return hart identifier
+ ******************************************************************************/
+static inline uint64_t sched_hart_id(sched_hart_t *hart) {
+  return hart - sched_harts;
+}
+
+/******************************************************************************
+ * @brief wake up an idle hart a waiting task can run on
+ *
+ * The task stays queued on its hart, the idle hart steals a task from the
+ * busiest peer once it's woken up. Pinned tasks never wake up an another hart.
+ *
+ * @param task waiting for the cpu
+ * @return none
+ ******************************************************************************/
+void sched_kick_idle(task_t *task) {
+  uint64_t harts = task->affinity & ~TASK_AFFINITY_HART(task->hart);
+  uint8_t  hart_id;
+
+  while (harts) {
+    hart_id = bit_find_first_set(harts);
+    bit_clear(&harts, hart_id);
+
+    if (sched_harts[hart_id].current_task == &sched_harts[hart_id].idle_task) {
+      smp_send_ipi(hart_id, SMP_IPI_RESCHED);
+      return;
+    }
+  }
+}
+
+/******************************************************************************
+ * @brief check if a task is ordered by the deadline queue of its hart
+ *
+ * An EDF task boosted above its level by a mutex is ordered by its priority
+ * until it's given back its base priority.
+ *
+ * @param task to check
+ * @return true if the task runs at the EDF level
+ ******************************************************************************/
+static inline bool sched_task_uses_edf(task_t *task) {
+  return task_is_edf(task) && task->prio == CONFIG_SCHED_EDF_PRIO;
+}
+
+/******************************************************************************
+ * @brief save a task in a deadline heap slot
+ * @param heap
+ * @param slot index
+ * @param task to save
+ * @return none
+ ******************************************************************************/
+static inline void sched_edf_heap_set(sched_edf_heap_t *heap, int64_t index,
+                                      task_t *task) {
+  heap->tasks[index] = task;
+  task->edf_index    = index;
+}
+
+/******************************************************************************
+ * @brief move a task up to its place in the deadline heap
+ * @param heap
+ * @param heap index of the task
+ * @return none
+ ******************************************************************************/
+static void sched_edf_heap_up(sched_edf_heap_t *heap, int64_t index) {
+  task_t *task = heap->tasks[index];
+
+  while (index > SCHED_EDF_HEAP_ROOT) {
+    task_t *parent = heap->tasks[sched_edf_heap_parent(index)];
+
+    if (parent->deadline <= task->deadline) {
+      break;
+    }
+
+    sched_edf_heap_set(heap, index, parent);
+    index = sched_edf_heap_parent(index);
+  }
+
+  sched_edf_heap_set(heap, index, task);
+}
+
+/******************************************************************************
+ * @brief move a task down to its place in the deadline heap
+ * @param heap
+ * @param heap index of the task
+ * @return none
+ ******************************************************************************/
+static void sched_edf_heap_down(sched_edf_heap_t *heap, int64_t index) {
+  task_t *task = heap->tasks[index];
+  int64_t child;
+
+  while ((child = sched_edf_heap_left(index)) < heap->size) {
+    // select the earliest deadline among both children
+    if ((child + 1 < heap->size) &&
+        (heap->tasks[child + 1]->deadline < heap->tasks[child]->deadline)) {
+      child += 1;
+    }
+
+    if (task->deadline <= heap->tasks[child]->deadline) {
       break;
     }
 
-    prio_idx -= 1;
+    sched_edf_heap_set(heap, index, heap->tasks[child]);
+    index = child;
+  }
+
+  sched_edf_heap_set(heap, index, task);
+}
+
+/******************************************************************************
+ * @brief insert a task in the deadline heap
+ * @param heap
+ * @param task to insert
+ * @return none
+ ******************************************************************************/
+static void sched_edf_heap_insert(sched_edf_heap_t *heap, task_t *task) {
+  sched_edf_heap_set(heap, heap->size, task);
+  heap->size += 1;
+  sched_edf_heap_up(heap, task->edf_index);
+}
+
+/******************************************************************************
+ * @brief remove a task from the deadline heap
+ * @param heap
+ * @param task to remove
+ * @return none
+ ******************************************************************************/
+static void sched_edf_heap_remove(sched_edf_heap_t *heap, task_t *task) {
+  int64_t index = task->edf_index;
+  task_t *last;
+  task_t *parent;
+
+  task->edf_index = TASK_EDF_NOT_QUEUED;
+
+  heap->size -= 1;
+  if (index == heap->size) {
+    return;
+  }
+
+  // fill the hole with the last task and restore the heap order
+  last = heap->tasks[heap->size];
+  sched_edf_heap_set(heap, index, last);
+
+  parent = heap->tasks[sched_edf_heap_parent(index)];
+  if ((index > SCHED_EDF_HEAP_ROOT) && (last->deadline < parent->deadline)) {
+    sched_edf_heap_up(heap, index);
+  } else {
+    sched_edf_heap_down(heap, index);
+  }
+}
+
+/******************************************************************************
+ * @brief find the highest priority level with a ready task
+ * @param run queue to scan
+ * @return highest ready priority
+ ******************************************************************************/
+static inline uint8_t sched_get_highest_prio(run_queue_t *run_queue) {
+  // the idle task is always in the run queue so groups is never null
+  uint8_t group = bit_find_last_set(run_queue->groups);
+
+  return group * RUN_QUEUE_GROUP_SIZE +
+         bit_find_last_set(run_queue->bitmap[group]);
+}
+
+/******************************************************************************
+ * @brief find the next task to run on the current hart
+ *
+ * Fixed priority tasks boosted to the EDF level are queued at the head of the
+ * level, they release the mutex an EDF task waits for before the earliest
+ * deadline runs.
+ *
+ * @param none
+ * @return task to run
+ ******************************************************************************/
+task_t *sched_get_next_task() {
+  sched_hart_t *hart      = sched_hart();
+  run_queue_t  *run_queue = &hart->run_queue;
+  list_node_t  *node =
+      list_first(&run_queue->tasks[sched_get_highest_prio(run_queue)]);
+  task_t *task = container_of(node, task_t, node);
+
+  if (sched_task_uses_edf(task)) {
+    return hart->edf_heap.tasks[SCHED_EDF_HEAP_ROOT];
+  }
+
+  return task;
+}
+
+/******************************************************************************
+ * @brief check if several ready tasks share the priority of a task
+ *
+ * EDF tasks never share the cpu, the earliest deadline runs until its job is
+ * complete.
+ *
+ * @param task to check
+ * @return true if the task priority level holds more than one task
+ ******************************************************************************/
+static inline bool sched_prio_is_shared(task_t *task) {
+  list_node_t *level = &sched_harts[task->hart].run_queue.tasks[task->prio];
+
+  return !sched_task_uses_edf(task) && !list_is_empty(level) &&
+         level->next != level->prev;
+}
+
+/******************************************************************************
+ * @brief check if a task runs before an another one
+ * @param task to check
+ * @param task it's compared to
+ * @return true if the task has a higher priority, or an earlier deadline at
+ * the EDF level, where boosted tasks come first
+ ******************************************************************************/
+static inline bool sched_task_precedes(task_t *task, task_t *other) {
+  if (task->prio != other->prio || task->prio != CONFIG_SCHED_EDF_PRIO) {
+    return task->prio > other->prio;
+  }
+
+  if (!task_is_edf(task)) {
+    return task_is_edf(other);
   }
 
-  return run_queue[prio_idx];
+  return task_is_edf(other) && task->deadline < other->deadline;
 }
 
 /******************************************************************************
@@ -86,35 +391,351 @@ void sched_switch(task_t *prev_task, task_t *new_task) {
   _switch_to(&prev_task->thread, &new_task->thread);
 }
 
+/******************************************************************************
+ * @brief charge the cpu time used by a task since its last charge
+ *
+ * The handler of the task is notified when the budget is used up, the task is
+ * throttled by the next election.
+ *
+ * @param task running on the current hart
+ * @param mtime value of the charge
+ * @return none
+ ******************************************************************************/
+static void sched_charge(task_t *task, uint64_t now) {
+  uint64_t used   = now - task->switch_in;
+  uint64_t cycles = cycle_counter_get();
+
+  task->switch_in    = now;
+  task->runtime     += used;
+  task->job_runtime += used;
+  task->cycles      += cycles - task->cycle_in;
+  task->cycle_in     = cycles;
+
+  if (!task->budget || !task->budget_left) {
+    return;
+  }
+
+  if (used < task->budget_left) {
+    task->budget_left -= used;
+    return;
+  }
+
+  task->budget_left  = 0;
+  task->overruns    += 1;
+
+  if (task->overrun_handler != NULL) {
+    notify_signal(task->overrun_handler, task->overrun_notify);
+  }
+}
+
+/******************************************************************************
+ * @brief charge the current task of this hart up to now
+ * @param none
+ * @return none
+ ******************************************************************************/
+void sched_charge_current() {
+  uint64_t flags = smp_lock();
+
+  sched_charge(sched_hart()->current_task, timer_arch_get_time());
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief give a fixed priority task a new budget once its period has elapsed
+ *
+ * The periods follow each other from the one set by task_set_budget(), those
+ * the task didn't run in are skipped. EDF tasks are given their budget on
+ * each job release.
+ *
+ * @param task to check
+ * @param current mtime value
+ * @return none
+ ******************************************************************************/
+static void sched_replenish(task_t *task, uint64_t now) {
+  if (!task->budget || task_is_edf(task) ||
+      now < task->release + task->period) {
+    return;
+  }
+
+  if (task->job_runtime > task->wcet) {
+    task->wcet = task->job_runtime;
+  }
+
+  task->release    += (now - task->release) / task->period * task->period;
+  task->budget_left = task->budget;
+  task->job_runtime = 0;
+}
+
+/******************************************************************************
+ * @brief take a task which has used its budget out of the run queue
+ *
+ * The task sleeps on its timer until its next period. The deadline of an EDF
+ * task is postponed by a period and its job resumes with a new budget.
+ *
+ * @param task to throttle
+ * @return none
+ ******************************************************************************/
+static void sched_throttle(task_t *task) {
+  uint64_t release = task->release + task->period;
+
+  // without any timer left the task keeps running
+  if (ktimer_start(&task->timer, release) != K_OK) {
+    return;
+  }
+
+  sched_remove_task(task);
+  task_set_state(task, BLOCKED);
+  task->throttled = true;
+
+  if (task_is_edf(task)) {
+    task->release     = release;
+    task->deadline    = release + task->relative_deadline;
+    task->budget_left = task->budget;
+  }
+}
+
+/******************************************************************************
+ * @brief preempt a task which has used its budget
+ *
+ * Kernel timers are served by hart 0, the other harts are told to elect a new
+ * task with an inter-processor interrupt.
+ *
+ * @param budget timer of a hart
+ * @return true if the current task has to be preempted
+ ******************************************************************************/
+static bool sched_budget_expire(ktimer_t *timer) {
+  sched_hart_t *hart = container_of(timer, sched_hart_t, budget_timer);
+
+  if (hart != sched_hart()) {
+    smp_send_ipi(sched_hart_id(hart), SMP_IPI_RESCHED);
+    return false;
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief start charging the task which gets the cpu of a hart
+ * @param scheduler state of the hart
+ * @param task getting the cpu
+ * @param current mtime value
+ * @return none
+ ******************************************************************************/
+static void sched_start_task(sched_hart_t *hart, task_t *task, uint64_t now) {
+  task->switch_in = now;
+  task->cycle_in  = cycle_counter_get();
+  sched_replenish(task, now);
+
+  if (task->budget) {
+    ktimer_start(&hart->budget_timer, now + task->budget_left);
+  } else if (ktimer_is_armed(&hart->budget_timer)) {
+    ktimer_cancel(&hart->budget_timer);
+  }
+}
+
+/******************************************************************************
+ * @brief count a switch in the statistics of both tasks
+ *
+ * A task which leaves the cpu still ready starts waiting for it again, the
+ * wait of the next task ends. Only the switches forced by task_preempt() or
+ * the budget are preemptions.
+ *
+ * @param task leaving the cpu
+ * @param task getting the cpu
+ * @param current mtime value
+ * @return none
+ ******************************************************************************/
+static inline void sched_count_switch(task_t *prev_task, task_t *new_task,
+                                      uint64_t now) {
+  uint64_t wait = now - new_task->ready_since;
+
+  prev_task->switches += 1;
+
+  if (list_is_linked(&prev_task->node) || prev_task->throttled) {
+    prev_task->ready_since = now;
+  }
+
+  // a yielding task leaves the cpu still ready but of its own will
+  if (prev_task->preempted || prev_task->throttled) {
+    prev_task->preemptions += 1;
+  }
+
+  new_task->ready_time += wait;
+  if (wait > new_task->ready_max) {
+    new_task->ready_max = wait;
+  }
+}
+
+/******************************************************************************
+ * @brief elect the next task to run and make it the current task
+ *
+ * The caller must hold the kernel lock and switch to the elected task if it's
+ * not the previous current task. The previous task is charged the cpu time it
+ * has used, the budget timer is armed for the elected task.
+ *
+ * @param none
+ * @return elected task
+ ******************************************************************************/
+task_t *sched_elect_task() {
+  sched_hart_t *hart      = sched_hart();
+  task_t       *prev_task = hart->current_task;
+  uint64_t      now       = timer_arch_get_time();
+  task_t       *new_task;
+
+  sched_charge(prev_task, now);
+  sched_replenish(prev_task, now);
+
+  // a runaway task leaves the cpu until its next period
+  if (prev_task->budget && !prev_task->budget_left &&
+      list_is_linked(&prev_task->node)) {
+    sched_throttle(prev_task);
+  }
+
+  // the affinity of the current task may have been changed from an another
+  // hart
+  if (!(prev_task->affinity & TASK_AFFINITY_HART(sched_hart_id(hart)))) {
+    sched_migrate_task(prev_task, bit_find_first_set(prev_task->affinity));
+  }
+
+  // get the new task to run
+  new_task = sched_get_next_task();
+  task_set_state(new_task, RUNNING);
+
+  // the time of the new task is charged from now
+  sched_start_task(hart, new_task, now);
+
+  // the current task is still the best candidate, no need to switch
+  if (new_task != prev_task) {
+    TRACE(TRACE_SWITCH, task_get_tid(prev_task), task_get_tid(new_task));
+    sched_count_switch(prev_task, new_task, now);
+
+#ifdef CONFIG_FPU
+    fpu_switch(sched_hart_id(hart), prev_task, new_task);
+#endif
+
+    // update the current task
+    hart->current_task = new_task;
+
+#if defined(CONFIG_VM)
+    vm_switch(sched_hart_id(hart), new_task);
+#elif defined(CONFIG_PMP)
+    pmp_switch(sched_hart_id(hart), new_task);
+#endif
+
+#ifdef CONFIG_SCHED_TIME_SLICING
+    // the new task may need the tick, or not anymore
+    sched_tick_update(hart);
+#endif
+
+    // a preempted task now waits for the cpu
+    if (list_is_linked(&prev_task->node) &&
+        prev_task->hart == sched_hart_id(hart)) {
+      sched_kick_idle(prev_task);
+    }
+  }
+
+  prev_task->preempted = false;
+
+  return new_task;
+}
+
 /******************************************************************************
  * @brief main function to run the scheduler
  * @param none
  * @return none
  ******************************************************************************/
 void sched_run() {
-  task_t *new_task;
-  task_t *prev_task;
+  task_t  *new_task;
+  task_t  *prev_task;
+  uint64_t flags;
+
+  // the kernel lock is held from the election to the end of the context
+  // switch, it's released by the task which is switched to
+  flags = smp_lock();
 
   // save the current task
   prev_task = sched_get_current_task();
 
-  // get the new task to run
-  new_task = sched_get_next_task();
-  task_set_state(new_task, RUNNING);
+  new_task = sched_elect_task();
+
+  if (new_task != prev_task) {
+    sched_switch(prev_task, new_task);
+  }
 
-  // update the current task
-  sched_set_current_task(new_task);
+  // each task restores the interrupt state it had when it left the cpu
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief release the kernel lock on the first run of a new task
+ *
+ * A new task is switched to by sched_run() but starts from _ret_from_switch,
+ * not from the end of sched_run(). A task resumed after a preemption by an
+ * interrupt also goes through here, it gives the cpu again if a preemption
+ * has been deferred meanwhile.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void sched_task_start() {
+  smp_lock_drop();
 
-  sched_switch(prev_task, new_task);
+  if (smp_preempt_take()) {
+    task_preempt();
+  }
 }
 
 /******************************************************************************
  * @brief add a new task to the run queue
+ *
+ * A task queued on an another hart preempts the current task of this hart
+ * with an inter-processor interrupt. A task which can't preempt the current
+ * task of its hart wakes up an idle hart allowed by its affinity.
+ *
  * @param task to add in the run queue
  * @return none
  ******************************************************************************/
 void sched_add_task(task_t *task) {
-  run_queue[task->prio] = task;
+  uint8_t       prio  = task->prio;
+  sched_hart_t *hart  = &sched_harts[task->hart];
+  uint64_t      flags = smp_lock();
+
+  // a task can be woken up while it's already in the run queue
+  if (!list_is_linked(&task->node)) {
+    if (sched_task_uses_edf(task)) {
+      list_add_tail(&task->node, &hart->run_queue.tasks[prio]);
+      sched_edf_heap_insert(&hart->edf_heap, task);
+    } else if (prio == CONFIG_SCHED_EDF_PRIO) {
+      list_add_head(&task->node, &hart->run_queue.tasks[prio]);
+    } else {
+      list_add_tail(&task->node, &hart->run_queue.tasks[prio]);
+    }
+    hart->nb_ready    += 1;
+    task->ready_since  = timer_arch_get_time();
+
+    TRACE(TRACE_WAKEUP, task_get_tid(task), task->hart);
+
+    bit_set(&hart->run_queue.bitmap[prio / RUN_QUEUE_GROUP_SIZE],
+            prio % RUN_QUEUE_GROUP_SIZE);
+    bit_set(&hart->run_queue.groups, prio / RUN_QUEUE_GROUP_SIZE);
+
+#ifdef CONFIG_SCHED_TIME_SLICING
+    // the current task has now a peer to share the cpu with
+    if (prio == hart->current_task->prio) {
+      sched_tick_update(hart);
+    }
+#endif
+
+    // the caller decides if the current task of this hart is preempted
+    if (!sched_task_precedes(task, hart->current_task)) {
+      sched_kick_idle(task);
+    } else if (hart != sched_hart()) {
+      smp_send_ipi(task->hart, SMP_IPI_RESCHED);
+    }
+  }
+
+  smp_unlock(flags);
 }
 
 /******************************************************************************
@@ -123,34 +744,474 @@ void sched_add_task(task_t *task) {
  * @return none
  ******************************************************************************/
 void sched_remove_task(task_t *task) {
-  run_queue[task->prio] = NULL;
+  uint8_t       prio      = task->prio;
+  sched_hart_t *hart      = &sched_harts[task->hart];
+  run_queue_t  *run_queue = &hart->run_queue;
+  uint64_t      flags     = smp_lock();
+
+  // the task may have already been removed, e.g. a blocked task destroyed
+  if (list_is_linked(&task->node)) {
+    list_remove(&task->node);
+    hart->nb_ready -= 1;
+
+    if (task->edf_index != TASK_EDF_NOT_QUEUED) {
+      sched_edf_heap_remove(&hart->edf_heap, task);
+    }
+
+    // update the bitmap if this priority level is now empty
+    if (list_is_empty(&run_queue->tasks[prio])) {
+      bit_clear(&run_queue->bitmap[prio / RUN_QUEUE_GROUP_SIZE],
+                prio % RUN_QUEUE_GROUP_SIZE);
+
+      if (!run_queue->bitmap[prio / RUN_QUEUE_GROUP_SIZE]) {
+        bit_clear(&run_queue->groups, prio / RUN_QUEUE_GROUP_SIZE);
+      }
+    }
+  }
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief change the priority of a task, a ready task moves to its new level
+ * @param task to modify
+ * @param new priority
+ * @return none
+ ******************************************************************************/
+void sched_set_prio(task_t *task, uint8_t prio) {
+  uint64_t flags = smp_lock();
+
+  // a ready task keeps waiting from its wake up
+  if (list_is_linked(&task->node)) {
+    uint64_t ready_since = task->ready_since;
+
+    sched_remove_task(task);
+    task->prio = prio;
+    sched_add_task(task);
+    task->ready_since = ready_since;
+  } else {
+    task->prio = prio;
+  }
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief move a task which doesn't run to the run queue of an another hart
+ *
+ * A ready task is queued on its new hart right away, a blocked task is woken
+ * up there.
+ *
+ * @param task to move
+ * @param hart the task is queued on from now
+ * @return none
+ ******************************************************************************/
+void sched_migrate_task(task_t *task, uint64_t hart_id) {
+  uint64_t flags = smp_lock();
+
+  // a ready task keeps waiting from its wake up
+  if (list_is_linked(&task->node)) {
+    uint64_t ready_since = task->ready_since;
+
+    sched_remove_task(task);
+    task->hart = hart_id;
+    sched_add_task(task);
+    task->ready_since = ready_since;
+  } else {
+    task->hart = hart_id;
+  }
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief check if a woken up task preempts the current task of this hart
+ *
+ * A task queued on an another hart preempts there, sched_add_task() already
+ * sent the inter-processor interrupt.
+ *
+ * @param task woken up
+ * @return true if the task is queued here with a higher priority or an
+ * earlier deadline
+ ******************************************************************************/
+bool sched_preempts_current(task_t *task) {
+  return task->hart == hart_id_get() &&
+         sched_task_precedes(task, sched_get_current_task());
+}
+
+/******************************************************************************
+ * @brief reserve the bandwidth of an EDF task on a hart
+ *
+ * The density budget / deadline of each task is summed, the tasks of a hart
+ * meet their deadlines as long as the sum doesn't exceed the hart.
+ *
+ * @param hart running the task
+ * @param budget of a job in mtime ticks
+ * @param relative deadline in mtime ticks
+ * @return K_OK, or K_ERROR if the hart can't hold the task
+ ******************************************************************************/
+k_return_t sched_edf_reserve(uint64_t hart_id, uint64_t budget,
+                             uint64_t deadline) {
+  sched_hart_t *hart      = &sched_harts[hart_id];
+  uint64_t      bandwidth = budget * SCHED_EDF_FULL / deadline;
+  uint64_t      flags     = smp_lock();
+
+  if (hart->edf_bandwidth + bandwidth > SCHED_EDF_FULL) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  hart->edf_bandwidth += bandwidth;
+
+  smp_unlock(flags);
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief give back the bandwidth of an EDF task
+ * @param hart running the task
+ * @param budget of a job in mtime ticks
+ * @param relative deadline in mtime ticks
+ * @return none
+ ******************************************************************************/
+void sched_edf_release(uint64_t hart_id, uint64_t budget, uint64_t deadline) {
+  uint64_t flags = smp_lock();
+
+  sched_harts[hart_id].edf_bandwidth -= budget * SCHED_EDF_FULL / deadline;
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief move a task at the end of its priority level in the run queue
+ * @param task to move
+ * @return none
+ ******************************************************************************/
+void sched_rotate_task(task_t *task) {
+  uint64_t flags = smp_lock();
+
+  // the deadline heap orders the EDF tasks, there is nothing to rotate
+  if (list_is_linked(&task->node) && !sched_task_uses_edf(task)) {
+    list_remove(&task->node);
+    list_add_tail(&task->node,
+                  &sched_harts[task->hart].run_queue.tasks[task->prio]);
+  }
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief check if the current task would lose the cpu by yielding
+ *
+ * This runs from the fast syscall path with interrupts disabled. The run queue
+ * of the current hart is also updated by the other harts, a level and its
+ * list are only consistent under the lock.
+ *
+ * @param none
+ * @return true if another ready task has the same or a higher priority
+ ******************************************************************************/
+bool sched_yield_needed() {
+  task_t  *current_task = sched_get_current_task();
+  uint64_t flags        = smp_lock();
+  bool     needed;
+
+  needed = sched_get_next_task() != current_task ||
+           sched_prio_is_shared(current_task);
+
+  smp_unlock(flags);
+
+  return needed;
+}
+
+#ifdef CONFIG_SCHED_TIME_SLICING
+
+/******************************************************************************
+ * @brief arm or disarm the tick of a hart according to its current task
+ *
+ * A task alone in its priority level can't be preempted by the tick, so the
+ * timer is only programmed when the cpu is shared. The idle task is always
+ * alone and the hart is never woken up by a useless tick.
+ *
+ * @param scheduler state of the hart
+ * @return none
+ ******************************************************************************/
+static void sched_tick_update(sched_hart_t *hart) {
+  bool shared = sched_prio_is_shared(hart->current_task);
+  bool armed  = ktimer_is_armed(&hart->tick_timer);
+
+  if (shared && !armed) {
+    ktimer_start(&hart->tick_timer, timer_arch_get_time() + SCHED_TICK_PERIOD);
+  } else if (!shared && armed) {
+    ktimer_cancel(&hart->tick_timer);
+  }
+}
+
+/******************************************************************************
+ * @brief account a scheduler tick to the current task of a hart
+ *
+ * Called from the timer interrupt. The current task time slice is decreased
+ * and, when it expires, the task has to leave the cpu if an another task with
+ * the same priority is ready. Higher priority tasks don't need the tick as
+ * they preempt the current task as soon as they are woken up.
+ *
+ * Kernel timers are served by hart 0, the other harts are told to switch
+ * with an inter-processor interrupt.
+ *
+ * @param scheduler tick timer
+ * @return true if the current task has to be preempted
+ ******************************************************************************/
+static bool sched_tick(ktimer_t *timer) {
+  sched_hart_t *hart     = container_of(timer, sched_hart_t, tick_timer);
+  task_t       *task     = hart->current_task;
+  uint64_t      deadline = timer->deadline + SCHED_TICK_PERIOD;
+  uint64_t      now      = timer_arch_get_time();
+
+  // the peers may have left the run queue since the tick was armed
+  if (!sched_prio_is_shared(task)) {
+    return false;
+  }
+
+  // program the next tick, skip the ones we missed
+  if (deadline <= now) {
+    deadline = now + SCHED_TICK_PERIOD;
+  }
+  ktimer_start(timer, deadline);
+
+  if (task->ticks_left > 1) {
+    task->ticks_left -= 1;
+    return false;
+  }
+
+  // the time slice has expired, give a new one to the task and let a peer
+  // run first
+  task->ticks_left = task->quantum;
+  sched_rotate_task(task);
+
+  if (hart != sched_hart()) {
+    smp_send_ipi(hart - sched_harts, SMP_IPI_RESCHED);
+    return false;
+  }
+
+  return true;
+}
+#endif
+
+/******************************************************************************
+ * @brief steal a ready task from the busiest peer
+ *
+ * The highest priority task waiting on the peer which has the most ready
+ * tasks is moved to the run queue of this hart, if its affinity allows it.
+ * The peer keeps its running task.
+ *
+ * @param none
+ * @return true if a task has been stolen
+ ******************************************************************************/
+static bool sched_steal_task() {
+  sched_hart_t *hart    = sched_hart();
+  uint64_t      allowed = TASK_AFFINITY_HART(sched_hart_id(hart));
+  sched_hart_t *busiest = NULL;
+  uint64_t      scanned = 0;
+  uint64_t      groups;
+  uint64_t      levels;
+  uint8_t       group;
+  uint8_t       level;
+  list_node_t  *head;
+  list_node_t  *node;
+  task_t       *task;
+
+  for (uint64_t hart_id = 0; hart_id < CONFIG_HART_MAX_NB; hart_id++) {
+    sched_hart_t *peer = &sched_harts[hart_id];
+
+    if (peer != hart && peer->nb_ready >= SCHED_STEAL_MIN_READY &&
+        (busiest == NULL || peer->nb_ready > busiest->nb_ready)) {
+      busiest = peer;
+    }
+  }
+
+  if (busiest == NULL) {
+    return false;
+  }
+
+  // walk the non-empty levels of the peer from the highest priority
+  groups = busiest->run_queue.groups;
+
+  while (groups) {
+    group = bit_find_last_set(groups);
+    bit_clear(&groups, group);
+    levels = busiest->run_queue.bitmap[group];
+
+    while (levels) {
+      level = bit_find_last_set(levels);
+      bit_clear(&levels, level);
+
+      head = &busiest->run_queue.tasks[group * RUN_QUEUE_GROUP_SIZE + level];
+
+      list_for_each(node, head) {
+        task = container_of(node, task_t, node);
+
+        // the idle task of the peer is pinned like any other pinned task, so
+        // are the EDF tasks
+        if (task != busiest->current_task && (task->affinity & allowed)) {
+          sched_migrate_task(task, sched_hart_id(hart));
+          return true;
+        }
+
+        if (++scanned == SCHED_STEAL_SCAN_MAX) {
+          return false;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+/******************************************************************************
+ * @brief put the hart to sleep when no other task than idle is ready
+ *
+ * Interrupts are disabled while the run queue is checked so a wake up can't
+ * be missed between the check and wfi: a task queued by an another hart once
+ * the lock is released raises the software interrupt. The pending interrupt
+ * is served as soon as interrupts are restored.
+ *
+ * An idle hart first tries to steal a task from its peers, it only sleeps if
+ * there is none to take.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void sched_idle() {
+  uint64_t flags = irq_arch_disable();
+  uint64_t lock  = smp_lock();
+  bool     idle  = sched_get_next_task() == &sched_hart()->idle_task &&
+                   !sched_steal_task();
+
+  // the lock must not be held while the hart sleeps
+  smp_unlock(lock);
+
+  if (idle) {
+    irq_arch_wait();
+  }
+
+  irq_arch_restore(flags);
 }
 
 /******************************************************************************
  * @brief find the current running task
+ *
+ * The thread pointer holds the task running the caller, whatever the hart it
+ * runs on.
+ *
  * @param none
  * @return current_task address pointer
  ******************************************************************************/
 task_t *sched_get_current_task() {
-  return current_task;
+  return (task_t *)thread_pointer_get();
 }
 
 /******************************************************************************
- * @brief set the current running task
+ * @brief set the current running task of the current hart
+ *
+ * Used by the direct switches which bypass the election, the previous task is
+ * charged the cpu time it has used.
+ *
  * @param current_task address pointer
  * @return none
  ******************************************************************************/
 void sched_set_current_task(task_t *task) {
-  current_task = task;
+  sched_hart_t *hart = sched_hart();
+  uint64_t      now  = timer_arch_get_time();
+
+  sched_charge(hart->current_task, now);
+
+  TRACE(TRACE_SWITCH, task_get_tid(hart->current_task), task_get_tid(task));
+  sched_count_switch(hart->current_task, task, now);
+
+#ifdef CONFIG_FPU
+  fpu_switch(sched_hart_id(hart), hart->current_task, task);
+#endif
+
+  hart->current_task = task;
+  sched_start_task(hart, task, now);
+
+#if defined(CONFIG_VM)
+  vm_switch(sched_hart_id(hart), task);
+#elif defined(CONFIG_PMP)
+  pmp_switch(sched_hart_id(hart), task);
+#endif
+}
+
+/******************************************************************************
+ * @brief check if a task is the current task of its hart
+ * @param task to check
+ * @return true if the task runs
+ ******************************************************************************/
+bool sched_task_is_running(task_t *task) {
+  return sched_harts[task->hart].current_task == task;
+}
+
+/******************************************************************************
+ * @brief make the idle task of the current hart its running task
+ * @param none
+ * @return none
+ ******************************************************************************/
+void sched_init_hart() {
+  sched_hart_t *hart = sched_hart();
+
+  hart->current_task = &hart->idle_task;
+  thread_pointer_set((uint64_t)&hart->idle_task);
 }
 
 /******************************************************************************
  * @brief initiliaze scheduler parameters
+ *
+ * The run queues and idle tasks of all harts are initialized by hart 0 before
+ * the secondary harts are started.
+ *
  * @param none
  * @return none
  ******************************************************************************/
 void sched_init() {
-  current_task = &idle_task;
+  sched_hart_t *hart;
+  task_t       *idle;
+
+  for (uint64_t hart_id = 0; hart_id < CONFIG_HART_MAX_NB; hart_id++) {
+    hart = &sched_harts[hart_id];
+    idle = &hart->idle_task;
+
+    for (uint64_t prio = 0; prio < MAX_PRIO; prio++) {
+      list_init(&hart->run_queue.tasks[prio]);
+    }
+
+#ifdef CONFIG_SCHED_TIME_SLICING
+    ktimer_setup(&hart->tick_timer, sched_tick);
+#endif
+    ktimer_setup(&hart->budget_timer, sched_budget_expire);
 
-  sched_add_task(&idle_task);
+    hart->current_task = idle;
+
+    idle->name       = "idle";
+    idle->prio       = IDLE_PRIO;
+    idle->base_prio  = IDLE_PRIO;
+    idle->hart       = hart_id;
+    idle->affinity   = TASK_AFFINITY_HART(hart_id);
+    idle->edf_index  = TASK_EDF_NOT_QUEUED;
+    idle->state      = READY;
+    idle->stack      = smp_idle_stack(hart_id);
+    idle->stack_size = STACK_SIZE;
+    idle->quantum    = CONFIG_SCHED_QUANTUM_TICKS;
+    idle->ticks_left = CONFIG_SCHED_QUANTUM_TICKS;
+
+    list_node_init(&idle->node);
+    list_node_init(&idle->wait);
+    list_init(&idle->mutexes);
+  }
+
+  // hart 0 runs the kernel initialization in its idle task, the kernel
+  // lock can be taken from here
+  sched_init_hart();
+
+  for (uint64_t hart_id = 0; hart_id < CONFIG_HART_MAX_NB; hart_id++) {
+    sched_add_task(&sched_harts[hart_id].idle_task);
+  }
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "slab.h"
+
+#include "buddy.h"
+#include "smp.h"
+#include "stddef.h"
+
+/******************************************************************************
+ * @brief get the free list link of an object
+ * @param cache the object belongs to
+ * @param object address
+ * @return link address, in the last word of the object
+ ******************************************************************************/
+static inline slab_object_t *slab_link(slab_cache_t *cache, void *object) {
+  return (slab_object_t *)((uint8_t *)object + cache->object_size -
+                           sizeof(slab_object_t));
+}
+
+/******************************************************************************
+ * @brief get the object address from its free list link
+ * @param cache the object belongs to
+ * @param link address
+ * @return object address
+ ******************************************************************************/
+static inline void *slab_object(slab_cache_t *cache, slab_object_t *link) {
+  return (uint8_t *)link + sizeof(slab_object_t) - cache->object_size;
+}
+
+/******************************************************************************
+ * @brief carve a new slab and add its objects to the free list
+ * @param cache to grow
+ * @return K_OK or K_ERROR if the heap is full
+ ******************************************************************************/
+static k_return_t slab_grow(slab_cache_t *cache) {
+  uint8_t *slab = buddy_alloc(cache->order);
+  uint64_t nb   = (1UL << cache->order) / cache->object_size;
+
+  if (slab == NULL) {
+    return K_ERROR;
+  }
+
+  for (uint64_t index = 0; index < nb; index++) {
+    void          *object = slab + index * cache->object_size;
+    slab_object_t *link   = slab_link(cache, object);
+
+    if (cache->ctor) {
+      cache->ctor(object);
+    }
+
+    link->next  = cache->free;
+    cache->free = link;
+  }
+
+  cache->nb_objects += nb;
+  cache->nb_free    += nb;
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief initialize an empty cache, no memory is allocated
+ * @param cache to initialize
+ * @param cache name
+ * @param size of the objects in bytes
+ * @param constructor called on new objects, can be NULL
+ * @return none
+ ******************************************************************************/
+void slab_cache_init(slab_cache_t *cache, const char *name, uint64_t size,
+                     void (*ctor)(void *)) {
+  // objects are aligned on double words
+  size = (size + DOUBLE_WORD_SIZE - 1) & ~(uint64_t)(DOUBLE_WORD_SIZE - 1);
+
+  cache->name        = name;
+  cache->object_size = size;
+  cache->order       = buddy_order(size * SLAB_MIN_OBJECTS);
+  cache->ctor        = ctor;
+  cache->free        = NULL;
+  cache->nb_objects  = 0;
+  cache->nb_free     = 0;
+}
+
+/******************************************************************************
+ * @brief allocate an object, a new slab is carved if the cache is empty
+ * @param cache to allocate from
+ * @return object address, or NULL if the heap is full
+ ******************************************************************************/
+void *slab_alloc(slab_cache_t *cache) {
+  slab_object_t *link  = NULL;
+  uint64_t       flags = smp_lock();
+
+  if (cache->free == NULL && slab_grow(cache) != K_OK) {
+    smp_unlock(flags);
+    return NULL;
+  }
+
+  // pop the last released object, it's likely still in the cache
+  link        = cache->free;
+  cache->free = link->next;
+  cache->nb_free -= 1;
+
+  smp_unlock(flags);
+
+  return slab_object(cache, link);
+}
+
+/******************************************************************************
+ * @brief give an object back to its cache
+ * @param cache the object was allocated from
+ * @param object address
+ * @return none
+ ******************************************************************************/
+void slab_free(slab_cache_t *cache, void *object) {
+  slab_object_t *link;
+  uint64_t       flags;
+
+  if (object == NULL) {
+    return;
+  }
+
+  link  = slab_link(cache, object);
+  flags = smp_lock();
+
+  link->next  = cache->free;
+  cache->free = link;
+  cache->nb_free += 1;
+
+  smp_unlock(flags);
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "smp.h"
+
+#include "irq_arch.h"
+#include "irqsoff.h"
+#include "processor.h"
+#include "sched.h"
+#include "spinlock.h"
+#include "task.h"
+
+/******************************************************************************
+ * hart 0 runs on the idle stack of the linker script, the secondary harts on
+ * their own idle stacks, there is none with a single hart
+ ******************************************************************************/
+extern stack_t idle_stack;
+#if CONFIG_HART_MAX_NB > 1
+static stack_t smp_idle_stacks[CONFIG_HART_MAX_NB - 1];
+#endif
+
+/******************************************************************************
+ * stack given to each secondary hart by smp_start(), null until the hart is
+ * released. start.S reads it before hart 0 zeroes bss so it's kept in data.
+ ******************************************************************************/
+__attribute__((section(".data"))) uint64_t smp_boot_stack[CONFIG_HART_MAX_NB];
+
+/******************************************************************************
+ * requests posted to each hart and harts ready to serve them
+ ******************************************************************************/
+static uint64_t smp_ipi[CONFIG_HART_MAX_NB];
+static bool     smp_online[CONFIG_HART_MAX_NB];
+
+/******************************************************************************
+ * kernel lock, the nesting depth is saved in the owner task
+ ******************************************************************************/
+static spinlock_t smp_kernel_lock;
+
+/******************************************************************************
+ * preemptions deferred on each hart until the kernel lock is released
+ ******************************************************************************/
+static bool smp_preempt_pending[CONFIG_HART_MAX_NB];
+
+/******************************************************************************
+ * @brief wait for the kernel lock and take it
+ *
+ * A task which locked with interrupts enabled keeps serving them while an
+ * another hart holds the lock: they are only disabled to try to take it.
+ *
+ * @param interrupt enable state of the caller
+ * @return none
+ ******************************************************************************/
+static inline void smp_spin(uint64_t flags) {
+  while (!spin_trylock(&smp_kernel_lock)) {
+    irq_arch_restore(flags);
+
+    while (spin_is_locked(&smp_kernel_lock)) {
+    }
+
+    irq_arch_disable();
+  }
+}
+
+/******************************************************************************
+ * @brief take the kernel lock
+ *
+ * The depth lives in the task rather than in the hart: the lock is held across
+ * a context switch and each task unwinds its own nesting once resumed, the
+ * last one releases the lock. The interrupt state of the outermost section is
+ * kept in the task for smp_irq_window().
+ *
+ * @param none
+ * @return previous interrupt enable state to give to smp_unlock()
+ ******************************************************************************/
+uint64_t smp_lock() {
+  uint64_t flags = irq_arch_disable();
+  task_t  *task  = sched_get_current_task();
+
+  if (task->lock_depth == 0) {
+    smp_spin(flags);
+    task->lock_flags = flags;
+
+    if (flags) {
+      IRQSOFF_BEGIN(__builtin_return_address(0));
+    }
+  }
+
+  task->lock_depth++;
+
+  return flags;
+}
+
+/******************************************************************************
+ * @brief release the kernel lock taken by smp_lock()
+ *
+ * The outermost section run with interrupts enabled gives the cpu to a task
+ * woken up by an interrupt served in one of its windows.
+ *
+ * @param previous interrupt enable state
+ * @return none
+ ******************************************************************************/
+void smp_unlock(uint64_t flags) {
+  task_t *task = sched_get_current_task();
+
+  if (--task->lock_depth == 0) {
+    spin_unlock(&smp_kernel_lock);
+
+    if (flags) {
+      if (smp_preempt_take()) {
+        task_preempt();
+      }
+
+      IRQSOFF_END();
+    }
+  }
+
+  irq_arch_restore(flags);
+}
+
+/******************************************************************************
+ * @brief serve the pending interrupts in a kernel lock section
+ *
+ * Called at a point where the kernel objects are consistent, so a section
+ * which lasts, such as a bulk message copy, doesn't delay the interrupts of
+ * the hart until its end. The lock stays held: an interrupt handler nests its
+ * own sections in the one of the task and a preemption is deferred to the
+ * release of the lock. A section entered with interrupts disabled has no
+ * window.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_irq_window() {
+  task_t *task = sched_get_current_task();
+
+  if (!task->lock_flags || !irq_arch_pending()) {
+    return;
+  }
+
+  IRQSOFF_END();
+  irq_arch_restore(task->lock_flags);
+
+  irq_arch_disable();
+  IRQSOFF_BEGIN(__builtin_return_address(0));
+}
+
+/******************************************************************************
+ * @brief check if the current task holds the kernel lock
+ * @param none
+ * @return true if the lock is held
+ ******************************************************************************/
+bool smp_lock_held() {
+  return sched_get_current_task()->lock_depth != 0;
+}
+
+/******************************************************************************
+ * @brief defer the preemption of the current task of the hart
+ *
+ * Called with interrupts disabled by an interrupt which can't switch the task
+ * itself: it's nested in an another handler or in a kernel lock window.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_preempt_defer() {
+  smp_preempt_pending[hart_id_get()] = true;
+}
+
+/******************************************************************************
+ * @brief take the preemption deferred on the hart
+ * @param none
+ * @return true if the current task has to be preempted
+ ******************************************************************************/
+bool smp_preempt_take() {
+  uint64_t hart_id = hart_id_get();
+  bool     pending = smp_preempt_pending[hart_id];
+
+  smp_preempt_pending[hart_id] = false;
+
+  return pending;
+}
+
+/******************************************************************************
+ * @brief release the kernel lock inherited by a new task from the scheduler
+ *
+ * A new task starts from the switch done by the scheduler with the lock held,
+ * it has no nesting to unwind.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_lock_drop() {
+  spin_unlock(&smp_kernel_lock);
+}
+
+/******************************************************************************
+ * @brief post a request to a hart and raise its software interrupt
+ *
+ * A hart which is not online yet is not interrupted, it runs its scheduler as
+ * soon as it's started.
+ *
+ * @param target hart identifier
+ * @param SMP_IPI_* requests
+ * @return none
+ ******************************************************************************/
+void smp_send_ipi(uint64_t hart_id, uint64_t ipi) {
+  if (!__atomic_load_n(&smp_online[hart_id], __ATOMIC_ACQUIRE)) {
+    return;
+  }
+
+  __atomic_fetch_or(&smp_ipi[hart_id], ipi, __ATOMIC_RELEASE);
+  irq_arch_send_ipi(hart_id);
+}
+
+/******************************************************************************
+ * @brief acknowledge the software interrupt and take the posted requests
+ *
+ * msip is cleared first: a request posted meanwhile is either taken now or
+ * raises the interrupt again.
+ *
+ * @param none
+ * @return SMP_IPI_* requests sent to the current hart, 0 if none
+ ******************************************************************************/
+uint64_t smp_ipi_take() {
+  uint64_t hart_id = hart_id_get();
+
+  irq_arch_clear_ipi(hart_id);
+
+  return __atomic_exchange_n(&smp_ipi[hart_id], 0, __ATOMIC_ACQUIRE);
+}
+
+/******************************************************************************
+ * @brief check if a hart has been started and schedules tasks
+ * @param hart identifier
+ * @return true if the hart is online
+ ******************************************************************************/
+bool smp_is_online(uint64_t hart_id) {
+  return hart_id < CONFIG_HART_MAX_NB &&
+         __atomic_load_n(&smp_online[hart_id], __ATOMIC_ACQUIRE);
+}
+
+/******************************************************************************
+ * @brief get the idle stack of a hart
+ * @param hart identifier
+ * @return idle stack base address
+ ******************************************************************************/
+void *smp_idle_stack(uint64_t hart_id) {
+#if CONFIG_HART_MAX_NB > 1
+  if (hart_id) {
+    return &smp_idle_stacks[hart_id - 1];
+  }
+#endif
+  return &idle_stack;
+}
+
+/******************************************************************************
+ * @brief release the secondary harts, called once the kernel is initialized
+ *
+ * Each secondary hart waits in start.S for its boot stack, the software
+ * interrupt wakes it up from wfi.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_start() {
+  __atomic_store_n(&smp_online[0], true, __ATOMIC_RELEASE);
+
+  for (uint64_t hart_id = 1; hart_id < CONFIG_HART_MAX_NB; hart_id++) {
+    __atomic_store_n(&smp_boot_stack[hart_id],
+                     (uint64_t)smp_idle_stack(hart_id) + STACK_SIZE,
+                     __ATOMIC_RELEASE);
+    irq_arch_send_ipi(hart_id);
+  }
+}
+
+/******************************************************************************
+ * @brief make the current secondary hart available to the other harts
+ * @param none
+ * @return none
+ ******************************************************************************/
+void smp_hart_online() {
+  uint64_t hart_id = hart_id_get();
+
+  // the release interrupt must not be taken as a request
+  irq_arch_clear_ipi(hart_id);
+
+  __atomic_store_n(&smp_online[hart_id], true, __ATOMIC_RELEASE);
+
+  irq_arch_enable();
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "stats.h"
+
+#include "app.h"
+#include "ax_syscall.h"
+#include "timer_arch.h"
+#include "uart.h"
+
+#ifndef CONFIG_TASK_STATS_PERIOD_MS
+#define CONFIG_TASK_STATS_PERIOD_MS 0
+#endif
+
+#ifndef CONFIG_TASK_MAX_NB
+#define CONFIG_TASK_MAX_NB 64
+#endif
+
+#ifndef CONFIG_HART_MAX_NB
+#define CONFIG_HART_MAX_NB 4
+#endif
+
+// the dump preempts the application tasks, a runaway task can't hide itself
+#define STATS_PRIO 254
+
+static task_stats_t stats_records[CONFIG_TASK_MAX_NB];
+
+/******************************************************************************
+ * @brief add the bytes of a buffer to a checksum
+ * @param checksum so far
+ * @param buffer to add
+ * @param size in bytes
+ * @return new checksum
+ ******************************************************************************/
+uint32_t stats_sum(uint32_t sum, const void *buffer, uint64_t size) {
+  const uint8_t *byte = buffer;
+
+  for (uint64_t i = 0; i < size; i++) {
+    sum += byte[i];
+  }
+
+  return sum;
+}
+
+/******************************************************************************
+ * @brief send the counters of all tasks over the uart as a single frame
+ *
+ * The frame is written without any lock, a line printed by an another hart
+ * in the middle of it makes the host drop the frame on its checksum.
+ *
+ * @param none
+ * @return number of tasks in the frame
+ ******************************************************************************/
+uint64_t stats_dump() {
+  stats_frame_header_t header;
+  uint64_t             nb_tasks = 0;
+  uint32_t             sum;
+
+  for (uint64_t slot = 0; slot < CONFIG_TASK_MAX_NB; slot++) {
+    if (ax_task_get_stats(slot, &stats_records[nb_tasks]) == K_OK) {
+      nb_tasks += 1;
+    }
+  }
+
+  header.magic       = STATS_FRAME_MAGIC;
+  header.version     = STATS_FRAME_VERSION;
+  header.nb_harts    = CONFIG_HART_MAX_NB;
+  header.nb_tasks    = nb_tasks;
+  header.timebase    = TIMER_ARCH_RATE;
+  header.record_size = sizeof(task_stats_t);
+  header.timestamp   = timer_arch_get_time();
+
+  sum = stats_sum(0, &header, sizeof(header));
+  sum = stats_sum(sum, stats_records, nb_tasks * sizeof(task_stats_t));
+
+  uart_send((const uint8_t *)&header, sizeof(header));
+  uart_send((const uint8_t *)stats_records, nb_tasks * sizeof(task_stats_t));
+  uart_send((const uint8_t *)&sum, sizeof(sum));
+
+  return nb_tasks;
+}
+
+#if CONFIG_TASK_STATS_PERIOD_MS
+
+stack_t stats_stack;
+
+/******************************************************************************
+ * @brief dump the task statistics periodically
+ * @param none
+ * @return none
+ ******************************************************************************/
+static void stats_run(void) {
+  uint64_t next = timer_arch_ticks_to_us(timer_arch_get_time());
+
+  while (true) {
+    next += CONFIG_TASK_STATS_PERIOD_MS * 1000;
+    ax_task_sleep_until(next);
+    stats_dump();
+  }
+}
+
+REGISTER_APP_ON("stats", stats_run, stats_stack, STATS_PRIO, 0)
+
+#endif
@@ -0,0 +1,439 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "syscall.h"
+
+#include "channel.h"
+#include "irqsoff.h"
+#include "kmutex.h"
+#include "notify.h"
+#include "sched.h"
+#include "task.h"
+#include "trace.h"
+#include "wait_any.h"
+
+/*******************************************************************************
+ * The syscall table points to these entries for the syscalls which take a
+ * pointer: the syscalls run in machine mode, each pointer given by a user task
+ * is checked against its stack and its region set before the kernel reads or
+ * writes through it. A kernel task passes all the checks.
+ ******************************************************************************/
+
+/******************************************************************************
+ * @brief check a user task can read a string up to its terminating null
+ * @param task making the syscall
+ * @param string to check
+ * @return true if all the bytes of the string are in reach of the task
+ ******************************************************************************/
+static bool sys_user_string(const task_t *task, const char *str) {
+  if (task->region == NULL) {
+    return true;
+  }
+
+  while (task_user_range(task, str, 1, false)) {
+    if (*str == '\0') {
+      return true;
+    }
+    str++;
+  }
+
+  return false;
+}
+
+/******************************************************************************
+ * @brief task_create syscall
+ * @param see task_create()
+ * @return new task, or NULL if a pointer is out of reach
+ ******************************************************************************/
+task_t *sys_task_create(const char *name, void (*task_entry)(void), void *stack,
+                        uint64_t stack_size, uint8_t prio) {
+  task_t *task = sched_get_current_task();
+
+  // the stack is painted by the kernel when the task is set up
+  if (!sys_user_string(task, name) ||
+      !task_user_range(task, stack, stack_size, true)) {
+    return NULL;
+  }
+
+  return task_create(name, task_entry, stack, stack_size, prio);
+}
+
+/******************************************************************************
+ * @brief task_destroy syscall
+ * @param see task_destroy()
+ * @return none
+ ******************************************************************************/
+void sys_task_destroy(task_t *handle) {
+  if (task_user_handle(sched_get_current_task(), handle)) {
+    task_destroy(handle);
+  }
+}
+
+/******************************************************************************
+ * @brief task_wakeup syscall
+ * @param see task_wakeup()
+ * @return none
+ ******************************************************************************/
+void sys_task_wakeup(task_t *handle) {
+  if (task_user_handle(sched_get_current_task(), handle)) {
+    task_wakeup(handle);
+  }
+}
+
+/******************************************************************************
+ * @brief channel_create syscall
+ * @param see channel_create()
+ * @return K_OK, or K_ERROR if a pointer is out of reach
+ ******************************************************************************/
+k_return_t sys_channel_create(uint64_t *channel_handler, const char *name) {
+  task_t *task = sched_get_current_task();
+
+  if (!task_user_range(task, channel_handler, sizeof(uint64_t), true) ||
+      !sys_user_string(task, name)) {
+    return K_ERROR;
+  }
+
+  return channel_create(channel_handler, name);
+}
+
+/******************************************************************************
+ * @brief channel_get syscall
+ * @param see channel_get()
+ * @return K_OK, or K_ERROR if a pointer is out of reach
+ ******************************************************************************/
+k_return_t sys_channel_get(uint64_t *channel_handler, const char *name) {
+  task_t *task = sched_get_current_task();
+
+  if (!task_user_range(task, channel_handler, sizeof(uint64_t), true) ||
+      !sys_user_string(task, name)) {
+    return K_ERROR;
+  }
+
+  return channel_get(channel_handler, name);
+}
+
+/******************************************************************************
+ * @brief channel_snd syscall
+ * @param see channel_snd()
+ * @return K_OK, or K_ERROR if the message is out of reach
+ ******************************************************************************/
+k_return_t sys_channel_snd(const uint64_t channel_handler, const uint64_t *msg,
+                           uint64_t msg_len) {
+  if (!task_user_range(sched_get_current_task(), msg, msg_len, false)) {
+    return K_ERROR;
+  }
+
+  return channel_snd(channel_handler, msg, msg_len);
+}
+
+/******************************************************************************
+ * @brief channel_rcv syscall
+ *
+ * The size of the buffer is read once, a task of the same region set can't
+ * change it after the check.
+ *
+ * @param see channel_rcv()
+ * @return K_OK, or K_ERROR if the buffer is out of reach
+ ******************************************************************************/
+k_return_t sys_channel_rcv(const uint64_t channel_handler, uint64_t *msg,
+                           uint64_t *msg_len) {
+  task_t    *task = sched_get_current_task();
+  uint64_t   len;
+  k_return_t ret;
+
+  if (!task_user_range(task, msg_len, sizeof(uint64_t), true)) {
+    return K_ERROR;
+  }
+
+  len = *msg_len;
+  if (!task_user_range(task, msg, len, true)) {
+    return K_ERROR;
+  }
+
+  ret      = channel_rcv(channel_handler, msg, &len);
+  *msg_len = len;
+
+  return ret;
+}
+
+/******************************************************************************
+ * @brief task_set_quantum syscall
+ * @param see task_set_quantum()
+ * @return none
+ ******************************************************************************/
+void sys_task_set_quantum(task_t *handle, uint32_t quantum) {
+  if (task_user_handle(sched_get_current_task(), handle)) {
+    task_set_quantum(handle, quantum);
+  }
+}
+
+/******************************************************************************
+ * @brief channel_call syscall
+ * @param see channel_call()
+ * @return K_OK, or K_ERROR if a buffer is out of reach
+ ******************************************************************************/
+k_return_t sys_channel_call(const uint64_t channel_handler, const uint64_t *msg,
+                            uint64_t msg_len, uint64_t *reply,
+                            uint64_t *reply_len) {
+  task_t    *task = sched_get_current_task();
+  uint64_t   len;
+  k_return_t ret;
+
+  if (!task_user_range(task, msg, msg_len, false) ||
+      !task_user_range(task, reply_len, sizeof(uint64_t), true)) {
+    return K_ERROR;
+  }
+
+  len = *reply_len;
+  if (!task_user_range(task, reply, len, true)) {
+    return K_ERROR;
+  }
+
+  ret        = channel_call(channel_handler, msg, msg_len, reply, &len);
+  *reply_len = len;
+
+  return ret;
+}
+
+/******************************************************************************
+ * @brief channel_reply_wait syscall
+ * @param see channel_reply_wait()
+ * @return K_OK, or K_ERROR if a buffer is out of reach
+ ******************************************************************************/
+k_return_t sys_channel_reply_wait(const uint64_t  channel_handler,
+                                  const uint64_t *reply, uint64_t reply_len,
+                                  uint64_t *msg, uint64_t *msg_len) {
+  task_t    *task = sched_get_current_task();
+  uint64_t   len;
+  k_return_t ret;
+
+  if (!task_user_range(task, reply, reply_len, false) ||
+      !task_user_range(task, msg_len, sizeof(uint64_t), true)) {
+    return K_ERROR;
+  }
+
+  len = *msg_len;
+  if (!task_user_range(task, msg, len, true)) {
+    return K_ERROR;
+  }
+
+  ret = channel_reply_wait(channel_handler, reply, reply_len, msg, &len);
+  *msg_len = len;
+
+  return ret;
+}
+
+/******************************************************************************
+ * @brief notify syscall
+ * @param see notify()
+ * @return none
+ ******************************************************************************/
+void sys_notify(task_t *handle, uint64_t bits) {
+  if (task_user_handle(sched_get_current_task(), handle)) {
+    notify(handle, bits);
+  }
+}
+
+/******************************************************************************
+ * @brief task_spawn syscall
+ * @param see task_spawn()
+ * @return new task, or NULL if the name is out of reach
+ ******************************************************************************/
+task_t *sys_task_spawn(const char *name, void (*task_entry)(void),
+                       uint8_t prio) {
+  if (!sys_user_string(sched_get_current_task(), name)) {
+    return NULL;
+  }
+
+  return task_spawn(name, task_entry, prio);
+}
+
+/******************************************************************************
+ * @brief task_stack_usage syscall
+ * @param see task_stack_usage()
+ * @return stack usage, 0 if the handle is not valid
+ ******************************************************************************/
+uint64_t sys_task_stack_usage(task_t *handle) {
+  if (!task_user_handle(sched_get_current_task(), handle)) {
+    return 0;
+  }
+
+  return task_stack_usage(handle);
+}
+
+/******************************************************************************
+ * @brief kmutex_lock syscall
+ * @param see kmutex_lock()
+ * @return K_OK, or K_ERROR if the mutex is out of reach
+ ******************************************************************************/
+k_return_t sys_kmutex_lock(mutex_t *mutex) {
+  if (!task_user_range(sched_get_current_task(), mutex, sizeof(mutex_t),
+                       true)) {
+    return K_ERROR;
+  }
+
+  return kmutex_lock(mutex);
+}
+
+/******************************************************************************
+ * @brief kmutex_unlock syscall
+ * @param see kmutex_unlock()
+ * @return K_OK, or K_ERROR if the mutex is out of reach
+ ******************************************************************************/
+k_return_t sys_kmutex_unlock(mutex_t *mutex) {
+  if (!task_user_range(sched_get_current_task(), mutex, sizeof(mutex_t),
+                       true)) {
+    return K_ERROR;
+  }
+
+  return kmutex_unlock(mutex);
+}
+
+/******************************************************************************
+ * @brief task_create_on syscall
+ * @param see task_create_on()
+ * @return new task, or NULL if a pointer is out of reach
+ ******************************************************************************/
+task_t *sys_task_create_on(const char *name, void (*task_entry)(void),
+                           void *stack, uint64_t stack_size, uint8_t prio,
+                           uint64_t hart) {
+  task_t *task = sched_get_current_task();
+
+  if (!sys_user_string(task, name) ||
+      !task_user_range(task, stack, stack_size, true)) {
+    return NULL;
+  }
+
+  return task_create_on(name, task_entry, stack, stack_size, prio, hart);
+}
+
+/******************************************************************************
+ * @brief task_set_affinity syscall
+ * @param see task_set_affinity()
+ * @return K_OK, or K_ERROR if the handle is not valid
+ ******************************************************************************/
+k_return_t sys_task_set_affinity(task_t *handle, uint64_t affinity) {
+  if (!task_user_handle(sched_get_current_task(), handle)) {
+    return K_ERROR;
+  }
+
+  return task_set_affinity(handle, affinity);
+}
+
+/******************************************************************************
+ * @brief task_create_edf syscall
+ * @param see task_create_edf()
+ * @return new task, or NULL if a pointer is out of reach
+ ******************************************************************************/
+task_t *sys_task_create_edf(const char *name, void (*task_entry)(void),
+                            void *stack, uint64_t stack_size,
+                            const task_edf_t *edf, uint64_t hart) {
+  task_t *task = sched_get_current_task();
+
+  if (!sys_user_string(task, name) ||
+      !task_user_range(task, stack, stack_size, true) ||
+      !task_user_range(task, edf, sizeof(task_edf_t), false)) {
+    return NULL;
+  }
+
+  return task_create_edf(name, task_entry, stack, stack_size, edf, hart);
+}
+
+/******************************************************************************
+ * @brief task_set_budget syscall
+ *
+ * The budget is copied first, a task of the same region set can't change it
+ * after it's checked.
+ *
+ * @param see task_set_budget()
+ * @return K_OK, or K_ERROR if a pointer is out of reach
+ ******************************************************************************/
+k_return_t sys_task_set_budget(task_t *handle, const task_budget_t *budget) {
+  task_t       *task = sched_get_current_task();
+  task_budget_t params;
+
+  if (!task_user_handle(task, handle) ||
+      !task_user_range(task, budget, sizeof(task_budget_t), false)) {
+    return K_ERROR;
+  }
+
+  params = *budget;
+
+  return task_set_budget(handle, &params);
+}
+
+/******************************************************************************
+ * @brief trace_read syscall
+ * @param see trace_read()
+ * @return number of records read, 0 if the buffer is out of reach
+ ******************************************************************************/
+uint64_t sys_trace_read(uint64_t hart, trace_record_t *records, uint64_t nb) {
+  // a ring never holds more records, the size of the buffer can't overflow
+  if (nb > CONFIG_TRACE_RECORDS) {
+    nb = CONFIG_TRACE_RECORDS;
+  }
+
+  if (!task_user_range(sched_get_current_task(), records,
+                       nb * sizeof(trace_record_t), true)) {
+    return 0;
+  }
+
+  return trace_read(hart, records, nb);
+}
+
+/******************************************************************************
+ * @brief task_get_stats syscall
+ * @param see task_get_stats()
+ * @return K_OK, or K_ERROR if the buffer is out of reach
+ ******************************************************************************/
+k_return_t sys_task_get_stats(uint64_t slot, task_stats_t *stats) {
+  if (!task_user_range(sched_get_current_task(), stats, sizeof(task_stats_t),
+                       true)) {
+    return K_ERROR;
+  }
+
+  return task_get_stats(slot, stats);
+}
+
+/******************************************************************************
+ * @brief wait_any syscall
+ * @param see wait_any()
+ * @return index of the ready object, or K_ERROR if the objects are out of
+ * reach
+ ******************************************************************************/
+int64_t sys_wait_any(const wait_object_t *objects, uint64_t nb) {
+  if (nb > WAIT_ANY_MAX_NB ||
+      !task_user_range(sched_get_current_task(), objects,
+                       nb * sizeof(wait_object_t), false)) {
+    return K_ERROR;
+  }
+
+  return wait_any(objects, nb);
+}
+
+/******************************************************************************
+ * @brief irqsoff_read syscall
+ * @param see irqsoff_read()
+ * @return K_OK, or K_ERROR if the buffer is out of reach
+ ******************************************************************************/
+k_return_t sys_irqsoff_read(uint64_t hart, irqsoff_stats_t *stats) {
+  if (!task_user_range(sched_get_current_task(), stats,
+                       sizeof(irqsoff_stats_t), true)) {
+    return K_ERROR;
+  }
+
+  return irqsoff_read(hart, stats);
+}
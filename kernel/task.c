@@ -17,8 +17,37 @@
 #include "task.h"
 
 #include "ax_syscall.h"
+#include "bitops.h"
+#include "channel.h"
+#include "fpu.h"
+#include "kmutex.h"
+#include "offsets.h"
 #include "sched.h"
+#include "slab.h"
+#include "smp.h"
 #include "stddef.h"
+#include "timer_arch.h"
+#include "vm.h"
+#include "wait_any.h"
+
+#ifndef CONFIG_SCHED_QUANTUM_TICKS
+#define CONFIG_SCHED_QUANTUM_TICKS 10
+#endif
+
+#ifndef CONFIG_TASK_MAX_NB
+#define CONFIG_TASK_MAX_NB 64
+#endif
+
+#ifndef CONFIG_SCHED_EDF_PRIO
+#define CONFIG_SCHED_EDF_PRIO 128
+#endif
+
+#define TASK_FREE_WORDS ((CONFIG_TASK_MAX_NB + 63) / 64)
+
+// _switch_to loads the thread pointer with the thread_t address
+_Static_assert(offsetof(task_t, thread) == 0, "thread must start task_t");
+_Static_assert(offsetof(thread_t, msg_deposited) == TASK_THREAD_MSG_DEPOSITED,
+               "channel routines read msg_deposited from tp");
 
 #define __no_return __attribute__((noreturn))
 
@@ -26,6 +55,18 @@ extern void _syscall(uint64_t syscall_number);
 
 uint64_t last_thread_id = (uint64_t)NULL;
 
+// control blocks of all tasks but the idle one, bit n of task_free is set
+// when the slot n of the table is free
+static task_t   task_table[CONFIG_TASK_MAX_NB];
+static uint64_t task_free[TASK_FREE_WORDS];
+
+// stacks of the spawned tasks
+static slab_cache_t task_cache;
+
+// tasks which have exited or have been destroyed, their control block and
+// stack are still in use until they have left the cpu of their hart
+static list_node_t task_zombies;
+
 /******************************************************************************
  * @brief find a new thread_id
  * @param none
@@ -37,6 +78,132 @@ static uint64_t task_get_new_thread_id() {
   return last_thread_id;
 }
 
+/******************************************************************************
+ * @brief take a free control block from the task table
+ * @param none
+ * @return control block, or NULL if the table is full
+ ******************************************************************************/
+static task_t *task_alloc() {
+  task_t  *task  = NULL;
+  uint64_t flags = smp_lock();
+
+  for (uint64_t word = 0; word < TASK_FREE_WORDS; word++) {
+    if (task_free[word]) {
+      uint8_t bit = bit_find_first_set(task_free[word]);
+
+      bit_clear(&task_free[word], bit);
+      task = &task_table[word * 64 + bit];
+      break;
+    }
+  }
+
+  smp_unlock(flags);
+
+  return task;
+}
+
+/******************************************************************************
+ * @brief give a control block back to the table, and its stack to the cache
+ * @param task to release
+ * @return none
+ ******************************************************************************/
+static void task_release(task_t *task) {
+  uint64_t index = task - task_table;
+  uint64_t flags = smp_lock();
+
+#ifdef CONFIG_VM
+  if (task->task_id.vms_id != 0) {
+    vm_unmap_stack(task->task_id.vms_id, task->stack, task->stack_size);
+  }
+#endif
+
+#ifdef CONFIG_FPU
+  fpu_release(task);
+#endif
+
+  if (task->spawned) {
+    task->spawned = false;
+    slab_free(&task_cache, task->stack);
+  }
+
+  bit_set(&task_free[index / 64], index % 64);
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief take a task out of the run queue and of the objects it waits for
+ * @param task to detach
+ * @return none
+ ******************************************************************************/
+static void task_detach(task_t *task) {
+  uint64_t flags = smp_lock();
+
+  // a pending sleep timer must not wake up a dead task
+  ktimer_cancel(&task->timer);
+  // nor a mutex or a channel waiting for it
+  kmutex_cancel_wait(task);
+  channel_cancel_wait(task);
+  // nor an object bound by wait_any()
+  wait_any_release(task);
+  // tag the deleted task as blocked
+  task_set_state(task, BLOCKED);
+  // remove it from the run queue
+  sched_remove_task(task);
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief release the exited and destroyed tasks which have left the cpu
+ *
+ * The kernel lock is held by a hart from the election to the end of the
+ * switch, a zombie which isn't the current task of its hart has fully left
+ * it. A task destroyed from an another hart may have entered the kernel again
+ * before its hart took the interrupt, it's detached again before it's
+ * released.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+static void task_reap() {
+  uint64_t     flags = smp_lock();
+  list_node_t *node  = task_zombies.next;
+  list_node_t *next;
+  task_t      *task;
+
+  for (; node != &task_zombies; node = next) {
+    next = node->next;
+    task = container_of(node, task_t, zombie);
+
+    if (!sched_task_is_running(task)) {
+      list_remove(node);
+      task_detach(task);
+      task_release(task);
+    }
+  }
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief wake up a task when its sleep timer expires
+ *
+ * The timer also ends the throttling of a task which has used its budget.
+ *
+ * @param timer embedded in the task
+ * @return true if the woken up task has to preempt the current one
+ ******************************************************************************/
+static bool task_timer_expire(ktimer_t *timer) {
+  task_t *task = container_of(timer, task_t, timer);
+
+  task->throttled = false;
+  task_set_state(task, READY);
+  sched_add_task(task);
+
+  return sched_preempts_current(task);
+}
+
 /******************************************************************************
  * @brief task runtinme
  *
@@ -60,38 +227,497 @@ __no_return void task_runtime(void (*task_entry)(void)) {
 }
 
 /******************************************************************************
- * @brief initialize a task and schedule it
+ * @brief initialize the task table and the cache of task stacks
+ * @param none
+ * @return none
+ ******************************************************************************/
+void task_init() {
+  for (uint64_t index = 0; index < CONFIG_TASK_MAX_NB; index++) {
+    bit_set(&task_free[index / 64], index % 64);
+  }
+
+  list_init(&task_zombies);
+
+  slab_cache_init(&task_cache, "task", sizeof(stack_t), NULL);
+}
+
+/******************************************************************************
+ * @brief initialize a task with its hart and affinity, and schedule it
  * @param id of the task
  * @param function to run in the task
  * @param stack start address of the task
+ * @param stack size in bytes, at least STACK_MIN_SIZE
  * @param priority for the new task
- * @return none
+ * @param hart running the task
+ * @param harts the task is allowed to run on, the hart included
+ * @param timing parameters of an EDF task, NULL for a fixed priority task
+ * @param region set of a user task, NULL for a kernel task
+ * @return new task, or NULL if the hart doesn't exist, the stack is too small
+ * or the table is full
  ******************************************************************************/
-void task_create(const char *name, void (*task_entry)(void), stack_t *stack,
-                 uint8_t prio) {
-  // save task infos at the beginning of the task
-  task_t *task = (task_t *)stack;
+static task_t *task_setup(const char *name, void (*task_entry)(void),
+                          void *stack, uint64_t stack_size, uint8_t prio,
+                          uint64_t hart, uint64_t affinity,
+                          const task_edf_t *edf, task_region_t *region) {
+  task_t   *task    = NULL;
+  task_t   *creator = sched_get_current_task();
+  uint64_t *word    = NULL;
+  uint32_t  vms_id  = 0;
+
+  // sp must stay 16-bytes aligned
+  stack_size &= ~(uint64_t)(LWORD_SIZE - 1);
+
+  // a user task can't create a kernel task, nor escape its region set
+  if (creator != NULL && creator->region != NULL) {
+    region = creator->region;
+  }
+
+  if (stack_size < STACK_MIN_SIZE || hart >= CONFIG_HART_MAX_NB) {
+    return NULL;
+  }
+
+  if (region != NULL && stack_size < STACK_MIN_SIZE + USER_KERNEL_STACK_SIZE) {
+    return NULL;
+  }
+
+  // an exited task may still hold the last free control block, or the pages
+  // of the stack
+  task_reap();
+
+#ifdef CONFIG_VM
+  // the stack of a user task is mapped in the address space of its region set
+  if (region != NULL) {
+    vms_id = vm_map_stack(region, stack, stack_size);
+    if (vms_id == 0) {
+      return NULL;
+    }
+  }
+#endif
+
+  task = task_alloc();
+  if (task == NULL) {
+#ifdef CONFIG_VM
+    if (vms_id != 0) {
+      vm_unmap_stack(vms_id, stack, stack_size);
+    }
+#endif
+    return NULL;
+  }
 
   task->name = name;
 
-  // find a unique task ID
-  task->task_id.vms_id    = 0;
+  // find a unique task ID, the kernel tasks are in the address space 0
+  task->task_id.vms_id    = vms_id;
   task->task_id.thread_id = task_get_new_thread_id();
 
-  // save task priority
-  task->prio = prio;
+  // save task priority, it's raised while the task owns a contended mutex
+  task->prio      = prio;
+  task->base_prio = prio;
+
+  // the task is queued on its hart, it doesn't hold the kernel lock
+  task->hart       = hart;
+  task->affinity   = affinity;
+  task->lock_depth = 0;
+  task->lock_flags = 0;
+
+  // the floating point and vector contexts are allocated on first use
+  task->fpu         = NULL;
+  task->vector      = NULL;
+  task->fpu_hart    = FPU_NO_HART;
+  task->vector_hart = FPU_NO_HART;
+
+  // all tasks get the default time slice
+  task->quantum    = CONFIG_SCHED_QUANTUM_TICKS;
+  task->ticks_left = CONFIG_SCHED_QUANTUM_TICKS;
+
+  // an EDF task releases its first job now
+  task->edf_index       = TASK_EDF_NOT_QUEUED;
+  task->deadline_misses = 0;
+
+  if (edf != NULL) {
+    task->period            = edf->period_us * TIMER_ARCH_TICKS_PER_US;
+    task->budget            = edf->budget_us * TIMER_ARCH_TICKS_PER_US;
+    task->relative_deadline = edf->deadline_us * TIMER_ARCH_TICKS_PER_US;
+    task->release           = timer_arch_get_time();
+    task->deadline          = task->release + task->relative_deadline;
+  } else {
+    task->period            = 0;
+    task->budget            = 0;
+    task->relative_deadline = 0;
+    task->release           = 0;
+    task->deadline          = 0;
+  }
+
+  // the cpu time is charged from the first election of the task
+  task->budget_left     = task->budget;
+  task->switch_in       = 0;
+  task->throttled       = false;
+  task->runtime         = 0;
+  task->job_runtime     = 0;
+  task->wcet            = 0;
+  task->overruns        = 0;
+  task->overrun_handler = NULL;
+  task->overrun_notify  = 0;
+
+  // the counters start with the task, it waits for the cpu from now
+  task->cycle_in     = 0;
+  task->cycles       = 0;
+  task->switches     = 0;
+  task->preemptions  = 0;
+  task->preempted    = false;
+  task->ready_since  = timer_arch_get_time();
+  task->ready_time   = 0;
+  task->ready_max    = 0;
+  task->ipc_sent     = 0;
+  task->ipc_received = 0;
 
   // all created tasks are placed in READY state
   task_set_state(task, READY);
 
   // save the stack base address
-  task->stack = stack;
+  task->stack      = stack;
+  task->stack_size = stack_size;
+
+  // a kernel task runs in machine mode
+  task->region = region;
+
+  // the task is not linked in any queue yet
+  list_node_init(&task->node);
+  list_node_init(&task->wait);
+  list_node_init(&task->zombie);
+
+  // the task is not engaged in any call nor serves any channel
+  task->ipc_call    = false;
+  task->ipc_caller  = NULL;
+  task->ipc_server  = NULL;
+  task->ipc_channel = NULL;
+  task->ipc_sending = false;
+  list_init(&task->ipc_channels);
+
+  // the task doesn't own nor wait for any mutex
+  list_init(&task->mutexes);
+  task->mutex_wait = NULL;
+
+  // no notification is pending nor waited for
+  task->notify_pending = 0;
+  task->notify_mask    = 0;
+
+  // no object is bound by wait_any()
+  task->wait_objects     = NULL;
+  task->wait_nb          = 0;
+  task->wait_ready       = 0;
+  task->wait_rearm       = 0;
+  task->wait_notify      = 0;
+  task->wait_notify_mask = 0;
+  task->wait_blocked     = false;
+
+  // the stack belongs to the caller
+  task->spawned = false;
+
+  // the sleep timer is armed by task_sleep_until()
+  ktimer_setup(&task->timer, task_timer_expire);
+
+  // paint the stack before its first frame is built to track its usage
+  for (word = stack; word < (uint64_t *)((uint8_t *)stack + stack_size);
+       word++) {
+    *word = STACK_CANARY;
+  }
 
   // initialize task stack
-  task_stack_init(stack, STACK_SIZE, task_entry);
+  task_stack_init(task, task_entry);
 
   // save the new task in the run queue
   sched_add_task(task);
+
+  return task;
+}
+
+/******************************************************************************
+ * @brief initialize a task and schedule it
+ *
+ * The new task runs on the hart of its creator and inherits its affinity, so
+ * the children of a pinned task keep a single processor view of the
+ * priorities.
+ *
+ * @param id of the task
+ * @param function to run in the task
+ * @param stack start address of the task
+ * @param stack size in bytes, at least STACK_MIN_SIZE
+ * @param priority for the new task
+ * @return new task, or NULL if the stack is too small or the table is full
+ ******************************************************************************/
+task_t *task_create(const char *name, void (*task_entry)(void), void *stack,
+                    uint64_t stack_size, uint8_t prio) {
+  task_t *creator = sched_get_current_task();
+
+  return task_setup(name, task_entry, stack, stack_size, prio, creator->hart,
+                    creator->affinity, NULL, NULL);
+}
+
+/******************************************************************************
+ * @brief initialize a task and schedule it on a given hart
+ *
+ * The new task is pinned to the hart.
+ *
+ * @param id of the task
+ * @param function to run in the task
+ * @param stack start address of the task
+ * @param stack size in bytes, at least STACK_MIN_SIZE
+ * @param priority for the new task
+ * @param hart running the task
+ * @return new task, or NULL if the hart doesn't exist, the stack is too small
+ * or the table is full
+ ******************************************************************************/
+task_t *task_create_on(const char *name, void (*task_entry)(void), void *stack,
+                       uint64_t stack_size, uint8_t prio, uint64_t hart) {
+  return task_setup(name, task_entry, stack, stack_size, prio, hart,
+                    TASK_AFFINITY_HART(hart), NULL, NULL);
+}
+
+/******************************************************************************
+ * @brief initialize an earliest deadline first task and schedule it
+ *
+ * The bandwidth of the task is reserved on its hart before it's set up, and
+ * given back if the task can't be created.
+ *
+ * @param id of the task
+ * @param function to run in the task
+ * @param stack start address of the task
+ * @param stack size in bytes, at least STACK_MIN_SIZE
+ * @param timing parameters of the task
+ * @param hart running the task
+ * @return new task, or NULL if the parameters are not valid, the hart is
+ * overloaded or the table is full
+ ******************************************************************************/
+task_t *task_create_edf(const char *name, void (*task_entry)(void),
+                        void *stack, uint64_t stack_size,
+                        const task_edf_t *edf, uint64_t hart) {
+  task_edf_t params = *edf;
+  task_t    *task   = NULL;
+  uint64_t   flags;
+
+  if (!params.deadline_us) {
+    params.deadline_us = params.period_us;
+  }
+
+  // a job must fit in its deadline, which can't exceed the period
+  if (!params.budget_us || params.budget_us > params.deadline_us ||
+      params.deadline_us > params.period_us || hart >= CONFIG_HART_MAX_NB) {
+    return NULL;
+  }
+
+  // the task must not run before its bandwidth is accounted
+  flags = smp_lock();
+
+  if (sched_edf_reserve(hart, params.budget_us * TIMER_ARCH_TICKS_PER_US,
+                        params.deadline_us * TIMER_ARCH_TICKS_PER_US) == K_OK) {
+    task = task_setup(name, task_entry, stack, stack_size,
+                      CONFIG_SCHED_EDF_PRIO, hart, TASK_AFFINITY_HART(hart),
+                      &params, NULL);
+
+    if (task == NULL) {
+      sched_edf_release(hart, params.budget_us * TIMER_ARCH_TICKS_PER_US,
+                        params.deadline_us * TIMER_ARCH_TICKS_PER_US);
+    }
+  }
+
+  smp_unlock(flags);
+
+  return task;
+}
+
+#ifdef CONFIG_PMP
+/******************************************************************************
+ * @brief initialize a user mode task and schedule it
+ * @param id of the task
+ * @param function to run in the task, in the region set text
+ * @param stack start address of the task
+ * @param stack size in bytes, at least STACK_MIN_SIZE plus the kernel stack
+ * @param priority for the new task
+ * @param region set of the task
+ * @return new task, or NULL if the stack is too small or the table is full
+ ******************************************************************************/
+task_t *task_create_user(const char *name, void (*task_entry)(void),
+                         void *stack, uint64_t stack_size, uint8_t prio,
+                         task_region_t *region) {
+  task_t *creator = sched_get_current_task();
+
+  return task_setup(name, task_entry, stack, stack_size, prio, creator->hart,
+                    creator->affinity, NULL, region);
+}
+#endif
+
+/******************************************************************************
+ * @brief create a task with a stack allocated from the task cache
+ * @param name of the task
+ * @param function to run in the task
+ * @param priority for the new task
+ * @return new task, or NULL if there is no memory left
+ ******************************************************************************/
+task_t *task_spawn(const char *name, void (*task_entry)(void), uint8_t prio) {
+  stack_t *stack = NULL;
+  task_t  *task  = NULL;
+  uint64_t flags;
+
+  task_reap();
+
+  stack = slab_alloc(&task_cache);
+  if (stack == NULL) {
+    return NULL;
+  }
+
+  // the task must not run before it's tagged as spawned
+  flags = smp_lock();
+
+  task = task_create(name, task_entry, stack, sizeof(stack_t), prio);
+  if (task == NULL) {
+    slab_free(&task_cache, stack);
+  } else {
+    task->spawned = true;
+  }
+
+  smp_unlock(flags);
+
+  return task;
+}
+
+/******************************************************************************
+ * @brief get the stack high-water mark of a task
+ * @param task to measure
+ * @return maximum number of stack bytes used since the task creation
+ ******************************************************************************/
+uint64_t task_stack_usage(task_t *task) {
+  uint64_t *word = task->stack;
+  uint64_t *top  = (uint64_t *)((uint8_t *)task->stack + task->stack_size);
+
+  // the stack grows down, the deepest word used is the first one overwritten
+  while (word < top && *word == STACK_CANARY) {
+    word++;
+  }
+
+  return (uint8_t *)top - (uint8_t *)word;
+}
+
+/******************************************************************************
+ * @brief read the counters of a task of the task table
+ * @param slot of the task table, from 0 to task_max_nb - 1
+ * @param statistics of the task
+ * @return K_OK, or K_ERROR if the slot is free or doesn't exist
+ ******************************************************************************/
+k_return_t task_get_stats(uint64_t slot, task_stats_t *stats) {
+  task_t  *task;
+  uint64_t flags;
+  uint64_t index;
+
+  if (slot >= CONFIG_TASK_MAX_NB) {
+    return K_ERROR;
+  }
+
+  task = &task_table[slot];
+
+  // the counters are updated under the kernel lock
+  flags = smp_lock();
+
+  if (task_free[slot / 64] & (1UL << (slot % 64))) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  stats->task_id  = task_get_tid(task);
+  stats->prio     = task->prio;
+  stats->hart     = task->hart;
+  stats->state    = task_get_state(task);
+  stats->reserved = 0;
+
+  for (index = 0; index < TASK_STATS_NAME_LENGTH; index++) {
+    stats->name[index] = task->name[index];
+
+    if (task->name[index] == '\0') {
+      break;
+    }
+  }
+
+  for (; index < TASK_STATS_NAME_LENGTH; index++) {
+    stats->name[index] = '\0';
+  }
+
+  // a running task is only charged when it leaves the cpu
+  stats->runtime = task->runtime;
+  if (task_get_state(task) == RUNNING) {
+    stats->runtime += timer_arch_get_time() - task->switch_in;
+  }
+
+  stats->cycles       = task->cycles;
+  stats->switches     = task->switches;
+  stats->preemptions  = task->preemptions;
+  stats->ready_time   = task->ready_time;
+  stats->ready_max    = task->ready_max;
+  stats->ipc_sent     = task->ipc_sent;
+  stats->ipc_received = task->ipc_received;
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief check a user task can reach a memory range given to a syscall
+ * @param task making the syscall
+ * @param start address of the range
+ * @param size of the range in bytes
+ * @param true if the kernel writes the range
+ * @return true if the range lies in the user part of the task stack or in its
+ * region set, always true for a kernel task
+ ******************************************************************************/
+bool task_user_range(const task_t *task, const void *addr, uint64_t size,
+                     bool write) {
+  task_region_t *region = task->region;
+  uint64_t       start  = (uint64_t)addr;
+  uint64_t       end    = start + size;
+  uint64_t       stack  = (uint64_t)task->stack;
+
+  if (region == NULL) {
+    return true;
+  }
+
+  if (end < start) {
+    return false;
+  }
+
+  // the kernel stack at the top of the stack is out of reach
+  if (start >= stack &&
+      end <= stack + task->stack_size - USER_KERNEL_STACK_SIZE) {
+    return true;
+  }
+
+  if (start >= region->data_start && end <= region->data_end) {
+    return true;
+  }
+
+  return !write && start >= region->text_start && end <= region->text_end;
+}
+
+/******************************************************************************
+ * @brief check a task handle given to a syscall by a user task
+ * @param task making the syscall
+ * @param handle to check
+ * @return true if the handle is a task of the task table, always true for a
+ * kernel task
+ ******************************************************************************/
+bool task_user_handle(const task_t *task, const task_t *handle) {
+  uint64_t offset = (uint64_t)handle - (uint64_t)task_table;
+  uint64_t index  = offset / sizeof(task_t);
+
+  if (task->region == NULL) {
+    return true;
+  }
+
+  if ((uint64_t)handle < (uint64_t)task_table || offset % sizeof(task_t) ||
+      index >= CONFIG_TASK_MAX_NB) {
+    return false;
+  }
+
+  return !(task_free[index / 64] & (1UL << (index % 64)));
 }
 
 /******************************************************************************
@@ -104,6 +730,9 @@ void task_yield() {
 
   task_set_state(current_task, READY);
 
+  // let other tasks with the same priority run before this one
+  sched_rotate_task(current_task);
+
   sched_run();
 }
 
@@ -129,11 +758,229 @@ void task_sleep() {
  * @return none
  ******************************************************************************/
 void task_wakeup(task_t *task) {
+  // a throttled task only runs again with a new budget
+  if (task->throttled) {
+    return;
+  }
+
+  // an explicit wake up ends a timed sleep
+  ktimer_cancel(&task->timer);
+
   task_set_state(task, READY);
   // add the task to the run queue
   sched_add_task(task);
 }
 
+/******************************************************************************
+ * @brief put the current task to sleep until a machine timer date
+ * @param wake up date in mtime ticks
+ * @return none
+ ******************************************************************************/
+static void task_sleep_until_deadline(uint64_t deadline) {
+  task_t  *current_task = sched_get_current_task();
+  uint64_t flags;
+
+  // the date is already reached
+  if (deadline <= timer_arch_get_time()) {
+    return;
+  }
+
+  // the timer must not expire before the task has left the run queue
+  flags = smp_lock();
+
+  if (ktimer_start(&current_task->timer, deadline) == K_OK) {
+    task_set_state(current_task, BLOCKED);
+    sched_remove_task(current_task);
+    sched_run();
+  }
+
+  smp_unlock(flags);
+}
+
+/******************************************************************************
+ * @brief put the current task to sleep until a date
+ * @param wake up date in us since boot
+ * @return none
+ ******************************************************************************/
+void task_sleep_until(uint64_t date_in_us) {
+  task_sleep_until_deadline(date_in_us * TIMER_ARCH_TICKS_PER_US);
+}
+
+/******************************************************************************
+ * @brief put the current task to sleep during a given time
+ * @param sleep duration in us
+ * @return none
+ ******************************************************************************/
+void task_sleep_for(uint64_t duration_in_us) {
+  task_sleep_until_deadline(timer_arch_get_time() +
+                            duration_in_us * TIMER_ARCH_TICKS_PER_US);
+}
+
+/******************************************************************************
+ * @brief complete the current job and wait for the next release
+ *
+ * The releases are computed from the first one, a late job doesn't shift the
+ * following ones. The task leaves the run queue while its deadline changes
+ * so the deadline heap stays sorted.
+ *
+ * @param none
+ * @return K_OK, or K_ERROR if the current task is not an EDF task
+ ******************************************************************************/
+k_return_t task_wait_period() {
+  task_t  *task = sched_get_current_task();
+  uint64_t now  = timer_arch_get_time();
+  uint64_t flags;
+
+  if (!task_is_edf(task)) {
+    return K_ERROR;
+  }
+
+  flags = smp_lock();
+
+  if (now > task->deadline) {
+    task->deadline_misses += 1;
+  }
+
+  // the job is complete, the next one gets a full budget
+  sched_charge_current();
+  if (task->job_runtime > task->wcet) {
+    task->wcet = task->job_runtime;
+  }
+  task->job_runtime = 0;
+  task->budget_left = task->budget;
+
+  sched_remove_task(task);
+
+  task->release += task->period;
+  task->deadline = task->release + task->relative_deadline;
+
+  // the next job is already released if this one is late
+  if (task->release > now && ktimer_start(&task->timer, task->release) == K_OK) {
+    task_set_state(task, BLOCKED);
+  } else {
+    task_set_state(task, READY);
+    sched_add_task(task);
+  }
+
+  sched_run();
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief give the cpu to a higher priority task from an interrupt
+ *
+ * Unlike task_yield(), the current task keeps its place in its priority level
+ * so it resumes first once the higher priority tasks are blocked again.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void task_preempt() {
+  task_t *current_task = sched_get_current_task();
+
+  task_set_state(current_task, READY);
+
+  // counted as a preemption by the election, unlike a yield
+  current_task->preempted = true;
+
+  sched_run();
+}
+
+/******************************************************************************
+ * @brief set the time slice given to a task when time slicing is enabled
+ * @param task to modify
+ * @param number of scheduler ticks in the time slice
+ * @return none
+ ******************************************************************************/
+void task_set_quantum(task_t *task, uint32_t quantum) {
+  task->quantum    = quantum;
+  task->ticks_left = quantum;
+}
+
+/******************************************************************************
+ * @brief set the harts a task is allowed to run on
+ * @param task to modify
+ * @param affinity mask, bit n allows hart n
+ * @return K_OK, or K_ERROR if the mask doesn't hold any existing hart or the
+ * task is an EDF task
+ ******************************************************************************/
+k_return_t task_set_affinity(task_t *task, uint64_t affinity) {
+  uint64_t flags;
+
+  // the bandwidth of an EDF task is reserved on its hart
+  affinity &= TASK_AFFINITY_ALL;
+  if (!affinity || task_is_edf(task)) {
+    return K_ERROR;
+  }
+
+  flags = smp_lock();
+
+  task->affinity = affinity;
+
+  if (!(affinity & TASK_AFFINITY_HART(task->hart))) {
+    if (task == sched_get_current_task()) {
+      // the election moves the current task out of this hart
+      task_preempt();
+    } else if (sched_task_is_running(task)) {
+      smp_send_ipi(task->hart, SMP_IPI_RESCHED);
+    } else {
+      sched_migrate_task(task, bit_find_first_set(affinity));
+    }
+  } else if (list_is_linked(&task->node) && !sched_task_is_running(task)) {
+    // a waiting task may now run on an idle hart
+    sched_kick_idle(task);
+  }
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
+/******************************************************************************
+ * @brief limit the cpu time a task uses in each period
+ *
+ * The first period starts now with a full budget. A running task is elected
+ * again so the budget timer of its hart is armed.
+ *
+ * @param task to modify
+ * @param budget, period and overrun handler
+ * @return K_OK, or K_ERROR if the budget exceeds the period
+ ******************************************************************************/
+k_return_t task_set_budget(task_t *task, const task_budget_t *budget) {
+  uint64_t flags;
+
+  if (!task_is_edf(task) && budget->budget_us &&
+      budget->budget_us > budget->period_us) {
+    return K_ERROR;
+  }
+
+  flags = smp_lock();
+
+  task->overrun_handler = budget->handler;
+  task->overrun_notify  = budget->notify;
+
+  if (!task_is_edf(task)) {
+    task->budget      = budget->budget_us * TIMER_ARCH_TICKS_PER_US;
+    task->period      = budget->period_us * TIMER_ARCH_TICKS_PER_US;
+    task->release     = timer_arch_get_time();
+    task->budget_left = task->budget;
+    task->job_runtime = 0;
+
+    if (task == sched_get_current_task()) {
+      task_preempt();
+    } else if (sched_task_is_running(task)) {
+      smp_send_ipi(task->hart, SMP_IPI_RESCHED);
+    }
+  }
+
+  smp_unlock(flags);
+
+  return K_OK;
+}
+
 /******************************************************************************
  * @brief task exit
  *
@@ -147,13 +994,22 @@ void task_wakeup(task_t *task) {
  * @return none
  ******************************************************************************/
 void task_exit() {
-  task_t *task = sched_get_current_task();
-  // tag the deleted task as blocked
-  task_set_state(task, BLOCKED);
-  // remove it from the run queue
-  sched_remove_task(task);
+  task_t  *task  = sched_get_current_task();
+  uint64_t flags = smp_lock();
+
+  // the task is still used until the switch, release it later
+  task_reap();
+  list_add_tail(&task->zombie, &task_zombies);
+
+  task_detach(task);
+  // give back the bandwidth of an EDF task
+  if (task_is_edf(task)) {
+    sched_edf_release(task->hart, task->budget, task->relative_deadline);
+  }
   // call the scheduler
   sched_run();
+
+  smp_unlock(flags);
 }
 
 /******************************************************************************
@@ -163,14 +1019,44 @@ void task_exit() {
  * comprises all stacks and associated structures. It also deletes the task from
  * the scheduler runqueue.
  *
- * Instead of task_exit, it's used to delete a task from an another task
+ * Instead of task_exit, it's used to delete a task from an another task. A task
+ * running on an another hart is only released once its hart has switched it
+ * out.
  *
  * @param task to delete
  * @return none
  ******************************************************************************/
 void task_destroy(task_t *task) {
-  // tag the deleted task as blocked
-  task_set_state(task, BLOCKED);
-  // remove it from the run queue
-  sched_remove_task(task);
+  uint64_t flags = smp_lock();
+
+  // an exited or destroyed task only waits to be released
+  if (list_is_linked(&task->zombie)) {
+    task_reap();
+    smp_unlock(flags);
+    return;
+  }
+
+  // the control block and the stack are released once the task has left
+  // the cpu
+  list_add_tail(&task->zombie, &task_zombies);
+
+  task_detach(task);
+  // give back the bandwidth of an EDF task
+  if (task_is_edf(task)) {
+    sched_edf_release(task->hart, task->budget, task->relative_deadline);
+  }
+
+  if (task == sched_get_current_task()) {
+    // the task never returns, it's released by a later reap
+    sched_run();
+  } else if (sched_task_is_running(task)) {
+    // a task running on an another hart is switched out by its scheduler
+    smp_send_ipi(task->hart, SMP_IPI_RESCHED);
+  }
+
+  // the control block and the stack of a task which wasn't running can be
+  // reused
+  task_reap();
+
+  smp_unlock(flags);
 }
\ No newline at end of file
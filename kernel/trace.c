@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "trace.h"
+
+#include "smp.h"
+
+#ifdef CONFIG_TRACE
+
+trace_ring_t trace_rings[CONFIG_HART_MAX_NB];
+
+/******************************************************************************
+ * @brief read the oldest records of a hart
+ *
+ * The writer never takes the lock, the tail is only moved once the records
+ * have been copied.
+ *
+ * @param hart which has recorded the events
+ * @param buffer to copy the records in
+ * @param maximum number of records to read
+ * @return number of records read, 0 if the hart doesn't exist
+ ******************************************************************************/
+uint64_t trace_read(uint64_t hart, trace_record_t *records, uint64_t nb) {
+  trace_ring_t *ring;
+  uint64_t      head;
+  uint64_t      tail;
+  uint64_t      flags;
+  uint64_t      count = 0;
+
+  if (hart >= CONFIG_HART_MAX_NB) {
+    return 0;
+  }
+
+  ring  = &trace_rings[hart];
+  flags = smp_lock();
+
+  head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  tail = ring->tail;
+
+  for (; tail != head && count < nb; tail++, count++) {
+    records[count] = ring->records[tail & (CONFIG_TRACE_RECORDS - 1)];
+  }
+
+  // the slots can be written again
+  __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+  smp_unlock(flags);
+
+  return count;
+}
+
+/******************************************************************************
+ * @brief get the number of records a hart has dropped
+ * @param hart which has recorded the events
+ * @return number of records which didn't fit in the ring
+ ******************************************************************************/
+uint64_t trace_dropped(uint64_t hart) {
+  if (hart >= CONFIG_HART_MAX_NB) {
+    return 0;
+  }
+
+  return __atomic_load_n(&trace_rings[hart].dropped, __ATOMIC_RELAXED);
+}
+
+#else
+
+/******************************************************************************
+ * @brief read the oldest records of a hart, tracing is compiled out
+ * @param hart which has recorded the events
+ * @param buffer to copy the records in
+ * @param maximum number of records to read
+ * @return 0, nothing is recorded
+ ******************************************************************************/
+uint64_t trace_read(uint64_t hart, trace_record_t *records, uint64_t nb) {
+  return 0;
+}
+
+/******************************************************************************
+ * @brief get the number of records a hart has dropped, tracing is compiled out
+ * @param hart which has recorded the events
+ * @return 0, nothing is recorded
+ ******************************************************************************/
+uint64_t trace_dropped(uint64_t hart) {
+  return 0;
+}
+#endif
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "wait_any.h"
+
+#include "channel.h"
+#include "irq_arch.h"
+#include "sched.h"
+#include "smp.h"
+
+/******************************************************************************
+ * @brief unbind the objects of the array bound to a task
+ *
+ * A channel destroyed or an interrupt released meanwhile is already unbound,
+ * the handles are checked against the task again.
+ *
+ * @param task owning the objects
+ * @return none
+ ******************************************************************************/
+static void wait_any_unbind(task_t *task) {
+  const wait_object_t *object;
+
+  for (uint64_t i = 0; i < task->wait_nb; i++) {
+    object = &task->wait_objects[i];
+
+    if (object->type == WAIT_CHANNEL) {
+      channel_unwatch(object->handle, task);
+    } else if (object->type == WAIT_INTERRUPT) {
+      interrupt_unwatch((interrupt_id_t)object->handle, task);
+    }
+  }
+
+  task->wait_objects     = NULL;
+  task->wait_nb          = 0;
+  task->wait_ready       = 0;
+  task->wait_rearm       = 0;
+  task->wait_notify      = 0;
+  task->wait_notify_mask = 0;
+}
+
+/******************************************************************************
+ * @brief bind an array of objects to a task
+ *
+ * Each object gets the ready bit of its index, an object which is already
+ * ready sets it right away.
+ *
+ * @param task waiting for the objects
+ * @param objects to wait for
+ * @param number of objects
+ * @return K_OK, or K_ERROR if an object can't be waited for, nothing is bound
+ ******************************************************************************/
+static k_return_t wait_any_bind(task_t *task, const wait_object_t *objects,
+                                uint64_t nb) {
+  const wait_object_t *object;
+  k_return_t           ret = K_OK;
+  uint64_t             bit;
+
+  wait_any_unbind(task);
+
+  if (nb == 0 || nb > WAIT_ANY_MAX_NB) {
+    return K_ERROR;
+  }
+
+  task->wait_objects = (wait_object_t *)objects;
+  task->wait_nb      = nb;
+
+  for (uint64_t i = 0; i < nb && ret == K_OK; i++) {
+    object = &objects[i];
+    bit    = 1UL << i;
+
+    switch (object->type) {
+      case WAIT_CHANNEL:
+        ret = channel_watch(object->handle, task, bit);
+        break;
+
+      case WAIT_NOTIFY:
+        // a single mask holds all the bits a task waits for
+        if (task->wait_notify || object->handle == 0) {
+          ret = K_ERROR;
+          break;
+        }
+
+        task->wait_notify      = bit;
+        task->wait_notify_mask = object->handle;
+
+        if (task->notify_pending & object->handle) {
+          task->wait_ready |= bit;
+        }
+        break;
+
+      case WAIT_INTERRUPT:
+        ret = interrupt_watch((interrupt_id_t)object->handle, task, bit);
+        break;
+
+      default:
+        ret = K_ERROR;
+        break;
+    }
+  }
+
+  if (ret != K_OK) {
+    // objects are only unbound from their owner, the ones which were not
+    // bound are left untouched
+    wait_any_unbind(task);
+  }
+
+  return ret;
+}
+
+/******************************************************************************
+ * @brief check if the object of a ready bit is still ready
+ *
+ * Ready bits are only set by the objects, a bit is cleared here once its
+ * object has been received: a wait costs one check per object which fired
+ * since the last wait.
+ *
+ * @param task waiting for the objects
+ * @param index of the object
+ * @return true if the object is ready, an interrupt is consumed
+ ******************************************************************************/
+static bool wait_any_check(task_t *task, uint64_t index) {
+  const wait_object_t *object = &task->wait_objects[index];
+
+  switch (object->type) {
+    case WAIT_CHANNEL:
+      // a channel stays ready while senders are blocked on it
+      return channel_has_sender(object->handle);
+
+    case WAIT_NOTIFY:
+      return (task->notify_pending & task->wait_notify_mask) != 0;
+
+    case WAIT_INTERRUPT:
+      if (!interrupt_take((interrupt_id_t)object->handle)) {
+        return false;
+      }
+
+      // the source stays masked until the task served it and waits again
+      task->wait_ready &= ~(1UL << index);
+      task->wait_rearm |= 1UL << index;
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+/******************************************************************************
+ * @brief block until one of the given objects is ready
+ * @param objects to wait for, at most WAIT_ANY_MAX_NB
+ * @param number of objects
+ * @return index of the ready object with the lowest index, or K_ERROR if an
+ * object can't be waited for
+ ******************************************************************************/
+int64_t wait_any(const wait_object_t *objects, uint64_t nb) {
+  task_t  *task = sched_get_current_task();
+  uint64_t flags;
+  uint64_t ready;
+  uint64_t index;
+
+  // the objects must not signal the task between the check and the block
+  flags = smp_lock();
+
+  if ((objects != task->wait_objects || nb != task->wait_nb) &&
+      wait_any_bind(task, objects, nb) != K_OK) {
+    smp_unlock(flags);
+    return K_ERROR;
+  }
+
+  // unmask the interrupts returned by the previous waits
+  while (task->wait_rearm) {
+    index             = __builtin_ctzl(task->wait_rearm);
+    task->wait_rearm &= ~(1UL << index);
+    interrupt_rearm((interrupt_id_t)objects[index].handle, task);
+  }
+
+  for (;;) {
+    ready = task->wait_ready;
+
+    while (ready) {
+      index  = __builtin_ctzl(ready);
+      ready &= ~(1UL << index);
+
+      if (wait_any_check(task, index)) {
+        smp_unlock(flags);
+        return index;
+      }
+
+      task->wait_ready &= ~(1UL << index);
+    }
+
+    // the task may also be woken up by task_wakeup(), it waits again
+    task->wait_blocked = true;
+    task_set_state(task, BLOCKED);
+    sched_remove_task(task);
+    sched_run();
+    task->wait_blocked = false;
+  }
+}
+
+/******************************************************************************
+ * @brief set a ready bit of a task, wake it up if it waits in wait_any()
+ * @param task to signal
+ * @param ready bit of the object
+ * @return true if the signaled task has to preempt the current task
+ ******************************************************************************/
+bool wait_any_signal(task_t *task, uint64_t bit) {
+  task->wait_ready |= bit;
+
+  // a task woken up by task_wakeup() is already in the run queue
+  if (!task->wait_blocked || task_get_state(task) != BLOCKED) {
+    return false;
+  }
+
+  task->wait_blocked = false;
+  task_set_state(task, READY);
+  sched_add_task(task);
+
+  return sched_preempts_current(task);
+}
+
+/******************************************************************************
+ * @brief unbind the objects a task waits for
+ * @param task to release
+ * @return none
+ ******************************************************************************/
+void wait_any_release(task_t *task) {
+  uint64_t flags = smp_lock();
+
+  wait_any_unbind(task);
+  task->wait_blocked = false;
+
+  smp_unlock(flags);
+}
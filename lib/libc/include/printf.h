@@ -49,6 +49,15 @@ extern "C" {
 void _putchar(char character);
 
 
+/**
+ * Output a buffer of characters to the same device, used by printf() and vprintf()
+ * to send their output by chunks
+ * \param buffer Characters to output
+ * \param size Number of characters in the buffer
+ */
+void _putbuffer(const char* buffer, size_t size);
+
+
 /**
  * Tiny printf implementation
  * You have to implement _putchar if you use printf()
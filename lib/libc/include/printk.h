@@ -15,14 +15,25 @@
  * not, see https://www.gnu.org/licenses/
  */
 
-#ifndef SYS_OUT_H
-#define SYS_OUT_H
+#ifndef PRINTK_H
+#define PRINTK_H
 
 #include "printf.h"
 
+#ifdef CONFIG_PRINTK_DEFERRED
+#include "log.h"
+
+/**
+ * @brief printk saves its format and arguments, the message is formatted and
+ * printed later by the log server
+ */
+#define printk(_format, ...) \
+  log_printk(_format, LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__)
+#else
 /**
  * @brief printk use the same implementation as printf
  */
 #define printk printf
+#endif
 
-#endif
\ No newline at end of file
+#endif
@@ -22,5 +22,7 @@
 uint64_t strlen(char const *);
 char    *strcpy(char *, char const *);
 int      strcmp(char const *, char const *);
+void    *memcpy(void *, void const *, uint64_t);
+void    *memset(void *, int, uint64_t);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include <string.h>
+
+#include "word.h"
+
+#ifndef CONFIG_LIBC_RVV
+/******************************************************************************
+ * @brief copy a memory area, the areas must not overlap
+ *
+ * The destination is aligned first so the stores are never split. A source
+ * with the same alignment is copied by words, an other one is read by aligned
+ * words and each stored word is merged from two of them: the hart never does
+ * a misaligned access, which may trap.
+ *
+ * @param destination
+ * @param source
+ * @param number of bytes
+ * @return destination
+ ******************************************************************************/
+void *memcpy(void *dest, void const *src, uint64_t n) {
+  uint8_t       *d = dest;
+  uint8_t const *s = src;
+  word_t        *dw;
+  word_t const  *sw;
+  uint64_t       shift;
+  uint64_t       prev;
+  uint64_t       next;
+
+  // short copies don't pay for the alignment
+  if (n >= 2 * WORD_SIZE) {
+    while (!word_is_aligned(d)) {
+      *d++ = *s++;
+      n   -= 1;
+    }
+
+    dw = (word_t *)d;
+
+    if (word_is_aligned(s)) {
+      sw = (word_t const *)s;
+
+      for (; n >= 4 * WORD_SIZE; n -= 4 * WORD_SIZE) {
+        dw[0] = sw[0];
+        dw[1] = sw[1];
+        dw[2] = sw[2];
+        dw[3] = sw[3];
+        dw   += 4;
+        sw   += 4;
+      }
+
+      for (; n >= WORD_SIZE; n -= WORD_SIZE) {
+        *dw++ = *sw++;
+      }
+    } else {
+      // the last aligned word read holds at least one byte of the source
+      shift = ((uint64_t)s & WORD_MASK) * 8;
+      sw    = (word_t const *)((uint64_t)s & ~WORD_MASK);
+      prev  = *sw++;
+
+      for (; n >= WORD_SIZE; n -= WORD_SIZE) {
+        next  = *sw++;
+        *dw++ = prev >> shift | next << (64 - shift);
+        prev  = next;
+      }
+    }
+
+    s += (uint8_t *)dw - d;
+    d  = (uint8_t *)dw;
+  }
+
+  while (n--) {
+    *d++ = *s++;
+  }
+  return dest;
+}
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include <string.h>
+
+#include "word.h"
+
+#ifndef CONFIG_LIBC_RVV
+/******************************************************************************
+ * @brief fill a memory area with a byte, by aligned words in between its
+ * unaligned ends
+ * @param memory area
+ * @param byte value
+ * @param number of bytes
+ * @return memory area
+ ******************************************************************************/
+void *memset(void *dest, int c, uint64_t n) {
+  uint8_t *d    = dest;
+  uint64_t word = (uint8_t)c * WORD_ONES;
+  word_t  *dw;
+
+  if (n >= 2 * WORD_SIZE) {
+    while (!word_is_aligned(d)) {
+      *d++ = (uint8_t)c;
+      n   -= 1;
+    }
+
+    dw = (word_t *)d;
+
+    for (; n >= 4 * WORD_SIZE; n -= 4 * WORD_SIZE) {
+      dw[0] = word;
+      dw[1] = word;
+      dw[2] = word;
+      dw[3] = word;
+      dw   += 4;
+    }
+
+    for (; n >= WORD_SIZE; n -= WORD_SIZE) {
+      *dw++ = word;
+    }
+
+    d = (uint8_t *)dw;
+  }
+
+  while (n--) {
+    *d++ = (uint8_t)c;
+  }
+  return dest;
+}
+#endif
@@ -52,6 +52,13 @@
 #define PRINTF_NTOA_BUFFER_SIZE 32U
 #endif
 
+// output batch size of printf and vprintf, the characters are passed to
+// _putbuffer by chunks instead of one by one to _putchar (created on stack)
+// default: 64 byte
+#ifndef PRINTF_BATCH_BUFFER_SIZE
+#define PRINTF_BATCH_BUFFER_SIZE 64U
+#endif
+
 // 'ftoa' conversion buffer size, this must be big enough to hold one converted
 // float number including padded zeros (dynamically created on stack)
 // default: 32 byte
@@ -155,6 +162,27 @@ static inline void _out_char(char character, void* buffer, size_t idx,
   }
 }
 
+// output batch of printf and vprintf
+typedef struct {
+  char   data[PRINTF_BATCH_BUFFER_SIZE];
+  size_t len;
+} out_batch_type;
+
+// internal _putbuffer wrapper, a full batch is flushed
+static inline void _out_batch(char character, void* buffer, size_t idx,
+                              size_t maxlen) {
+  out_batch_type* batch = (out_batch_type*)buffer;
+  (void)idx;
+  (void)maxlen;
+  if (character) {
+    batch->data[batch->len++] = character;
+    if (batch->len == PRINTF_BATCH_BUFFER_SIZE) {
+      _putbuffer(batch->data, batch->len);
+      batch->len = 0U;
+    }
+  }
+}
+
 // internal output function wrapper
 static inline void _out_fct(char character, void* buffer, size_t idx,
                             size_t maxlen) {
@@ -914,8 +942,7 @@ static int _vsnprintf(out_fct_type out, char* buffer, const size_t maxlen,
 int printf_(const char* format, ...) {
   va_list va;
   va_start(va, format);
-  char      buffer[1];
-  const int ret = _vsnprintf(_out_char, buffer, (size_t)-1, format, va);
+  const int ret = vprintf_(format, va);
   va_end(va);
   return ret;
 }
@@ -937,8 +964,13 @@ int snprintf_(char* buffer, size_t count, const char* format, ...) {
 }
 
 int vprintf_(const char* format, va_list va) {
-  char buffer[1];
-  return _vsnprintf(_out_char, buffer, (size_t)-1, format, va);
+  out_batch_type batch;
+  batch.len     = 0U;
+  const int ret = _vsnprintf(_out_batch, (char*)&batch, (size_t)-1, format, va);
+  if (batch.len) {
+    _putbuffer(batch.data, batch.len);
+  }
+  return ret;
 }
 
 int vsnprintf_(char* buffer, size_t count, const char* format, va_list va) {
@@ -11,12 +11,36 @@
  */
 #include <string.h>
 
+#include "word.h"
+
+#ifndef CONFIG_LIBC_RVV
 int strcmp(char const *cs, char const *ct) {
-  signed char __res;
+  signed char   __res;
+  word_t const *ws;
+  word_t const *wt;
+
+  // strings with the same alignment are compared by words up to the first
+  // different word or the one holding the null byte
+  if (((uint64_t)cs & WORD_MASK) == ((uint64_t)ct & WORD_MASK)) {
+    while (!word_is_aligned(cs)) {
+      if ((__res = *cs - *ct++) != 0 || !*cs++) return __res;
+    }
+
+    ws = (word_t const *)cs;
+    wt = (word_t const *)ct;
+    while (*ws == *wt && !word_has_zero(*ws)) {
+      ws += 1;
+      wt += 1;
+    }
+
+    cs = (char const *)ws;
+    ct = (char const *)wt;
+  }
 
   while (1) {
     if ((__res = *cs - *ct++) != 0 || !*cs++) break;
   }
 
   return __res;
-}
\ No newline at end of file
+}
+#endif
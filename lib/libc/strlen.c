@@ -16,12 +16,37 @@
  */
 #include "string.h"
 
+#include "word.h"
+
+#ifndef CONFIG_LIBC_RVV
+/******************************************************************************
+ * @brief get the length of a string
+ *
+ * The string is read by aligned words once its start is aligned, a word never
+ * crosses a page so the bytes read after the null one can't fault.
+ *
+ * @param string
+ * @return number of bytes before the null byte
+ ******************************************************************************/
 uint64_t strlen(char const *s) {
-  const char *sc = s;
+  const char   *sc = s;
+  word_t const *sw;
+
+  while (!word_is_aligned(sc)) {
+    if (*sc == '\0') {
+      return (uint64_t)(sc - s);
+    }
+    sc += 1;
+  }
+
+  for (sw = (word_t const *)sc; !word_has_zero(*sw); sw++) {
+  }
 
+  sc = (const char *)sw;
   while (*sc != '\0') {
     sc += 1;
   }
 
   return (uint64_t)(sc - s);
-}
\ No newline at end of file
+}
+#endif
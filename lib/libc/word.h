@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef WORD_H
+#define WORD_H
+
+#include "common.h"
+
+/******************************************************************************
+ * word-at-a-time helpers of the string functions, a word may alias any type
+ ******************************************************************************/
+typedef uint64_t __attribute__((may_alias)) word_t;
+
+#define WORD_SIZE  sizeof(word_t)
+#define WORD_MASK  (WORD_SIZE - 1)
+#define WORD_ONES  0x0101010101010101UL
+#define WORD_HIGHS 0x8080808080808080UL
+
+/******************************************************************************
+ * @brief check if an address is aligned on a word
+ * @param address
+ * @return true if the address is aligned
+ ******************************************************************************/
+static inline bool word_is_aligned(const void *addr) {
+  return ((uint64_t)addr & WORD_MASK) == 0;
+}
+
+/******************************************************************************
+ * @brief check if a word holds a null byte
+ *
+ * A byte borrows from its high bit only if it was null, or if a lower byte
+ * was null: the lowest byte flagged is the first null byte.
+ *
+ * @param word
+ * @return non null if a byte of the word is null
+ ******************************************************************************/
+static inline uint64_t word_has_zero(uint64_t word) {
+  return (word - WORD_ONES) & ~word & WORD_HIGHS;
+}
+
+#endif
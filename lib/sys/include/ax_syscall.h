@@ -18,19 +18,52 @@
 #define AX_SYSCALL_H
 
 #include "interrupt.h"
+#include "irqsoff.h"
 #include "task.h"
+#include "trace.h"
+#include "wait_any.h"
 
-extern void ax_task_create(const char *, void (*)(void), stack_t *, uint8_t);
+struct mutex_t;
+
+extern task_t *ax_task_create(const char *, void (*)(void), void *, uint64_t,
+                              uint8_t);
+extern task_t *ax_task_create_on(const char *, void (*)(void), void *,
+                                 uint64_t, uint8_t, uint64_t);
+extern task_t *ax_task_create_edf(const char *, void (*)(void), void *,
+                                  uint64_t, const task_edf_t *, uint64_t);
 extern void ax_task_destroy(task_t *);
 extern void ax_task_yield(void);
 extern void ax_task_sleep(void);
 extern void ax_task_wakeup(task_t *);
 extern void ax_task_exit(void);
+extern task_t *ax_task_self(void);
+extern task_t *ax_task_spawn(const char *, void (*)(void), uint8_t);
+extern uint64_t ax_task_stack_usage(task_t *);
 extern void ax_interrupt_request(interrupt_id_t);
 extern void ax_interrupt_release(interrupt_id_t);
+extern void ax_interrupt_wait(interrupt_id_t);
 extern k_return_t ax_channel_create(uint64_t *, const char *);
 extern k_return_t ax_channel_get(uint64_t *, const char *);
-extern void       ax_channel_snd(const uint64_t, const uint64_t *, uint64_t);
-extern void       ax_channel_rcv(const uint64_t, const uint64_t *, uint64_t *);
+extern k_return_t ax_channel_destroy(const uint64_t);
+extern k_return_t ax_channel_snd(const uint64_t, const uint64_t *, uint64_t);
+extern k_return_t ax_channel_rcv(const uint64_t, uint64_t *, uint64_t *);
+extern void       ax_task_set_quantum(task_t *, uint32_t);
+extern k_return_t ax_task_set_affinity(task_t *, uint64_t);
+extern k_return_t ax_task_set_budget(task_t *, const task_budget_t *);
+extern k_return_t ax_task_get_stats(uint64_t, task_stats_t *);
+extern void       ax_task_sleep_until(uint64_t);
+extern void       ax_task_sleep_for(uint64_t);
+extern k_return_t ax_task_wait_period(void);
+extern k_return_t ax_channel_call(const uint64_t, const uint64_t *, uint64_t,
+                                  uint64_t *, uint64_t *);
+extern k_return_t ax_channel_reply_wait(const uint64_t, const uint64_t *,
+                                        uint64_t, uint64_t *, uint64_t *);
+extern void       ax_notify(task_t *, uint64_t);
+extern uint64_t   ax_wait(uint64_t);
+extern k_return_t ax_mutex_lock(struct mutex_t *);
+extern k_return_t ax_mutex_unlock(struct mutex_t *);
+extern uint64_t   ax_trace_read(uint64_t, trace_record_t *, uint64_t);
+extern int64_t    ax_wait_any(const wait_object_t *, uint64_t);
+extern k_return_t ax_irqsoff_read(uint64_t, irqsoff_stats_t *);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef BITOPS_H
+#define BITOPS_H
+
+#include "common.h"
+
+/******************************************************************************
+ * @brief find the index of the most significant bit set in a 64-bit word
+ *
+ * The target is built without the bitmanip extension, so a count leading zeros
+ * instruction is not available and gcc would emit a call to libgcc which is not
+ * linked. This binary search always runs 6 steps whatever the word value.
+ *
+ * @param word to scan, must not be 0
+ * @return index of the most significant bit set
+ ******************************************************************************/
+static inline uint8_t bit_find_last_set(uint64_t word) {
+  uint8_t index = 0;
+
+  if (word & 0xFFFFFFFF00000000UL) {
+    index += 32;
+    word >>= 32;
+  }
+  if (word & 0xFFFF0000UL) {
+    index += 16;
+    word >>= 16;
+  }
+  if (word & 0xFF00UL) {
+    index += 8;
+    word >>= 8;
+  }
+  if (word & 0xF0UL) {
+    index += 4;
+    word >>= 4;
+  }
+  if (word & 0xCUL) {
+    index += 2;
+    word >>= 2;
+  }
+  if (word & 0x2UL) {
+    index += 1;
+  }
+
+  return index;
+}
+
+/******************************************************************************
+ * @brief find the index of the least significant bit set in a 64-bit word
+ * @param word to scan, must not be 0
+ * @return index of the least significant bit set
+ ******************************************************************************/
+static inline uint8_t bit_find_first_set(uint64_t word) {
+  // isolate the lowest bit set
+  return bit_find_last_set(word & -word);
+}
+
+/******************************************************************************
+ * @brief set a bit in a 64-bit word
+ * @param word address pointer
+ * @param bit index
+ * @return none
+ ******************************************************************************/
+static inline void bit_set(uint64_t *word, uint8_t bit) {
+  *word |= (1UL << bit);
+}
+
+/******************************************************************************
+ * @brief clear a bit in a 64-bit word
+ * @param word address pointer
+ * @param bit index
+ * @return none
+ ******************************************************************************/
+static inline void bit_clear(uint64_t *word, uint8_t bit) {
+  *word &= ~(1UL << bit);
+}
+
+/******************************************************************************
+ * @brief invert a bit in a 64-bit word
+ * @param word address pointer
+ * @param bit index
+ * @return new value of the bit
+ ******************************************************************************/
+static inline bool bit_toggle(uint64_t *word, uint8_t bit) {
+  *word ^= (1UL << bit);
+
+  return (*word >> bit) & 1;
+}
+
+#endif
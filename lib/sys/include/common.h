@@ -26,6 +26,8 @@
 #define uint32_t unsigned int
 #define uint16_t unsigned short int
 #define uint8_t  unsigned char
+#define int64_t  long int
+#define int32_t  int
 #define bool_t   bool
 
 #define DOUBLE_WORD_SIZE sizeof(uint64_t)
@@ -61,18 +63,52 @@ inline uint64_t reg_read_double_word(const uint64_t addr) {
 }
 
 /******************************************************************************
- * @brief write 8-bit data in 64-bit registers
+ * @brief write 32-bit registers
  * @param addr of the register
  * @param data to write
- * @param offset inthe 64-bit register
+ * @return None
+ ******************************************************************************/
+inline void reg_write_word(const uint64_t addr, const uint32_t data) {
+  volatile uint32_t *reg_addr = (uint32_t *)addr;
+  *reg_addr                   = data;
+}
+
+/******************************************************************************
+ * @brief read 32-bit registers
+ * @param addr of the register
+ * @return data in the register
+ ******************************************************************************/
+inline uint32_t reg_read_word(const uint64_t addr) {
+  volatile uint32_t *reg_addr = (uint32_t *)addr;
+  return (uint32_t)*reg_addr;
+}
+
+/******************************************************************************
+ * @brief write 8-bit registers
+ *
+ * The register is written with a single byte store, the registers next to it
+ * are not accessed.
+ *
+ * @param base addr of the device
+ * @param offset of the register from the base address
+ * @param data to write
  * @return None
  ******************************************************************************/
 inline void reg_write_byte(const uint64_t addr, const uint64_t offset,
-                           const uint64_t data) {
-  uint64_t val = reg_read_double_word(addr);
-  val &= 0xFFFFFFFFFFFFFF00 << (8 * offset);
-  val |= (uint64_t)data << (8 * offset);
-  reg_write_double_word(addr, val);
+                           const uint8_t data) {
+  volatile uint8_t *reg_addr = (uint8_t *)(addr + offset);
+  *reg_addr                  = data;
+}
+
+/******************************************************************************
+ * @brief read 8-bit registers
+ * @param base addr of the device
+ * @param offset of the register from the base address
+ * @return data in the register
+ ******************************************************************************/
+inline uint8_t reg_read_byte(const uint64_t addr, const uint64_t offset) {
+  volatile uint8_t *reg_addr = (uint8_t *)(addr + offset);
+  return (uint8_t)*reg_addr;
 }
 
 #endif
\ No newline at end of file
@@ -17,6 +17,8 @@
 #ifndef INTERRUPT_H
 #define INTERRUPT_H
 
+#include "common.h"
+
 /******************************************************************************
  * @brief enumerator with all interrupt IDs
  * @param None
@@ -28,4 +30,23 @@ typedef enum interrupt_id {
   EXTERNAL_INTERRUPT = 2,
 } interrupt_id_t;
 
+/******************************************************************************
+ * external sources are numbered after EXTERNAL_INTERRUPT, source 0 doesn't
+ * exist as it means no pending interrupt for the controller
+ ******************************************************************************/
+#define INTERRUPT_NB_EXTERNAL 96
+
+#define INTERRUPT_EXTERNAL_ID(_source) \
+  ((interrupt_id_t)(EXTERNAL_INTERRUPT + (_source)))
+#define INTERRUPT_EXTERNAL_SOURCE(_id) ((uint32_t)((_id)-EXTERNAL_INTERRUPT))
+
+#define NB_INTERRUPT (EXTERNAL_INTERRUPT + INTERRUPT_NB_EXTERNAL)
+
+/******************************************************************************
+ * @brief in-kernel interrupt handler run before the task notification
+ * @param interrupt identifier
+ * @return true if the attached task has to be notified
+ ******************************************************************************/
+typedef bool (*interrupt_top_half_t)(interrupt_id_t);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef LIST_H
+#define LIST_H
+
+#include "common.h"
+#include "stddef.h"
+
+/******************************************************************************
+ * @struct list_node_t
+ * @brief intrusive doubly linked list node
+ *
+ * A list head is a node which points to itself when the list is empty. A node
+ * which is not linked in any list has its pointers set to NULL.
+ ******************************************************************************/
+typedef struct list_node_t {
+  struct list_node_t *next;
+  struct list_node_t *prev;
+} list_node_t;
+
+/******************************************************************************
+ * @brief get the structure address from the address of one of its members
+ * @param pointer to the member
+ * @param type of the container structure
+ * @param name of the member in the container structure
+ * @return container structure address pointer
+ ******************************************************************************/
+#define container_of(_ptr, _type, _member) \
+  ((_type *)((uint8_t *)(_ptr) - offsetof(_type, _member)))
+
+/******************************************************************************
+ * @brief initialize an empty list head
+ * @param list head
+ * @return none
+ ******************************************************************************/
+static inline void list_init(list_node_t *head) {
+  head->next = head;
+  head->prev = head;
+}
+
+/******************************************************************************
+ * @brief initialize a node which is not linked in any list
+ * @param node to initialize
+ * @return none
+ ******************************************************************************/
+static inline void list_node_init(list_node_t *node) {
+  node->next = NULL;
+  node->prev = NULL;
+}
+
+/******************************************************************************
+ * @brief check if a list is empty
+ * @param list head
+ * @return true if the list is empty
+ ******************************************************************************/
+static inline bool list_is_empty(const list_node_t *head) {
+  return head->next == head;
+}
+
+/******************************************************************************
+ * @brief check if a node is linked in a list
+ * @param node to check
+ * @return true if the node belongs to a list
+ ******************************************************************************/
+static inline bool list_is_linked(const list_node_t *node) {
+  return node->next != NULL;
+}
+
+/******************************************************************************
+ * @brief insert a node after an another one
+ * @param node to insert
+ * @param node after which the new node is inserted
+ * @return none
+ ******************************************************************************/
+static inline void list_insert_after(list_node_t *node, list_node_t *prev) {
+  node->next       = prev->next;
+  node->prev       = prev;
+  prev->next->prev = node;
+  prev->next       = node;
+}
+
+/******************************************************************************
+ * @brief add a node at the end of a list
+ * @param node to add
+ * @param list head
+ * @return none
+ ******************************************************************************/
+static inline void list_add_tail(list_node_t *node, list_node_t *head) {
+  list_insert_after(node, head->prev);
+}
+
+/******************************************************************************
+ * @brief add a node at the beginning of a list
+ * @param node to add
+ * @param list head
+ * @return none
+ ******************************************************************************/
+static inline void list_add_head(list_node_t *node, list_node_t *head) {
+  list_insert_after(node, head);
+}
+
+/******************************************************************************
+ * @brief remove a node from the list it's linked in
+ * @param node to remove
+ * @return none
+ ******************************************************************************/
+static inline void list_remove(list_node_t *node) {
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  list_node_init(node);
+}
+
+/******************************************************************************
+ * @brief get the first node of a list
+ * @param list head
+ * @return first node or NULL if the list is empty
+ ******************************************************************************/
+static inline list_node_t *list_first(const list_node_t *head) {
+  return list_is_empty(head) ? NULL : head->next;
+}
+
+/******************************************************************************
+ * @brief iterate over all nodes of a list
+ * @param node iterator
+ * @param list head
+ ******************************************************************************/
+#define list_for_each(_node, _head) \
+  for (_node = (_head)->next; _node != (_head); _node = _node->next)
+
+#endif
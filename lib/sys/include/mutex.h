@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#include "ax_syscall.h"
+#include "common.h"
+#include "list.h"
+#include "processor.h"
+
+/******************************************************************************
+ * owner flag set when at least one task waits for the mutex
+ ******************************************************************************/
+#define MUTEX_CONTENDED 1UL
+
+/******************************************************************************
+ * @struct mutex_t
+ * @brief priority inheritance mutex shared by tasks
+ *
+ * The owner word holds the owner task, or 0 when the mutex is free. An
+ * uncontended mutex is taken and released with a single compare and swap on
+ * the owner word, the kernel is only entered when the owner word has to change
+ * while another task is involved. A waiting task sets MUTEX_CONTENDED so the
+ * owner releases the mutex through the kernel, which hands it over to the
+ * highest priority waiter. Meanwhile the owner inherits the priority of its
+ * highest priority waiter.
+ ******************************************************************************/
+typedef struct mutex_t {
+  uint64_t    owner;
+  list_node_t waiters;
+  list_node_t node;
+} mutex_t;
+
+/******************************************************************************
+ * @brief initialize a free mutex
+ * @param mutex to initialize
+ * @return none
+ ******************************************************************************/
+static inline void mutex_init(mutex_t *mutex) {
+  mutex->owner = 0;
+  list_init(&mutex->waiters);
+  list_node_init(&mutex->node);
+}
+
+/******************************************************************************
+ * @brief take a mutex if it's free, never blocks
+ * @param mutex to take
+ * @return true if the calling task owns the mutex
+ ******************************************************************************/
+static inline bool mutex_try_lock(mutex_t *mutex) {
+  uint64_t free = 0;
+
+  return __atomic_compare_exchange_n(&mutex->owner, &free, thread_pointer_get(),
+                                     false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/******************************************************************************
+ * @brief take a mutex, block until it's released if it's owned
+ * @param mutex to take
+ * @return K_OK or K_ERROR if the calling task already owns the mutex
+ ******************************************************************************/
+static inline k_return_t mutex_lock(mutex_t *mutex) {
+  if (mutex_try_lock(mutex)) {
+    return K_OK;
+  }
+
+  return ax_mutex_lock(mutex);
+}
+
+/******************************************************************************
+ * @brief release a mutex owned by the calling task
+ * @param mutex to release
+ * @return K_OK or K_ERROR if the calling task doesn't own the mutex
+ ******************************************************************************/
+static inline k_return_t mutex_unlock(mutex_t *mutex) {
+  uint64_t self = thread_pointer_get();
+
+  // the owner word is contended or owned by another task
+  if (!__atomic_compare_exchange_n(&mutex->owner, &self, 0, false,
+                                   __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    return ax_mutex_unlock(mutex);
+  }
+
+  return K_OK;
+}
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef RING_H
+#define RING_H
+
+#include "ax_syscall.h"
+#include "common.h"
+#include "stddef.h"
+
+/******************************************************************************
+ * @struct ring_t
+ * @brief single producer / single consumer ring buffer shared by two tasks
+ *
+ * Elements have a fixed size and are copied in a buffer shared by both tasks.
+ * The producer only writes head and the consumer only writes tail, so neither
+ * of them enters the kernel to transfer an element. A syscall is only raised
+ * to block on a full or empty ring: the blocked task waits for the ring
+ * notification bit, which the other task sets when it sees the waiting flag.
+ *
+ * The number of elements must be a power of two.
+ ******************************************************************************/
+typedef struct ring_t {
+  uint64_t head;
+  uint64_t tail;
+  uint64_t mask;
+  uint64_t elem_size;
+  uint8_t *data;
+  task_t  *producer;
+  task_t  *consumer;
+  uint64_t producer_waiting;
+  uint64_t consumer_waiting;
+  uint64_t notify_bit;
+} ring_t;
+
+#define ring_load(_var)        __atomic_load_n(&(_var), __ATOMIC_ACQUIRE)
+#define ring_store(_var, _val) __atomic_store_n(&(_var), _val, __ATOMIC_RELEASE)
+#define ring_flag(_var, _val)  __atomic_store_n(&(_var), _val, __ATOMIC_SEQ_CST)
+
+/******************************************************************************
+ * @brief initialize a ring buffer
+ * @param ring to initialize
+ * @param buffer of nb_elems * elem_size bytes
+ * @param size of an element in bytes
+ * @param number of elements, a power of two
+ * @param notification bit used to block on the ring
+ * @return none
+ ******************************************************************************/
+static inline void ring_init(ring_t *ring, void *data, uint64_t elem_size,
+                             uint64_t nb_elems, uint64_t notify_bit) {
+  ring->head             = 0;
+  ring->tail             = 0;
+  ring->mask             = nb_elems - 1;
+  ring->elem_size        = elem_size;
+  ring->data             = data;
+  ring->producer         = NULL;
+  ring->consumer         = NULL;
+  ring->producer_waiting = 0;
+  ring->consumer_waiting = 0;
+  ring->notify_bit       = notify_bit;
+}
+
+/******************************************************************************
+ * @brief register the calling task as the ring producer
+ * @param ring
+ * @return none
+ ******************************************************************************/
+static inline void ring_attach_producer(ring_t *ring) {
+  ring->producer = ax_task_self();
+}
+
+/******************************************************************************
+ * @brief register the calling task as the ring consumer
+ * @param ring
+ * @return none
+ ******************************************************************************/
+static inline void ring_attach_consumer(ring_t *ring) {
+  ring->consumer = ax_task_self();
+}
+
+/******************************************************************************
+ * @brief copy an element, word by word when it's possible
+ * @param destination
+ * @param source
+ * @param size of the element in bytes
+ * @return none
+ ******************************************************************************/
+static inline void ring_copy(void *dest, const void *src, uint64_t size) {
+  if ((size | (uint64_t)dest | (uint64_t)src) % DOUBLE_WORD_SIZE == 0) {
+    for (uint64_t i = 0; i < size / DOUBLE_WORD_SIZE; i++) {
+      ((uint64_t *)dest)[i] = ((const uint64_t *)src)[i];
+    }
+  } else {
+    for (uint64_t i = 0; i < size; i++) {
+      ((uint8_t *)dest)[i] = ((const uint8_t *)src)[i];
+    }
+  }
+}
+
+/******************************************************************************
+ * @brief try to add an element in the ring, from the producer
+ * @param ring
+ * @param element to copy in the ring
+ * @return false if the ring is full
+ ******************************************************************************/
+static inline bool ring_try_put(ring_t *ring, const void *elem) {
+  uint64_t head = ring->head;
+
+  if (head - ring_load(ring->tail) > ring->mask) {
+    return false;
+  }
+
+  ring_copy(&ring->data[(head & ring->mask) * ring->elem_size], elem,
+            ring->elem_size);
+
+  // the element is visible before the new head
+  ring_store(ring->head, head + 1);
+
+  if (ring_load(ring->consumer_waiting)) {
+    ax_notify(ring->consumer, ring->notify_bit);
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief try to remove an element from the ring, from the consumer
+ * @param ring
+ * @param buffer the element is copied into
+ * @return false if the ring is empty
+ ******************************************************************************/
+static inline bool ring_try_get(ring_t *ring, void *elem) {
+  uint64_t tail = ring->tail;
+
+  if (tail == ring_load(ring->head)) {
+    return false;
+  }
+
+  ring_copy(elem, &ring->data[(tail & ring->mask) * ring->elem_size],
+            ring->elem_size);
+
+  // the element is read before the producer can overwrite it
+  ring_store(ring->tail, tail + 1);
+
+  if (ring_load(ring->producer_waiting)) {
+    ax_notify(ring->producer, ring->notify_bit);
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief add an element in the ring, block while the ring is full
+ * @param ring
+ * @param element to copy in the ring
+ * @return none
+ ******************************************************************************/
+static inline void ring_put(ring_t *ring, const void *elem) {
+  while (!ring_try_put(ring, elem)) {
+    // the ring is checked again once the flag is visible, so the consumer
+    // can't miss it: a notification sent meanwhile stays pending
+    ring_flag(ring->producer_waiting, 1);
+
+    if (ring->head - ring_load(ring->tail) > ring->mask) {
+      ax_wait(ring->notify_bit);
+    }
+
+    ring_flag(ring->producer_waiting, 0);
+  }
+}
+
+/******************************************************************************
+ * @brief remove an element from the ring, block while the ring is empty
+ * @param ring
+ * @param buffer the element is copied into
+ * @return none
+ ******************************************************************************/
+static inline void ring_get(ring_t *ring, void *elem) {
+  while (!ring_try_get(ring, elem)) {
+    // the ring is checked again once the flag is visible, so the producer
+    // can't miss it: a notification sent meanwhile stays pending
+    ring_flag(ring->consumer_waiting, 1);
+
+    if (ring->tail == ring_load(ring->head)) {
+      ax_wait(ring->notify_bit);
+    }
+
+    ring_flag(ring->consumer_waiting, 0);
+  }
+}
+
+#endif
@@ -29,4 +29,14 @@ inline void _putchar(char character) {
   uart_send((const uint8_t *)&character, 1);
 }
 
+/******************************************************************************
+ * @brief send a buffer of characters for printf routine
+ * @param characters to send
+ * @param number of characters
+ * @return None
+ ******************************************************************************/
+inline void _putbuffer(const char *buffer, size_t size) {
+  uart_send((const uint8_t *)buffer, size);
+}
+
 #endif
\ No newline at end of file
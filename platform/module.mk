@@ -15,6 +15,7 @@
 
 MODULE_ID := $(GET_MODULE_ID)
 MODULE_DEPS := lib/sys \
-			drv/uart
+			drv/uart \
+			drv/plic
 
 include tools/make/compile.mk
\ No newline at end of file
@@ -15,6 +15,7 @@
  * not, see https://www.gnu.org/licenses/
  */
 
+#include "plic.h"
 #include "uart.h"
 
 /******************************************************************************
@@ -23,5 +24,8 @@
  * @return None
  ******************************************************************************/
 void platform_init() {
+  // the uart attaches its interrupt to the controller
+  plic_init();
+
   uart_init();
 }
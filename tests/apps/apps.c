@@ -26,16 +26,27 @@ stack_t apps_test_stack;
 
 static uint8_t test_step = 0;
 
+// created at boot with the test channel, before any task runs
+REGISTER_CHANNEL(apps_channel, "apps_channel")
+
 /******************************************************************************
- * @brief just create a thread and return from it
+ * @brief just create a thread, check the static channels and return from it
  * @param None
  * @return None
  ******************************************************************************/
 void apps_test_thread(void) {
+  uint64_t handler = 0;
+
   test_step += 1;
   TEST_ASSERT(test_step >= 1)
 
+  // the static channels are found by name as the created ones
+  TEST_ASSERT(ax_channel_get(&handler, "apps_channel") == K_OK);
+  TEST_ASSERT(handler == apps_channel.handler);
+  TEST_ASSERT(ax_channel_get(&handler, "test_channel") == K_OK);
+  TEST_ASSERT(handler == test_channel.handler);
+
   TEST_END()
 }
 
-REGISTER_TEST("apps_test", apps_test_thread, apps_test_stack, 3)
\ No newline at end of file
+REGISTER_TEST_PARALLEL("apps_test", apps_test_thread, apps_test_stack, 3)
\ No newline at end of file
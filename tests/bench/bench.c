@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "bench.h"
+
+#include "ax_syscall.h"
+#include "printf.h"
+#include "test.h"
+
+// the peer shares the priority of the benchmark task to yield to it
+#define BENCH_PRIO 3
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t bench_switch_stack;
+stack_t bench_peer_stack;
+
+uint64_t bench_samples[BENCH_SAMPLES];
+uint64_t bench_nb_samples = 0;
+
+// date of the last yield to the peer
+static uint64_t bench_stamp;
+
+/******************************************************************************
+ * @brief sort the samples of the running benchmark
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void bench_sort() {
+  for (uint64_t i = 1; i < bench_nb_samples; i++) {
+    uint64_t sample = bench_samples[i];
+    uint64_t j      = i;
+
+    for (; j > 0 && bench_samples[j - 1] > sample; j--) {
+      bench_samples[j] = bench_samples[j - 1];
+    }
+
+    bench_samples[j] = sample;
+  }
+}
+
+/******************************************************************************
+ * @brief print the statistics of the running benchmark
+ * @param benchmark name
+ * @param unit of the samples
+ * @return None
+ ******************************************************************************/
+void bench_report(const char *name, const char *unit) {
+  uint64_t sum = 0;
+
+  if (!bench_nb_samples) {
+    test_set_error(true);
+    return;
+  }
+
+  bench_sort();
+
+  for (uint64_t i = 0; i < bench_nb_samples; i++) {
+    sum += bench_samples[i];
+  }
+
+  printf("BENCH name=%s unit=%s n=%lu min=%lu avg=%lu max=%lu p99=%lu\r\n",
+         name, unit, bench_nb_samples, bench_samples[0],
+         sum / bench_nb_samples, bench_samples[bench_nb_samples - 1],
+         bench_samples[bench_nb_samples * 99 / 100]);
+}
+
+/******************************************************************************
+ * @brief yield to the other task of the ping-pong until all samples are saved
+ *
+ * Each sample is the time from a yield in one task to the return of the yield
+ * in the other one.
+ *
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void bench_ping_pong() {
+  while (bench_nb_samples < BENCH_SAMPLES) {
+    bench_stamp = bench_cycles();
+    ax_task_yield();
+    bench_record(bench_cycles() - bench_stamp);
+  }
+}
+
+/******************************************************************************
+ * @brief peer of the ping-pong
+ * @param None
+ * @return None
+ ******************************************************************************/
+void bench_peer_thread(void) {
+  bench_ping_pong();
+}
+
+/******************************************************************************
+ * @brief measure the cost of a yield with and without a task switch
+ * @param None
+ * @return None
+ ******************************************************************************/
+void bench_switch(void) {
+  uint64_t start;
+
+  // nothing else is ready at this priority, the yield returns right away
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    start = bench_cycles();
+    ax_task_yield();
+    bench_record(bench_cycles() - start);
+  }
+  bench_report("task_yield", "cycles");
+
+  // a yield to a peer goes through the election and _switch_to
+  bench_start();
+  ax_task_create("bench_peer", bench_peer_thread, &bench_peer_stack,
+                 sizeof(bench_peer_stack), BENCH_PRIO);
+  bench_ping_pong();
+  bench_report("task_switch", "cycles");
+
+  // let the peer leave its loop and exit
+  ax_task_yield();
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("bench_switch", bench_switch, bench_switch_stack, BENCH_PRIO)
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "bench.h"
+
+#include "ax_syscall.h"
+#include "test.h"
+
+// the server runs as soon as a message is sent to it
+#define BENCH_SERVER_PRIO 4
+
+// a long message is copied, it doesn't fit in registers
+#define BENCH_LONG_NB_WORDS 64
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t bench_channel_stack;
+stack_t bench_server_stack;
+
+static uint64_t bench_request;
+static uint64_t bench_long[BENCH_LONG_NB_WORDS];
+static uint64_t bench_received[BENCH_LONG_NB_WORDS];
+
+/******************************************************************************
+ * @brief answer the calls, then receive the long messages
+ * @param None
+ * @return None
+ ******************************************************************************/
+void bench_server_thread(void) {
+  uint64_t handler;
+  uint64_t len = sizeof(bench_request);
+
+  ax_channel_create(&handler, "bench_channel");
+
+  ax_channel_rcv(handler, &bench_request, &len);
+
+  for (uint64_t i = 1; i < BENCH_SAMPLES; i++) {
+    len = sizeof(bench_request);
+    ax_channel_reply_wait(handler, &bench_request, sizeof(bench_request),
+                          &bench_request, &len);
+  }
+
+  // the last reply is followed by the first long message
+  len = sizeof(bench_received);
+  ax_channel_reply_wait(handler, &bench_request, sizeof(bench_request),
+                        bench_received, &len);
+
+  for (uint64_t i = 1; i < BENCH_SAMPLES; i++) {
+    len = sizeof(bench_received);
+    ax_channel_rcv(handler, bench_received, &len);
+  }
+}
+
+/******************************************************************************
+ * @brief measure a channel round trip and a long message send
+ * @param None
+ * @return None
+ ******************************************************************************/
+void bench_channel(void) {
+  uint64_t handler;
+  uint64_t request = 0;
+  uint64_t reply;
+  uint64_t reply_len;
+  uint64_t start;
+
+  // the server creates the channel and waits for the first request
+  ax_task_create("bench_server", bench_server_thread, &bench_server_stack,
+                 sizeof(bench_server_stack), BENCH_SERVER_PRIO);
+  ax_task_yield();
+  TEST_ASSERT(ax_channel_get(&handler, "bench_channel") == K_OK);
+
+  // 8 bytes each way, the server replies and waits for the next call
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    reply_len = sizeof(reply);
+    start     = bench_cycles();
+    ax_channel_call(handler, &request, sizeof(request), &reply, &reply_len);
+    bench_record(bench_cycles() - start);
+  }
+  bench_report("channel_call_8", "cycles");
+
+  // the send returns once the server waits again
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    start = bench_cycles();
+    ax_channel_snd(handler, bench_long, sizeof(bench_long));
+    bench_record(bench_cycles() - start);
+  }
+  bench_report("channel_snd_512", "cycles");
+
+  ax_channel_destroy(handler);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("bench_channel", bench_channel, bench_channel_stack, 3)
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "common.h"
+#include "processor.h"
+
+// number of samples of each benchmark
+#define BENCH_SAMPLES 256
+
+/*******************************************************************************
+ * samples of the running benchmark, a single benchmark runs at a time
+ ******************************************************************************/
+extern uint64_t bench_samples[BENCH_SAMPLES];
+extern uint64_t bench_nb_samples;
+
+/******************************************************************************
+ * @brief read the cycle counter of the hart
+ * @param None
+ * @return number of cycles
+ ******************************************************************************/
+static inline uint64_t bench_cycles() {
+  return cycle_counter_get();
+}
+
+/******************************************************************************
+ * @brief start a new benchmark
+ * @param None
+ * @return None
+ ******************************************************************************/
+static inline void bench_start() {
+  bench_nb_samples = 0;
+}
+
+/******************************************************************************
+ * @brief save a sample of the running benchmark, extra samples are dropped
+ * @param sample value
+ * @return None
+ ******************************************************************************/
+static inline void bench_record(uint64_t sample) {
+  if (bench_nb_samples < BENCH_SAMPLES) {
+    bench_samples[bench_nb_samples++] = sample;
+  }
+}
+
+/******************************************************************************
+ * @brief print the statistics of the running benchmark
+ *
+ * One line is printed per benchmark, with space separated key=value fields:
+ * BENCH name=<name> unit=<unit> n=<samples> min=<> avg=<> max=<> p99=<>
+ *
+ * @param benchmark name
+ * @param unit of the samples
+ * @return None
+ ******************************************************************************/
+void bench_report(const char *, const char *);
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "bench.h"
+
+#include "ktimer.h"
+#include "test.h"
+#include "timer_arch.h"
+
+// the timer is armed far enough for the comparator to be programmed first
+#define BENCH_TIMER_DELAY (100 * TIMER_ARCH_TICKS_PER_US)
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t bench_irq_stack;
+
+static bool bench_timer_expire(ktimer_t *);
+
+static ktimer_t bench_timer = KTIMER_INIT(bench_timer_expire);
+
+/******************************************************************************
+ * @brief save the delay from the comparator match to the timer callback
+ * @param timer which has expired
+ * @return false, no task is woken up
+ ******************************************************************************/
+static bool bench_timer_expire(ktimer_t *timer) {
+  bench_record(timer_arch_get_time() - timer->deadline);
+
+  return false;
+}
+
+/******************************************************************************
+ * @brief measure the latency of the machine timer interrupt
+ *
+ * The latency is measured with mtime, the cycle counter of the hart can't be
+ * compared to the comparator match.
+ *
+ * @param None
+ * @return None
+ ******************************************************************************/
+void bench_irq(void) {
+  uint64_t nb_samples;
+
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    nb_samples = bench_nb_samples;
+    ktimer_start(&bench_timer, timer_arch_get_time() + BENCH_TIMER_DELAY);
+
+    // kernel timers are served by hart 0, which runs this task
+    while (__atomic_load_n(&bench_nb_samples, __ATOMIC_ACQUIRE) == nb_samples) {
+    }
+  }
+
+  for (uint64_t i = 0; i < bench_nb_samples; i++) {
+    bench_samples[i] *= TIMER_ARCH_NS_PER_TICK;
+  }
+  bench_report("timer_irq_latency", "ns");
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("bench_irq", bench_irq, bench_irq_stack, 3)
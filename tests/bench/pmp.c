@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "bench.h"
+
+#include "ax_syscall.h"
+#include "pmp.h"
+#include "task.h"
+#include "test.h"
+
+#ifdef CONFIG_PMP
+
+// the user tasks ping-pong above the benchmark task until they exit
+#define BENCH_PMP_PRIO 4
+
+/*******************************************************************************
+ * the user tasks can't call the kernel code, the cycle counter is read inline
+ ******************************************************************************/
+#define BENCH_PMP_CYCLES(_cycles) __asm__ volatile("rdcycle %0" : "=r"(_cycles))
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t bench_pmp_stack;
+DECLARE_USER_STACK(bench_pmp_ping_stack, USER_STACK_SIZE);
+DECLARE_USER_STACK(bench_pmp_pong_stack, USER_STACK_SIZE);
+
+// same entries as the default region set, in another set
+static task_region_t bench_pmp_region;
+
+// samples of the user tasks, in the user data
+__user_data uint64_t bench_pmp_samples[BENCH_SAMPLES];
+__user_data uint64_t bench_pmp_nb_samples = 0;
+__user_data uint64_t bench_pmp_stamp      = 0;
+
+/******************************************************************************
+ * @brief yield to the other user task until all samples are saved
+ * @param None
+ * @return None
+ ******************************************************************************/
+__user_text void bench_pmp_ping_pong(void) {
+  uint64_t cycles;
+
+  while (bench_pmp_nb_samples < BENCH_SAMPLES) {
+    BENCH_PMP_CYCLES(bench_pmp_stamp);
+    ax_task_yield();
+    BENCH_PMP_CYCLES(cycles);
+
+    // the peer may have saved the last sample
+    if (bench_pmp_nb_samples < BENCH_SAMPLES) {
+      bench_pmp_samples[bench_pmp_nb_samples++] = cycles - bench_pmp_stamp;
+    }
+  }
+}
+
+/******************************************************************************
+ * @brief run a ping-pong between two user tasks and report it
+ * @param benchmark name
+ * @param region set of the second task
+ * @return None
+ ******************************************************************************/
+static void bench_pmp_run(const char *name, task_region_t *region) {
+  bench_pmp_nb_samples = 0;
+
+  task_create_user("bench_ping", bench_pmp_ping_pong, &bench_pmp_ping_stack,
+                   sizeof(bench_pmp_ping_stack), BENCH_PMP_PRIO,
+                   &pmp_user_region);
+  task_create_user("bench_pong", bench_pmp_ping_pong, &bench_pmp_pong_stack,
+                   sizeof(bench_pmp_pong_stack), BENCH_PMP_PRIO, region);
+
+  // the user tasks run until they exit
+  ax_task_yield();
+
+  bench_start();
+  for (uint64_t i = 0; i < bench_pmp_nb_samples; i++) {
+    bench_record(bench_pmp_samples[i]);
+  }
+  bench_report(name, "cycles");
+}
+
+/******************************************************************************
+ * @brief measure the cost of a switch between user tasks
+ *
+ * The cost of the pmp is the difference with the task_switch benchmark: the
+ * user entry and return, the stack entries written on every switch and the
+ * region set entries when the tasks don't share their region set.
+ *
+ * @param None
+ * @return None
+ ******************************************************************************/
+void bench_pmp(void) {
+  bench_pmp_run("task_switch_user", &pmp_user_region);
+
+  bench_pmp_region = pmp_user_region;
+  bench_pmp_run("task_switch_user_region", &bench_pmp_region);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("bench_pmp", bench_pmp, bench_pmp_stack, 3)
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "bench.h"
+
+#include "string.h"
+#include "test.h"
+
+// a page, the size of the long messages and of the stack cache blocks
+#define BENCH_STRING_SIZE 4096
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t bench_string_stack;
+
+static uint8_t bench_src[BENCH_STRING_SIZE + 8] __attribute__((aligned(8)));
+static uint8_t bench_dst[BENCH_STRING_SIZE] __attribute__((aligned(8)));
+
+/******************************************************************************
+ * @brief measure the copy and the fill of a page
+ * @param None
+ * @return None
+ ******************************************************************************/
+void bench_string(void) {
+  uint64_t start;
+
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    start = bench_cycles();
+    memcpy(bench_dst, bench_src, BENCH_STRING_SIZE);
+    bench_record(bench_cycles() - start);
+  }
+  bench_report("memcpy_4096", "cycles");
+
+  // the source words are merged from two aligned loads
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    start = bench_cycles();
+    memcpy(bench_dst, bench_src + 3, BENCH_STRING_SIZE);
+    bench_record(bench_cycles() - start);
+  }
+  bench_report("memcpy_4096_unaligned", "cycles");
+
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    start = bench_cycles();
+    memset(bench_dst, 0, BENCH_STRING_SIZE);
+    bench_record(bench_cycles() - start);
+  }
+  bench_report("memset_4096", "cycles");
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("bench_string", bench_string, bench_string_stack, 3)
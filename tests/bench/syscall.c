@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "bench.h"
+
+#include "ax_syscall.h"
+#include "mutex.h"
+#include "test.h"
+
+#define BENCH_NOTIFY_BIT (1UL << 0)
+
+/*******************************************************************************
+ * measure a call BENCH_SAMPLES times and print its statistics
+ ******************************************************************************/
+#define BENCH_CALL(_name, _call)                   \
+  bench_start();                                   \
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {   \
+    uint64_t start = bench_cycles();               \
+    _call;                                         \
+    bench_record(bench_cycles() - start);          \
+  }                                                \
+  bench_report(_name, "cycles");
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t bench_syscall_stack;
+
+static mutex_t bench_mutex;
+
+/******************************************************************************
+ * @brief measure the syscalls which return without blocking
+ *
+ * The blocking syscalls are measured along with the switch they lead to by the
+ * other benchmarks.
+ *
+ * @param None
+ * @return None
+ ******************************************************************************/
+void bench_syscall(void) {
+  task_t  *self = ax_task_self();
+  uint64_t handler;
+
+  BENCH_CALL("task_self", ax_task_self());
+  BENCH_CALL("task_set_quantum", ax_task_set_quantum(self, self->quantum));
+  BENCH_CALL("task_set_affinity", ax_task_set_affinity(self, self->affinity));
+  BENCH_CALL("task_stack_usage", ax_task_stack_usage(self));
+  BENCH_CALL("channel_get", ax_channel_get(&handler, "test_channel"));
+
+  // the notification is pending, the wait returns right away
+  BENCH_CALL("notify", ax_notify(self, BENCH_NOTIFY_BIT));
+  BENCH_CALL("notify_wait", (ax_notify(self, BENCH_NOTIFY_BIT),
+                             ax_wait(BENCH_NOTIFY_BIT)));
+
+  // an uncontended mutex is taken and released without any syscall
+  mutex_init(&bench_mutex);
+  BENCH_CALL("mutex_lock_unlock",
+             (mutex_lock(&bench_mutex), mutex_unlock(&bench_mutex)));
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("bench_syscall", bench_syscall, bench_syscall_stack, 3)
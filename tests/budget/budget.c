@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "ax_syscall.h"
+#include "test.h"
+#include "timer_arch.h"
+
+// the runaway task would starve every task of the hart without a budget
+#define BUDGET_RUNAWAY_PRIO 250
+
+#define BUDGET_US 1000
+#define PERIOD_US 10000
+#define PERIODS   3
+
+#define BUDGET_NOTIFY_BIT (1UL << 0)
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t budget_thread_stack;
+stack_t budget_runaway_stack;
+
+static bool budget_spin = true;
+
+/******************************************************************************
+ * @brief task which never leaves the cpu
+ * @param None
+ * @return None
+ ******************************************************************************/
+void budget_runaway_thread(void) {
+  while (__atomic_load_n(&budget_spin, __ATOMIC_ACQUIRE)) {
+  }
+}
+
+/******************************************************************************
+ * @brief check a runaway task is throttled and its overruns accounted
+ * @param None
+ * @return None
+ ******************************************************************************/
+void budget_thread(void) {
+  task_budget_t budget = {.budget_us = BUDGET_US,
+                          .period_us = PERIOD_US,
+                          .handler   = ax_task_self(),
+                          .notify    = BUDGET_NOTIFY_BIT};
+  task_budget_t wrong  = {.budget_us = PERIOD_US + 1, .period_us = PERIOD_US};
+  task_t       *runaway;
+  uint64_t      overruns;
+
+  // the runaway task loops as soon as it's created
+  runaway = ax_task_create("budget_runaway", budget_runaway_thread,
+                           &budget_runaway_stack, sizeof(budget_runaway_stack),
+                           BUDGET_RUNAWAY_PRIO);
+  TEST_ASSERT(runaway != NULL);
+
+  // a budget can't exceed its period
+  TEST_ASSERT(ax_task_set_budget(runaway, &wrong) == K_ERROR);
+  TEST_ASSERT(ax_task_set_budget(runaway, &budget) == K_OK);
+
+  // the runaway task gets the cpu until its budget is used up
+  ax_wait(BUDGET_NOTIFY_BIT);
+  TEST_ASSERT(runaway->overruns == 1);
+  TEST_ASSERT(runaway->throttled);
+  TEST_ASSERT(runaway->runtime >= BUDGET_US * TIMER_ARCH_TICKS_PER_US);
+
+  // it's given a new budget every period, this task runs in between
+  ax_task_sleep_for(PERIODS * PERIOD_US);
+  overruns = runaway->overruns;
+  TEST_ASSERT(runaway->throttled);
+  TEST_ASSERT(overruns >= PERIODS);
+  TEST_ASSERT(runaway->runtime <
+              (overruns + 1) * BUDGET_US * TIMER_ARCH_TICKS_PER_US);
+  TEST_ASSERT(runaway->wcet >= BUDGET_US * TIMER_ARCH_TICKS_PER_US);
+
+  __atomic_store_n(&budget_spin, false, __ATOMIC_RELEASE);
+  ax_task_destroy(runaway);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("budget_thread", budget_thread, budget_thread_stack, 3)
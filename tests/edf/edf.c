@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "ax_syscall.h"
+#include "test.h"
+
+#define EDF_HART 0
+
+// the launcher creates the EDF tasks before any of them runs
+#define EDF_LAUNCHER_PRIO 200
+
+#define EDF_JOBS 3
+
+#define EDF_SLOW_ID 1
+#define EDF_FAST_ID 2
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t edf_thread_stack;
+stack_t edf_launcher_stack;
+stack_t edf_slow_stack;
+stack_t edf_fast_stack;
+stack_t edf_heavy_stack;
+
+// density 2 / 10
+static const task_edf_t edf_slow = {
+    .period_us = 10000, .budget_us = 2000, .deadline_us = 0};
+// density 1 / 2, the earliest first deadline
+static const task_edf_t edf_fast = {
+    .period_us = 5000, .budget_us = 1000, .deadline_us = 2000};
+// density 4 / 10, it doesn't fit with both tasks above
+static const task_edf_t edf_heavy = {
+    .period_us = 10000, .budget_us = 4000, .deadline_us = 0};
+
+static uint64_t edf_log[2 * EDF_JOBS];
+static uint64_t edf_log_nb        = 0;
+static bool     edf_heavy_refused = false;
+
+/******************************************************************************
+ * @brief log the jobs of an EDF task
+ * @param id saved in the log
+ * @return None
+ ******************************************************************************/
+static void edf_run_jobs(uint64_t id) {
+  for (uint64_t job = 0; job < EDF_JOBS; job++) {
+    edf_log[edf_log_nb++] = id;
+    ax_task_wait_period();
+  }
+}
+
+/******************************************************************************
+ * @brief EDF task with the latest deadline
+ * @param None
+ * @return None
+ ******************************************************************************/
+void edf_slow_thread(void) {
+  edf_run_jobs(EDF_SLOW_ID);
+}
+
+/******************************************************************************
+ * @brief EDF task with the earliest deadline
+ * @param None
+ * @return None
+ ******************************************************************************/
+void edf_fast_thread(void) {
+  edf_run_jobs(EDF_FAST_ID);
+}
+
+/******************************************************************************
+ * @brief EDF task admitted once the others have exited
+ * @param None
+ * @return None
+ ******************************************************************************/
+void edf_heavy_thread(void) {
+}
+
+/******************************************************************************
+ * @brief release both EDF tasks at the same time
+ * @param None
+ * @return None
+ ******************************************************************************/
+void edf_launcher_thread(void) {
+  ax_task_create_edf("edf_slow", edf_slow_thread, &edf_slow_stack,
+                     sizeof(edf_slow_stack), &edf_slow, EDF_HART);
+  ax_task_create_edf("edf_fast", edf_fast_thread, &edf_fast_stack,
+                     sizeof(edf_fast_stack), &edf_fast, EDF_HART);
+
+  // the hart has no bandwidth left for this one
+  edf_heavy_refused =
+      ax_task_create_edf("edf_heavy", edf_heavy_thread, &edf_heavy_stack,
+                         sizeof(edf_heavy_stack), &edf_heavy,
+                         EDF_HART) == NULL;
+}
+
+/******************************************************************************
+ * @brief check the admission and the order of EDF tasks
+ * @param None
+ * @return None
+ ******************************************************************************/
+void edf_thread(void) {
+  const task_edf_t late  = {.period_us = 1000, .budget_us = 2000};
+  const task_edf_t loose = {
+      .period_us = 1000, .budget_us = 500, .deadline_us = 2000};
+  uint64_t slow_jobs = 0;
+  uint64_t fast_jobs = 0;
+
+  // a job can't exceed its deadline, nor the deadline the period
+  TEST_ASSERT(ax_task_create_edf("edf_late", edf_heavy_thread,
+                                 &edf_heavy_stack, sizeof(edf_heavy_stack),
+                                 &late, EDF_HART) == NULL);
+  TEST_ASSERT(ax_task_create_edf("edf_loose", edf_heavy_thread,
+                                 &edf_heavy_stack, sizeof(edf_heavy_stack),
+                                 &loose, EDF_HART) == NULL);
+  TEST_ASSERT(ax_task_create_edf("edf_none", edf_heavy_thread,
+                                 &edf_heavy_stack, sizeof(edf_heavy_stack),
+                                 &edf_slow, CONFIG_HART_MAX_NB) == NULL);
+
+  // a fixed priority task has no period
+  TEST_ASSERT(ax_task_wait_period() == K_ERROR);
+
+  // the launcher runs first, then the EDF tasks until their first jobs are
+  // complete
+  ax_task_create("edf_launcher", edf_launcher_thread, &edf_launcher_stack,
+                 sizeof(edf_launcher_stack), EDF_LAUNCHER_PRIO);
+  ax_task_yield();
+  TEST_ASSERT(edf_heavy_refused);
+
+  // let all the jobs complete, the tasks exit once their last period ends
+  ax_task_sleep_for((EDF_JOBS + 1) * edf_slow.period_us);
+
+  // the earliest deadline runs first, the releases follow the periods
+  TEST_ASSERT(edf_log_nb == 2 * EDF_JOBS);
+  TEST_ASSERT(edf_log[0] == EDF_FAST_ID);
+  TEST_ASSERT(edf_log[1] == EDF_SLOW_ID);
+
+  for (uint64_t index = 0; index < edf_log_nb; index++) {
+    slow_jobs += edf_log[index] == EDF_SLOW_ID;
+    fast_jobs += edf_log[index] == EDF_FAST_ID;
+  }
+
+  TEST_ASSERT(slow_jobs == EDF_JOBS);
+  TEST_ASSERT(fast_jobs == EDF_JOBS);
+
+  // the exited tasks gave their bandwidth back
+  TEST_ASSERT(ax_task_create_edf("edf_heavy", edf_heavy_thread,
+                                 &edf_heavy_stack, sizeof(edf_heavy_stack),
+                                 &edf_heavy, EDF_HART) != NULL);
+
+  TEST_END();
+}
+
+REGISTER_TEST("edf_thread", edf_thread, edf_thread_stack, 3)
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "fpu.h"
+#include "task.h"
+#include "test.h"
+
+// the floating point tasks run as soon as the test yields
+#define FPU_TASK_PRIO 4
+
+// rounding modes set in frm by each task
+#define FPU_RM_RTZ 0x1
+#define FPU_RM_RUP 0x3
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t fpu_thread_stack;
+stack_t fpu_first_stack;
+stack_t fpu_second_stack;
+
+static uint64_t fpu_first_value  = 0;
+static uint64_t fpu_second_value = 0;
+static uint64_t fpu_first_rm     = 0;
+static uint64_t fpu_second_rm    = 0;
+static bool_t   fpu_loaded       = false;
+
+/******************************************************************************
+ * @brief set ft0 and frm, give the cpu to the other task and read them back
+ * @param value written in ft0
+ * @param rounding mode
+ * @param value read back
+ * @param rounding mode read back
+ * @return None
+ ******************************************************************************/
+static void fpu_round_trip(uint64_t value, uint64_t rm, uint64_t *read_value,
+                           uint64_t *read_rm) {
+  __asm__ volatile("fmv.d.x ft0, %0" : : "r"(value) : "ft0");
+  __asm__ volatile("fsrm %0" : : "r"(rm));
+
+  // the other task overwrites both registers
+  ax_task_yield();
+
+  __asm__ volatile("fmv.x.d %0, ft0" : "=r"(*read_value));
+  __asm__ volatile("frrm %0" : "=r"(*read_rm));
+}
+
+/******************************************************************************
+ * @brief first floating point task
+ * @param None
+ * @return None
+ ******************************************************************************/
+void fpu_first_thread(void) {
+  fpu_round_trip(0x3FF0000000000000, FPU_RM_RTZ, &fpu_first_value,
+                 &fpu_first_rm);
+
+  // the context was allocated by the first floating point instruction
+  fpu_loaded = ax_task_self()->fpu != NULL;
+}
+
+/******************************************************************************
+ * @brief second floating point task
+ * @param None
+ * @return None
+ ******************************************************************************/
+void fpu_second_thread(void) {
+  fpu_round_trip(0x4000000000000000, FPU_RM_RUP, &fpu_second_value,
+                 &fpu_second_rm);
+}
+
+/******************************************************************************
+ * @brief check the floating point registers belong to each task
+ * @param None
+ * @return None
+ ******************************************************************************/
+void fpu_thread(void) {
+  ax_task_create("fpu_first", fpu_first_thread, &fpu_first_stack,
+                 sizeof(fpu_first_stack), FPU_TASK_PRIO);
+  ax_task_create("fpu_second", fpu_second_thread, &fpu_second_stack,
+                 sizeof(fpu_second_stack), FPU_TASK_PRIO);
+
+  ax_task_yield();
+
+  TEST_ASSERT(fpu_first_value == 0x3FF0000000000000);
+  TEST_ASSERT(fpu_second_value == 0x4000000000000000);
+  TEST_ASSERT(fpu_first_rm == FPU_RM_RTZ);
+  TEST_ASSERT(fpu_second_rm == FPU_RM_RUP);
+  TEST_ASSERT(fpu_loaded);
+
+  // the test never used the unit, it has no context to save
+  TEST_ASSERT(ax_task_self()->fpu == NULL);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST_PARALLEL("fpu_thread", fpu_thread, fpu_thread_stack, 3)
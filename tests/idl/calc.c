@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "calc_idl.h"
+#include "test.h"
+
+#define CALC_DATA_SIZE  96
+#define CALC_FILL_VALUE 0x5A
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t calc_server_thread_stack;
+stack_t calc_thread_stack;
+
+/******************************************************************************
+ * @brief handlers of the test server
+ ******************************************************************************/
+static k_return_t calc_do_add(uint64_t a, uint64_t b, uint64_t *sum) {
+  *sum = a + b;
+
+  return K_OK;
+}
+
+static k_return_t calc_do_checksum(const uint8_t *data, uint32_t len,
+                                   uint64_t *sum) {
+  if (len > CALC_DATA_SIZE) {
+    return K_ERROR;
+  }
+
+  *sum = 0;
+  for (uint32_t i = 0; i < len; i++) {
+    *sum += data[i];
+  }
+
+  return K_OK;
+}
+
+static k_return_t calc_do_fill(uint8_t value, uint8_t *data) {
+  for (uint32_t i = 0; i < CALC_DATA_SIZE; i++) {
+    data[i] = value + i;
+  }
+
+  return K_OK;
+}
+
+static const calc_server_t calc_server = {
+    .add      = calc_do_add,
+    .checksum = calc_do_checksum,
+    .fill     = calc_do_fill,
+    .reset    = NULL,
+};
+
+/******************************************************************************
+ * @brief server running the generated dispatch loop
+ * @param None
+ * @return None
+ ******************************************************************************/
+void calc_server_thread(void) {
+  uint64_t chan_handler;
+
+  ax_channel_create(&chan_handler, "calc_channel");
+
+  calc_serve(chan_handler, &calc_server);
+}
+
+/******************************************************************************
+ * @brief client calling the server through the generated stubs
+ * @param None
+ * @return None
+ ******************************************************************************/
+void calc_thread(void) {
+  uint8_t  data[CALC_DATA_SIZE];
+  uint64_t sum;
+  uint64_t expected;
+  uint64_t request;
+  uint64_t reply;
+  uint64_t reply_len;
+  uint64_t chan_handler;
+
+  ax_task_create("calc_server", calc_server_thread, &calc_server_thread_stack,
+                 sizeof(calc_server_thread_stack), 4);
+
+  // the server has a higher priority and waits for requests
+  ax_task_yield();
+
+  if (ax_channel_get(&chan_handler, "calc_channel") < 0) {
+    TEST_ASSERT(false);
+  } else {
+    TEST_ASSERT(calc_add(chan_handler, 40, 2, &sum) == K_OK);
+    TEST_ASSERT(sum == 42);
+
+    expected = 0;
+    for (uint32_t i = 0; i < CALC_DATA_SIZE; i++) {
+      data[i] = i;
+      expected += i;
+    }
+    TEST_ASSERT(calc_checksum(chan_handler, data, CALC_DATA_SIZE, &sum) ==
+                K_OK);
+    TEST_ASSERT(sum == expected);
+
+    // the error status of the handler is returned to the client
+    TEST_ASSERT(calc_checksum(chan_handler, data, CALC_DATA_SIZE + 1, &sum) ==
+                K_ERROR);
+
+    TEST_ASSERT(calc_fill(chan_handler, CALC_FILL_VALUE, data) == K_OK);
+    TEST_ASSERT(data[0] == CALC_FILL_VALUE);
+    TEST_ASSERT(data[CALC_DATA_SIZE - 1] ==
+                (uint8_t)(CALC_FILL_VALUE + CALC_DATA_SIZE - 1));
+
+    // no handler for this operation
+    TEST_ASSERT(calc_reset(chan_handler) == K_ERROR);
+
+    // an unknown opcode is rejected by the dispatch
+    request   = CALC_OP_NB;
+    reply_len = sizeof(reply);
+    ax_channel_call(chan_handler, &request, sizeof(request), &reply,
+                    &reply_len);
+    TEST_ASSERT(reply_len == sizeof(reply));
+    TEST_ASSERT((int64_t)reply == K_ERROR);
+  }
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("calc_thread", calc_thread, calc_thread_stack, 3)
@@ -18,6 +18,7 @@
 #ifndef TEST_H
 #define TEST_H
 
+#include "app.h"
 #include "ax_syscall.h"
 #include "common.h"
 
@@ -27,16 +28,29 @@
 
 /*******************************************************************************
  * macros to register test applications and run them with the ATE
+ *
+ * A test registered with REGISTER_TEST runs alone on hart 0. A test which
+ * doesn't share any state with the others is registered with
+ * REGISTER_TEST_PARALLEL, it runs pinned to a free hart next to the other
+ * parallel tests.
  ******************************************************************************/
-#define REGISTER_TEST(_entry_name, _entry, _entry_stack, _prio) \
-  test_info_t test_##_entry = {                                 \
-      .name  = _entry_name,                                     \
-      .stack = &_entry_stack,                                   \
-      .prio  = _prio,                                           \
-      .entry = _entry,                                          \
-  };                                                            \
+#define _REGISTER_TEST(_entry_name, _entry, _entry_stack, _prio, _parallel) \
+  test_info_t test_##_entry = {                                             \
+      .name       = _entry_name,                                            \
+      .stack      = &_entry_stack,                                          \
+      .stack_size = sizeof(_entry_stack),                                   \
+      .prio       = _prio,                                                  \
+      .parallel   = _parallel,                                              \
+      .entry      = _entry,                                                 \
+  };                                                                        \
   _test_section test_info_t *test_##_entry##_pt = &test_##_entry;
 
+#define REGISTER_TEST(_entry_name, _entry, _entry_stack, _prio) \
+  _REGISTER_TEST(_entry_name, _entry, _entry_stack, _prio, false)
+
+#define REGISTER_TEST_PARALLEL(_entry_name, _entry, _entry_stack, _prio) \
+  _REGISTER_TEST(_entry_name, _entry, _entry_stack, _prio, true)
+
 /*******************************************************************************
  * @brief structure to save tests parameters
  * @param None
@@ -44,8 +58,10 @@
  ******************************************************************************/
 typedef struct {
   const char *name;
-  stack_t    *stack;
+  void       *stack;
+  uint64_t    stack_size;
   uint8_t     prio;
+  bool_t      parallel;
   void (*entry)(void);
 } test_info_t;
 
@@ -54,15 +70,17 @@ typedef struct {
  ******************************************************************************/
 void test_set_error(bool_t);
 
+// channel of the test ends, created at boot
+extern app_channel_t test_channel;
+
 #define TEST_ASSERT(_expr) \
   if (!(_expr)) {          \
     test_set_error(true);  \
   }
 
-#define TEST_END()                                    \
-  uint64_t test_data = TEST_END_WORD;                 \
-  uint64_t test_chan_handler;                         \
-  ax_channel_get(&test_chan_handler, "test_channel"); \
-  ax_channel_snd(test_chan_handler, &test_data, sizeof(test_data));
+// the engine finds the test which ends from its task
+#define TEST_END()                                                   \
+  uint64_t test_data[2] = {TEST_END_WORD, (uint64_t)ax_task_self()}; \
+  ax_channel_snd(test_channel.handler, test_data, sizeof(test_data));
 
 #endif
\ No newline at end of file
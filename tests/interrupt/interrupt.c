@@ -43,28 +43,21 @@ static uint8_t test_step = 0;
  * @return None
  ******************************************************************************/
 void interrupt_thread(void) {
-  time_t raw_timer_value  = 0;
   time_t start_date_in_us = 0;
   time_t stop_date_in_us  = 0;
   time_t duration_in_us   = 0;
 
   while (test_step <= NB_INTERRUPT_LOOP) {
     // get the current time
-    start_date_in_us = reg_read_double_word(TIMER_MTIME_ADDR) / 10UL;
+    start_date_in_us = clock_get_us();
 
-    // set the timer to wait TIMER_PERIOD_IN_S
-    raw_timer_value = reg_read_double_word(TIMER_MTIME_ADDR);
-    raw_timer_value += (time_t)(TIMER_PERIOD_IN_S * ARCH_TIMER_RATE);
-    reg_write_double_word(TIMER_MTIMECMP_ADDR, raw_timer_value);
-
-    // enable the interrupt in csr register
-    ax_interrupt_request(TIMER_INTERRUPT);
-
-    // go to sleep, the interrupt will wake up the task in 1s
-    ax_task_sleep();
+    // go to sleep, the timer interrupt will wake up the task after
+    // TIMER_PERIOD_IN_S
+    ax_task_sleep_until(start_date_in_us +
+                        (time_t)(TIMER_PERIOD_IN_S * ONE_SECOND_IN_US));
 
     // get the current time
-    stop_date_in_us = reg_read_double_word(TIMER_MTIME_ADDR) / 10UL;
+    stop_date_in_us = clock_get_us();
 
     duration_in_us = stop_date_in_us - start_date_in_us;
 
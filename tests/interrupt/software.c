@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "ax_syscall.h"
+#include "irq_arch.h"
+#include "test.h"
+
+#define SOFTWARE_TRIGGER_PRIO 4
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t software_thread_stack;
+stack_t software_trigger_stack;
+
+static uint8_t software_step = 0;
+
+/******************************************************************************
+ * @brief raise the software interrupt
+ * @param None
+ * @return None
+ ******************************************************************************/
+static inline void software_raise() {
+  reg_write_word(CLINT_MSIP_ADDR, 1);
+}
+
+/******************************************************************************
+ * @brief lower priority task raising the interrupt
+ * @param None
+ * @return None
+ ******************************************************************************/
+void software_trigger_thread(void) {
+  // STEP 2
+  software_step += 1;
+
+  // the waiting task is directly woken up and preempts this one
+  software_raise();
+
+  // STEP 4
+  software_step += 1;
+}
+
+/******************************************************************************
+ * @brief check the software interrupt is delivered to the attached task
+ * @param None
+ * @return None
+ ******************************************************************************/
+void software_thread(void) {
+  ax_interrupt_request(SOFTWARE_INTERRUPT);
+
+  // an interrupt delivered before the wait is not lost
+  software_raise();
+  ax_interrupt_wait(SOFTWARE_INTERRUPT);
+
+  // STEP 1
+  software_step += 1;
+  TEST_ASSERT(software_step == 1)
+
+  ax_task_create("software_trigger", software_trigger_thread,
+                 &software_trigger_stack, sizeof(software_trigger_stack),
+                 SOFTWARE_TRIGGER_PRIO);
+
+  // block until the trigger task raises the interrupt
+  ax_interrupt_wait(SOFTWARE_INTERRUPT);
+
+  // STEP 3
+  software_step += 1;
+  TEST_ASSERT(software_step == 3)
+
+  // let the trigger task end
+  ax_task_sleep_for(1000);
+  TEST_ASSERT(software_step == 4)
+
+  ax_interrupt_release(SOFTWARE_INTERRUPT);
+
+  TEST_END()
+}
+
+REGISTER_TEST("software_interrupt_test", software_thread, software_thread_stack,
+              5)
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "ax_syscall.h"
+#include "test.h"
+
+#define IRQSOFF_HART          0
+#define IRQSOFF_RECEIVER_PRIO 4
+// the message is copied by the bulk path in several chunks
+#define IRQSOFF_MSG_LEN       4096
+#define IRQSOFF_MSG_WORDS     (IRQSOFF_MSG_LEN / sizeof(uint64_t))
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t irqsoff_thread_stack;
+stack_t irqsoff_receiver_stack;
+
+static uint64_t irqsoff_snd_msg[IRQSOFF_MSG_WORDS];
+static uint64_t irqsoff_rcv_msg[IRQSOFF_MSG_WORDS];
+
+/******************************************************************************
+ * @brief receive a single bulk message
+ * @param None
+ * @return None
+ ******************************************************************************/
+void irqsoff_receiver_thread(void) {
+  uint64_t handler;
+  uint64_t len = sizeof(irqsoff_rcv_msg);
+
+  ax_channel_create(&handler, "irqsoff_channel");
+  ax_channel_rcv(handler, irqsoff_rcv_msg, &len);
+  ax_channel_destroy(handler);
+}
+
+/******************************************************************************
+ * @brief check the intervals measured around a bulk message
+ * @param None
+ * @return None
+ ******************************************************************************/
+void irqsoff_thread(void) {
+  irqsoff_stats_t before;
+  irqsoff_stats_t after;
+  uint64_t        handler;
+
+  for (uint64_t i = 0; i < IRQSOFF_MSG_WORDS; i++) {
+    irqsoff_snd_msg[i] = i;
+  }
+
+  TEST_ASSERT(ax_irqsoff_read(IRQSOFF_HART, &before) == K_OK);
+
+  // the receiver waits for the message, it's switched to by the send
+  ax_task_create("irqsoff_receiver", irqsoff_receiver_thread,
+                 &irqsoff_receiver_stack, sizeof(irqsoff_receiver_stack),
+                 IRQSOFF_RECEIVER_PRIO);
+  ax_task_yield();
+  TEST_ASSERT(ax_channel_get(&handler, "irqsoff_channel") == K_OK);
+  ax_channel_snd(handler, irqsoff_snd_msg, IRQSOFF_MSG_LEN);
+
+  for (uint64_t i = 0; i < IRQSOFF_MSG_WORDS; i++) {
+    TEST_ASSERT(irqsoff_rcv_msg[i] == i);
+  }
+
+  TEST_ASSERT(ax_irqsoff_read(IRQSOFF_HART, &after) == K_OK);
+
+  // the syscalls have run kernel sections with interrupts disabled
+  TEST_ASSERT(after.count > before.count);
+  TEST_ASSERT(after.total > before.total);
+  TEST_ASSERT(after.max > 0 && after.max >= before.max);
+  TEST_ASSERT(after.max_site != 0);
+
+  // a hart which doesn't exist has no statistics
+  TEST_ASSERT(ax_irqsoff_read(CONFIG_HART_MAX_NB, &after) == K_ERROR);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("irqsoff_thread", irqsoff_thread, irqsoff_thread_stack, 3)
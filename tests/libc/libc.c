@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "string.h"
+#include "test.h"
+
+// every offset of a word is tried on each side, with lengths crossing several
+// words and the unrolled blocks
+#define LIBC_OFFSETS  8
+#define LIBC_MAX_LEN  80
+#define LIBC_BUF_SIZE (LIBC_MAX_LEN + 2 * LIBC_OFFSETS)
+#define LIBC_GUARD    0xA5
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t libc_thread_stack;
+
+static uint8_t libc_src[LIBC_BUF_SIZE] __attribute__((aligned(8)));
+static uint8_t libc_dst[LIBC_BUF_SIZE] __attribute__((aligned(8)));
+static char    libc_str[LIBC_BUF_SIZE] __attribute__((aligned(8)));
+static char    libc_other[LIBC_BUF_SIZE] __attribute__((aligned(8)));
+
+/******************************************************************************
+ * @brief check the bytes of the destination outside of a range are the guard
+ * @param start of the range
+ * @param length of the range
+ * @return true if no byte outside of the range was written
+ ******************************************************************************/
+static bool_t libc_guard_intact(uint64_t start, uint64_t len) {
+  for (uint64_t i = 0; i < LIBC_BUF_SIZE; i++) {
+    if ((i < start || i >= start + len) && libc_dst[i] != LIBC_GUARD) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief fill a string with a repeated pattern
+ * @param string
+ * @param length of the string
+ * @return none
+ ******************************************************************************/
+static void libc_fill_string(char *str, uint64_t len) {
+  for (uint64_t i = 0; i < len; i++) {
+    str[i] = 'a' + i % 26;
+  }
+  str[len] = '\0';
+}
+
+/******************************************************************************
+ * @brief check the string functions at all relative alignments
+ * @param None
+ * @return None
+ ******************************************************************************/
+void libc_thread(void) {
+  uint64_t len;
+  uint64_t i;
+
+  for (i = 0; i < LIBC_BUF_SIZE; i++) {
+    libc_src[i] = i;
+  }
+
+  for (uint64_t s = 0; s < LIBC_OFFSETS; s++) {
+    for (uint64_t d = 0; d < LIBC_OFFSETS; d++) {
+      for (len = 0; len <= LIBC_MAX_LEN; len++) {
+        memset(libc_dst, LIBC_GUARD, sizeof(libc_dst));
+
+        TEST_ASSERT(memcpy(libc_dst + d, libc_src + s, len) == libc_dst + d);
+        for (i = 0; i < len; i++) {
+          TEST_ASSERT(libc_dst[d + i] == libc_src[s + i]);
+        }
+        TEST_ASSERT(libc_guard_intact(d, len));
+
+        TEST_ASSERT(memset(libc_dst + d, s, len) == libc_dst + d);
+        for (i = 0; i < len; i++) {
+          TEST_ASSERT(libc_dst[d + i] == s);
+        }
+        TEST_ASSERT(libc_guard_intact(d, len));
+      }
+
+      // the word loops stop on the null byte or the first difference,
+      // whichever word holds it
+      for (len = 0; len <= LIBC_MAX_LEN; len++) {
+        libc_fill_string(libc_str + s, len);
+        libc_fill_string(libc_other + d, len);
+        TEST_ASSERT(strlen(libc_str + s) == len);
+        TEST_ASSERT(strcmp(libc_str + s, libc_other + d) == 0);
+
+        if (len > 0) {
+          libc_other[d + len - 1] += 1;
+          TEST_ASSERT(strcmp(libc_str + s, libc_other + d) < 0);
+          TEST_ASSERT(strcmp(libc_other + d, libc_str + s) > 0);
+
+          libc_other[d + len - 1] = '\0';
+          TEST_ASSERT(strcmp(libc_str + s, libc_other + d) > 0);
+        }
+      }
+    }
+  }
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST_PARALLEL("libc_thread", libc_thread, libc_thread_stack, 3)
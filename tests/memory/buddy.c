@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "buddy.h"
+
+#include "test.h"
+
+#define BUDDY_TEST_NB_BLOCKS 8
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t buddy_thread_stack;
+
+static void *buddy_blocks[BUDDY_TEST_NB_BLOCKS];
+
+/******************************************************************************
+ * @brief check the block is aligned on its size and filled with its index
+ * @param block index
+ * @param block order
+ * @return true if the block is valid
+ ******************************************************************************/
+static bool buddy_check(uint8_t index, uint8_t order) {
+  uint8_t *block = buddy_blocks[index];
+
+  if ((uint64_t)block & ((1UL << order) - 1)) {
+    return false;
+  }
+
+  for (uint64_t byte = 0; byte < (1UL << order); byte++) {
+    if (block[byte] != index) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief allocate and release blocks of the kernel heap
+ * @param None
+ * @return None
+ ******************************************************************************/
+void buddy_thread(void) {
+  uint64_t free_size = buddy_free_size();
+  uint8_t  order;
+
+  TEST_ASSERT(buddy_order(1) == BUDDY_MIN_ORDER);
+  TEST_ASSERT(buddy_order(STACK_SIZE) == 12);
+  TEST_ASSERT(buddy_order(STACK_SIZE + 1) == 13);
+  TEST_ASSERT(buddy_alloc(BUDDY_MAX_ORDER + 1) == NULL);
+
+  // blocks of different orders don't overlap
+  for (uint8_t index = 0; index < BUDDY_TEST_NB_BLOCKS; index++) {
+    order               = BUDDY_MIN_ORDER + index;
+    buddy_blocks[index] = buddy_alloc(order);
+    TEST_ASSERT(buddy_blocks[index] != NULL);
+
+    for (uint64_t byte = 0; byte < (1UL << order); byte++) {
+      ((uint8_t *)buddy_blocks[index])[byte] = index;
+    }
+  }
+
+  TEST_ASSERT(buddy_free_size() < free_size);
+
+  for (uint8_t index = 0; index < BUDDY_TEST_NB_BLOCKS; index++) {
+    TEST_ASSERT(buddy_check(index, BUDDY_MIN_ORDER + index));
+  }
+
+  // released blocks are merged back with their buddies
+  for (uint8_t index = 0; index < BUDDY_TEST_NB_BLOCKS; index += 2) {
+    buddy_free(buddy_blocks[index], BUDDY_MIN_ORDER + index);
+  }
+  for (uint8_t index = 1; index < BUDDY_TEST_NB_BLOCKS; index += 2) {
+    buddy_free(buddy_blocks[index], BUDDY_MIN_ORDER + index);
+  }
+
+  TEST_ASSERT(buddy_free_size() == free_size);
+
+  // the whole heap is available again for a big block
+  order           = buddy_order(free_size / 2);
+  buddy_blocks[0] = buddy_alloc(order - 1);
+  TEST_ASSERT(buddy_blocks[0] != NULL);
+  TEST_ASSERT(((uint64_t)buddy_blocks[0] & ((1UL << (order - 1)) - 1)) == 0);
+
+  buddy_free(buddy_blocks[0], order - 1);
+  TEST_ASSERT(buddy_free_size() == free_size);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("buddy_thread", buddy_thread, buddy_thread_stack, 3)
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "slab.h"
+
+#include "test.h"
+
+#define SLAB_TEST_MAGIC    0xCAFE
+#define SLAB_WORKER_PRIO   4
+#define SLAB_NB_WORKERS    4
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+typedef struct {
+  uint64_t magic;
+  uint64_t data[4];
+} slab_test_object_t;
+
+stack_t slab_thread_stack;
+
+static slab_cache_t slab_test_cache;
+static uint64_t     slab_ctor_calls  = 0;
+static uint64_t     slab_worker_runs = 0;
+
+/******************************************************************************
+ * @brief constructor of the test objects
+ * @param object to construct
+ * @return None
+ ******************************************************************************/
+static void slab_test_ctor(void *object) {
+  ((slab_test_object_t *)object)->magic = SLAB_TEST_MAGIC;
+  slab_ctor_calls += 1;
+}
+
+/******************************************************************************
+ * @brief short-lived worker task
+ * @param None
+ * @return None
+ ******************************************************************************/
+void slab_worker_thread(void) {
+  slab_worker_runs += 1;
+}
+
+/******************************************************************************
+ * @brief allocate objects from a cache and spawn short-lived tasks
+ * @param None
+ * @return None
+ ******************************************************************************/
+void slab_thread(void) {
+  slab_test_object_t *objects[SLAB_MIN_OBJECTS + 1];
+  slab_test_object_t *object;
+  task_t             *worker;
+  task_t             *first;
+
+  slab_cache_init(&slab_test_cache, "test", sizeof(slab_test_object_t),
+                  slab_test_ctor);
+  TEST_ASSERT(slab_test_cache.nb_objects == 0);
+
+  // objects are constructed when the slab is carved
+  objects[0] = slab_alloc(&slab_test_cache);
+  TEST_ASSERT(objects[0] != NULL);
+  TEST_ASSERT(objects[0]->magic == SLAB_TEST_MAGIC);
+  TEST_ASSERT(slab_ctor_calls == slab_test_cache.nb_objects);
+  TEST_ASSERT(slab_test_cache.nb_objects >= SLAB_MIN_OBJECTS);
+
+  // a cache grows by a new slab when it's empty
+  for (uint8_t index = 1; index <= SLAB_MIN_OBJECTS; index++) {
+    objects[index] = slab_alloc(&slab_test_cache);
+    TEST_ASSERT(objects[index] != NULL);
+    TEST_ASSERT(objects[index] != objects[index - 1]);
+    TEST_ASSERT(objects[index]->magic == SLAB_TEST_MAGIC);
+  }
+
+  // the last released object is given first
+  slab_free(&slab_test_cache, objects[3]);
+  object = slab_alloc(&slab_test_cache);
+  TEST_ASSERT(object == objects[3]);
+
+  for (uint8_t index = 0; index <= SLAB_MIN_OBJECTS; index++) {
+    slab_free(&slab_test_cache, objects[index]);
+  }
+  TEST_ASSERT(slab_test_cache.nb_free == slab_test_cache.nb_objects);
+
+  // an exited task gives its stack back for the next one
+  first = ax_task_spawn("slab_worker", slab_worker_thread, SLAB_WORKER_PRIO);
+  TEST_ASSERT(first != NULL);
+  ax_task_yield();
+
+  for (uint8_t index = 1; index < SLAB_NB_WORKERS; index++) {
+    worker = ax_task_spawn("slab_worker", slab_worker_thread, SLAB_WORKER_PRIO);
+    TEST_ASSERT(worker == first);
+    ax_task_yield();
+  }
+
+  TEST_ASSERT(slab_worker_runs == SLAB_NB_WORKERS);
+
+  // a destroyed task gives its stack back too
+  worker = ax_task_spawn("slab_worker", slab_worker_thread, 1);
+  ax_task_destroy(worker);
+  TEST_ASSERT(ax_task_spawn("slab_worker", slab_worker_thread, 1) == worker);
+  ax_task_destroy(worker);
+  TEST_ASSERT(slab_worker_runs == SLAB_NB_WORKERS);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("slab_thread", slab_thread, slab_thread_stack, 3)
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "test.h"
+
+#define STACK_TEST_PRIO       4
+#define STACK_TEST_SMALL_SIZE 1536
+#define STACK_TEST_BUFFER_LEN 64
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+DECLARE_STACK(stack_light_stack, STACK_TEST_SMALL_SIZE);
+DECLARE_STACK(stack_heavy_stack, STACK_TEST_SMALL_SIZE);
+DECLARE_STACK(stack_tiny_stack, STACK_MIN_SIZE / 2);
+stack_t stack_thread_stack;
+
+static uint64_t stack_result      = 0;
+static uint64_t stack_light_usage = 0;
+static uint64_t stack_heavy_usage = 0;
+
+/******************************************************************************
+ * @brief task using a few stack bytes
+ * @param None
+ * @return None
+ ******************************************************************************/
+void stack_light_thread(void) {
+  stack_result     += 1;
+  stack_light_usage = ax_task_stack_usage(ax_task_self());
+}
+
+/******************************************************************************
+ * @brief task using a large buffer on its stack
+ * @param None
+ * @return None
+ ******************************************************************************/
+void stack_heavy_thread(void) {
+  volatile uint64_t buffer[STACK_TEST_BUFFER_LEN];
+
+  for (uint64_t index = 0; index < STACK_TEST_BUFFER_LEN; index++) {
+    buffer[index] = index;
+  }
+
+  stack_result     += buffer[STACK_TEST_BUFFER_LEN - 1];
+  stack_heavy_usage = ax_task_stack_usage(ax_task_self());
+}
+
+/******************************************************************************
+ * @brief measure the stack high-water marks of tasks with custom stack sizes
+ * @param None
+ * @return None
+ ******************************************************************************/
+void stack_thread(void) {
+  task_t *light;
+
+  // a stack can't be smaller than the minimum size
+  TEST_ASSERT(ax_task_create("stack_tiny", stack_light_thread,
+                             stack_tiny_stack, sizeof(stack_tiny_stack),
+                             STACK_TEST_PRIO) == NULL);
+
+  // the control block doesn't lie in the stack
+  light = ax_task_create("stack_light", stack_light_thread, stack_light_stack,
+                         sizeof(stack_light_stack), STACK_TEST_PRIO);
+  TEST_ASSERT(light != NULL);
+  TEST_ASSERT((uint8_t *)light + sizeof(task_t) <= stack_light_stack ||
+              (uint8_t *)light >= stack_light_stack + STACK_TEST_SMALL_SIZE);
+
+  TEST_ASSERT(ax_task_create("stack_heavy", stack_heavy_thread,
+                             stack_heavy_stack, sizeof(stack_heavy_stack),
+                             STACK_TEST_PRIO) != NULL);
+
+  // both tasks have run and exited
+  ax_task_yield();
+  TEST_ASSERT(stack_result == STACK_TEST_BUFFER_LEN);
+
+  TEST_ASSERT(stack_light_usage > 0);
+  TEST_ASSERT(stack_heavy_usage > stack_light_usage);
+  TEST_ASSERT(stack_heavy_usage >= sizeof(uint64_t) * STACK_TEST_BUFFER_LEN);
+  TEST_ASSERT(stack_heavy_usage < STACK_TEST_SMALL_SIZE);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("stack_thread", stack_thread, stack_thread_stack, 3)
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "test.h"
+
+#define NB_CALLS        8
+#define BULK_NB_WORDS   16
+#define CALL_END        0xFFFFFFFF
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t call_server_thread_stack;
+stack_t call_thread_stack;
+
+/******************************************************************************
+ * @brief server incrementing each request, its reply is longer than the
+ * registers to also check the bulk path
+ * @param None
+ * @return None
+ ******************************************************************************/
+void call_server_thread(void) {
+  uint64_t reply[BULK_NB_WORDS];
+  uint64_t reply_len = 0;
+  uint64_t request;
+  uint64_t request_len;
+  uint64_t chan_handler;
+
+  ax_channel_create(&chan_handler, "call_channel");
+
+  // there is no caller yet, only wait for the first request
+  request_len = sizeof(request);
+  ax_channel_reply_wait(chan_handler, reply, reply_len, &request,
+                        &request_len);
+
+  while (request != CALL_END) {
+    TEST_ASSERT(request_len == sizeof(request));
+
+    for (uint64_t i = 0; i < BULK_NB_WORDS; i++) {
+      reply[i] = request + i + 1;
+    }
+
+    // short requests get a short answer passed in registers
+    reply_len = (request % 2) ? sizeof(reply) : sizeof(uint64_t);
+
+    request_len = sizeof(request);
+    ax_channel_reply_wait(chan_handler, reply, reply_len, &request,
+                          &request_len);
+  }
+
+  // the last caller doesn't wait for any data, the server then stays
+  // blocked on the channel
+  ax_channel_reply_wait(chan_handler, reply, 0, &request, &request_len);
+}
+
+/******************************************************************************
+ * @brief client calling the server
+ * @param None
+ * @return None
+ ******************************************************************************/
+void call_thread(void) {
+  uint64_t reply[BULK_NB_WORDS];
+  uint64_t reply_len;
+  uint64_t request;
+  uint64_t chan_handler;
+
+  ax_task_create("call_server", call_server_thread, &call_server_thread_stack,
+                 sizeof(call_server_thread_stack), 4);
+
+  // the server has a higher priority and waits for requests
+  ax_task_yield();
+
+  if (ax_channel_get(&chan_handler, "call_channel") < 0) {
+    TEST_ASSERT(false);
+  } else {
+    for (request = 0; request < NB_CALLS; request++) {
+      reply_len = sizeof(reply);
+      ax_channel_call(chan_handler, &request, sizeof(request), reply,
+                      &reply_len);
+
+      if (request % 2) {
+        TEST_ASSERT(reply_len == sizeof(reply));
+        TEST_ASSERT(reply[BULK_NB_WORDS - 1] == request + BULK_NB_WORDS);
+      } else {
+        TEST_ASSERT(reply_len == sizeof(uint64_t));
+      }
+
+      TEST_ASSERT(reply[0] == request + 1);
+    }
+
+    request   = CALL_END;
+    reply_len = sizeof(reply);
+    ax_channel_call(chan_handler, &request, sizeof(request), reply,
+                    &reply_len);
+    TEST_ASSERT(reply_len == 0);
+  }
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("call_thread", call_thread, call_thread_stack, 3)
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "test.h"
+
+#define DONATION_CLIENT_PRIO 6
+#define DONATION_MEDIUM_PRIO 4
+#define DONATION_SERVER_PRIO 2
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t donation_thread_stack;
+stack_t donation_server_stack;
+stack_t donation_medium_stack;
+
+static bool donation_medium_ran = false;
+
+/******************************************************************************
+ * @brief low priority server, it lets any task of a higher priority run while
+ * it handles a request
+ * @param None
+ * @return None
+ ******************************************************************************/
+void donation_server_thread(void) {
+  uint64_t reply     = 0;
+  uint64_t reply_len = 0;
+  uint64_t request;
+  uint64_t request_len;
+  uint64_t chan_handler;
+
+  ax_channel_create(&chan_handler, "donation_channel");
+
+  while (true) {
+    request_len = sizeof(request);
+    ax_channel_reply_wait(chan_handler, &reply, reply_len, &request,
+                          &request_len);
+
+    // the medium task only runs here if the server kept its own priority
+    ax_task_yield();
+
+    reply     = donation_medium_ran;
+    reply_len = sizeof(reply);
+  }
+}
+
+/******************************************************************************
+ * @brief medium priority task, ready during the whole call
+ * @param None
+ * @return None
+ ******************************************************************************/
+void donation_medium_thread(void) {
+  donation_medium_ran = true;
+}
+
+/******************************************************************************
+ * @brief call the server while a medium priority task is ready
+ * @param None
+ * @return None
+ ******************************************************************************/
+void donation_thread(void) {
+  task_t  *server;
+  uint64_t request = 0;
+  uint64_t reply   = true;
+  uint64_t reply_len;
+  uint64_t chan_handler;
+
+  server = ax_task_create("donation_server", donation_server_thread,
+                          &donation_server_stack,
+                          sizeof(donation_server_stack), DONATION_SERVER_PRIO);
+
+  // let the server wait for its first request
+  ax_task_sleep_for(1000);
+
+  if (ax_channel_get(&chan_handler, "donation_channel") < 0) {
+    TEST_ASSERT(false);
+  } else {
+    ax_task_create("donation_medium", donation_medium_thread,
+                   &donation_medium_stack, sizeof(donation_medium_stack),
+                   DONATION_MEDIUM_PRIO);
+
+    reply_len = sizeof(reply);
+    ax_channel_call(chan_handler, &request, sizeof(request), &reply,
+                    &reply_len);
+
+    // the server ran at the priority of the caller
+    TEST_ASSERT(reply_len == sizeof(reply));
+    TEST_ASSERT(reply == false);
+
+    // and got its own priority back with the reply
+    TEST_ASSERT(task_get_priority(server) == DONATION_SERVER_PRIO);
+  }
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("donation_thread", donation_thread, donation_thread_stack,
+              DONATION_CLIENT_PRIO)
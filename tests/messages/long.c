@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "test.h"
+
+// a sensor frame is passed in registers, a bigger one is copied
+#define FRAME_NB_WORDS      6
+#define BULK_NB_WORDS       64
+#define TRUNCATED_NB_WORDS  5
+#define LONG_MESSAGE_SEED   0xA5A50000
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t snd_long_thread_stack;
+stack_t rcv_long_thread_stack;
+stack_t long_messages_thread_stack;
+
+// receiver buffer, zeroed to check the words past the message
+static uint64_t msg[BULK_NB_WORDS];
+
+/******************************************************************************
+ * @brief fill a message with a known pattern
+ * @param message buffer
+ * @param number of words in the message
+ * @return None
+ ******************************************************************************/
+static void long_message_fill(uint64_t *msg, uint64_t nb_words) {
+  for (uint64_t i = 0; i < nb_words; i++) {
+    msg[i] = LONG_MESSAGE_SEED + i;
+  }
+}
+
+/******************************************************************************
+ * @brief check a received message holds the known pattern
+ * @param message buffer
+ * @param number of words in the message
+ * @return true if the message is valid
+ ******************************************************************************/
+static bool long_message_check(uint64_t *msg, uint64_t nb_words) {
+  for (uint64_t i = 0; i < nb_words; i++) {
+    if (msg[i] != LONG_MESSAGE_SEED + i) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief send a register message, a bulk message and a too long message
+ * @param None
+ * @return None
+ ******************************************************************************/
+void snd_long_thread(void) {
+  uint64_t snd_msg[BULK_NB_WORDS];
+  uint64_t snd_chan_handler;
+
+  long_message_fill(snd_msg, BULK_NB_WORDS);
+
+  if (ax_channel_get(&snd_chan_handler, "long_channel") < 0) {
+    TEST_ASSERT(false);
+    return;
+  }
+
+  ax_channel_snd(snd_chan_handler, snd_msg, FRAME_NB_WORDS * sizeof(uint64_t));
+  ax_channel_snd(snd_chan_handler, snd_msg, sizeof(snd_msg));
+  ax_channel_snd(snd_chan_handler, snd_msg, sizeof(snd_msg));
+}
+
+/******************************************************************************
+ * @brief receive messages and check their length
+ * @param None
+ * @return None
+ ******************************************************************************/
+void rcv_long_thread(void) {
+  uint64_t msg_len;
+  uint64_t rcv_chan_handler;
+
+  ax_channel_create(&rcv_chan_handler, "long_channel");
+
+  // the receiver buffer is bigger than the message
+  msg_len = sizeof(msg);
+  ax_channel_rcv(rcv_chan_handler, msg, &msg_len);
+  TEST_ASSERT(msg_len == FRAME_NB_WORDS * sizeof(uint64_t));
+  TEST_ASSERT(long_message_check(msg, FRAME_NB_WORDS));
+  TEST_ASSERT(msg[FRAME_NB_WORDS] == 0);
+
+  msg_len = sizeof(msg);
+  ax_channel_rcv(rcv_chan_handler, msg, &msg_len);
+  TEST_ASSERT(msg_len == sizeof(msg));
+  TEST_ASSERT(long_message_check(msg, BULK_NB_WORDS));
+
+  // the message is truncated to the receiver buffer size
+  msg[TRUNCATED_NB_WORDS] = 0;
+  msg_len                 = TRUNCATED_NB_WORDS * sizeof(uint64_t);
+  ax_channel_rcv(rcv_chan_handler, msg, &msg_len);
+  TEST_ASSERT(msg_len == TRUNCATED_NB_WORDS * sizeof(uint64_t));
+  TEST_ASSERT(msg[TRUNCATED_NB_WORDS] == 0);
+}
+
+/******************************************************************************
+ * @brief create the send / rcv threads
+ * @param None
+ * @return None
+ ******************************************************************************/
+void long_messages_thread(void) {
+  // the receiver waits first on the channel
+  ax_task_create("rcv_long_test", rcv_long_thread, &rcv_long_thread_stack,
+                 sizeof(rcv_long_thread_stack), 5);
+
+  ax_task_yield();
+
+  ax_task_create("snd_long_test", snd_long_thread, &snd_long_thread_stack,
+                 sizeof(snd_long_thread_stack), 4);
+
+  ax_task_yield();
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("long_messages_thread", long_messages_thread,
+              long_messages_thread_stack, 3)
@@ -59,7 +59,7 @@ void snd_messages_thread(void) {
  ******************************************************************************/
 void rcv_messages_thread(void) {
   uint64_t data_to_receive = 0;
-  uint64_t data_len        = 0;
+  uint64_t data_len        = sizeof(data_to_receive);
   uint64_t rcv_chan_handler;
 
   // create a communication channel
@@ -94,7 +94,7 @@ void snd_messages_thread_2(void) {
  ******************************************************************************/
 void rcv_messages_thread_2(void) {
   uint64_t data_to_receive = 0;
-  uint64_t data_len        = 0;
+  uint64_t data_len        = sizeof(data_to_receive);
   uint64_t rcv_chan_handler;
 
   // looking for the channel
@@ -119,11 +119,13 @@ void messages_thread(void) {
 
   // create the send thread
   ax_task_create("snd_messages_test", snd_messages_thread,
-                 &snd_messages_thread_stack, 4);
+                 &snd_messages_thread_stack, sizeof(snd_messages_thread_stack),
+                 4);
 
   // create the rcv thread
   ax_task_create("rcv_messages_test", rcv_messages_thread,
-                 &rcv_messages_thread_stack, 5);
+                 &rcv_messages_thread_stack, sizeof(rcv_messages_thread_stack),
+                 5);
 
   ax_task_yield();
 
@@ -131,11 +133,13 @@ void messages_thread(void) {
 
   // create the send thread
   ax_task_create("snd_messages_test_2", snd_messages_thread_2,
-                 &snd_messages_thread_stack_2, 5);
+                 &snd_messages_thread_stack_2,
+                 sizeof(snd_messages_thread_stack_2), 5);
 
   // create the rcv thread
   ax_task_create("rcv_messages_test_2", rcv_messages_thread_2,
-                 &rcv_messages_thread_stack_2, 4);
+                 &rcv_messages_thread_stack_2,
+                 sizeof(rcv_messages_thread_stack_2), 4);
 
   ax_task_yield();
 
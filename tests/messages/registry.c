@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "test.h"
+
+// more channels than the former fixed table
+#define NB_REGISTRY_CHANNELS 20
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t registry_thread_stack;
+
+static uint64_t registry_handler[NB_REGISTRY_CHANNELS];
+
+/******************************************************************************
+ * @brief build a channel name from an index
+ * @param name buffer
+ * @param index of the channel
+ * @return None
+ ******************************************************************************/
+static void registry_name(char *name, uint64_t index) {
+  const char *prefix = "registry_";
+  uint64_t    i;
+
+  for (i = 0; prefix[i]; i++) {
+    name[i] = prefix[i];
+  }
+
+  name[i++] = 'a' + index / 10;
+  name[i++] = 'a' + index % 10;
+  name[i]   = '\0';
+}
+
+/******************************************************************************
+ * @brief create, look for and destroy channels
+ * @param None
+ * @return None
+ ******************************************************************************/
+void registry_thread(void) {
+  char     name[16];
+  uint64_t handler;
+  uint64_t data     = 0;
+  uint64_t data_len = sizeof(data);
+
+  for (uint64_t i = 0; i < NB_REGISTRY_CHANNELS; i++) {
+    registry_name(name, i);
+    TEST_ASSERT(ax_channel_create(&registry_handler[i], name) == K_OK);
+  }
+
+  // a name identifies a single channel
+  registry_name(name, 0);
+  TEST_ASSERT(ax_channel_create(&handler, name) == K_ERROR);
+
+  for (uint64_t i = 0; i < NB_REGISTRY_CHANNELS; i++) {
+    registry_name(name, i);
+    TEST_ASSERT(ax_channel_get(&handler, name) == K_OK);
+    TEST_ASSERT(handler == registry_handler[i]);
+  }
+
+  TEST_ASSERT(ax_channel_get(&handler, "registry_unknown") == K_ERROR);
+
+  // a destroyed channel can't be found nor used anymore
+  registry_name(name, 0);
+  TEST_ASSERT(ax_channel_destroy(registry_handler[0]) == K_OK);
+  TEST_ASSERT(ax_channel_get(&handler, name) == K_ERROR);
+  TEST_ASSERT(ax_channel_rcv(registry_handler[0], &data, &data_len) ==
+              K_ERROR);
+
+  // the name is available again with a new handler
+  TEST_ASSERT(ax_channel_create(&handler, name) == K_OK);
+  TEST_ASSERT(handler != registry_handler[0]);
+
+  // other channels are still reachable through the deleted entry
+  for (uint64_t i = 1; i < NB_REGISTRY_CHANNELS; i++) {
+    registry_name(name, i);
+    TEST_ASSERT(ax_channel_get(&handler, name) == K_OK);
+    TEST_ASSERT(handler == registry_handler[i]);
+    TEST_ASSERT(ax_channel_destroy(handler) == K_OK);
+  }
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("registry_thread", registry_thread, registry_thread_stack, 3)
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "ring.h"
+#include "test.h"
+
+#define RING_NB_ELEMS  8
+#define RING_NB_SAMPLE 100
+#define RING_BIT       (1UL << 0)
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t ring_producer_stack;
+stack_t ring_consumer_stack;
+stack_t ring_thread_stack;
+
+typedef struct ring_sample_t {
+  uint64_t index;
+  uint64_t value;
+} ring_sample_t;
+
+static ring_sample_t ring_buffer[RING_NB_ELEMS];
+static ring_t        ring;
+static uint64_t      ring_received = 0;
+
+/******************************************************************************
+ * @brief push samples faster than the consumer reads them
+ * @param None
+ * @return None
+ ******************************************************************************/
+void ring_producer_thread(void) {
+  ring_sample_t sample;
+
+  ring_attach_producer(&ring);
+
+  for (uint64_t i = 0; i < RING_NB_SAMPLE; i++) {
+    sample.index = i;
+    sample.value = ~i;
+    ring_put(&ring, &sample);
+  }
+}
+
+/******************************************************************************
+ * @brief higher priority consumer, it blocks on the empty ring
+ * @param None
+ * @return None
+ ******************************************************************************/
+void ring_consumer_thread(void) {
+  ring_sample_t sample;
+
+  ring_attach_consumer(&ring);
+
+  for (uint64_t i = 0; i < RING_NB_SAMPLE; i++) {
+    ring_get(&ring, &sample);
+
+    TEST_ASSERT(sample.index == i && sample.value == ~i);
+    ring_received += 1;
+
+    // let the producer fill the ring
+    if (i % RING_NB_ELEMS == 0) {
+      ax_task_sleep_for(1000);
+    }
+  }
+}
+
+/******************************************************************************
+ * @brief stream samples through a ring buffer
+ * @param None
+ * @return None
+ ******************************************************************************/
+void ring_thread(void) {
+  ring_init(&ring, ring_buffer, sizeof(ring_sample_t), RING_NB_ELEMS,
+            RING_BIT);
+
+  ax_task_create("ring_consumer", ring_consumer_thread, &ring_consumer_stack,
+                 sizeof(ring_consumer_stack), 5);
+  ax_task_create("ring_producer", ring_producer_thread, &ring_producer_stack,
+                 sizeof(ring_producer_stack), 4);
+
+  // wait for the producer and the consumer to finish
+  while (ring_received < RING_NB_SAMPLE) {
+    ax_task_sleep_for(1000);
+  }
+
+  TEST_ASSERT(ring.head == RING_NB_SAMPLE && ring.tail == RING_NB_SAMPLE);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("ring_thread", ring_thread, ring_thread_stack, 3)
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "test.h"
+
+#define NB_SENDERS 4
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t sender_thread_stack[NB_SENDERS];
+stack_t senders_thread_stack;
+
+// senders priorities, two senders share the same priority level
+static const uint8_t sender_prio[NB_SENDERS] = {4, 5, 6, 5};
+
+// expected order of reception: by priority then by arrival order
+static const uint64_t expected_sender[NB_SENDERS] = {2, 1, 3, 0};
+
+/******************************************************************************
+ * @brief send the sender index, each sender is identified by its priority
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void sender_thread(uint64_t index) {
+  uint64_t snd_chan_handler;
+
+  if (ax_channel_get(&snd_chan_handler, "senders_channel") < 0) {
+    TEST_ASSERT(false);
+    return;
+  }
+
+  ax_channel_snd(snd_chan_handler, &index, sizeof(index));
+}
+
+/******************************************************************************
+ * @brief sender task 0
+ * @param None
+ * @return None
+ ******************************************************************************/
+void sender_thread_0(void) {
+  sender_thread(0);
+}
+
+/******************************************************************************
+ * @brief sender task 1
+ * @param None
+ * @return None
+ ******************************************************************************/
+void sender_thread_1(void) {
+  sender_thread(1);
+}
+
+/******************************************************************************
+ * @brief sender task 2
+ * @param None
+ * @return None
+ ******************************************************************************/
+void sender_thread_2(void) {
+  sender_thread(2);
+}
+
+/******************************************************************************
+ * @brief sender task 3
+ * @param None
+ * @return None
+ ******************************************************************************/
+void sender_thread_3(void) {
+  sender_thread(3);
+}
+
+static void (*const sender_entry[NB_SENDERS])(void) = {
+    sender_thread_0,
+    sender_thread_1,
+    sender_thread_2,
+    sender_thread_3,
+};
+
+/******************************************************************************
+ * @brief block all senders on the channel then receive their messages
+ * @param None
+ * @return None
+ ******************************************************************************/
+void senders_thread(void) {
+  uint64_t rcv_chan_handler;
+  uint64_t index;
+  uint64_t index_len;
+
+  ax_channel_create(&rcv_chan_handler, "senders_channel");
+
+  for (uint64_t i = 0; i < NB_SENDERS; i++) {
+    ax_task_create("sender_test", sender_entry[i], &sender_thread_stack[i],
+                   sizeof(sender_thread_stack[i]), sender_prio[i]);
+  }
+
+  // all senders have a higher priority and block on the channel
+  ax_task_yield();
+
+  // no sender is lost and the highest priority sender is served first
+  for (uint64_t i = 0; i < NB_SENDERS; i++) {
+    index     = NB_SENDERS;
+    index_len = sizeof(index);
+    ax_channel_rcv(rcv_chan_handler, &index, &index_len);
+
+    TEST_ASSERT(index == expected_sender[i]);
+  }
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("senders_thread", senders_thread, senders_thread_stack, 3)
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "irq_arch.h"
+#include "test.h"
+
+#define WAIT_ANY_TRIGGER_PRIO 2
+
+#define WAIT_ANY_NOTIFY_BIT (1UL << 0)
+#define WAIT_ANY_MSG        0xCAFE
+
+#define WAIT_ANY_CHANNEL   0
+#define WAIT_ANY_NOTIFY    1
+#define WAIT_ANY_INTERRUPT 2
+#define WAIT_ANY_NB        3
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t wait_any_thread_stack;
+stack_t wait_any_trigger_stack;
+
+static uint8_t  wait_any_step = 0;
+static task_t  *wait_any_server;
+static uint64_t wait_any_channel;
+
+/******************************************************************************
+ * @brief raise the software interrupt
+ * @param None
+ * @return None
+ ******************************************************************************/
+static inline void wait_any_raise() {
+  reg_write_word(CLINT_MSIP_ADDR, 1);
+}
+
+/******************************************************************************
+ * @brief lower priority task firing the objects one after the other
+ * @param None
+ * @return None
+ ******************************************************************************/
+void wait_any_trigger_thread(void) {
+  uint64_t msg = WAIT_ANY_MSG;
+
+  // STEP 1, the server preempts this task for each object
+  wait_any_step += 1;
+  ax_notify(wait_any_server, WAIT_ANY_NOTIFY_BIT);
+
+  // STEP 2
+  wait_any_step += 1;
+  wait_any_raise();
+
+  // STEP 3
+  wait_any_step += 1;
+  ax_channel_snd(wait_any_channel, &msg, sizeof(msg));
+}
+
+/******************************************************************************
+ * @brief serve a channel, a notification and an interrupt from a single task
+ * @param None
+ * @return None
+ ******************************************************************************/
+void wait_any_thread(void) {
+  wait_object_t objects[WAIT_ANY_NB];
+  uint64_t      msg;
+  uint64_t      msg_len;
+
+  wait_any_server = ax_task_self();
+
+  ax_channel_create(&wait_any_channel, "wait_any_channel");
+  ax_interrupt_request(SOFTWARE_INTERRUPT);
+
+  objects[WAIT_ANY_CHANNEL].type     = WAIT_CHANNEL;
+  objects[WAIT_ANY_CHANNEL].handle   = wait_any_channel;
+  objects[WAIT_ANY_NOTIFY].type      = WAIT_NOTIFY;
+  objects[WAIT_ANY_NOTIFY].handle    = WAIT_ANY_NOTIFY_BIT;
+  objects[WAIT_ANY_INTERRUPT].type   = WAIT_INTERRUPT;
+  objects[WAIT_ANY_INTERRUPT].handle = SOFTWARE_INTERRUPT;
+
+  // there must be at least one object to wait for
+  TEST_ASSERT(ax_wait_any(objects, 0) == K_ERROR);
+
+  ax_task_create("wait_any_trigger", wait_any_trigger_thread,
+                 &wait_any_trigger_stack, sizeof(wait_any_trigger_stack),
+                 WAIT_ANY_TRIGGER_PRIO);
+
+  // the trigger task only runs while this task waits
+  TEST_ASSERT(ax_wait_any(objects, WAIT_ANY_NB) == WAIT_ANY_NOTIFY);
+  TEST_ASSERT(wait_any_step == 1);
+  TEST_ASSERT(ax_wait(WAIT_ANY_NOTIFY_BIT) == WAIT_ANY_NOTIFY_BIT);
+
+  TEST_ASSERT(ax_wait_any(objects, WAIT_ANY_NB) == WAIT_ANY_INTERRUPT);
+  TEST_ASSERT(wait_any_step == 2);
+
+  // the message is received without blocking
+  TEST_ASSERT(ax_wait_any(objects, WAIT_ANY_NB) == WAIT_ANY_CHANNEL);
+  TEST_ASSERT(wait_any_step == 3);
+
+  msg_len = sizeof(msg);
+  ax_channel_rcv(wait_any_channel, &msg, &msg_len);
+  TEST_ASSERT(msg == WAIT_ANY_MSG);
+
+  // objects ready before the wait are returned in the array order
+  wait_any_raise();
+  ax_notify(wait_any_server, WAIT_ANY_NOTIFY_BIT);
+
+  TEST_ASSERT(ax_wait_any(objects, WAIT_ANY_NB) == WAIT_ANY_NOTIFY);
+  TEST_ASSERT(ax_wait(WAIT_ANY_NOTIFY_BIT) == WAIT_ANY_NOTIFY_BIT);
+  TEST_ASSERT(ax_wait_any(objects, WAIT_ANY_NB) == WAIT_ANY_INTERRUPT);
+
+  ax_interrupt_release(SOFTWARE_INTERRUPT);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("wait_any_thread", wait_any_thread, wait_any_thread_stack, 3)
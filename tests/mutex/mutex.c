@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "mutex.h"
+
+#include "test.h"
+
+#define MUTEX_LOW_PRIO    4
+#define MUTEX_MEDIUM_PRIO 5
+#define MUTEX_HIGH_PRIO   6
+
+#define MUTEX_STEP_HIGH   1
+#define MUTEX_STEP_MEDIUM 2
+#define MUTEX_STEP_LOW    3
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t mutex_thread_stack;
+stack_t mutex_low_stack;
+stack_t mutex_medium_stack;
+stack_t mutex_high_stack;
+
+static mutex_t mutex;
+static uint8_t mutex_steps[3];
+static uint8_t mutex_nb_steps = 0;
+
+/******************************************************************************
+ * @brief high priority task blocking on the mutex
+ * @param None
+ * @return None
+ ******************************************************************************/
+void mutex_high_thread(void) {
+  TEST_ASSERT(mutex_lock(&mutex) == K_OK);
+
+  // the mutex has been handed over by the low priority task
+  TEST_ASSERT(mutex.owner == (uint64_t)ax_task_self());
+  mutex_steps[mutex_nb_steps++] = MUTEX_STEP_HIGH;
+
+  TEST_ASSERT(mutex_unlock(&mutex) == K_OK);
+}
+
+/******************************************************************************
+ * @brief medium priority task which must not preempt the mutex owner
+ * @param None
+ * @return None
+ ******************************************************************************/
+void mutex_medium_thread(void) {
+  mutex_steps[mutex_nb_steps++] = MUTEX_STEP_MEDIUM;
+}
+
+/******************************************************************************
+ * @brief low priority task owning the mutex
+ * @param None
+ * @return None
+ ******************************************************************************/
+void mutex_low_thread(void) {
+  task_t *self = ax_task_self();
+
+  // uncontended, taken without any syscall
+  TEST_ASSERT(mutex_lock(&mutex) == K_OK);
+  TEST_ASSERT(mutex_lock(&mutex) == K_ERROR);
+
+  ax_task_create("mutex_high", mutex_high_thread, &mutex_high_stack,
+                 sizeof(mutex_high_stack), MUTEX_HIGH_PRIO);
+  ax_task_yield();
+
+  // the high priority task waits for the mutex, its priority is inherited
+  TEST_ASSERT(mutex.owner & MUTEX_CONTENDED);
+  TEST_ASSERT(self->prio == MUTEX_HIGH_PRIO);
+
+  ax_task_create("mutex_medium", mutex_medium_thread, &mutex_medium_stack,
+                 sizeof(mutex_medium_stack), MUTEX_MEDIUM_PRIO);
+  ax_task_yield();
+  TEST_ASSERT(mutex_nb_steps == 0);
+
+  // the high priority task runs as soon as it gets the mutex
+  TEST_ASSERT(mutex_unlock(&mutex) == K_OK);
+  TEST_ASSERT(self->prio == MUTEX_LOW_PRIO);
+
+  mutex_steps[mutex_nb_steps++] = MUTEX_STEP_LOW;
+}
+
+/******************************************************************************
+ * @brief check priority inheritance between three tasks
+ * @param None
+ * @return None
+ ******************************************************************************/
+void mutex_thread(void) {
+  mutex_init(&mutex);
+
+  TEST_ASSERT(mutex_try_lock(&mutex));
+  TEST_ASSERT(!mutex_try_lock(&mutex));
+  TEST_ASSERT(mutex_unlock(&mutex) == K_OK);
+  TEST_ASSERT(mutex_unlock(&mutex) == K_ERROR);
+  TEST_ASSERT(mutex.owner == 0);
+
+  ax_task_create("mutex_low", mutex_low_thread, &mutex_low_stack,
+                 sizeof(mutex_low_stack), MUTEX_LOW_PRIO);
+  ax_task_yield();
+
+  TEST_ASSERT(mutex_nb_steps == 3);
+  TEST_ASSERT(mutex_steps[0] == MUTEX_STEP_HIGH);
+  TEST_ASSERT(mutex_steps[1] == MUTEX_STEP_MEDIUM);
+  TEST_ASSERT(mutex_steps[2] == MUTEX_STEP_LOW);
+  TEST_ASSERT(mutex.owner == 0);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("mutex_thread", mutex_thread, mutex_thread_stack, 3)
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "test.h"
+
+#define NOTIFY_WAITER_PRIO 5
+
+#define NOTIFY_BIT_0 (1UL << 0)
+#define NOTIFY_BIT_1 (1UL << 1)
+#define NOTIFY_BIT_2 (1UL << 2)
+#define NOTIFY_BIT_3 (1UL << 3)
+#define NOTIFY_BIT_4 (1UL << 4)
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t notify_thread_stack;
+stack_t notify_waiter_stack;
+
+static uint8_t  notify_step = 0;
+static uint64_t notify_bits[4];
+
+/******************************************************************************
+ * @brief higher priority task waiting for notifications
+ * @param None
+ * @return None
+ ******************************************************************************/
+void notify_waiter_thread(void) {
+  // STEP 1
+  notify_step += 1;
+  notify_bits[0] = ax_wait(NOTIFY_BIT_0 | NOTIFY_BIT_1);
+
+  // STEP 2, a bit set before the wait is not lost
+  notify_step += 1;
+  notify_bits[1] = ax_wait(NOTIFY_BIT_1 | NOTIFY_BIT_2);
+
+  // STEP 3
+  notify_step += 1;
+  notify_bits[2] = ax_wait(NOTIFY_BIT_3);
+
+  // STEP 4, several notifications are coalesced
+  notify_step += 1;
+  notify_bits[3] = ax_wait(NOTIFY_BIT_1 | NOTIFY_BIT_4);
+}
+
+/******************************************************************************
+ * @brief notify the waiting task
+ * @param None
+ * @return None
+ ******************************************************************************/
+void notify_thread(void) {
+  task_t *waiter;
+
+  waiter = ax_task_create("notify_waiter", notify_waiter_thread,
+                          &notify_waiter_stack, sizeof(notify_waiter_stack),
+                          NOTIFY_WAITER_PRIO);
+
+  ax_task_yield();
+  TEST_ASSERT(notify_step == 1);
+
+  // a bit out of the waited mask doesn't wake the task up
+  ax_notify(waiter, NOTIFY_BIT_2);
+  TEST_ASSERT(notify_step == 1);
+
+  // the waiter preempts the notifying task
+  ax_notify(waiter, NOTIFY_BIT_0);
+  TEST_ASSERT(notify_step == 3);
+  TEST_ASSERT(notify_bits[0] == NOTIFY_BIT_0);
+  TEST_ASSERT(notify_bits[1] == NOTIFY_BIT_2);
+
+  // the notifying task never blocks
+  ax_notify(waiter, NOTIFY_BIT_1);
+  ax_notify(waiter, NOTIFY_BIT_4);
+  ax_notify(waiter, NOTIFY_BIT_1);
+  TEST_ASSERT(notify_step == 3);
+
+  ax_notify(waiter, NOTIFY_BIT_3);
+  TEST_ASSERT(notify_step == 4);
+  TEST_ASSERT(notify_bits[2] == NOTIFY_BIT_3);
+  TEST_ASSERT(notify_bits[3] == (NOTIFY_BIT_1 | NOTIFY_BIT_4));
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("notify_thread", notify_thread, notify_thread_stack, 3)
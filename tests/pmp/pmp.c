@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "pmp.h"
+#include "task.h"
+#include "test.h"
+
+// the user tasks run as soon as the test yields
+#define PMP_USER_PRIO 4
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t pmp_thread_stack;
+DECLARE_USER_STACK(pmp_user_stack, USER_STACK_SIZE);
+DECLARE_USER_STACK(pmp_fault_stack, USER_STACK_SIZE);
+DECLARE_USER_STACK(pmp_syscall_stack, USER_STACK_SIZE);
+
+// progress of the user tasks, in the user data
+__user_data uint64_t  pmp_user_counter = 0;
+__user_data uint64_t  pmp_fault_step   = 0;
+__user_data uint64_t *pmp_fault_target = NULL;
+
+// results of the syscalls given kernel addresses, in the user data
+__user_data char       pmp_child_name[] = "pmp_child";
+__user_data uint64_t   pmp_channel      = 0;
+__user_data task_t    *pmp_child        = NULL;
+__user_data k_return_t pmp_stats_ret    = K_OK;
+__user_data k_return_t pmp_rcv_ret      = K_OK;
+
+// kernel data, out of the region set
+static uint64_t     pmp_kernel_word = 0;
+static stack_t      pmp_kernel_stack;
+static task_stats_t pmp_kernel_stats;
+
+/******************************************************************************
+ * @brief user task writing its data and stack across a syscall
+ * @param None
+ * @return None
+ ******************************************************************************/
+__user_text void pmp_user_thread(void) {
+  pmp_user_counter++;
+  ax_task_yield();
+  pmp_user_counter++;
+}
+
+/******************************************************************************
+ * @brief user task writing to the kernel data, it's killed by the store
+ * @param None
+ * @return None
+ ******************************************************************************/
+__user_text void pmp_fault_thread(void) {
+  pmp_fault_step    = 1;
+  *pmp_fault_target = 1;
+  pmp_fault_step    = 2;
+}
+
+/******************************************************************************
+ * @brief user task giving kernel addresses to syscalls, they fail without
+ * touching the kernel data
+ * @param None
+ * @return None
+ ******************************************************************************/
+__user_text void pmp_syscall_thread(void) {
+  uint64_t len = sizeof(pmp_kernel_word);
+
+  pmp_child     = ax_task_create(pmp_child_name, pmp_user_thread,
+                                 &pmp_kernel_stack, sizeof(pmp_kernel_stack),
+                                 PMP_USER_PRIO);
+  pmp_stats_ret = ax_task_get_stats(0, &pmp_kernel_stats);
+  // the channel has no sender, the receive would block if it was accepted
+  pmp_rcv_ret   = ax_channel_rcv(pmp_channel, &pmp_kernel_word, &len);
+}
+
+/******************************************************************************
+ * @brief check the user tasks are confined to their stack and region set
+ * @param None
+ * @return None
+ ******************************************************************************/
+void pmp_thread(void) {
+  task_t *task;
+
+  // the kernel stack doesn't fit
+  task = task_create_user("pmp_small", pmp_user_thread, &pmp_user_stack,
+                          STACK_MIN_SIZE, PMP_USER_PRIO, &pmp_user_region);
+  TEST_ASSERT(task == NULL);
+
+  // a user task makes syscalls and returns to the exit stub
+  task = task_create_user("pmp_user", pmp_user_thread, &pmp_user_stack,
+                          sizeof(pmp_user_stack), PMP_USER_PRIO,
+                          &pmp_user_region);
+  TEST_ASSERT(task != NULL);
+  TEST_ASSERT(task->region == &pmp_user_region);
+
+  ax_task_yield();
+  TEST_ASSERT(pmp_user_counter == 2);
+
+  // an access out of the region set kills the task before the kernel data
+  // is written
+  pmp_fault_target = &pmp_kernel_word;
+  task = task_create_user("pmp_fault", pmp_fault_thread, &pmp_fault_stack,
+                          sizeof(pmp_fault_stack), PMP_USER_PRIO,
+                          &pmp_user_region);
+  TEST_ASSERT(task != NULL);
+
+  ax_task_yield();
+  TEST_ASSERT(pmp_fault_step == 1);
+  TEST_ASSERT(pmp_kernel_word == 0);
+
+  // the syscalls check the pointers of a user task, the stack isn't painted
+  TEST_ASSERT(ax_channel_create(&pmp_channel, "pmp_channel") == K_OK);
+  task = task_create_user("pmp_syscall", pmp_syscall_thread,
+                          &pmp_syscall_stack, sizeof(pmp_syscall_stack),
+                          PMP_USER_PRIO, &pmp_user_region);
+  TEST_ASSERT(task != NULL);
+
+  ax_task_yield();
+  TEST_ASSERT(pmp_child == NULL);
+  TEST_ASSERT(pmp_stats_ret == K_ERROR);
+  TEST_ASSERT(pmp_rcv_ret == K_ERROR);
+  TEST_ASSERT(pmp_kernel_stack[0] == 0);
+  TEST_ASSERT(pmp_kernel_stats.task_id == 0);
+  TEST_ASSERT(pmp_kernel_word == 0);
+
+  ax_channel_destroy(pmp_channel);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("pmp_thread", pmp_thread, pmp_thread_stack, 3)
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "log.h"
+#include "printk.h"
+#include "test.h"
+
+#define PRINTK_HART 0
+
+// the log server drains the rings at least every 10 ms
+#define PRINTK_SLEEP_US 20000
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t printk_thread_stack;
+
+/******************************************************************************
+ * @brief check printk records are deferred to the log server
+ * @param None
+ * @return None
+ ******************************************************************************/
+void printk_thread(void) {
+  log_ring_t   *ring = &log_rings[PRINTK_HART];
+  log_record_t *record;
+  uint64_t      dropped;
+
+  // the messages printed since boot are drained while the test sleeps
+  ax_task_sleep_for(PRINTK_SLEEP_US);
+  TEST_ASSERT(log_pending(PRINTK_HART) == 0);
+
+  // the server runs at a lower priority, the record waits for it, an empty
+  // format doesn't print anything
+  printk("", 42, ring);
+  TEST_ASSERT(log_pending(PRINTK_HART) == 1);
+
+  record = &ring->records[(ring->head - 1) & (CONFIG_PRINTK_RECORDS - 1)];
+  TEST_ASSERT(record->args[0] == 42);
+  TEST_ASSERT(record->args[1] == (uint64_t)ring);
+
+  // a full ring drops the new records without waiting
+  dropped = log_dropped(PRINTK_HART);
+  for (uint64_t i = 0; i < CONFIG_PRINTK_RECORDS; i++) {
+    printk("");
+  }
+  TEST_ASSERT(log_pending(PRINTK_HART) == CONFIG_PRINTK_RECORDS);
+  TEST_ASSERT(log_dropped(PRINTK_HART) == dropped + 1);
+
+  ax_task_sleep_for(PRINTK_SLEEP_US);
+  TEST_ASSERT(log_pending(PRINTK_HART) == 0);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("printk_thread", printk_thread, printk_thread_stack, 3)
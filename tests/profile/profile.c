@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "ax_syscall.h"
+#include "profile.h"
+#include "test.h"
+#include "timer_arch.h"
+
+// the task spins long enough to be sampled a few times
+#define PROFILE_SPIN_PERIODS 20
+#define PROFILE_SPIN         (PROFILE_SPIN_PERIODS * CONFIG_PROFILE_PERIOD_US)
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t profile_thread_stack;
+
+static profile_sample_t profile_samples[CONFIG_PROFILE_SAMPLES];
+
+// return address of the spin, found by the stack walk of its samples
+static uint64_t profile_spin_ret;
+
+/******************************************************************************
+ * @brief keep the cpu busy until a deadline
+ * @param duration in us
+ * @return None
+ ******************************************************************************/
+static void __attribute__((noinline)) profile_spin(uint64_t duration) {
+  uint64_t end = timer_arch_get_time() + duration * TIMER_ARCH_TICKS_PER_US;
+
+  profile_spin_ret = (uint64_t)__builtin_return_address(0);
+
+  while (timer_arch_get_time() < end) {
+  }
+}
+
+/******************************************************************************
+ * @brief drop the samples of a hart
+ * @param hart which has taken the samples
+ * @return None
+ ******************************************************************************/
+static void profile_drain(uint64_t hart) {
+  while (profile_read(hart, profile_samples, CONFIG_PROFILE_SAMPLES)) {
+  }
+}
+
+/******************************************************************************
+ * @brief check the samples taken while the task spins
+ * @param None
+ * @return None
+ ******************************************************************************/
+void profile_thread(void) {
+  task_t  *self    = ax_task_self();
+  uint64_t tid     = task_get_tid(self);
+  uint64_t hart    = self->hart;
+  uint64_t nb_self = 0;
+  bool     walked  = false;
+  uint64_t nb;
+
+  profile_drain(hart);
+
+  TEST_ASSERT(profile_start() == K_OK);
+  // a second start doesn't arm an another timer
+  TEST_ASSERT(profile_start() == K_OK);
+  profile_spin(PROFILE_SPIN);
+  profile_stop();
+
+  nb = profile_read(hart, profile_samples, CONFIG_PROFILE_SAMPLES);
+  TEST_ASSERT(nb > 0);
+
+  for (uint64_t i = 0; i < nb; i++) {
+    profile_sample_t *sample = &profile_samples[i];
+
+    TEST_ASSERT(sample->hart == hart);
+    TEST_ASSERT(sample->depth <= PROFILE_DEPTH);
+
+    if (sample->task_id != tid) {
+      continue;
+    }
+
+    nb_self += 1;
+    for (uint64_t depth = 0; depth < sample->depth; depth++) {
+      walked |= sample->callers[depth] == profile_spin_ret;
+    }
+  }
+
+  // the spin is interrupted at each period, the walk finds its caller
+  TEST_ASSERT(nb_self > PROFILE_SPIN_PERIODS / 2);
+  TEST_ASSERT(walked);
+
+  // nothing is sampled once stopped
+  ax_task_sleep_for(2 * CONFIG_PROFILE_PERIOD_US);
+  profile_drain(hart);
+  ax_task_sleep_for(4 * CONFIG_PROFILE_PERIOD_US);
+  TEST_ASSERT(profile_read(hart, profile_samples, CONFIG_PROFILE_SAMPLES) ==
+              0);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("profile_thread", profile_thread, profile_thread_stack, 3)
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "processor.h"
+#include "test.h"
+#include "timer_arch.h"
+
+#define SMP_SERVER_HART 1
+#define SMP_SERVER_PRIO 4
+
+#define SMP_NB_CALLS      8
+#define SMP_BULK_NB_WORDS 16
+#define SMP_CALL_END      0xFFFFFFFF
+
+// bounded wait for the server, in machine timer ticks
+#define SMP_CHANNEL_TIMEOUT (100000 * TIMER_ARCH_TICKS_PER_US)
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t smp_channel_stack;
+stack_t smp_server_stack;
+
+static bool smp_server_done = false;
+
+/******************************************************************************
+ * @brief server pinned to a secondary hart, its reply to odd requests is
+ * longer than the registers
+ * @param None
+ * @return None
+ ******************************************************************************/
+void smp_server_thread(void) {
+  uint64_t reply[SMP_BULK_NB_WORDS];
+  uint64_t reply_len = 0;
+  uint64_t request;
+  uint64_t request_len;
+  uint64_t chan_handler;
+
+  ax_channel_create(&chan_handler, "smp_channel");
+
+  // there is no caller yet, only wait for the first request
+  request_len = sizeof(request);
+  ax_channel_reply_wait(chan_handler, reply, reply_len, &request,
+                        &request_len);
+
+  while (request != SMP_CALL_END) {
+    // the server is never moved to the hart of its callers
+    TEST_ASSERT(hart_id_get() == SMP_SERVER_HART);
+    TEST_ASSERT(request_len == sizeof(request));
+
+    for (uint64_t i = 0; i < SMP_BULK_NB_WORDS; i++) {
+      reply[i] = request + i + 1;
+    }
+
+    reply_len = (request % 2) ? sizeof(reply) : sizeof(uint64_t);
+
+    request_len = sizeof(request);
+    ax_channel_reply_wait(chan_handler, reply, reply_len, &request,
+                          &request_len);
+  }
+
+  // the last request is a plain message, there is no one to reply to
+  TEST_ASSERT(hart_id_get() == SMP_SERVER_HART);
+  __atomic_store_n(&smp_server_done, true, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ * @brief busy wait until a condition flag is set
+ * @param flag to wait for
+ * @return true if the flag has been set before the timeout
+ ******************************************************************************/
+static bool smp_channel_wait(bool *flag) {
+  uint64_t deadline = timer_arch_get_time() + SMP_CHANNEL_TIMEOUT;
+
+  while (!__atomic_load_n(flag, __ATOMIC_ACQUIRE)) {
+    if (timer_arch_get_time() > deadline) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief call a server running on an another hart
+ * @param None
+ * @return None
+ ******************************************************************************/
+void smp_channel(void) {
+  uint64_t reply[SMP_BULK_NB_WORDS];
+  uint64_t reply_len;
+  uint64_t request;
+  uint64_t chan_handler;
+  uint64_t deadline = timer_arch_get_time() + SMP_CHANNEL_TIMEOUT;
+  bool     found    = false;
+
+  TEST_ASSERT(ax_task_create_on("smp_server", smp_server_thread,
+                                &smp_server_stack, sizeof(smp_server_stack),
+                                SMP_SERVER_PRIO, SMP_SERVER_HART) != NULL);
+
+  // the server creates its channel in parallel
+  while (!found && timer_arch_get_time() < deadline) {
+    found = ax_channel_get(&chan_handler, "smp_channel") == K_OK;
+  }
+  TEST_ASSERT(found);
+
+  for (request = 0; found && request < SMP_NB_CALLS; request++) {
+    reply_len = sizeof(reply);
+    TEST_ASSERT(ax_channel_call(chan_handler, &request, sizeof(request),
+                                reply, &reply_len) == K_OK);
+    TEST_ASSERT(hart_id_get() == 0);
+
+    if (request % 2) {
+      TEST_ASSERT(reply_len == sizeof(reply));
+      TEST_ASSERT(reply[SMP_BULK_NB_WORDS - 1] ==
+                  request + SMP_BULK_NB_WORDS);
+    } else {
+      TEST_ASSERT(reply_len == sizeof(uint64_t));
+    }
+
+    TEST_ASSERT(reply[0] == request + 1);
+  }
+
+  if (found) {
+    // the message is deposited, the sender doesn't wait for the server
+    request = SMP_CALL_END;
+    TEST_ASSERT(ax_channel_snd(chan_handler, &request, sizeof(request)) ==
+                K_OK);
+    TEST_ASSERT(smp_channel_wait(&smp_server_done));
+  }
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("smp_channel", smp_channel, smp_channel_stack, 3)
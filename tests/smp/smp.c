@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "processor.h"
+#include "test.h"
+#include "timer_arch.h"
+
+#define SMP_REMOTE_HART 1
+#define SMP_REMOTE_PRIO 4
+
+// the mover waits behind the spinner on the remote hart until it's stolen
+#define SMP_SPINNER_PRIO 5
+#define SMP_STEAL_HART   2
+#define SMP_MOVE_HART    3
+
+#define SMP_NOTIFY_BIT (1UL << 0)
+
+// bounded wait for the remote task, in machine timer ticks
+#define SMP_TIMEOUT (100000 * TIMER_ARCH_TICKS_PER_US)
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t smp_thread_stack;
+stack_t smp_remote_stack;
+stack_t smp_affinity_stack;
+stack_t smp_spinner_stack;
+stack_t smp_mover_stack;
+stack_t smp_destroy_stack;
+stack_t smp_victim_stack;
+
+static uint64_t smp_remote_hart;
+static uint64_t smp_step = 0;
+static bool     smp_spin = true;
+static uint64_t smp_count = 0;
+
+/******************************************************************************
+ * @brief busy wait until the remote task reaches a step
+ * @param step to reach
+ * @return true if the step has been reached before the timeout
+ ******************************************************************************/
+static bool smp_wait_step(uint64_t step) {
+  uint64_t deadline = timer_arch_get_time() + SMP_TIMEOUT;
+
+  // the calling task never leaves the cpu, the remote task must run in
+  // parallel on its own hart
+  while (__atomic_load_n(&smp_step, __ATOMIC_ACQUIRE) < step) {
+    if (timer_arch_get_time() > deadline) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief task created on a secondary hart
+ * @param None
+ * @return None
+ ******************************************************************************/
+void smp_remote_thread(void) {
+  // STEP 1
+  smp_remote_hart = hart_id_get();
+  __atomic_store_n(&smp_step, 1, __ATOMIC_RELEASE);
+
+  // STEP 2, woken up by a task running on hart 0
+  ax_wait(SMP_NOTIFY_BIT);
+  TEST_ASSERT(hart_id_get() == SMP_REMOTE_HART);
+  __atomic_store_n(&smp_step, 2, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ * @brief task keeping the remote hart busy
+ * @param None
+ * @return None
+ ******************************************************************************/
+void smp_spinner_thread(void) {
+  while (__atomic_load_n(&smp_spin, __ATOMIC_ACQUIRE)) {
+  }
+}
+
+/******************************************************************************
+ * @brief task moved between harts by its affinity
+ * @param None
+ * @return None
+ ******************************************************************************/
+void smp_mover_thread(void) {
+  // STEP 1, stolen by an idle hart
+  smp_remote_hart = hart_id_get();
+  __atomic_store_n(&smp_step, 1, __ATOMIC_RELEASE);
+
+  // STEP 2, moved while it's blocked
+  ax_wait(SMP_NOTIFY_BIT);
+  smp_remote_hart = hart_id_get();
+  __atomic_store_n(&smp_step, 2, __ATOMIC_RELEASE);
+}
+
+/******************************************************************************
+ * @brief task destroyed while it runs on the remote hart
+ * @param None
+ * @return None
+ ******************************************************************************/
+void smp_victim_thread(void) {
+  // STEP 1
+  __atomic_store_n(&smp_step, 1, __ATOMIC_RELEASE);
+
+  while (true) {
+    __atomic_add_fetch(&smp_count, 1, __ATOMIC_RELEASE);
+  }
+}
+
+/******************************************************************************
+ * @brief busy wait until the victim task has left the cpu
+ * @param None
+ * @return true if the counter of the victim has stopped before the timeout
+ ******************************************************************************/
+static bool smp_wait_frozen(void) {
+  uint64_t deadline = timer_arch_get_time() + SMP_TIMEOUT;
+  uint64_t count    = __atomic_load_n(&smp_count, __ATOMIC_ACQUIRE);
+  uint64_t stable   = 0;
+
+  // the counter must stay still for a while, not only between two reads
+  while (stable < 1000) {
+    if (timer_arch_get_time() > deadline) {
+      return false;
+    }
+
+    if (__atomic_load_n(&smp_count, __ATOMIC_ACQUIRE) == count) {
+      stable++;
+    } else {
+      count  = __atomic_load_n(&smp_count, __ATOMIC_ACQUIRE);
+      stable = 0;
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief busy wait until a task is blocked
+ * @param task to wait for
+ * @return true if the task has blocked before the timeout
+ ******************************************************************************/
+static bool smp_wait_blocked(task_t *task) {
+  uint64_t deadline = timer_arch_get_time() + SMP_TIMEOUT;
+
+  while (__atomic_load_n(&task->state, __ATOMIC_ACQUIRE) != BLOCKED) {
+    if (timer_arch_get_time() > deadline) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/******************************************************************************
+ * @brief check tasks running on a secondary hart
+ * @param None
+ * @return None
+ ******************************************************************************/
+void smp_thread(void) {
+  task_t *remote;
+
+  TEST_ASSERT(hart_id_get() == 0);
+
+  // there is no such hart
+  TEST_ASSERT(ax_task_create_on("smp_none", smp_remote_thread,
+                                &smp_remote_stack, sizeof(smp_remote_stack),
+                                SMP_REMOTE_PRIO, CONFIG_HART_MAX_NB) == NULL);
+
+  // the higher priority task doesn't preempt this one, it runs on its hart
+  remote = ax_task_create_on("smp_remote", smp_remote_thread,
+                             &smp_remote_stack, sizeof(smp_remote_stack),
+                             SMP_REMOTE_PRIO, SMP_REMOTE_HART);
+  TEST_ASSERT(remote != NULL);
+  TEST_ASSERT(smp_wait_step(1));
+  TEST_ASSERT(smp_remote_hart == SMP_REMOTE_HART);
+
+  // the remote task is woken up with an inter-processor interrupt
+  ax_notify(remote, SMP_NOTIFY_BIT);
+  TEST_ASSERT(smp_wait_step(2));
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("smp_thread", smp_thread, smp_thread_stack, 3)
+
+/******************************************************************************
+ * @brief check task affinities and work stealing
+ * @param None
+ * @return None
+ ******************************************************************************/
+void smp_affinity(void) {
+  task_t *mover;
+
+  smp_step = 0;
+
+  // the mask holds no existing hart
+  TEST_ASSERT(ax_task_set_affinity(ax_task_self(),
+                                   TASK_AFFINITY_HART(CONFIG_HART_MAX_NB)) ==
+              K_ERROR);
+
+  // the remote hart is kept busy by a pinned task
+  TEST_ASSERT(ax_task_create_on("smp_spinner", smp_spinner_thread,
+                                &smp_spinner_stack, sizeof(smp_spinner_stack),
+                                SMP_SPINNER_PRIO, SMP_REMOTE_HART) != NULL);
+
+  // the mover waits behind the spinner as long as it's pinned
+  mover = ax_task_create_on("smp_mover", smp_mover_thread, &smp_mover_stack,
+                            sizeof(smp_mover_stack), SMP_REMOTE_PRIO,
+                            SMP_REMOTE_HART);
+  TEST_ASSERT(mover != NULL);
+  TEST_ASSERT(smp_step == 0);
+
+  // once allowed, the idle hart steals it from the busy one
+  TEST_ASSERT(ax_task_set_affinity(mover,
+                                   TASK_AFFINITY_HART(SMP_REMOTE_HART) |
+                                       TASK_AFFINITY_HART(SMP_STEAL_HART)) ==
+              K_OK);
+  TEST_ASSERT(smp_wait_step(1));
+  TEST_ASSERT(smp_remote_hart == SMP_STEAL_HART);
+
+  // a blocked task is woken up on the hart of its new affinity
+  TEST_ASSERT(smp_wait_blocked(mover));
+  TEST_ASSERT(ax_task_set_affinity(mover, TASK_AFFINITY_HART(SMP_MOVE_HART)) ==
+              K_OK);
+  ax_notify(mover, SMP_NOTIFY_BIT);
+  TEST_ASSERT(smp_wait_step(2));
+  TEST_ASSERT(smp_remote_hart == SMP_MOVE_HART);
+
+  __atomic_store_n(&smp_spin, false, __ATOMIC_RELEASE);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("smp_affinity", smp_affinity, smp_affinity_stack, 3)
+
+/******************************************************************************
+ * @brief check a task destroyed while it runs on an another hart
+ * @param None
+ * @return None
+ ******************************************************************************/
+void smp_destroy(void) {
+  task_t  *victim;
+  uint64_t count;
+
+  smp_step = 0;
+
+  victim = ax_task_create_on("smp_victim", smp_victim_thread,
+                             &smp_victim_stack, sizeof(smp_victim_stack),
+                             SMP_REMOTE_PRIO, SMP_REMOTE_HART);
+  TEST_ASSERT(victim != NULL);
+  TEST_ASSERT(smp_wait_step(1));
+
+  // the victim is switched out by its hart before its memory is reused
+  ax_task_destroy(victim);
+  TEST_ASSERT(smp_wait_frozen());
+  count    = __atomic_load_n(&smp_count, __ATOMIC_ACQUIRE);
+  smp_step = 0;
+
+  // its control block and its stack are given to a new task
+  TEST_ASSERT(ax_task_create_on("smp_remote", smp_remote_thread,
+                                &smp_victim_stack, sizeof(smp_victim_stack),
+                                SMP_REMOTE_PRIO, SMP_REMOTE_HART) != NULL);
+  TEST_ASSERT(smp_wait_step(1));
+  TEST_ASSERT(smp_remote_hart == SMP_REMOTE_HART);
+  TEST_ASSERT(__atomic_load_n(&smp_count, __ATOMIC_ACQUIRE) == count);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("smp_destroy", smp_destroy, smp_destroy_stack, 3)
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "string.h"
+#include "test.h"
+
+#define STATS_RECEIVER_PRIO 4
+
+// the sleep is ended by the machine timer interrupt
+#define STATS_SLEEP_US 1000
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t stats_thread_stack;
+stack_t stats_receiver_stack;
+
+static task_stats_t stats_receiver;
+
+/******************************************************************************
+ * @brief find the counters of a task in the task table
+ * @param task to find
+ * @param statistics of the task
+ * @return true if the task has been found
+ ******************************************************************************/
+static bool stats_find(task_t *task, task_stats_t *stats) {
+  for (uint64_t slot = 0; slot < CONFIG_TASK_MAX_NB; slot++) {
+    if (ax_task_get_stats(slot, stats) == K_OK &&
+        stats->task_id == task_get_tid(task)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/******************************************************************************
+ * @brief receive a single message and save its own counters
+ * @param None
+ * @return None
+ ******************************************************************************/
+void stats_receiver_thread(void) {
+  uint64_t handler;
+  uint64_t msg;
+  uint64_t len = sizeof(msg);
+
+  ax_channel_create(&handler, "stats_channel");
+  ax_channel_rcv(handler, &msg, &len);
+  stats_find(ax_task_self(), &stats_receiver);
+  ax_channel_destroy(handler);
+}
+
+/******************************************************************************
+ * @brief check the counters of a task around a sleep and a message
+ * @param None
+ * @return None
+ ******************************************************************************/
+void stats_thread(void) {
+  task_t      *self = ax_task_self();
+  task_stats_t before;
+  task_stats_t after;
+  uint64_t     handler;
+  uint64_t     msg = 0;
+
+  // free and missing slots are not read
+  TEST_ASSERT(ax_task_get_stats(CONFIG_TASK_MAX_NB, &before) == K_ERROR);
+
+  TEST_ASSERT(stats_find(self, &before));
+  TEST_ASSERT(strcmp(before.name, "stats_thread") == 0);
+  TEST_ASSERT(before.state == RUNNING);
+  TEST_ASSERT(before.runtime > 0);
+
+  // a sleep is a voluntary switch
+  ax_task_sleep_for(STATS_SLEEP_US);
+
+  TEST_ASSERT(stats_find(self, &after));
+  TEST_ASSERT(after.switches > before.switches);
+  TEST_ASSERT(after.preemptions == before.preemptions);
+  TEST_ASSERT(after.runtime > before.runtime);
+  TEST_ASSERT(after.cycles > before.cycles);
+
+  // the receiver waits for the message, it preempts the sender
+  ax_task_create("stats_receiver", stats_receiver_thread,
+                 &stats_receiver_stack, sizeof(stats_receiver_stack),
+                 STATS_RECEIVER_PRIO);
+  ax_task_yield();
+  TEST_ASSERT(ax_channel_get(&handler, "stats_channel") == K_OK);
+
+  TEST_ASSERT(stats_find(self, &before));
+  ax_channel_snd(handler, &msg, sizeof(msg));
+  TEST_ASSERT(stats_find(self, &after));
+
+  TEST_ASSERT(after.ipc_sent == before.ipc_sent + 1);
+  TEST_ASSERT(after.ipc_received == before.ipc_received);
+  TEST_ASSERT(after.preemptions > before.preemptions);
+  TEST_ASSERT(after.ready_time > before.ready_time);
+  TEST_ASSERT(after.ready_time >= after.ready_max);
+
+  TEST_ASSERT(stats_receiver.ipc_received == 1);
+  TEST_ASSERT(stats_receiver.ipc_sent == 0);
+  TEST_ASSERT(stats_receiver.prio == STATS_RECEIVER_PRIO);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("stats_thread", stats_thread, stats_thread_stack, 3)
@@ -18,79 +18,295 @@
 #include "include/test.h"
 
 #include "app.h"
+#include "mutex.h"
 #include "printf.h"
+#include "smp.h"
+#include "timer_arch.h"
+
+#ifndef CONFIG_TEST_TIMEOUT_MS
+#define CONFIG_TEST_TIMEOUT_MS 10000
+#endif
+
+// time given to a test to send its end word, in machine timer ticks
+#define TEST_TIMEOUT (CONFIG_TEST_TIMEOUT_MS * 1000 * TIMER_ARCH_TICKS_PER_US)
+
+// the watchdog preempts any test of its hart to destroy a hung one
+#define TEST_WATCHDOG_PRIO 250
+
+// the serial tests run on the hart of the engine
+#define TEST_SERIAL_HART 0
+
+// end word of a test destroyed by the watchdog
+#define TEST_TIMEOUT_WORD 0
+
+/*******************************************************************************
+ * @struct test_slot_t
+ * @brief test running on a hart, NULL if the hart is free
+ ******************************************************************************/
+typedef struct {
+  test_info_t *test;
+  task_t      *task;
+  uint64_t     deadline;
+} test_slot_t;
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
-stack_t       test_engine_stack;
-static bool_t test_error   = false;
-uint64_t      tests_passed = 0;
-uint64_t      tests_failed = 0;
+stack_t  test_engine_stack;
+stack_t  test_watchdog_stack;
+uint64_t tests_passed = 0;
+uint64_t tests_failed = 0;
+
+// the errors are set by the tasks of the test running on each hart
+static bool_t      test_errors[CONFIG_HART_MAX_NB];
+static test_slot_t test_slots[CONFIG_HART_MAX_NB];
+static uint64_t    tests_running = 0;
+static bool_t      tests_done    = false;
+static uint64_t   *test_next;
+
+// the engine and the watchdog update the slots under the mutex
+static mutex_t test_mutex;
 
 extern uint64_t _tests_start;
 extern uint64_t _tests_end;
 
+// the tests send their end word on a static channel, it exists before any
+// test runs
+REGISTER_CHANNEL(test_channel, "test_channel")
+
+/******************************************************************************
+ * @brief find a hart to run a test on
+ *
+ * A serial test waits for all the running tests to complete, the following
+ * tests wait for it. The parallel tests take the free harts from the last
+ * one, hart 0 is shared with the engine.
+ *
+ * @param test to run
+ * @return hart, or CONFIG_HART_MAX_NB if the test must wait
+ ******************************************************************************/
+static uint64_t test_find_hart(test_info_t *test) {
+  if (!test->parallel) {
+    return tests_running ? CONFIG_HART_MAX_NB : TEST_SERIAL_HART;
+  }
+
+  if (test_slots[TEST_SERIAL_HART].test != NULL &&
+      !test_slots[TEST_SERIAL_HART].test->parallel) {
+    return CONFIG_HART_MAX_NB;
+  }
+
+  for (uint64_t hart = CONFIG_HART_MAX_NB; hart-- > 0;) {
+    if (test_slots[hart].test == NULL && smp_is_online(hart)) {
+      return hart;
+    }
+  }
+
+  return CONFIG_HART_MAX_NB;
+}
+
+/******************************************************************************
+ * @brief display the result of all tests
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void test_report(void) {
+  tests_done = true;
+
+  // all registered tests have been runned
+  if (tests_failed) {
+    printf("ATE - FAILED - %d passed - %d failed\r\n", tests_passed,
+           tests_failed);
+  } else {
+    printf("ATE - PASSED - %d passed - %d failed\r\n", tests_passed,
+           tests_failed);
+  }
+}
+
+/******************************************************************************
+ * @brief start the next tests while they find a free hart
+ *
+ * The caller must hold the test mutex.
+ *
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void test_start(void) {
+  test_info_t *test;
+  test_slot_t *slot;
+  uint64_t     hart;
+
+  for (; test_next < &_tests_end; test_next += 1) {
+    // get the test descriptor from the current pointer
+    test = (test_info_t *)*test_next;
+    hart = test_find_hart(test);
+    if (hart == CONFIG_HART_MAX_NB) {
+      return;
+    }
+
+    // a serial test may set errors from any hart
+    for (uint64_t index = 0; index < CONFIG_HART_MAX_NB; index++) {
+      if (index == hart || !test->parallel) {
+        test_errors[index] = false;
+      }
+    }
+
+    // create a task for the test, its helpers inherit the hart
+    slot       = &test_slots[hart];
+    slot->task = ax_task_create_on(test->name, test->entry, test->stack,
+                                   test->stack_size, test->prio, hart);
+    if (slot->task == NULL) {
+      tests_failed += 1;
+      printf("ATE - %s - failed\r\n", test->name);
+      continue;
+    }
+
+    slot->test     = test;
+    slot->deadline = timer_arch_get_time() + TEST_TIMEOUT;
+    tests_running += 1;
+  }
+
+  if (!tests_running && !tests_done) {
+    test_report();
+  }
+}
+
+/******************************************************************************
+ * @brief destroy the test of a hart and display its result
+ *
+ * The caller must hold the test mutex.
+ *
+ * @param hart of the test
+ * @param end word sent by the test, or TEST_TIMEOUT_WORD
+ * @return None
+ ******************************************************************************/
+static void test_complete(uint64_t hart, uint64_t end_word) {
+  test_slot_t *slot  = &test_slots[hart];
+  bool_t       error = end_word != TEST_END_WORD;
+
+  for (uint64_t index = 0; index < CONFIG_HART_MAX_NB; index++) {
+    if (index == hart || !slot->test->parallel) {
+      error |= test_errors[index];
+    }
+  }
+
+  // clean up the task
+  ax_task_destroy(slot->task);
+
+  if (end_word == TEST_TIMEOUT_WORD) {
+    tests_failed += 1;
+    printf("ATE - %s - timeout\r\n", slot->test->name);
+  } else if (error) {
+    tests_failed += 1;
+    printf("ATE - %s - failed\r\n", slot->test->name);
+  } else {
+    tests_passed += 1;
+    printf("ATE - %s - passed\r\n", slot->test->name);
+  }
+
+  slot->test     = NULL;
+  slot->task     = NULL;
+  tests_running -= 1;
+}
+
+/******************************************************************************
+ * @brief destroy the tests which didn't end before their deadline
+ *
+ * The watchdog sleeps until the earliest deadline, the tests started meanwhile
+ * get later ones. The helper tasks of a destroyed test are left running.
+ *
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void test_watchdog(void) {
+  uint64_t now;
+  uint64_t deadline;
+
+  while (!tests_done) {
+    mutex_lock(&test_mutex);
+
+    now      = timer_arch_get_time();
+    deadline = now + TEST_TIMEOUT;
+
+    for (uint64_t hart = 0; hart < CONFIG_HART_MAX_NB; hart++) {
+      if (test_slots[hart].test == NULL) {
+        continue;
+      }
+
+      if (test_slots[hart].deadline <= now) {
+        test_complete(hart, TEST_TIMEOUT_WORD);
+      } else if (test_slots[hart].deadline < deadline) {
+        deadline = test_slots[hart].deadline;
+      }
+    }
+
+    // the engine may wait for a test which will never end
+    test_start();
+
+    mutex_unlock(&test_mutex);
+
+    ax_task_sleep_until(deadline / TIMER_ARCH_TICKS_PER_US + 1);
+  }
+}
+
 /******************************************************************************
  * @brief test scheduling routine
+ *
+ * The results are displayed as the tests complete, a test which doesn't end
+ * before its deadline is destroyed by the watchdog and counted as failed.
+ *
  * @param None
  * @return None
  ******************************************************************************/
 void test_engine(void) {
-  uint64_t test_chan_handler;
-  uint64_t test_data     = 0;
-  uint64_t test_data_len = 0;
+  uint64_t test_data[2];
+  uint64_t test_data_len;
 
   printf("ATE - Anckor test engine\r\n");
 
-  // create a channel to receive tests end messages
-  ax_channel_create(&test_chan_handler, "test_channel");
+  mutex_init(&test_mutex);
 
   // iterate over all tests descriptors saved in the section(.data.tests)
-  for (uint64_t *test_pt = &_tests_start; test_pt < &_tests_end; test_pt += 1) {
-    // get the test descriptor from the current pointer
-    test_info_t *test = (test_info_t *)*test_pt;
-    // create a task for the test
-    ax_task_create(test->name, test->entry, test->stack, test->prio);
+  test_next = &_tests_start;
 
-    // block until the thread sends us the TEST_END_WORD
-    ax_channel_rcv(test_chan_handler, &test_data, &test_data_len);
+  mutex_lock(&test_mutex);
+  test_start();
+  mutex_unlock(&test_mutex);
 
-    if (test_data != TEST_END_WORD) test_error = true;
-    // reset trigger word
-    test_data = 0;
+  ax_task_create("test_watchdog", test_watchdog, &test_watchdog_stack,
+                 sizeof(test_watchdog_stack), TEST_WATCHDOG_PRIO);
 
-    // clean up the task
-    ax_task_destroy((task_t *)test->stack);
+  while (!tests_done) {
+    // block until a test sends us the TEST_END_WORD
+    test_data[1]  = 0;
+    test_data_len = sizeof(test_data);
+    ax_channel_rcv(test_channel.handler, test_data, &test_data_len);
 
-    // when the test returns, display its result
-    if (test_error) {
-      tests_failed += 1;
-      printf("ATE - %s - failed\r\n", test->name);
-    } else {
-      tests_passed += 1;
-      printf("ATE - %s - passed\r\n", test->name);
+    mutex_lock(&test_mutex);
+
+    // a test destroyed by the watchdog is no longer in its slot
+    for (uint64_t hart = 0; hart < CONFIG_HART_MAX_NB; hart++) {
+      if (test_slots[hart].test != NULL &&
+          (uint64_t)test_slots[hart].task == test_data[1]) {
+        test_complete(hart, test_data[0]);
+        break;
+      }
     }
-  }
 
-  // all registered tests have been runned
-  if (tests_failed) {
-    printf("ATE - FAILED - %d passed - %d failed\r\n", tests_passed,
-           tests_failed);
-  } else {
-    printf("ATE - PASSED - %d passed - %d failed\r\n", tests_passed,
-           tests_failed);
+    test_start();
+
+    mutex_unlock(&test_mutex);
   }
 }
 
 /******************************************************************************
- * @brief set test_error
+ * @brief set the error of the test running on the hart of the caller
  * @param bool_t test error state
  * @return None
  ******************************************************************************/
 void test_set_error(bool_t error_state) {
-  test_error = error_state;
+  test_errors[ax_task_self()->hart] = error_state;
 }
 
-// define max priority for the test engine thread
-REGISTER_APP("test_engine", test_engine, test_engine_stack, 2);
\ No newline at end of file
+// define min priority for the test engine thread, the serial tests rely on
+// the priority rules of a single processor and run on hart 0
+REGISTER_APP_ON("test_engine", test_engine, test_engine_stack, 2,
+                TEST_SERIAL_HART);
@@ -26,7 +26,8 @@
 stack_t main_thread_stack;
 stack_t second_thread_stack;
 
-static uint8_t test_step = 0;
+static uint8_t test_step   = 0;
+static task_t *main_thread = NULL;
 
 /******************************************************************************
  * @brief get into the second thread and return to the main one
@@ -46,7 +47,7 @@ void second_thread(void) {
   TEST_ASSERT(test_step >= 3)
 
   // return from the second thread
-  ax_task_wakeup((task_t *)main_thread_stack);
+  ax_task_wakeup(main_thread);
 
   ax_task_yield();
 
@@ -62,11 +63,13 @@ void second_thread(void) {
  ******************************************************************************/
 void threads_test_thread(void) {
   // STEP 1
-  test_step += 1;
+  test_step  += 1;
+  main_thread = ax_task_self();
   TEST_ASSERT(test_step >= 1)
 
   // create the second thread
-  ax_task_create("second_thread", second_thread, &second_thread_stack, 4);
+  ax_task_create("second_thread", second_thread, &second_thread_stack,
+                 sizeof(second_thread_stack), 4);
 
   // switch from the main thread to the second thread
   ax_task_sleep();
@@ -78,4 +81,5 @@ void threads_test_thread(void) {
   TEST_END()
 }
 
-REGISTER_TEST("threads_test", threads_test_thread, main_thread_stack, 5)
\ No newline at end of file
+REGISTER_TEST_PARALLEL("threads_test", threads_test_thread, main_thread_stack,
+                       5)
\ No newline at end of file
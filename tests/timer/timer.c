@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "ax_syscall.h"
+#include "test.h"
+#include "timer_arch.h"
+
+#define NB_PERIODIC_TASK  3
+#define NB_PERIODIC_LOOP  5
+#define PERIODIC_PRIO     6
+#define MAX_LATENCY_IN_US 2000UL
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t timer_thread_stack;
+stack_t periodic_thread_stack[NB_PERIODIC_TASK];
+
+static const uint64_t periodic_period_in_us[NB_PERIODIC_TASK] = {
+    20000UL,
+    30000UL,
+    50000UL,
+};
+
+static uint64_t periodic_index = 0;
+static uint64_t periodic_done  = 0;
+
+/******************************************************************************
+ * @brief read the machine timer in us
+ * @param None
+ * @return current date in us
+ ******************************************************************************/
+static uint64_t timer_test_get_date() {
+  return timer_arch_ticks_to_us(timer_arch_get_time());
+}
+
+/******************************************************************************
+ * @brief periodic task, each one runs with its own period
+ * @param None
+ * @return None
+ ******************************************************************************/
+void periodic_thread(void) {
+  uint64_t period   = periodic_period_in_us[periodic_index++];
+  uint64_t deadline = timer_test_get_date();
+
+  for (uint64_t loop = 0; loop < NB_PERIODIC_LOOP; loop++) {
+    deadline += period;
+
+    ax_task_sleep_until(deadline);
+
+    // the task is never woken up before its deadline nor too late
+    uint64_t date = timer_test_get_date();
+    TEST_ASSERT((date >= deadline) && (date < deadline + MAX_LATENCY_IN_US))
+  }
+
+  periodic_done += 1;
+}
+
+/******************************************************************************
+ * @brief run several periodic tasks sharing the machine timer
+ * @param None
+ * @return None
+ ******************************************************************************/
+void timer_thread(void) {
+  for (uint64_t task = 0; task < NB_PERIODIC_TASK; task++) {
+    ax_task_create("periodic_thread", periodic_thread,
+                   &periodic_thread_stack[task],
+                   sizeof(periodic_thread_stack[task]), PERIODIC_PRIO);
+  }
+
+  // wait for all periodic tasks to end
+  while (periodic_done < NB_PERIODIC_TASK) {
+    ax_task_sleep_for(periodic_period_in_us[0]);
+  }
+
+  TEST_END()
+}
+
+REGISTER_TEST("timer_test", timer_thread, timer_thread_stack, 5)
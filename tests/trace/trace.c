@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "ax_syscall.h"
+#include "test.h"
+
+#define TRACE_HART          0
+#define TRACE_RECEIVER_PRIO 4
+#define TRACE_MSG_LEN       sizeof(uint64_t)
+
+// the sleep is ended by the machine timer interrupt
+#define TRACE_SLEEP_US 1000
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t trace_thread_stack;
+stack_t trace_receiver_stack;
+
+static trace_record_t trace_records[CONFIG_TRACE_RECORDS];
+
+/******************************************************************************
+ * @brief receive a single message
+ * @param None
+ * @return None
+ ******************************************************************************/
+void trace_receiver_thread(void) {
+  uint64_t handler;
+  uint64_t msg;
+  uint64_t len = sizeof(msg);
+
+  ax_channel_create(&handler, "trace_channel");
+  ax_channel_rcv(handler, &msg, &len);
+  ax_channel_destroy(handler);
+}
+
+/******************************************************************************
+ * @brief find a record in the records read from the ring
+ * @param number of records read
+ * @param event to find
+ * @return true if the event has been recorded
+ ******************************************************************************/
+static bool trace_find(uint64_t nb, trace_event_t event) {
+  for (uint64_t i = 0; i < nb; i++) {
+    if (trace_records[i].event == event) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/******************************************************************************
+ * @brief check the events recorded around a message and a sleep
+ * @param None
+ * @return None
+ ******************************************************************************/
+void trace_thread(void) {
+  uint64_t tid = task_get_tid(ax_task_self());
+  uint64_t handler;
+  uint64_t msg = 0;
+  uint64_t nb;
+  bool     sent = false;
+
+  // drop the events recorded since boot
+  while (ax_trace_read(TRACE_HART, trace_records, CONFIG_TRACE_RECORDS)) {
+  }
+
+  // the receiver waits for the message, it's switched to by the send
+  ax_task_create("trace_receiver", trace_receiver_thread,
+                 &trace_receiver_stack, sizeof(trace_receiver_stack),
+                 TRACE_RECEIVER_PRIO);
+  ax_task_yield();
+  TEST_ASSERT(ax_channel_get(&handler, "trace_channel") == K_OK);
+  ax_channel_snd(handler, &msg, TRACE_MSG_LEN);
+
+  ax_task_sleep_for(TRACE_SLEEP_US);
+
+  nb = ax_trace_read(TRACE_HART, trace_records, CONFIG_TRACE_RECORDS);
+  TEST_ASSERT(nb > 0);
+
+  TEST_ASSERT(trace_find(nb, TRACE_SWITCH));
+  TEST_ASSERT(trace_find(nb, TRACE_WAKEUP));
+  TEST_ASSERT(trace_find(nb, TRACE_CHANNEL_RCV));
+  TEST_ASSERT(trace_find(nb, TRACE_IRQ_ENTRY));
+  TEST_ASSERT(trace_find(nb, TRACE_IRQ_EXIT));
+
+  for (uint64_t i = 0; i < nb; i++) {
+    // records of a hart are in time order
+    TEST_ASSERT(i == 0 ||
+                trace_records[i].timestamp >= trace_records[i - 1].timestamp);
+
+    sent |= trace_records[i].event == TRACE_CHANNEL_SND &&
+            trace_records[i].task_id == tid &&
+            trace_records[i].args[0] == handler &&
+            trace_records[i].args[1] == TRACE_MSG_LEN;
+  }
+  TEST_ASSERT(sent);
+
+  // the ring is empty once read
+  TEST_ASSERT(ax_trace_read(TRACE_HART, trace_records, CONFIG_TRACE_RECORDS) <
+              nb);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("trace_thread", trace_thread, trace_thread_stack, 3)
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "test.h"
+#include "virtio.h"
+
+#define VIRTIO_TEST_BUF_SIZE 64
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t virtio_thread_stack;
+
+static virtq_mem_t virtio_test_mem;
+static virtq_t     virtio_test_queue;
+
+static uint8_t virtio_test_bufs[CONFIG_VIRTIO_QUEUE_SIZE][VIRTIO_TEST_BUF_SIZE];
+
+/******************************************************************************
+ * @brief play the device: take the next available chain and use it
+ * @param index of the next available entry seen by the device
+ * @param number of bytes written by the device
+ * @return head of the chain
+ ******************************************************************************/
+static uint16_t virtio_test_device_use(uint16_t *avail, uint32_t len) {
+  virtq_mem_t *mem  = &virtio_test_mem;
+  uint16_t     head = mem->avail.ring[*avail % CONFIG_VIRTIO_QUEUE_SIZE];
+  uint16_t     used = mem->used.idx;
+
+  mem->used.ring[used % CONFIG_VIRTIO_QUEUE_SIZE].id  = head;
+  mem->used.ring[used % CONFIG_VIRTIO_QUEUE_SIZE].len = len;
+  __atomic_store_n(&mem->used.idx, used + 1, __ATOMIC_RELEASE);
+
+  *avail += 1;
+
+  return head;
+}
+
+/******************************************************************************
+ * @brief check the chains point to the buffers, the device is notified and
+ * interrupts only when it asked for it
+ * @param None
+ * @return None
+ ******************************************************************************/
+void virtio_thread(void) {
+  virtq_mem_t *mem   = &virtio_test_mem;
+  virtq_t     *queue = &virtio_test_queue;
+  virtq_buf_t  chain[2];
+  uint16_t     avail = 0;
+  uint16_t     head;
+  void        *token;
+  uint32_t     len;
+
+  virtq_setup(queue, mem, true);
+  TEST_ASSERT(queue->nb_free == CONFIG_VIRTIO_QUEUE_SIZE);
+
+  // a chain of two buffers, the descriptors hold their addresses
+  chain[0] = (virtq_buf_t){virtio_test_bufs[0], VIRTIO_TEST_BUF_SIZE, false};
+  chain[1] = (virtq_buf_t){virtio_test_bufs[1], VIRTIO_TEST_BUF_SIZE, true};
+  TEST_ASSERT(virtq_add(queue, chain, 2, virtio_test_bufs[0]) == K_OK);
+  TEST_ASSERT(queue->nb_free == CONFIG_VIRTIO_QUEUE_SIZE - 2);
+
+  head = mem->avail.ring[0];
+  TEST_ASSERT(mem->desc[head].addr == (uint64_t)virtio_test_bufs[0]);
+  TEST_ASSERT(mem->desc[head].flags == VIRTQ_DESC_F_NEXT);
+  TEST_ASSERT(mem->desc[mem->desc[head].next].addr ==
+              (uint64_t)virtio_test_bufs[1]);
+  TEST_ASSERT(mem->desc[mem->desc[head].next].flags == VIRTQ_DESC_F_WRITE);
+
+  // the chain is not visible before it's published, the idle device waits
+  // for the first one
+  TEST_ASSERT(mem->avail.idx == 0);
+  TEST_ASSERT(virtq_publish(queue));
+  TEST_ASSERT(mem->avail.idx == 1);
+  TEST_ASSERT(!virtq_publish(queue));
+
+  // the device is busy and hasn't asked for a new notification
+  chain[0] = (virtq_buf_t){virtio_test_bufs[2], VIRTIO_TEST_BUF_SIZE, true};
+  TEST_ASSERT(virtq_add(queue, chain, 1, virtio_test_bufs[2]) == K_OK);
+  TEST_ASSERT(!virtq_publish(queue));
+
+  // once the device asks for the next chain, it's notified again
+  mem->used.avail_event = 2;
+  TEST_ASSERT(virtq_add(queue, chain, 1, virtio_test_bufs[2]) == K_OK);
+  TEST_ASSERT(virtq_publish(queue));
+
+  // the chains come back with their token, the descriptors are freed
+  TEST_ASSERT(!virtq_get_used(queue, &token, &len));
+  virtio_test_device_use(&avail, 16);
+  TEST_ASSERT(virtq_get_used(queue, &token, &len));
+  TEST_ASSERT(token == virtio_test_bufs[0] && len == 16);
+  TEST_ASSERT(queue->nb_free == CONFIG_VIRTIO_QUEUE_SIZE - 2);
+
+  // an interrupt is asked for the next used chain, unless one is already
+  // waiting
+  TEST_ASSERT(!virtq_arm(queue));
+  TEST_ASSERT(mem->avail.used_event == queue->used_idx);
+  virtio_test_device_use(&avail, 0);
+  TEST_ASSERT(virtq_arm(queue));
+
+  // without interrupt, the event is out of reach of the device
+  virtq_disarm(queue);
+  TEST_ASSERT(mem->avail.used_event == (uint16_t)(queue->used_idx - 1));
+
+  virtio_test_device_use(&avail, 0);
+  TEST_ASSERT(virtq_get_used(queue, &token, &len));
+  TEST_ASSERT(virtq_get_used(queue, &token, &len));
+  TEST_ASSERT(!virtq_get_used(queue, &token, &len));
+  TEST_ASSERT(queue->nb_free == CONFIG_VIRTIO_QUEUE_SIZE);
+
+  // the ring is full once all descriptors are given
+  for (uint64_t i = 0; i < CONFIG_VIRTIO_QUEUE_SIZE; i++) {
+    chain[0] = (virtq_buf_t){virtio_test_bufs[i], VIRTIO_TEST_BUF_SIZE, true};
+    TEST_ASSERT(virtq_add(queue, chain, 1, virtio_test_bufs[i]) == K_OK);
+  }
+  TEST_ASSERT(virtq_add(queue, chain, 1, NULL) == K_ERROR);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST_PARALLEL("virtio_thread", virtio_thread, virtio_thread_stack, 3)
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#include "ax_syscall.h"
+#include "pmp.h"
+#include "task.h"
+#include "test.h"
+
+// the user tasks run as soon as the test yields
+#define VM_USER_PRIO 4
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t vm_thread_stack;
+DECLARE_USER_STACK(vm_owner_stack, USER_STACK_SIZE);
+DECLARE_USER_STACK(vm_sibling_stack, USER_STACK_SIZE);
+DECLARE_USER_STACK(vm_intruder_stack, USER_STACK_SIZE);
+
+// data of a private region set, only mapped in its address space
+static uint8_t vm_page[PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+static task_region_t vm_region;
+
+// progress of the intruder, in the user data of the default region set
+__user_data uint64_t vm_intruder_step = 0;
+
+/******************************************************************************
+ * @brief user task of the private region set writing its data
+ * @param None
+ * @return None
+ ******************************************************************************/
+__user_text void vm_owner_thread(void) {
+  vm_page[0] = 1;
+}
+
+/******************************************************************************
+ * @brief second thread of the private region set, in the same address space
+ * @param None
+ * @return None
+ ******************************************************************************/
+__user_text void vm_sibling_thread(void) {
+  vm_page[1] = 1;
+}
+
+/******************************************************************************
+ * @brief user task of the default region set writing the private data, it's
+ * killed by the store
+ * @param None
+ * @return None
+ ******************************************************************************/
+__user_text void vm_intruder_thread(void) {
+  vm_intruder_step = 1;
+  vm_page[2]       = 1;
+  vm_intruder_step = 2;
+}
+
+/******************************************************************************
+ * @brief check each region set is an address space of its own
+ * @param None
+ * @return None
+ ******************************************************************************/
+void vm_thread(void) {
+  task_t  *task;
+  uint32_t vms_id;
+
+  // the private region set runs the user text of the default one
+  vm_region.text_start = pmp_user_region.text_start;
+  vm_region.text_end   = pmp_user_region.text_end;
+  vm_region.data_start = (uint64_t)vm_page;
+  vm_region.data_end   = (uint64_t)vm_page + sizeof(vm_page);
+
+  // the pages of the stack must be aligned
+  task = task_create_user("vm_unaligned", vm_owner_thread,
+                          vm_owner_stack + LWORD_SIZE,
+                          sizeof(vm_owner_stack) - LWORD_SIZE, VM_USER_PRIO,
+                          &vm_region);
+  TEST_ASSERT(task == NULL);
+
+  // the threads of a region set share its address space
+  task = task_create_user("vm_owner", vm_owner_thread, vm_owner_stack,
+                          sizeof(vm_owner_stack), VM_USER_PRIO, &vm_region);
+  TEST_ASSERT(task != NULL);
+  vms_id = task->task_id.vms_id;
+  TEST_ASSERT(vms_id != 0);
+
+  task = task_create_user("vm_sibling", vm_sibling_thread, vm_sibling_stack,
+                          sizeof(vm_sibling_stack), VM_USER_PRIO, &vm_region);
+  TEST_ASSERT(task != NULL);
+  TEST_ASSERT(task->task_id.vms_id == vms_id);
+
+  // a stack is mapped once in an address space
+  task = task_create_user("vm_twice", vm_sibling_thread, vm_sibling_stack,
+                          sizeof(vm_sibling_stack), VM_USER_PRIO, &vm_region);
+  TEST_ASSERT(task == NULL);
+
+  ax_task_yield();
+  TEST_ASSERT(vm_page[0] == 1);
+  TEST_ASSERT(vm_page[1] == 1);
+
+  // the private data are not mapped in the default address space
+  task = task_create_user("vm_intruder", vm_intruder_thread, vm_intruder_stack,
+                          sizeof(vm_intruder_stack), VM_USER_PRIO,
+                          &pmp_user_region);
+  TEST_ASSERT(task != NULL);
+  TEST_ASSERT(task->task_id.vms_id != 0);
+  TEST_ASSERT(task->task_id.vms_id != vms_id);
+
+  ax_task_yield();
+  TEST_ASSERT(vm_intruder_step == 1);
+  TEST_ASSERT(vm_page[2] == 0);
+
+  // end of test, return to ATE engine
+  TEST_END();
+}
+
+REGISTER_TEST("vm_thread", vm_thread, vm_thread_stack, 3)
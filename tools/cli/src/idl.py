@@ -0,0 +1,558 @@
+# Copyright (c) 2023 Qoda, engineering
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms and conditions of the GNU General Public License,
+# version 3 or later, as published by the Free Software Foundation.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+
+# You should have received copies of the GNU General Public License and
+# the GNU Lesser General Public License along with this program.  If
+# not, see https://www.gnu.org/licenses/
+
+# This script compiles an interface description into C client and server
+# stubs over the channel call primitives, see doc/api/idl.md
+
+import argparse
+import os
+import re
+import sys
+
+# message words passed in registers by a channel call, see kernel/channel.c
+IDL_MSG_REG_NB = 8
+IDL_WORD_SIZE = 8
+
+# types of the parameters and their size in bytes
+IDL_TYPES = {
+    "bool": 1,
+    "uint8_t": 1,
+    "uint16_t": 2,
+    "uint32_t": 4,
+    "int32_t": 4,
+    "uint64_t": 8,
+    "int64_t": 8,
+}
+
+IDL_TOKEN = re.compile(r"\s*(?:(//[^\n]*)|([A-Za-z_]\w*)|(\d+)|(->)|(\S))")
+
+# *******************************************************************************
+# @brief error in an interface description
+# @param None
+# @return None
+# *******************************************************************************
+class IdlError(Exception):
+    pass
+
+# *******************************************************************************
+# @brief parameter of an operation, an array when count is set
+# @param None
+# @return None
+# *******************************************************************************
+class Param:
+    def __init__(self, type, name, count):
+        self.type = type
+        self.name = name
+        self.count = count
+
+    def size(self):
+        return IDL_TYPES[self.type] * (self.count or 1)
+
+    def field(self):
+        if self.count:
+            return "%s %s[%d]" % (self.type, self.name, self.count)
+        return "%s %s" % (self.type, self.name)
+
+# *******************************************************************************
+# @brief operation of an interface, identified by its opcode
+# @param None
+# @return None
+# *******************************************************************************
+class Operation:
+    def __init__(self, name, opcode, inputs, outputs):
+        self.name = name
+        self.opcode = opcode
+        self.inputs = inputs
+        self.outputs = outputs
+
+# *******************************************************************************
+# @brief split an interface description in tokens, comments are skipped
+# @param text of the description
+# @return list of (token, line) tuples
+# *******************************************************************************
+def idl_tokenize(text):
+    tokens = []
+
+    for line, content in enumerate(text.splitlines(), 1):
+        for match in IDL_TOKEN.finditer(content):
+            if match.group(1) is None and match.group(0).strip():
+                tokens.append((match.group(0).strip(), line))
+
+    return tokens
+
+# *******************************************************************************
+# @brief parse an interface description
+#
+# interface <name> {
+#     <operation>(<type> <name>[<count>], ...) -> (<type> <name>, ...);
+# }
+#
+# The output list is optional, operations are numbered in their order.
+#
+# @param text of the description
+# @return interface name and list of operations
+# *******************************************************************************
+def idl_parse(text):
+    tokens = idl_tokenize(text)
+    index = [0]
+
+    def peek():
+        return tokens[index[0]][0] if index[0] < len(tokens) else None
+
+    def take(expected=None):
+        if index[0] >= len(tokens):
+            raise IdlError("unexpected end of file")
+        token, line = tokens[index[0]]
+        if expected is not None and token != expected:
+            raise IdlError("line %d: expected '%s', got '%s'"
+                           % (line, expected, token))
+        index[0] += 1
+        return token
+
+    def identifier():
+        line = tokens[index[0]][1] if index[0] < len(tokens) else 0
+        token = take()
+        if not re.match(r"[A-Za-z_]\w*$", token):
+            raise IdlError("line %d: expected an identifier, got '%s'"
+                           % (line, token))
+        return token
+
+    def params():
+        result = []
+        take("(")
+        while peek() != ")":
+            line = tokens[index[0]][1]
+            type = identifier()
+            if type not in IDL_TYPES:
+                raise IdlError("line %d: unknown type '%s'" % (line, type))
+            name = identifier()
+            count = None
+            if peek() == "[":
+                take("[")
+                count = int(take())
+                take("]")
+                if count == 0:
+                    raise IdlError("line %d: empty array '%s'" % (line, name))
+            result.append(Param(type, name, count))
+            if peek() != ")":
+                take(",")
+        take(")")
+        return result
+
+    take("interface")
+    name = identifier()
+    take("{")
+
+    operations = []
+    while peek() != "}":
+        op_name = identifier()
+        inputs = params()
+        outputs = []
+        if peek() == "->":
+            take("->")
+            outputs = params()
+        take(";")
+
+        names = [p.name for p in inputs + outputs]
+        if len(set(names)) != len(names):
+            raise IdlError("operation '%s': parameter names must differ"
+                           % op_name)
+        if op_name in [op.name for op in operations]:
+            raise IdlError("operation '%s' is declared twice" % op_name)
+
+        operations.append(Operation(op_name, len(operations), inputs, outputs))
+
+    take("}")
+
+    if peek() is not None:
+        raise IdlError("unexpected '%s' after the interface" % peek())
+
+    return name, operations
+
+# *******************************************************************************
+# @brief size of a message, each struct starts with a 64-bit word
+# @param parameters of the message
+# @return size in bytes, rounded up to words as the C struct
+# *******************************************************************************
+def idl_msg_size(params):
+    size = IDL_WORD_SIZE
+
+    for param in params:
+        align = IDL_TYPES[param.type]
+        size = (size + align - 1) // align * align + param.size()
+
+    return (size + IDL_WORD_SIZE - 1) // IDL_WORD_SIZE * IDL_WORD_SIZE
+
+# *******************************************************************************
+# @brief describe how a message is passed by the kernel
+# @param parameters of the message
+# @return comment text
+# *******************************************************************************
+def idl_path(params):
+    size = idl_msg_size(params)
+
+    if size <= IDL_MSG_REG_NB * IDL_WORD_SIZE:
+        return "%d bytes, passed in registers" % size
+    return "%d bytes, copied by the bulk path" % size
+
+# *******************************************************************************
+# @brief C parameter of a stub or a handler
+# @param parameter
+# @param true for an output parameter
+# @return C declaration
+# *******************************************************************************
+def idl_c_param(param, output):
+    if output:
+        return "%s *%s" % (param.type, param.name)
+    if param.count:
+        return "const %s *%s" % (param.type, param.name)
+    return "%s %s" % (param.type, param.name)
+
+# *******************************************************************************
+# @brief C parameter list of an operation
+# @param operation
+# @return C parameters, without the channel handler
+# *******************************************************************************
+def idl_c_params(op):
+    params = [idl_c_param(p, False) for p in op.inputs]
+    params += [idl_c_param(p, True) for p in op.outputs]
+    return params
+
+# *******************************************************************************
+# @brief write a struct declaration
+# @param output lines
+# @param name of the type
+# @param first word of the struct
+# @param fields
+# @return None
+# *******************************************************************************
+def idl_struct(lines, type_name, first, params):
+    lines.append("typedef struct %s {" % type_name)
+    lines.append("  %s;" % first)
+    for param in params:
+        lines.append("  %s;" % param.field())
+    lines.append("} %s;" % type_name)
+    lines.append("")
+
+# *******************************************************************************
+# @brief generate the header of an interface
+# @param interface name
+# @param operations
+# @param name of the description file
+# @return text of the header
+# *******************************************************************************
+def idl_header(name, operations, source):
+    prefix = name.upper()
+    guard = prefix + "_IDL_H"
+    lines = []
+
+    lines.append("/*")
+    lines.append(" * generated by the anckor idl compiler from %s, do not edit"
+                 % source)
+    lines.append(" */")
+    lines.append("#ifndef %s" % guard)
+    lines.append("#define %s" % guard)
+    lines.append("")
+    lines.append('#include "common.h"')
+    lines.append("")
+
+    lines.append("/" + "*" * 78)
+    lines.append(" * opcodes, the index of the operations in the dispatch table")
+    lines.append(" " + "*" * 78 + "/")
+    for op in operations:
+        lines.append("#define %s_OP_%s %d" % (prefix, op.name.upper(),
+                                              op.opcode))
+    lines.append("#define %s_OP_NB %d" % (prefix, len(operations)))
+    lines.append("")
+
+    for op in operations:
+        lines.append("// %s request: %s" % (op.name, idl_path(op.inputs)))
+        idl_struct(lines, "%s_%s_request_t" % (name, op.name),
+                   "uint64_t opcode", op.inputs)
+        lines.append("// %s reply: %s" % (op.name, idl_path(op.outputs)))
+        idl_struct(lines, "%s_%s_reply_t" % (name, op.name),
+                   "int64_t status", op.outputs)
+
+    lines.append("typedef union %s_request_t {" % name)
+    lines.append("  uint64_t opcode;")
+    for op in operations:
+        lines.append("  %s_%s_request_t %s;" % (name, op.name, op.name))
+    lines.append("} %s_request_t;" % name)
+    lines.append("")
+
+    lines.append("typedef union %s_reply_t {" % name)
+    lines.append("  int64_t status;")
+    for op in operations:
+        lines.append("  %s_%s_reply_t %s;" % (name, op.name, op.name))
+    lines.append("} %s_reply_t;" % name)
+    lines.append("")
+
+    lines.append("/" + "*" * 78)
+    lines.append(" * @struct %s_server_t" % name)
+    lines.append(" * @brief handlers of the operations, a NULL handler "
+                 "replies K_ERROR")
+    lines.append(" *")
+    lines.append(" * Input arrays point to the request and outputs to the "
+                 "reply, nothing is")
+    lines.append(" * copied by the stubs.")
+    lines.append(" " + "*" * 78 + "/")
+    lines.append("typedef struct %s_server_t {" % name)
+    for op in operations:
+        lines.append("  k_return_t (*%s)(%s);" % (op.name,
+                     ", ".join(idl_c_params(op)) or "void"))
+    lines.append("} %s_server_t;" % name)
+    lines.append("")
+
+    for op in operations:
+        lines.append("/" + "*" * 78)
+        lines.append(" * @brief call %s on the server of a channel" % op.name)
+        lines.append(" * @param channel handler")
+        for param in op.inputs:
+            lines.append(" * @param %s" % param.name)
+        for param in op.outputs:
+            lines.append(" * @param %s, written with the reply" % param.name)
+        lines.append(" * @return K_OK, or K_ERROR if the call or the handler "
+                     "failed")
+        lines.append(" " + "*" * 78 + "/")
+        lines.append("k_return_t %s_%s(%s);" % (name, op.name, ", ".join(
+            ["uint64_t"] + idl_c_params(op))))
+        lines.append("")
+
+    lines.append("/" + "*" * 78)
+    lines.append(" * @brief run the handler of a request and build its reply")
+    lines.append(" * @param handlers of the server")
+    lines.append(" * @param request received")
+    lines.append(" * @param length of the request")
+    lines.append(" * @param reply to send")
+    lines.append(" * @return length of the reply")
+    lines.append(" " + "*" * 78 + "/")
+    lines.append("uint64_t %s_dispatch(const %s_server_t *, const %s_request_t *,"
+                 % (name, name, name))
+    lines.append("    uint64_t, %s_reply_t *);" % name)
+    lines.append("")
+
+    lines.append("/" + "*" * 78)
+    lines.append(" * @brief serve the requests of a channel, never returns")
+    lines.append(" * @param channel handler")
+    lines.append(" * @param handlers of the server")
+    lines.append(" * @return none")
+    lines.append(" " + "*" * 78 + "/")
+    lines.append("void %s_serve(uint64_t, const %s_server_t *);" % (name, name))
+    lines.append("")
+
+    lines.append("#endif")
+
+    return "\n".join(lines) + "\n"
+
+# *******************************************************************************
+# @brief generate the client and server stubs of an interface
+# @param interface name
+# @param operations
+# @param name of the description file
+# @return text of the source
+# *******************************************************************************
+def idl_source(name, operations, source):
+    prefix = name.upper()
+    lines = []
+
+    lines.append("/*")
+    lines.append(" * generated by the anckor idl compiler from %s, do not edit"
+                 % source)
+    lines.append(" */")
+    lines.append('#include "%s_idl.h"' % name)
+    lines.append("")
+    lines.append('#include "ax_syscall.h"')
+    lines.append('#include "string.h"')
+    lines.append("")
+
+    # client stubs
+    for op in operations:
+        lines.append("k_return_t %s_%s(%s) {" % (name, op.name, ", ".join(
+            ["uint64_t channel"] + idl_c_params(op))))
+        lines.append("  %s_%s_request_t request;" % (name, op.name))
+        lines.append("  %s_%s_reply_t   reply;" % (name, op.name))
+        lines.append("  uint64_t reply_len = sizeof(reply);")
+        lines.append("")
+        lines.append("  request.opcode = %s_OP_%s;" % (prefix, op.name.upper()))
+        for param in op.inputs:
+            if param.count:
+                lines.append("  memcpy(request.%s, %s, sizeof(request.%s));"
+                             % (param.name, param.name, param.name))
+            else:
+                lines.append("  request.%s = %s;" % (param.name, param.name))
+        lines.append("")
+        lines.append("  if (ax_channel_call(channel, (uint64_t *)&request, "
+                     "sizeof(request),")
+        lines.append("                      (uint64_t *)&reply, &reply_len) "
+                     "!= K_OK) {")
+        lines.append("    return K_ERROR;")
+        lines.append("  }")
+        lines.append("")
+        lines.append("  if (reply_len < sizeof(reply.status) || "
+                     "reply.status != K_OK) {")
+        lines.append("    return K_ERROR;")
+        lines.append("  }")
+        if op.outputs:
+            lines.append("")
+            lines.append("  if (reply_len < sizeof(reply)) {")
+            lines.append("    return K_ERROR;")
+            lines.append("  }")
+            lines.append("")
+            for param in op.outputs:
+                if param.count:
+                    lines.append("  memcpy(%s, reply.%s, sizeof(reply.%s));"
+                                 % (param.name, param.name, param.name))
+                else:
+                    lines.append("  *%s = reply.%s;" % (param.name, param.name))
+        lines.append("")
+        lines.append("  return K_OK;")
+        lines.append("}")
+        lines.append("")
+
+    # server stubs, one per opcode
+    lines.append("typedef uint64_t (*%s_stub_t)(const %s_server_t *,"
+                 % (name, name))
+    lines.append("    const %s_request_t *, %s_reply_t *);" % (name, name))
+    lines.append("")
+
+    for op in operations:
+        args = []
+        for param in op.inputs:
+            args.append("request->%s.%s" % (op.name, param.name))
+        for param in op.outputs:
+            if param.count:
+                args.append("reply->%s.%s" % (op.name, param.name))
+            else:
+                args.append("&reply->%s.%s" % (op.name, param.name))
+
+        lines.append("static uint64_t %s_%s_stub(const %s_server_t   *server,"
+                     % (name, op.name, name))
+        lines.append("    const %s_request_t *request, %s_reply_t *reply) {"
+                     % (name, name))
+        lines.append("  if (server->%s == NULL) {" % op.name)
+        lines.append("    reply->status = K_ERROR;")
+        lines.append("    return sizeof(reply->status);")
+        lines.append("  }")
+        lines.append("")
+        lines.append("  reply->%s.status = server->%s(%s);"
+                     % (op.name, op.name, ", ".join(args)))
+        lines.append("")
+        lines.append("  return sizeof(reply->%s);" % op.name)
+        lines.append("}")
+        lines.append("")
+
+    lines.append("static const %s_stub_t %s_stubs[%s_OP_NB] = {"
+                 % (name, name, prefix))
+    for op in operations:
+        lines.append("    [%s_OP_%s] = %s_%s_stub," % (prefix, op.name.upper(),
+                                                      name, op.name))
+    lines.append("};")
+    lines.append("")
+
+    lines.append("static const uint64_t %s_request_len[%s_OP_NB] = {"
+                 % (name, prefix))
+    for op in operations:
+        lines.append("    [%s_OP_%s] = sizeof(%s_%s_request_t),"
+                     % (prefix, op.name.upper(), name, op.name))
+    lines.append("};")
+    lines.append("")
+
+    lines.append("uint64_t %s_dispatch(const %s_server_t  *server,"
+                 % (name, name))
+    lines.append("    const %s_request_t *request, uint64_t request_len,"
+                 % name)
+    lines.append("    %s_reply_t *reply) {" % name)
+    lines.append("  // an unknown or truncated request gets an error status")
+    lines.append("  if (request_len < sizeof(request->opcode) ||")
+    lines.append("      request->opcode >= %s_OP_NB ||" % prefix)
+    lines.append("      request_len < %s_request_len[request->opcode]) {"
+                 % name)
+    lines.append("    reply->status = K_ERROR;")
+    lines.append("    return sizeof(reply->status);")
+    lines.append("  }")
+    lines.append("")
+    lines.append("  return %s_stubs[request->opcode](server, request, reply);"
+                 % name)
+    lines.append("}")
+    lines.append("")
+
+    lines.append("void %s_serve(uint64_t channel, const %s_server_t *server) {"
+                 % (name, name))
+    lines.append("  %s_request_t request;" % name)
+    lines.append("  %s_reply_t   reply;" % name)
+    lines.append("  uint64_t reply_len = 0;")
+    lines.append("  uint64_t request_len;")
+    lines.append("")
+    lines.append("  // the first wait has no caller to reply to")
+    lines.append("  while (true) {")
+    lines.append("    request_len = sizeof(request);")
+    lines.append("    ax_channel_reply_wait(channel, (uint64_t *)&reply, "
+                 "reply_len,")
+    lines.append("                          (uint64_t *)&request, "
+                 "&request_len);")
+    lines.append("")
+    lines.append("    reply_len = %s_dispatch(server, &request, request_len, "
+                 "&reply);" % name)
+    lines.append("  }")
+    lines.append("}")
+
+    return "\n".join(lines) + "\n"
+
+# *******************************************************************************
+# @brief compile an interface description into <name>_idl.h and <name>_idl.c
+# @param path of the description
+# @param output directory
+# @return None
+# *******************************************************************************
+def idl_compile(path, output):
+    with open(path, "r") as idl_file:
+        name, operations = idl_parse(idl_file.read())
+
+    source = os.path.basename(path)
+    if os.path.splitext(source)[0] != name:
+        raise IdlError("interface '%s' must be described in %s.idl"
+                       % (name, name))
+
+    os.makedirs(output, exist_ok=True)
+
+    with open(os.path.join(output, name + "_idl.h"), "w") as header:
+        header.write(idl_header(name, operations, source))
+
+    with open(os.path.join(output, name + "_idl.c"), "w") as stubs:
+        stubs.write(idl_source(name, operations, source))
+
+# *******************************************************************************
+# @brief parse arguments and compile the interface
+# @param None
+# @return None
+# *******************************************************************************
+def main():
+    parser = argparse.ArgumentParser(
+        description='compile an interface description into C stubs')
+    parser.add_argument('idl',
+                        help='interface description file')
+    parser.add_argument('--output',
+                        help='directory of the generated files',
+                        default='.')
+    args = parser.parse_args()
+
+    try:
+        idl_compile(args.idl, args.output)
+    except (IdlError, ValueError) as error:
+        sys.stderr.write("%s: %s\n" % (args.idl, error))
+        sys.exit(1)
+
+if __name__ == '__main__':
+    main()
@@ -14,13 +14,32 @@
 # not, see https://www.gnu.org/licenses/
 
 import argparse
+import bisect
 import sys
 import os
+import struct
+import subprocess
 from datetime import datetime
 import git
 
 __version__ = "x.x.x"
 
+# statistics frames sent by the kernel, see kernel/include/stats.h
+STATS_FRAME_MAGIC = b"AXST"
+STATS_FRAME_VERSION = 1
+STATS_HEADER = struct.Struct("<4sBBHIIQ")
+STATS_RECORD = struct.Struct("<IBBBB16sQQQQQQQQ")
+STATS_CHECKSUM = struct.Struct("<I")
+STATS_STATES = ("READY", "RUNNING", "BLOCKED")
+STATS_LOG_LINES = 8
+
+# profile frames sent by the kernel, see kernel/include/profile.h
+PROFILE_FRAME_MAGIC = b"AXPF"
+PROFILE_FRAME_VERSION = 1
+PROFILE_DEPTH = 6
+PROFILE_SAMPLE = struct.Struct("<IHHQ" + "Q" * PROFILE_DEPTH)
+NM = "riscv64-unknown-elf-nm"
+
 # *******************************************************************************
 # @brief convert the .config file to config.mk
 # @param None
@@ -36,9 +55,13 @@ def convert_config_to_make():
 
     input_file = open(".config", "r")
     output_file = open("tools/generated/config.mk", "w+")
+    header_file = open("tools/generated/autoconf.h", "w+")
 
     module_list = "GLOBAL_MODULE_LIST := "
 
+    header_file.write("#ifndef AUTOCONF_H\n")
+    header_file.write("#define AUTOCONF_H\n\n")
+
     for line in input_file:
         line = line.lower()
         if "module" in line:
@@ -51,11 +74,20 @@ def convert_config_to_make():
                 module_list = module_list + line + ' '
         elif "config" in line:
             output_file.write(line)
+            # export kernel options to C and assembly sources
+            if line.startswith("config_") and "=" in line:
+                name, value = line.strip().split("=", 1)
+                if value == "y":
+                    value = "1"
+                header_file.write("#define " + name.upper() + " " + value + "\n")
     
     output_file.write(module_list)
 
+    header_file.write("\n#endif\n")
+
     input_file.close()
     output_file.close()
+    header_file.close()
     print("generate config.mk file")
 
 # *******************************************************************************
@@ -132,6 +164,318 @@ def run(args):
     else:
         os.system('make -f tools/make/build.mk run')
 
+# *******************************************************************************
+# @brief generate the C stubs of an interface description
+# @param None
+# @return None
+# *******************************************************************************
+def idl(args):
+    print("[IDL]")
+
+    os.system("python3 tools/cli/src/idl.py " + args.idl + " --output "
+              + args.output)
+
+# *******************************************************************************
+# @brief build the kernel core for the host and run its benchmarks or fuzzing
+# @param detect function arguments : target, --switch, --seed, --runs
+# @return None
+# *******************************************************************************
+def host(args):
+    print("[HOST]")
+
+    command = "make -f tools/make/host.mk " + args.target
+    if args.switch:
+        command += " HOST_SWITCH=" + args.switch
+    command += " HOST_FUZZ_SEED=" + str(args.seed)
+    command += " HOST_FUZZ_RUNS=" + str(args.runs)
+
+    # the exit status is the one of the runs, for the CI
+    return os.WEXITSTATUS(os.system(command))
+
+# *******************************************************************************
+# @brief split the uart output into text lines and statistics frames
+#
+# The profile frames have the same header layout, only their magic and their
+# records differ.
+#
+# @param None
+# @return None
+# *******************************************************************************
+class StatsDecoder:
+    MAGIC = STATS_FRAME_MAGIC
+    VERSION = STATS_FRAME_VERSION
+    RECORD = STATS_RECORD
+
+    def __init__(self):
+        self.buffer = b""
+        self.line = b""
+
+    # *******************************************************************************
+    # @brief decode the bytes received so far
+    # @param bytes read from the uart
+    # @return list of ("text", line) and ("frame", header, records) items
+    # *******************************************************************************
+    def feed(self, data):
+        items = []
+        self.buffer += data
+
+        while self.buffer:
+            start = self.buffer.find(self.MAGIC)
+
+            # the bytes before a frame are console output
+            if start < 0:
+                # keep a magic which may be split between two reads
+                keep = len(self.MAGIC) - 1
+                text = self.buffer[:-keep] if len(self.buffer) > keep else b""
+                self.buffer = self.buffer[len(text):]
+                self.text(text, items)
+                break
+
+            self.text(self.buffer[:start], items)
+            self.buffer = self.buffer[start:]
+
+            if len(self.buffer) < STATS_HEADER.size:
+                break
+
+            header = STATS_HEADER.unpack_from(self.buffer)
+            nb_tasks, record_size = header[3], header[5]
+            size = STATS_HEADER.size + nb_tasks * record_size
+
+            if header[1] != self.VERSION or record_size != self.RECORD.size:
+                self.text(self.buffer[:1], items)
+                self.buffer = self.buffer[1:]
+                continue
+
+            if len(self.buffer) < size + STATS_CHECKSUM.size:
+                break
+
+            # a line printed in the middle of the frame breaks its checksum
+            checksum = STATS_CHECKSUM.unpack_from(self.buffer, size)[0]
+            if sum(self.buffer[:size]) & 0xFFFFFFFF != checksum:
+                self.text(self.buffer[:1], items)
+                self.buffer = self.buffer[1:]
+                continue
+
+            records = [self.RECORD.unpack_from(self.buffer,
+                                               STATS_HEADER.size + i * record_size)
+                       for i in range(nb_tasks)]
+            items.append(("frame", header, records))
+            self.buffer = self.buffer[size + STATS_CHECKSUM.size:]
+
+        return items
+
+    # *******************************************************************************
+    # @brief cut console output into lines
+    # @param console bytes
+    # @param list of decoded items
+    # @return None
+    # *******************************************************************************
+    def text(self, data, items):
+        self.line += data
+        while b"\n" in self.line:
+            line, self.line = self.line.split(b"\n", 1)
+            # the bytes of a broken frame are not printable
+            line = line.decode("ascii", "replace").rstrip()
+            items.append(("text", "".join(c for c in line if c.isprintable())))
+
+# *******************************************************************************
+# @brief draw the task statistics of the last two frames
+# @param previous frame, or None
+# @param last frame
+# @param last console lines
+# @return None
+# *******************************************************************************
+def top_draw(previous, frame, log):
+    _, _, nb_harts, nb_tasks, timebase, _, timestamp = frame[1]
+    old = {}
+    elapsed = 0
+
+    if previous is not None:
+        old = {record[0]: record for record in previous[2]}
+        elapsed = timestamp - previous[1][6]
+
+    rows = []
+    for record in frame[2]:
+        (tid, prio, hart, state, _, name, runtime, cycles, switches,
+         preemptions, ready_time, ready_max, ipc_sent, ipc_received) = record
+        # a task without any previous record is shown since its creation
+        prev = old.get(tid, (tid, 0, 0, 0, 0, b"") + (0,) * 8)
+        runs = switches - prev[8]
+        cpu = 100.0 * (runtime - prev[6]) / elapsed if elapsed else 0.0
+        wait = (ready_time - prev[10]) / runs if runs else 0.0
+        rows.append((cpu, tid, name.split(b"\0")[0].decode("ascii", "replace"),
+                     prio, hart, STATS_STATES[state] if state < 3 else "?",
+                     runtime * 1000 // timebase, cycles - prev[7], runs,
+                     preemptions - prev[9], wait * 1000000 / timebase,
+                     ready_max * 1000000 // timebase,
+                     ipc_sent - prev[12], ipc_received - prev[13]))
+
+    # the busiest tasks first
+    rows.sort(key=lambda row: row[0], reverse=True)
+
+    out = ["\033[H\033[2J"]
+    out.append("anckor top - %d harts, %d tasks, uptime %.1f s"
+               % (nb_harts, nb_tasks, timestamp / timebase))
+    out.append("")
+    out.append("%6s %-16s %4s %4s %-8s %6s %10s %12s %6s %7s %9s %9s %6s %6s"
+               % ("TID", "NAME", "PRIO", "HART", "STATE", "CPU%", "TIME(ms)",
+                  "CYCLES", "SW", "PREEMPT", "WAIT(us)", "MAX(us)", "SND",
+                  "RCV"))
+    for row in rows:
+        out.append("%6d %-16s %4d %4d %-8s %6.1f %10d %12d %6d %7d %9.1f %9d %6d %6d"
+                   % (row[1:6] + (row[0],) + row[6:]))
+    out.append("")
+    out.extend(log)
+
+    sys.stdout.write("\n".join(out) + "\n")
+    sys.stdout.flush()
+
+# *******************************************************************************
+# @brief display the statistics dumped by the kernel until interrupted
+# @param detect function arguments : --port, --baud
+# @return None
+# *******************************************************************************
+def top(args):
+    decoder = StatsDecoder()
+    previous = None
+    log = []
+
+    # read a serial port, or the output of 'anckor run' piped to stdin
+    if args.port:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        read = lambda: port.read(4096)
+    else:
+        read = lambda: os.read(sys.stdin.fileno(), 4096)
+
+    try:
+        while True:
+            data = read()
+            if not data and not args.port:
+                break
+
+            for item in decoder.feed(data):
+                if item[0] == "text":
+                    log = (log + [item[1]])[-STATS_LOG_LINES:]
+                else:
+                    top_draw(previous, item, log)
+                    previous = item
+    except KeyboardInterrupt:
+        pass
+
+# *******************************************************************************
+# @brief split the uart output into text lines and profile frames
+# @param None
+# @return None
+# *******************************************************************************
+class ProfileDecoder(StatsDecoder):
+    MAGIC = PROFILE_FRAME_MAGIC
+    VERSION = PROFILE_FRAME_VERSION
+    RECORD = PROFILE_SAMPLE
+
+# *******************************************************************************
+# @brief function symbols of the kernel image, sorted by address
+# @param path of the kernel elf file
+# @return None
+# *******************************************************************************
+class Symbols:
+    def __init__(self, elf):
+        output = subprocess.run([NM, "-n", elf], capture_output=True,
+                                text=True, check=True).stdout
+        self.addresses = []
+        self.names = []
+
+        for line in output.splitlines():
+            fields = line.split()
+            if len(fields) == 3 and fields[1] in "tTwW":
+                self.addresses.append(int(fields[0], 16))
+                self.names.append(fields[2])
+
+    # *******************************************************************************
+    # @brief find the function holding an address
+    # @param code address
+    # @return function name, or the address if it's before the first function
+    # *******************************************************************************
+    def lookup(self, address):
+        index = bisect.bisect_right(self.addresses, address) - 1
+        return self.names[index] if index >= 0 else "0x%x" % address
+
+# *******************************************************************************
+# @brief fold a sample into a flamegraph stack, the task is the root frame
+# @param sample record
+# @param kernel symbols
+# @param task names read from the statistics frames
+# @return folded stack
+# *******************************************************************************
+def profile_fold(sample, symbols, names):
+    tid, _, depth, pc = sample[:4]
+    frames = [names.get(tid, "task-%d" % tid)]
+
+    # a return address follows the call, the call itself is one byte before
+    frames += [symbols.lookup(ra - 1) for ra in reversed(sample[4:4 + depth])]
+    frames.append(symbols.lookup(pc))
+
+    return ";".join(frames)
+
+# *******************************************************************************
+# @brief collect the samples dumped by the kernel and write them as folded
+# stacks once interrupted, or at the end of stdin
+#
+# The output is the input of flamegraph.pl. The tasks are named after the
+# statistics frames when the kernel dumps them too.
+#
+# @param detect function arguments : --port, --baud, --elf, --output
+# @return None
+# *******************************************************************************
+def profile(args):
+    decoder = ProfileDecoder()
+    stats = StatsDecoder()
+    symbols = Symbols(args.elf)
+    names = {}
+    stacks = {}
+    dropped = {}
+
+    # read a serial port, or the output of 'anckor run' piped to stdin
+    if args.port:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        read = lambda: port.read(4096)
+    else:
+        read = lambda: os.read(sys.stdin.fileno(), 4096)
+
+    try:
+        while True:
+            data = read()
+            if not data and not args.port:
+                break
+
+            for item in stats.feed(data):
+                if item[0] == "frame":
+                    for record in item[2]:
+                        name = record[5].split(b"\0")[0]
+                        names[record[0]] = name.decode("ascii", "replace")
+
+            for item in decoder.feed(data):
+                if item[0] == "text":
+                    sys.stderr.write(item[1] + "\n")
+                    continue
+
+                dropped[item[1][2]] = item[1][6]
+                for sample in item[2]:
+                    stack = profile_fold(sample, symbols, names)
+                    stacks[stack] = stacks.get(stack, 0) + 1
+    except KeyboardInterrupt:
+        pass
+
+    output = open(args.output, "w") if args.output else sys.stdout
+    for stack in sorted(stacks):
+        output.write("%s %d\n" % (stack, stacks[stack]))
+    if args.output:
+        output.close()
+
+    sys.stderr.write("%d samples, %d dropped\n"
+                     % (sum(stacks.values()), sum(dropped.values())))
+
 # *******************************************************************************
 # @brief find the root directory absolute path
 # @param None
@@ -228,6 +572,61 @@ def options():
                                          help='run the kernel on the target')
     run_parser.set_defaults(func=run)
 
+    # declare "idl" subcommand
+    idl_parser = subparsers.add_parser('idl',
+                                         help='generate the C stubs of an interface description')
+    idl_parser.add_argument('idl',
+                                help='interface description file')
+    idl_parser.add_argument('--output',
+                                help='directory of the generated files',
+                                default='.')
+    idl_parser.set_defaults(func=idl)
+
+    # declare "host" subcommand
+    host_parser = subparsers.add_parser('host',
+                                         help='run the benchmarks or the fuzzing of the kernel core on the host')
+    host_parser.add_argument('target',
+                                choices=['bench', 'fuzz'])
+    host_parser.add_argument('--switch',
+                                help='context switch of the host, native or ucontext',
+                                choices=['native', 'ucontext'])
+    host_parser.add_argument('--seed',
+                                help='seed of the first fuzzing run',
+                                type=int,
+                                default=1)
+    host_parser.add_argument('--runs',
+                                help='number of fuzzing runs',
+                                type=int,
+                                default=1000)
+    host_parser.set_defaults(func=host)
+
+    # declare "top" subcommand
+    top_parser = subparsers.add_parser('top',
+                                         help='display the task statistics dumped by the kernel')
+    top_parser.add_argument('--port',
+                                help='serial port of the target, stdin if not set')
+    top_parser.add_argument('--baud',
+                                help='baud rate of the serial port',
+                                type=int,
+                                default=115200)
+    top_parser.set_defaults(func=top)
+
+    # declare "profile" subcommand
+    profile_parser = subparsers.add_parser('profile',
+                                         help='fold the samples dumped by the kernel for a flamegraph')
+    profile_parser.add_argument('--port',
+                                help='serial port of the target, stdin if not set')
+    profile_parser.add_argument('--baud',
+                                help='baud rate of the serial port',
+                                type=int,
+                                default=115200)
+    profile_parser.add_argument('--elf',
+                                help='kernel image to symbolize the samples',
+                                default='build/kernel.elf')
+    profile_parser.add_argument('--output',
+                                help='file of the folded stacks, stdout if not set')
+    profile_parser.set_defaults(func=profile)
+
     return parser
 
 # *******************************************************************************
@@ -245,7 +644,7 @@ def main():
         # parse options
         args = parser.parse_args()
         # execute CLI subcommand
-        args.func(args)
+        return args.func(args)
     else:
         print("not enough arguments")
         print("please check how to use this tool with 'anckor -h' or 'anckor --help'")    
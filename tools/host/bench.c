@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+// the host headers come first, common.h defines the fixed width types as
+// macros
+#include <stdio.h>
+
+#include "host.h"
+
+#include "bench.h"
+#include "channel.h"
+#include "task.h"
+
+// the peer shares the priority of the benchmark task to yield to it
+#define BENCH_PRIO 3
+
+// the server runs as soon as a message is sent to it
+#define BENCH_SERVER_PRIO 4
+
+// a long message is copied, it doesn't fit in registers
+#define BENCH_LONG_NB_WORDS 64
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t bench_main_stack;
+stack_t bench_peer_stack;
+stack_t bench_server_stack;
+
+uint64_t bench_samples[BENCH_SAMPLES];
+uint64_t bench_nb_samples = 0;
+
+// date of the last yield to the peer
+static uint64_t bench_stamp;
+
+static uint64_t bench_request;
+static uint64_t bench_long[BENCH_LONG_NB_WORDS];
+static uint64_t bench_received[BENCH_LONG_NB_WORDS];
+
+/******************************************************************************
+ * @brief sort the samples of the running benchmark
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void bench_sort() {
+  for (uint64_t i = 1; i < bench_nb_samples; i++) {
+    uint64_t sample = bench_samples[i];
+    uint64_t j      = i;
+
+    for (; j > 0 && bench_samples[j - 1] > sample; j--) {
+      bench_samples[j] = bench_samples[j - 1];
+    }
+
+    bench_samples[j] = sample;
+  }
+}
+
+/******************************************************************************
+ * @brief print the statistics of the running benchmark
+ *
+ * The line is the one of tests/bench, the cycles are the ones of the host
+ * time stamp counter.
+ *
+ * @param benchmark name
+ * @param unit of the samples
+ * @return None
+ ******************************************************************************/
+void bench_report(const char *name, const char *unit) {
+  uint64_t sum = 0;
+
+  if (!bench_nb_samples) {
+    return;
+  }
+
+  bench_sort();
+
+  for (uint64_t i = 0; i < bench_nb_samples; i++) {
+    sum += bench_samples[i];
+  }
+
+  printf("BENCH name=%s unit=%s n=%lu min=%lu avg=%lu max=%lu p99=%lu\n", name,
+         unit, bench_nb_samples, bench_samples[0], sum / bench_nb_samples,
+         bench_samples[bench_nb_samples - 1],
+         bench_samples[bench_nb_samples * 99 / 100]);
+}
+
+/******************************************************************************
+ * @brief yield to the other task of the ping-pong until all samples are saved
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void bench_ping_pong() {
+  while (bench_nb_samples < BENCH_SAMPLES) {
+    bench_stamp = bench_cycles();
+    task_yield();
+    bench_record(bench_cycles() - bench_stamp);
+  }
+}
+
+/******************************************************************************
+ * @brief peer of the ping-pong
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void bench_peer_thread(void) {
+  bench_ping_pong();
+}
+
+/******************************************************************************
+ * @brief answer the calls, then receive the long messages
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void bench_server_thread(void) {
+  uint64_t handler;
+  uint64_t len = sizeof(bench_request);
+
+  channel_create(&handler, "bench_channel");
+
+  channel_rcv(handler, &bench_request, &len);
+
+  for (uint64_t i = 1; i < BENCH_SAMPLES; i++) {
+    len = sizeof(bench_request);
+    channel_reply_wait(handler, &bench_request, sizeof(bench_request),
+                       &bench_request, &len);
+  }
+
+  // the last reply is followed by the first long message
+  len = sizeof(bench_received);
+  channel_reply_wait(handler, &bench_request, sizeof(bench_request),
+                     bench_received, &len);
+
+  for (uint64_t i = 1; i < BENCH_SAMPLES; i++) {
+    len = sizeof(bench_received);
+    channel_rcv(handler, bench_received, &len);
+  }
+}
+
+/******************************************************************************
+ * @brief measure a yield with and without a task switch
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void bench_switch() {
+  uint64_t start;
+
+  // nothing else is ready at this priority, the yield returns right away
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    start = bench_cycles();
+    task_yield();
+    bench_record(bench_cycles() - start);
+  }
+  bench_report("task_yield", "cycles");
+
+  // a yield to a peer goes through the election and _switch_to
+  bench_start();
+  task_create("bench_peer", bench_peer_thread, &bench_peer_stack,
+              sizeof(bench_peer_stack), BENCH_PRIO);
+  bench_ping_pong();
+  bench_report("task_switch", "cycles");
+
+  // let the peer leave its loop and exit
+  task_yield();
+}
+
+/******************************************************************************
+ * @brief measure a channel round trip and a long message send
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void bench_channel() {
+  uint64_t handler;
+  uint64_t request = 0;
+  uint64_t reply;
+  uint64_t reply_len;
+  uint64_t start;
+
+  // the server creates the channel and waits for the first request
+  task_create("bench_server", bench_server_thread, &bench_server_stack,
+              sizeof(bench_server_stack), BENCH_SERVER_PRIO);
+  task_yield();
+  if (channel_get(&handler, "bench_channel") != K_OK) {
+    return;
+  }
+
+  // 8 bytes each way, the server replies and waits for the next call
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    reply_len = sizeof(reply);
+    start     = bench_cycles();
+    channel_call(handler, &request, sizeof(request), &reply, &reply_len);
+    bench_record(bench_cycles() - start);
+  }
+  bench_report("channel_call_8", "cycles");
+
+  // the send returns once the server waits again
+  bench_start();
+  for (uint64_t i = 0; i < BENCH_SAMPLES; i++) {
+    start = bench_cycles();
+    channel_snd(handler, bench_long, sizeof(bench_long));
+    bench_record(bench_cycles() - start);
+  }
+  bench_report("channel_snd_512", "cycles");
+
+  channel_destroy(handler);
+}
+
+/******************************************************************************
+ * @brief run the benchmarks of tests/bench, one after the other
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void bench_main_thread(void) {
+  bench_switch();
+  bench_channel();
+}
+
+/******************************************************************************
+ * @brief run the benchmarks on the host monotonic clock
+ * @param None
+ * @return 0
+ ******************************************************************************/
+int main() {
+  host_init(false);
+
+  task_create("bench_main", bench_main_thread, &bench_main_stack,
+              sizeof(bench_main_stack), BENCH_PRIO);
+
+  host_run();
+
+  return 0;
+}
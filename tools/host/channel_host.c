@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+#include "common.h"
+#include "processor.h"
+#include "sched.h"
+#include "string.h"
+
+/******************************************************************************
+ * Host stand-in of arch/channel.S. A short message is loaded by the sender
+ * in registers which survive the switch to the receiver: on the host they are
+ * the words below, the hart runs a single task at a time.
+ ******************************************************************************/
+#define HOST_MSG_REG_NB 8
+
+static uint64_t host_msg_regs[HOST_MSG_REG_NB];
+static uint64_t host_msg_nb_words;
+static uint64_t host_msg_len;
+
+/******************************************************************************
+ * @brief load the message words in the registers of the hart
+ * @param msg address
+ * @param number of words to pass in registers
+ * @param msg length
+ * @return none
+ ******************************************************************************/
+static inline void host_msg_load(const uint64_t *msg, uint64_t nb_words,
+                                 uint64_t msg_len) {
+  memcpy(host_msg_regs, msg, nb_words * sizeof(uint64_t));
+  host_msg_nb_words = nb_words;
+  host_msg_len      = msg_len;
+}
+
+/******************************************************************************
+ * @brief store the message words once the task is resumed
+ *
+ * A task woken up by the scheduler finds the message already deposited in its
+ * buffer, the registers don't hold any word.
+ *
+ * @param msg address
+ * @return message length, 0 if it has been deposited
+ ******************************************************************************/
+static inline uint64_t host_msg_resume(uint64_t *msg) {
+  thread_t *thread = (thread_t *)thread_pointer_get();
+
+  if (thread->msg_deposited) {
+    return 0;
+  }
+
+  memcpy(msg, host_msg_regs, host_msg_nb_words * sizeof(uint64_t));
+
+  return host_msg_len;
+}
+
+/******************************************************************************
+ * @brief switch to the receiver with the message in registers
+ * @param sender thread
+ * @param receiver thread
+ * @param msg address
+ * @param number of words to pass in registers
+ * @param msg length
+ * @return none
+ ******************************************************************************/
+void _channel_snd(thread_t *sender, thread_t *receiver, const uint64_t *msg,
+                  uint64_t nb_words, uint64_t msg_len) {
+  host_msg_load(msg, nb_words, msg_len);
+
+  _switch_to(sender, receiver);
+}
+
+/******************************************************************************
+ * @brief release the cpu and store the message the task is resumed with
+ * @param receiver thread
+ * @param next thread to run
+ * @param msg address
+ * @return message length
+ ******************************************************************************/
+uint64_t _channel_rcv(thread_t *receiver, thread_t *next, uint64_t *msg) {
+  _switch_to(receiver, next);
+
+  return host_msg_resume(msg);
+}
+
+/******************************************************************************
+ * @brief send a message to a task and wait for its answer with a single
+ * switch
+ * @param calling thread
+ * @param called thread
+ * @param msg address
+ * @param number of words to pass in registers
+ * @param msg length
+ * @param answer address
+ * @return answer length
+ ******************************************************************************/
+uint64_t _channel_call(thread_t *caller, thread_t *called, const uint64_t *msg,
+                       uint64_t nb_words, uint64_t msg_len, uint64_t *answer) {
+  host_msg_load(msg, nb_words, msg_len);
+
+  _switch_to(caller, called);
+
+  return host_msg_resume(answer);
+}
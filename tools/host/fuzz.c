@@ -0,0 +1,700 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+// the host headers come first, common.h defines the fixed width types as
+// macros
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// the signal stack of the C library takes the name of the kernel stacks
+#define stack_t host_signal_stack_t
+#include <sys/wait.h>
+#undef stack_t
+
+#include "host.h"
+
+#include "channel.h"
+#include "notify.h"
+#include "sched.h"
+#include "smp.h"
+#include "task.h"
+#include "timer_arch.h"
+#include "wait_any.h"
+
+// tasks running the random operations, each one serves its own channel
+#define FUZZ_ACTOR_NB  6
+#define FUZZ_ACTOR_OPS 64
+
+// tasks spawned by the actors, they send a single message and exit
+#define FUZZ_CHILD_NB 32
+
+// an actor replies at most once per message sent to it
+#define FUZZ_SENDER_NB (FUZZ_ACTOR_NB + FUZZ_CHILD_NB)
+#define FUZZ_SEQ_NB    (FUZZ_SENDER_NB * FUZZ_ACTOR_OPS)
+
+// a message of more than CHANNEL_COPY_CHUNK bytes is copied in chunks
+#define FUZZ_MSG_WORDS 80
+#define FUZZ_MSG_MIN   (3 * DWORD_SIZE)
+#define FUZZ_MSG_MAX   (FUZZ_MSG_WORDS * DWORD_SIZE)
+
+// priorities of the tasks, above the idle task
+#define FUZZ_PRIO_MIN 1
+#define FUZZ_PRIO_MAX 8
+
+// the ticker wakes up the actors waiting for a notification
+#define FUZZ_NOTIFY_TICK (1UL << 63)
+#define FUZZ_NOTIFY_ALL  (~0UL)
+
+// longest sleep, and longest clock step in mtime ticks
+#define FUZZ_SLEEP_MAX_US 100
+#define FUZZ_TICKS_MAX    (FUZZ_SLEEP_MAX_US * TIMER_ARCH_TICKS_PER_US)
+
+// a run that takes longer is stuck, in seconds
+#define FUZZ_RUN_TIMEOUT 10
+
+// bytes of a buffer past its given size, a transfer must not write them
+#define FUZZ_CANARY 0xa5
+
+// message header: kind, sender and sequence number of the sender
+#define FUZZ_KIND_SND   1
+#define FUZZ_KIND_CALL  2
+#define FUZZ_KIND_REPLY 3
+
+#define FUZZ_HEADER(kind, sender, seq)                                        \
+  (((uint64_t)(kind) << 56) | ((uint64_t)(sender) << 32) | (uint64_t)(seq))
+#define FUZZ_HEADER_KIND(header)   ((header) >> 56)
+#define FUZZ_HEADER_SENDER(header) (((header) >> 32) & 0xffffff)
+#define FUZZ_HEADER_SEQ(header)    ((header) & 0xffffffff)
+
+// words of a message: header, length, echoed request, then the pattern
+#define FUZZ_WORD_HEADER 0
+#define FUZZ_WORD_LEN    1
+#define FUZZ_WORD_ECHO   2
+
+// state of a message in the bookkeeping of the run
+#define FUZZ_MSG_NONE      0
+#define FUZZ_MSG_SENT      1
+#define FUZZ_MSG_COMPLETED 2
+
+/******************************************************************************
+ * @brief stop the run if an invariant doesn't hold
+ * @param invariant
+ * @return none
+ ******************************************************************************/
+#define FUZZ_CHECK(cond)                                                      \
+  do {                                                                        \
+    if (!(cond)) {                                                            \
+      fuzz_fail(__FILE__, __LINE__, #cond);                                   \
+    }                                                                         \
+  } while (0)
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+
+/******************************************************************************
+ * @enum fuzz_op_t
+ * @brief operation of an actor
+ ******************************************************************************/
+typedef enum fuzz_op_t {
+  FUZZ_OP_YIELD,
+  FUZZ_OP_SLEEP,
+  FUZZ_OP_SND,
+  FUZZ_OP_CALL,
+  FUZZ_OP_RCV,
+  FUZZ_OP_NOTIFY,
+  FUZZ_OP_NOTIFY_WAIT,
+  FUZZ_OP_WAIT_ANY,
+  FUZZ_OP_SPAWN,
+  FUZZ_OP_CLOCK,
+  FUZZ_OP_NB,
+} fuzz_op_t;
+
+/******************************************************************************
+ * @struct fuzz_actor_t
+ * @brief actor of a run
+ *
+ * An actor only sends to the actors of a higher index and only waits for a
+ * message already sent, then serves its channel once its operations are
+ * done: the messages of a run can't deadlock.
+ ******************************************************************************/
+typedef struct fuzz_actor_t {
+  task_t       *task;
+  uint64_t      channel;
+  uint64_t      seq;
+  uint64_t      caller;
+  bool          done;
+  wait_object_t objects[2];
+  uint64_t      buffer[FUZZ_MSG_WORDS];
+  uint64_t      msg[FUZZ_MSG_WORDS];
+} fuzz_actor_t;
+
+/******************************************************************************
+ * @struct fuzz_child_t
+ * @brief message sent by a spawned task
+ ******************************************************************************/
+typedef struct fuzz_child_t {
+  uint64_t dst;
+  uint64_t len;
+  uint64_t msg[FUZZ_MSG_WORDS];
+} fuzz_child_t;
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+stack_t fuzz_stacks[FUZZ_ACTOR_NB];
+stack_t fuzz_ticker_stack;
+
+static fuzz_actor_t fuzz_actors[FUZZ_ACTOR_NB];
+static fuzz_child_t fuzz_children[FUZZ_CHILD_NB];
+static uint64_t     fuzz_children_spawned;
+static uint64_t     fuzz_children_started;
+static bool         fuzz_ticker_done;
+
+static uint8_t fuzz_sent[FUZZ_SENDER_NB][FUZZ_SEQ_NB];
+static uint8_t fuzz_received[FUZZ_SENDER_NB][FUZZ_SEQ_NB];
+static uint8_t fuzz_kind[FUZZ_SENDER_NB][FUZZ_SEQ_NB];
+
+static uint64_t fuzz_seed;
+static uint64_t fuzz_state;
+
+/******************************************************************************
+ * @brief report the failed invariant and stop the run
+ * @param source file
+ * @param source line
+ * @param invariant
+ * @return none
+ ******************************************************************************/
+static void fuzz_fail(const char *file, int line, const char *cond) {
+  printf("FUZZ seed=%lu failed %s:%d: %s\n", fuzz_seed, file, line, cond);
+  fflush(stdout);
+  _exit(1);
+}
+
+/******************************************************************************
+ * @brief draw a random number, xorshift64*
+ * @param bound of the number
+ * @return number in [0, bound)
+ ******************************************************************************/
+static uint64_t fuzz_rand(uint64_t bound) {
+  fuzz_state ^= fuzz_state >> 12;
+  fuzz_state ^= fuzz_state << 25;
+  fuzz_state ^= fuzz_state >> 27;
+
+  return ((fuzz_state * 0x2545f4914f6cdd1dUL) >> 11) % bound;
+}
+
+/******************************************************************************
+ * @brief draw a random number in a range
+ * @param lowest number
+ * @param highest number
+ * @return number in [min, max]
+ ******************************************************************************/
+static uint64_t fuzz_range(uint64_t min, uint64_t max) {
+  return min + fuzz_rand(max - min + 1);
+}
+
+/******************************************************************************
+ * @brief pattern word of a message
+ * @param header of the message
+ * @param index of the word
+ * @return word
+ ******************************************************************************/
+static uint64_t fuzz_word(uint64_t header, uint64_t index) {
+  uint64_t word = header ^ (index * 0x9e3779b97f4a7c15UL);
+
+  word ^= word >> 31;
+  word *= 0xbf58476d1ce4e5b9UL;
+
+  return word ^ (word >> 29);
+}
+
+/******************************************************************************
+ * @brief build a message
+ * @param message buffer, FUZZ_MSG_WORDS long
+ * @param header of the message
+ * @param length in bytes
+ * @param echoed request header, 0 if it's not a reply
+ * @return none
+ ******************************************************************************/
+static void fuzz_fill(uint64_t *msg, uint64_t header, uint64_t len,
+                      uint64_t echo) {
+  msg[FUZZ_WORD_HEADER] = header;
+  msg[FUZZ_WORD_LEN]    = len;
+  msg[FUZZ_WORD_ECHO]   = echo;
+
+  for (uint64_t i = FUZZ_WORD_ECHO + 1; i < FUZZ_MSG_WORDS; i++) {
+    msg[i] = fuzz_word(header, i);
+  }
+}
+
+/******************************************************************************
+ * @brief give a message the next sequence number of its sender
+ * @param sender
+ * @param kind of message
+ * @param sequence number of the sender, incremented
+ * @return header of the message
+ ******************************************************************************/
+static uint64_t fuzz_new_msg(uint64_t sender, uint64_t kind, uint64_t *seq) {
+  uint64_t header = FUZZ_HEADER(kind, sender, *seq);
+
+  FUZZ_CHECK(*seq < FUZZ_SEQ_NB);
+  fuzz_sent[sender][*seq] = FUZZ_MSG_SENT;
+  fuzz_kind[sender][*seq] = kind;
+  *seq += 1;
+
+  return header;
+}
+
+/******************************************************************************
+ * @brief mark a message as delivered to its sender
+ * @param header of the message
+ * @return none
+ ******************************************************************************/
+static void fuzz_complete(uint64_t header) {
+  fuzz_sent[FUZZ_HEADER_SENDER(header)][FUZZ_HEADER_SEQ(header)] =
+      FUZZ_MSG_COMPLETED;
+}
+
+/******************************************************************************
+ * @brief fill a receive buffer with the canary
+ * @param buffer, FUZZ_MSG_WORDS long
+ * @return none
+ ******************************************************************************/
+static void fuzz_arm(uint64_t *buffer) {
+  memset(buffer, FUZZ_CANARY, FUZZ_MSG_MAX);
+}
+
+/******************************************************************************
+ * @brief check a received message against the one its header describes
+ *
+ * The message is truncated to the buffer size, the bytes of the buffer past
+ * its given size are left untouched.
+ *
+ * @param buffer, FUZZ_MSG_WORDS long
+ * @param size given to the kernel
+ * @param length returned by the kernel
+ * @return header of the message
+ ******************************************************************************/
+static uint64_t fuzz_check_msg(const uint64_t *buffer, uint64_t size,
+                               uint64_t len) {
+  uint64_t header = buffer[FUZZ_WORD_HEADER];
+  uint64_t sent   = buffer[FUZZ_WORD_LEN];
+  uint64_t expected[FUZZ_MSG_WORDS];
+
+  FUZZ_CHECK(len >= FUZZ_MSG_MIN);
+  FUZZ_CHECK(FUZZ_HEADER_SENDER(header) < FUZZ_SENDER_NB);
+  FUZZ_CHECK(FUZZ_HEADER_SEQ(header) < FUZZ_SEQ_NB);
+  FUZZ_CHECK(sent >= FUZZ_MSG_MIN && sent <= FUZZ_MSG_MAX);
+  FUZZ_CHECK(len == (sent < size ? sent : size));
+
+  fuzz_fill(expected, header, sent, buffer[FUZZ_WORD_ECHO]);
+  FUZZ_CHECK(memcmp(buffer, expected, len) == 0);
+
+  for (uint64_t i = size; i < FUZZ_MSG_MAX; i++) {
+    FUZZ_CHECK(((const uint8_t *)buffer)[i] == FUZZ_CANARY);
+  }
+
+  return header;
+}
+
+/******************************************************************************
+ * @brief check the scheduler state at an operation boundary
+ * @param actor running the operation
+ * @return none
+ ******************************************************************************/
+static void fuzz_check_sched(fuzz_actor_t *actor) {
+  task_t *current = sched_get_current_task();
+
+  FUZZ_CHECK(current == actor->task);
+  FUZZ_CHECK(task_get_state(current) == RUNNING);
+  FUZZ_CHECK(!smp_lock_held());
+}
+
+/******************************************************************************
+ * @brief check that a task given the cpu by the scheduler has the highest
+ * priority of the ready tasks
+ *
+ * A channel direct switch doesn't go through the election, the peer may run
+ * while a task of a higher priority is ready until its next election.
+ *
+ * @param None
+ * @return none
+ ******************************************************************************/
+static void fuzz_check_elected() {
+  task_t *current = sched_get_current_task();
+
+  FUZZ_CHECK(sched_get_next_task()->prio <= current->prio);
+}
+
+/******************************************************************************
+ * @brief reply to the last call if any and receive the next message
+ *
+ * Each message is delivered once, the next receive replies to a call.
+ *
+ * @param actor
+ * @return none
+ ******************************************************************************/
+static void fuzz_receive(fuzz_actor_t *actor) {
+  uint64_t id   = actor - fuzz_actors;
+  uint64_t size = fuzz_range(FUZZ_MSG_MIN, FUZZ_MSG_MAX);
+  uint64_t len  = size;
+  uint64_t reply_len;
+  uint64_t header;
+  uint64_t sender;
+  uint64_t seq;
+  uint64_t kind;
+
+  fuzz_arm(actor->buffer);
+
+  if (actor->caller) {
+    reply_len = fuzz_range(FUZZ_MSG_MIN, FUZZ_MSG_MAX);
+    header    = fuzz_new_msg(id, FUZZ_KIND_REPLY, &actor->seq);
+    fuzz_fill(actor->msg, header, reply_len, actor->caller);
+    FUZZ_CHECK(channel_reply_wait(actor->channel, actor->msg, reply_len,
+                                  actor->buffer, &len) == K_OK);
+  } else {
+    FUZZ_CHECK(channel_reply_wait(actor->channel, NULL, 0, actor->buffer,
+                                  &len) == K_OK);
+  }
+
+  header = fuzz_check_msg(actor->buffer, size, len);
+  sender = FUZZ_HEADER_SENDER(header);
+  seq    = FUZZ_HEADER_SEQ(header);
+  kind   = FUZZ_HEADER_KIND(header);
+
+  // a sender may already be resumed, the receive is recorded once the
+  // receiver runs
+  FUZZ_CHECK(kind == FUZZ_KIND_SND || kind == FUZZ_KIND_CALL);
+  FUZZ_CHECK(fuzz_kind[sender][seq] == kind);
+  FUZZ_CHECK(fuzz_sent[sender][seq] != FUZZ_MSG_NONE);
+  FUZZ_CHECK(fuzz_received[sender][seq]++ == 0);
+
+  actor->caller = kind == FUZZ_KIND_CALL ? header : 0;
+}
+
+/******************************************************************************
+ * @brief send a single message and exit
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void fuzz_child_thread(void) {
+  fuzz_child_t *child = &fuzz_children[fuzz_children_started++];
+
+  FUZZ_CHECK(channel_snd(fuzz_actors[child->dst].channel, child->msg,
+                         child->len) == K_OK);
+  fuzz_complete(child->msg[FUZZ_WORD_HEADER]);
+}
+
+/******************************************************************************
+ * @brief notify the actors until they are all done
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void fuzz_ticker_thread(void) {
+  bool done = false;
+
+  while (!done) {
+    task_sleep_for(fuzz_range(1, FUZZ_SLEEP_MAX_US));
+
+    done = true;
+    for (uint64_t i = 0; i < FUZZ_ACTOR_NB; i++) {
+      if (!fuzz_actors[i].done) {
+        notify(fuzz_actors[i].task, FUZZ_NOTIFY_TICK);
+        done = false;
+      }
+    }
+  }
+
+  fuzz_ticker_done = true;
+}
+
+/******************************************************************************
+ * @brief run an operation of an actor
+ * @param actor
+ * @param operation
+ * @return none
+ ******************************************************************************/
+static void fuzz_run_op(fuzz_actor_t *actor, fuzz_op_t op) {
+  uint64_t id  = actor - fuzz_actors;
+  uint64_t len = fuzz_range(FUZZ_MSG_MIN, FUZZ_MSG_MAX);
+  uint64_t reply[FUZZ_MSG_WORDS];
+  uint64_t reply_size;
+  uint64_t reply_len;
+  uint64_t header;
+  uint64_t start;
+  uint64_t mask;
+  uint64_t dst;
+  uint64_t us;
+  int64_t  ready;
+
+  fuzz_child_t *child;
+
+  // the messages only go to the actors of a higher index
+  dst = id + 1 < FUZZ_ACTOR_NB ? fuzz_range(id + 1, FUZZ_ACTOR_NB - 1) : id;
+
+  switch (op) {
+  case FUZZ_OP_YIELD:
+    task_yield();
+    fuzz_check_elected();
+    break;
+
+  case FUZZ_OP_SLEEP:
+    // the task is never woken up before its date
+    us    = fuzz_range(1, FUZZ_SLEEP_MAX_US);
+    start = timer_arch_get_time();
+    task_sleep_for(us);
+    FUZZ_CHECK(timer_arch_get_time() >= start + us * TIMER_ARCH_TICKS_PER_US);
+    fuzz_check_elected();
+    break;
+
+  case FUZZ_OP_SND:
+    if (dst == id) {
+      break;
+    }
+    header = fuzz_new_msg(id, FUZZ_KIND_SND, &actor->seq);
+    fuzz_fill(actor->msg, header, len, 0);
+    FUZZ_CHECK(channel_snd(fuzz_actors[dst].channel, actor->msg, len) ==
+               K_OK);
+    fuzz_complete(header);
+    break;
+
+  case FUZZ_OP_CALL:
+    // the reply echoes the header of the request
+    if (dst == id) {
+      break;
+    }
+    header = fuzz_new_msg(id, FUZZ_KIND_CALL, &actor->seq);
+    fuzz_fill(actor->msg, header, len, 0);
+    fuzz_arm(reply);
+    reply_size = fuzz_range(FUZZ_MSG_MIN, FUZZ_MSG_MAX);
+    reply_len  = reply_size;
+    FUZZ_CHECK(channel_call(fuzz_actors[dst].channel, actor->msg, len, reply,
+                            &reply_len) == K_OK);
+    FUZZ_CHECK(fuzz_received[id][FUZZ_HEADER_SEQ(header)] == 1);
+    fuzz_complete(header);
+
+    header = fuzz_check_msg(reply, reply_size, reply_len);
+    FUZZ_CHECK(FUZZ_HEADER_KIND(header) == FUZZ_KIND_REPLY);
+    FUZZ_CHECK(FUZZ_HEADER_SENDER(header) == dst);
+    FUZZ_CHECK(reply[FUZZ_WORD_ECHO] == actor->msg[FUZZ_WORD_HEADER]);
+    fuzz_complete(header);
+    break;
+
+  case FUZZ_OP_RCV:
+    // a sender may never come, only a blocked one is received
+    if (channel_has_sender(actor->channel)) {
+      fuzz_receive(actor);
+    }
+    break;
+
+  case FUZZ_OP_NOTIFY:
+    notify(fuzz_actors[fuzz_rand(FUZZ_ACTOR_NB)].task,
+           1UL << fuzz_rand(63));
+    break;
+
+  case FUZZ_OP_NOTIFY_WAIT:
+    // only bits of the mask are returned, the tick always comes
+    mask = fuzz_rand(FUZZ_NOTIFY_TICK) | FUZZ_NOTIFY_TICK;
+    FUZZ_CHECK((notify_wait(mask) & ~mask) == 0);
+    break;
+
+  case FUZZ_OP_WAIT_ANY:
+    // a ready object is received without blocking
+    ready = wait_any(actor->objects, 2);
+    FUZZ_CHECK(ready == 0 || ready == 1);
+    if (ready == 0) {
+      FUZZ_CHECK(channel_has_sender(actor->channel));
+      fuzz_receive(actor);
+    } else {
+      FUZZ_CHECK(actor->task->notify_pending != 0);
+      FUZZ_CHECK(notify_wait(FUZZ_NOTIFY_ALL) != 0);
+    }
+    break;
+
+  case FUZZ_OP_SPAWN:
+    // any actor serves the child once its operations are done
+    if (fuzz_children_spawned == FUZZ_CHILD_NB) {
+      break;
+    }
+    child      = &fuzz_children[fuzz_children_spawned];
+    child->dst = fuzz_rand(FUZZ_ACTOR_NB);
+    child->len = len;
+    header = fuzz_new_msg(FUZZ_ACTOR_NB + fuzz_children_spawned,
+                          FUZZ_KIND_SND, &(uint64_t){0});
+    fuzz_fill(child->msg, header, len, 0);
+    fuzz_children_spawned++;
+    FUZZ_CHECK(task_spawn("fuzz_child", fuzz_child_thread,
+                          fuzz_range(FUZZ_PRIO_MIN, FUZZ_PRIO_MAX)) != NULL);
+
+    // the creation doesn't preempt the creator, the yield does
+    task_yield();
+    fuzz_check_elected();
+    break;
+
+  case FUZZ_OP_CLOCK:
+    // the expired timers preempt the actor
+    host_time_advance(fuzz_range(1, FUZZ_TICKS_MAX));
+    host_irq_poll();
+    break;
+
+  default:
+    break;
+  }
+}
+
+/******************************************************************************
+ * @brief run the random operations of an actor, then serve its channel
+ * @param None
+ * @return None
+ ******************************************************************************/
+static void fuzz_actor_thread(void) {
+  fuzz_actor_t *actor = NULL;
+
+  for (uint64_t i = 0; i < FUZZ_ACTOR_NB; i++) {
+    if (fuzz_actors[i].task == sched_get_current_task()) {
+      actor = &fuzz_actors[i];
+    }
+  }
+
+  FUZZ_CHECK(actor != NULL);
+
+  for (uint64_t op = 0; op < FUZZ_ACTOR_OPS; op++) {
+    fuzz_check_sched(actor);
+    fuzz_run_op(actor, fuzz_rand(FUZZ_OP_NB));
+  }
+
+  actor->done = true;
+
+  while (1) {
+    fuzz_receive(actor);
+  }
+}
+
+/******************************************************************************
+ * @brief run a scenario and check the final state
+ * @param seed of the scenario
+ * @return none
+ ******************************************************************************/
+static void fuzz_run(uint64_t seed) {
+  fuzz_actor_t *actor;
+  char          name[CONFIG_CHANNEL_NAME_LENGTH];
+
+  fuzz_seed  = seed;
+  fuzz_state = seed * 0x9e3779b97f4a7c15UL + 1;
+
+  host_init(true);
+
+  for (uint64_t i = 0; i < FUZZ_ACTOR_NB; i++) {
+    actor = &fuzz_actors[i];
+
+    snprintf(name, sizeof(name), "fuzz%lu", i);
+    FUZZ_CHECK(channel_create(&actor->channel, name) == K_OK);
+
+    actor->objects[0] = (wait_object_t){WAIT_CHANNEL, actor->channel};
+    actor->objects[1] = (wait_object_t){WAIT_NOTIFY, FUZZ_NOTIFY_ALL};
+  }
+
+  // the actors start once they are all known
+  for (uint64_t i = 0; i < FUZZ_ACTOR_NB; i++) {
+    fuzz_actors[i].task =
+        task_create("fuzz_actor", fuzz_actor_thread, &fuzz_stacks[i],
+                    sizeof(fuzz_stacks[i]),
+                    fuzz_range(FUZZ_PRIO_MIN, FUZZ_PRIO_MAX));
+    FUZZ_CHECK(fuzz_actors[i].task != NULL);
+  }
+
+  FUZZ_CHECK(task_create("fuzz_ticker", fuzz_ticker_thread,
+                         &fuzz_ticker_stack, sizeof(fuzz_ticker_stack),
+                         fuzz_range(FUZZ_PRIO_MIN, FUZZ_PRIO_MAX)) != NULL);
+
+  host_run();
+
+  // all actors serve their channel, no message is left in flight
+  FUZZ_CHECK(!smp_lock_held());
+  FUZZ_CHECK(sched_get_next_task() == sched_get_current_task());
+  FUZZ_CHECK(fuzz_ticker_done);
+  FUZZ_CHECK(fuzz_children_started == fuzz_children_spawned);
+
+  for (uint64_t i = 0; i < FUZZ_ACTOR_NB; i++) {
+    FUZZ_CHECK(fuzz_actors[i].done);
+    FUZZ_CHECK(task_get_state(fuzz_actors[i].task) == BLOCKED);
+  }
+
+  for (uint64_t sender = 0; sender < FUZZ_SENDER_NB; sender++) {
+    for (uint64_t seq = 0; seq < FUZZ_SEQ_NB; seq++) {
+      FUZZ_CHECK(fuzz_sent[sender][seq] != FUZZ_MSG_SENT);
+
+      if (fuzz_sent[sender][seq] == FUZZ_MSG_COMPLETED &&
+          fuzz_kind[sender][seq] != FUZZ_KIND_REPLY) {
+        FUZZ_CHECK(fuzz_received[sender][seq] == 1);
+      }
+    }
+  }
+}
+
+/******************************************************************************
+ * @brief run the scenarios of consecutive seeds, each one in a new process
+ *
+ * usage: fuzz [--seed <first seed>] [--runs <number of runs>]
+ *
+ * @param number of arguments
+ * @param arguments
+ * @return 0 if all runs passed, 1 otherwise
+ ******************************************************************************/
+int main(int argc, char **argv) {
+  uint64_t seed   = 1;
+  uint64_t runs   = 1000;
+  uint64_t failed = 0;
+  int      status;
+  pid_t    pid;
+
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--seed")) {
+      seed = strtoul(argv[i + 1], NULL, 0);
+    } else if (!strcmp(argv[i], "--runs")) {
+      runs = strtoul(argv[i + 1], NULL, 0);
+    }
+  }
+
+  for (uint64_t run = 0; run < runs; run++, seed++) {
+    fflush(stdout);
+    pid = fork();
+
+    if (pid == 0) {
+      alarm(FUZZ_RUN_TIMEOUT);
+      fuzz_run(seed);
+      _exit(0);
+    }
+
+    waitpid(pid, &status, 0);
+
+    if (WIFSIGNALED(status)) {
+      printf("FUZZ seed=%lu failed signal %d\n", seed, WTERMSIG(status));
+    }
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+      failed++;
+    }
+  }
+
+  printf("FUZZ runs=%lu failed=%lu\n", runs, failed);
+
+  return failed ? 1 : 0;
+}
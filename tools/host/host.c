@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+// the host headers come first, common.h defines the fixed width types as
+// macros
+#include <time.h>
+
+#include "host.h"
+
+#include "buddy.h"
+#include "irq_arch.h"
+#include "ktimer.h"
+#include "processor.h"
+#include "sched.h"
+#include "smp.h"
+#include "task.h"
+#include "timer_arch.h"
+
+// the heap holds a single block of the biggest order, aligned on its size
+#define HOST_HEAP_SIZE 0x800000
+_Static_assert(HOST_HEAP_SIZE == 1UL << BUDDY_MAX_ORDER,
+               "the host heap is a single buddy block");
+
+#define HOST_STRINGIFY(x)  _HOST_STRINGIFY(x)
+#define _HOST_STRINGIFY(x) #x
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/******************************************************************************
+ * machine registers of the host hart, the thread pointer holds the current
+ * task
+ ******************************************************************************/
+uint64_t host_csr_mstatus;
+uint64_t host_csr_mie;
+uint64_t host_csr_mip;
+uint64_t host_csr_mcause;
+uint64_t host_thread_pointer;
+
+/******************************************************************************
+ * machine timer comparator and clock of the host hart
+ ******************************************************************************/
+uint64_t        host_timer_compare = TIMER_ARCH_NEVER;
+static bool     host_virtual       = false;
+static uint64_t host_virtual_time  = 0;
+
+/******************************************************************************
+ * the idle task runs on the stack of the process, idle_stack is only given to
+ * the scheduler for its stack usage
+ ******************************************************************************/
+stack_t idle_stack;
+
+/******************************************************************************
+ * memory given to the buddy allocator, bounded by the symbols of the linker
+ * script of the target
+ ******************************************************************************/
+__attribute__((aligned(HOST_HEAP_SIZE), used)) uint8_t host_heap[HOST_HEAP_SIZE];
+
+__asm__(".globl _heap_start\n"
+        ".set _heap_start, host_heap\n"
+        ".globl _heap_end\n"
+        ".set _heap_end, host_heap + " HOST_STRINGIFY(HOST_HEAP_SIZE) "\n");
+
+/******************************************************************************
+ * @brief read the clock of the host hart
+ * @param none
+ * @return mtime ticks
+ ******************************************************************************/
+uint64_t host_time_get() {
+  struct timespec now;
+
+  if (host_virtual) {
+    return host_virtual_time;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return ((uint64_t)now.tv_sec * 1000000000UL + now.tv_nsec) /
+         TIMER_ARCH_NS_PER_TICK;
+}
+
+/******************************************************************************
+ * @brief move the virtual clock forward
+ * @param number of ticks
+ * @return none
+ ******************************************************************************/
+void host_time_advance(uint64_t ticks) {
+  host_virtual_time += ticks;
+}
+
+/******************************************************************************
+ * @brief serve the pending interrupts, as the interrupt entry of the target
+ *
+ * The preemption follows dispatch_interrupt(): it's deferred if the kernel
+ * lock is held, the switch is done once the handlers have returned and the
+ * task resumes through sched_task_start().
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void host_irq_trap() {
+  uint64_t pending = csr_read(CSR_MIP) & csr_read(CSR_MIE);
+  bool     preempt = false;
+
+  // the trap entry disables interrupts, mret enables them again
+  csr_clear(CSR_MSTATUS, MACHINE_INTERRUPT_ENABLE);
+
+  if (pending & MACHINE_SOFTWARE_INTERRUPT_ENABLE) {
+    preempt |= (smp_ipi_take() & SMP_IPI_RESCHED) != 0;
+  }
+
+  if (pending & MACHINE_TIMER_INTERRUPT_ENABLE) {
+    preempt |= ktimer_expire();
+  }
+
+  if (smp_lock_held()) {
+    if (preempt) {
+      smp_preempt_defer();
+    }
+  } else if (preempt || smp_preempt_take()) {
+    task_preempt();
+    sched_task_start();
+  }
+
+  csr_set(CSR_MSTATUS, MACHINE_INTERRUPT_ENABLE);
+}
+
+/******************************************************************************
+ * @brief raise the interrupts due by now and take them if they are enabled
+ * @param none
+ * @return none
+ ******************************************************************************/
+void host_irq_poll() {
+  if (host_time_get() >= host_timer_compare) {
+    csr_set(CSR_MIP, MACHINE_TIMER_INTERRUPT_ENABLE);
+  }
+
+  if ((csr_read(CSR_MSTATUS) & MACHINE_INTERRUPT_ENABLE) &&
+      irq_arch_pending()) {
+    host_irq_trap();
+  }
+}
+
+/******************************************************************************
+ * @brief wait for the next timer interrupt, called by sched_idle()
+ *
+ * The virtual clock jumps to the comparator, the monotonic clock is waited
+ * for. Nothing can wake the hart up when no timer is armed.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void host_irq_wait() {
+  struct timespec date;
+
+  if (host_timer_compare == TIMER_ARCH_NEVER) {
+    return;
+  }
+
+  if (host_virtual) {
+    if (host_virtual_time < host_timer_compare) {
+      host_virtual_time = host_timer_compare;
+    }
+  } else {
+    date.tv_sec  = host_timer_compare / TIMER_ARCH_RATE;
+    date.tv_nsec = (host_timer_compare % TIMER_ARCH_RATE) *
+                   TIMER_ARCH_NS_PER_TICK;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &date, NULL);
+  }
+
+  csr_set(CSR_MIP, MACHINE_TIMER_INTERRUPT_ENABLE);
+}
+
+/******************************************************************************
+ * @brief leave the current task, a task returns to it from its entry
+ *
+ * The tasks of the host call the kernel directly, there is no syscall layer.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void ax_task_exit() {
+  task_exit();
+}
+
+/******************************************************************************
+ * No interrupt can be attached to a task on the host, wait_any() only binds
+ * channels and notifications
+ ******************************************************************************/
+k_return_t interrupt_watch(interrupt_id_t interrupt_id, task_t *task,
+                           uint64_t ready) {
+  return K_ERROR;
+}
+
+void interrupt_unwatch(interrupt_id_t interrupt_id, task_t *task) {
+}
+
+bool interrupt_take(interrupt_id_t interrupt_id) {
+  return false;
+}
+
+void interrupt_rearm(interrupt_id_t interrupt_id, task_t *task) {
+}
+
+/******************************************************************************
+ * @brief initialize the kernel core in the calling process
+ * @param true to run on the virtual clock, false on the host monotonic clock
+ * @return none
+ ******************************************************************************/
+void host_init(bool virtual_time) {
+  host_virtual = virtual_time;
+
+  // the process becomes the idle task of the host hart
+  sched_init();
+  host_context_init(sched_get_current_task());
+
+  buddy_init();
+
+  task_init();
+
+  ktimer_init();
+
+  smp_start();
+
+  // start.S enables the software interrupt, the idle task runs with
+  // interrupts enabled
+  csr_set(CSR_MIE, MACHINE_SOFTWARE_INTERRUPT_ENABLE);
+  irq_arch_enable();
+}
+
+/******************************************************************************
+ * @brief run the tasks until they all exit or block without any armed timer
+ *
+ * The calling process runs the idle loop of the target: it gives the cpu to
+ * the ready tasks and waits for the next timer once they all block.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void host_run() {
+  while (1) {
+    task_yield();
+
+    if (host_timer_compare == TIMER_ARCH_NEVER) {
+      return;
+    }
+
+    sched_idle();
+  }
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef HOST_H
+#define HOST_H
+
+#include "common.h"
+
+struct task_t;
+
+/******************************************************************************
+ * @brief initialize the kernel core in the calling process
+ *
+ * The caller becomes the idle task of the host hart, the tasks it creates run
+ * from host_run(). The virtual clock only advances with host_time_advance()
+ * and when all tasks wait for a timer, so a run doesn't depend on the host
+ * load.
+ *
+ * @param true to run on the virtual clock, false on the host monotonic clock
+ * @return none
+ ******************************************************************************/
+void host_init(bool);
+
+/******************************************************************************
+ * @brief run the tasks until they all exit or block without any armed timer
+ * @param none
+ * @return none
+ ******************************************************************************/
+void host_run(void);
+
+/******************************************************************************
+ * @brief raise the interrupts due by now and take them if they are enabled
+ *
+ * Interrupts are not asynchronous on the host: they are raised at the points
+ * where the caller polls them, and taken there or as soon as the kernel
+ * enables interrupts again.
+ *
+ * @param none
+ * @return none
+ ******************************************************************************/
+void host_irq_poll(void);
+
+/******************************************************************************
+ * @brief move the virtual clock forward
+ * @param number of ticks
+ * @return none
+ ******************************************************************************/
+void host_time_advance(uint64_t);
+
+/******************************************************************************
+ * @brief give the idle task the storage of its context
+ * @param idle task of the host hart
+ * @return none
+ ******************************************************************************/
+void host_context_init(struct task_t *);
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef HOST_AUTOCONF_H
+#define HOST_AUTOCONF_H
+
+/******************************************************************************
+ * Kernel options of the host build, it replaces tools/generated/autoconf.h.
+ * The host runs a single hart without memory protection, floating point
+ * context, trace nor time slicing: the benchmarks and the fuzzer only
+ * measure and exercise the scheduler and the channels.
+ ******************************************************************************/
+#define CONFIG_HART_MAX_NB         1
+#define CONFIG_TASK_MAX_NB         64
+#define CONFIG_KTIMER_MAX_NB       32
+#define CONFIG_CHANNEL_MAX_NB      64
+#define CONFIG_CHANNEL_COPY_CHUNK  512
+#define CONFIG_CHANNEL_NAME_LENGTH 32
+#define CONFIG_SCHED_EDF_PRIO      128
+
+#endif
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef HOST_OFFSETS_H
+#define HOST_OFFSETS_H
+
+/******************************************************************************
+ * offset of the stack pointer in thread_t
+ ******************************************************************************/
+#define HOST_THREAD_SP 0
+
+/******************************************************************************
+ * frame saved by _switch_to in context_x86_64.S, in words: the callee saved
+ * registers, the return address and a padding word which keeps the frame
+ * 16-bytes aligned. task_stack_init() builds the first one of a task.
+ ******************************************************************************/
+#define HOST_SWITCH_FRAME_WORDS 8
+#define HOST_SWITCH_FRAME_ENTRY 4
+#define HOST_SWITCH_FRAME_RET   6
+
+#endif
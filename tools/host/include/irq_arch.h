@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef IRQ_ARCH_H
+#define IRQ_ARCH_H
+
+#include "common.h"
+#include "interrupt.h"
+#include "registers.h"
+
+struct task_t;
+
+/******************************************************************************
+ * Host stand-in of arch/include/irq_arch.h: interrupts are not asynchronous,
+ * the pending ones are delivered by host_irq_poll() at the points chosen by
+ * the benchmark or the fuzzer
+ ******************************************************************************/
+#define RISCV_INTERRUPT_SUPERVISOR_SOFTWARE 1
+#define RISCV_INTERRUPT_MACHINE_SOFTWARE    MIE_SIE_OFFSET
+#define RISCV_INTERRUPT_SUPERVISOR_TIMER    5
+#define RISCV_INTERRUPT_MACHINE_TIMER       MIE_TIE_OFFSET
+#define RISCV_INTERRUPT_SUPERVISOR_EXTERNAL 9
+#define RISCV_INTERRUPT_MACHINE_EXTERNAL    MIE_EIE_OFFSET
+
+#define IRQ_LEVEL_MAX 8
+
+#ifndef CONFIG_IRQ_SOFTWARE_LEVEL
+#define CONFIG_IRQ_SOFTWARE_LEVEL IRQ_LEVEL_MAX
+#endif
+
+#ifndef CONFIG_IRQ_TIMER_LEVEL
+#define CONFIG_IRQ_TIMER_LEVEL IRQ_LEVEL_MAX
+#endif
+
+/******************************************************************************
+ * @brief serve the pending interrupts, as the interrupt entry of the target
+ * @param none
+ * @return none
+ ******************************************************************************/
+void host_irq_trap(void);
+
+/******************************************************************************
+ * @brief check if an enabled interrupt is pending
+ * @param none
+ * @return true if host_irq_poll() would serve an interrupt
+ ******************************************************************************/
+static inline bool irq_arch_pending() {
+  return (csr_read(CSR_MIP) & csr_read(CSR_MIE)) != 0;
+}
+
+/******************************************************************************
+ * @brief disable interrupts on the host hart
+ * @param none
+ * @return previous interrupt enable state
+ ******************************************************************************/
+static inline uint64_t irq_arch_disable() {
+  return csr_read_clear(CSR_MSTATUS, MACHINE_INTERRUPT_ENABLE) &
+         MACHINE_INTERRUPT_ENABLE;
+}
+
+/******************************************************************************
+ * @brief restore the interrupt enable state saved by irq_arch_disable()
+ * @param previous interrupt enable state
+ * @return none
+ ******************************************************************************/
+static inline void irq_arch_restore(uint64_t flags) {
+  csr_set(CSR_MSTATUS, flags);
+
+  // a pending interrupt is taken as soon as interrupts are enabled
+  if (flags && irq_arch_pending()) {
+    host_irq_trap();
+  }
+}
+
+/******************************************************************************
+ * @brief enable interrupts on the host hart
+ * @param none
+ * @return none
+ ******************************************************************************/
+static inline void irq_arch_enable() {
+  irq_arch_restore(MACHINE_INTERRUPT_ENABLE);
+}
+
+/******************************************************************************
+ * @brief raise the software interrupt, the host hart is the only target
+ * @param target hart identifier
+ * @return none
+ ******************************************************************************/
+static inline void irq_arch_send_ipi(uint64_t hart_id) {
+  (void)hart_id;
+  csr_set(CSR_MIP, MACHINE_SOFTWARE_INTERRUPT_ENABLE);
+}
+
+/******************************************************************************
+ * @brief acknowledge the software interrupt
+ * @param hart identifier
+ * @return none
+ ******************************************************************************/
+static inline void irq_arch_clear_ipi(uint64_t hart_id) {
+  (void)hart_id;
+  csr_clear(CSR_MIP, MACHINE_SOFTWARE_INTERRUPT_ENABLE);
+}
+
+/******************************************************************************
+ * @brief wait for the next interrupt, the host time goes to the next timer
+ * @param none
+ * @return none
+ ******************************************************************************/
+void host_irq_wait(void);
+
+static inline void irq_arch_wait() {
+  host_irq_wait();
+}
+
+/******************************************************************************
+ * @struct irq_controller_t
+ * @brief external interrupt controller operations, none on the host
+ ******************************************************************************/
+typedef struct irq_controller_t {
+  void (*enable)(uint32_t source, uint8_t prio);
+  void (*disable)(uint32_t source);
+  void (*mask)(uint32_t source);
+  void (*unmask)(uint32_t source);
+  uint32_t (*claim)(void);
+  void (*complete)(uint32_t source);
+  uint32_t (*level)(uint32_t source);
+  void (*set_level)(uint32_t level);
+} irq_controller_t;
+
+void interrupt_set_controller(const irq_controller_t *);
+
+void interrupt_set_top_half(interrupt_id_t, interrupt_top_half_t);
+
+k_return_t interrupt_attach(interrupt_id_t, interrupt_top_half_t, uint8_t);
+
+k_return_t interrupt_watch(interrupt_id_t, struct task_t *, uint64_t);
+
+void interrupt_unwatch(interrupt_id_t, struct task_t *);
+
+bool interrupt_take(interrupt_id_t);
+
+void interrupt_rearm(interrupt_id_t, struct task_t *);
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef PROCESSOR_H
+#define PROCESSOR_H
+
+/******************************************************************************
+ * Host stand-in of arch/include/processor.h: the kernel core runs as a single
+ * hart process, its stacks also hold the frames of the host C library
+ ******************************************************************************/
+#define STACK_SIZE     16384
+#define STACK_MIN_SIZE 4096
+#define PAGE_SIZE  4096
+#define PAGE_SHIFT 12
+
+#define USER_KERNEL_STACK_SIZE 2048
+#define USER_STACK_ALIGN       16
+#define USER_STACK_SIZE (STACK_SIZE + USER_KERNEL_STACK_SIZE)
+#define DWORD_SIZE 8
+#define LWORD_SIZE 16
+
+#define CACHE_LINE_SIZE 64
+
+/******************************************************************************
+ * @struct thread_t
+ * @brief structure used for thread local storage
+ *
+ * sp is the host stack pointer saved by _switch_to, or the host context of
+ * the task when the switch is done with ucontext.
+ ******************************************************************************/
+typedef struct thread_t {
+  uint64_t sp;
+  uint64_t msg_deposited;
+} thread_t;
+
+/******************************************************************************
+ * current task of the host hart, loaded by _switch_to
+ ******************************************************************************/
+extern uint64_t host_thread_pointer;
+
+/******************************************************************************
+ * @brief read the thread pointer, it holds the current task
+ * @param none
+ * @return current task address
+ ******************************************************************************/
+static inline uint64_t thread_pointer_get() {
+  return host_thread_pointer;
+}
+
+/******************************************************************************
+ * @brief read the identifier of the hart running the caller
+ * @param none
+ * @return 0, the host runs a single hart
+ ******************************************************************************/
+static inline uint64_t hart_id_get() {
+  return 0;
+}
+
+/******************************************************************************
+ * @brief read the cycle counter of the host processor
+ * @param none
+ * @return time stamp counter, or mtime ticks if the host has none
+ ******************************************************************************/
+static inline uint64_t cycle_counter_get() {
+#if defined(__x86_64__)
+  return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+  uint64_t cycles;
+
+  __asm__ volatile("mrs %0, cntvct_el0" : "=r"(cycles));
+
+  return cycles;
+#else
+  extern uint64_t host_time_get(void);
+
+  return host_time_get();
+#endif
+}
+
+/******************************************************************************
+ * @brief write the thread pointer
+ * @param new current task address
+ * @return none
+ ******************************************************************************/
+static inline void thread_pointer_set(uint64_t tp) {
+  host_thread_pointer = tp;
+}
+
+#endif
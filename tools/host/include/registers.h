@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef HOST_REGISTERS_H
+#define HOST_REGISTERS_H
+
+/******************************************************************************
+ * The bit layouts are the ones of the target, only the csr accessors are
+ * replaced: the host build keeps the machine interrupt registers of its
+ * single hart in plain variables.
+ ******************************************************************************/
+#include "../../../arch/include/registers.h"
+
+#undef csr_set
+#undef csr_clear
+#undef csr_read_clear
+#undef csr_write
+#undef csr_read
+
+extern unsigned long host_csr_mstatus;
+extern unsigned long host_csr_mie;
+extern unsigned long host_csr_mip;
+extern unsigned long host_csr_mcause;
+
+#define HOST_CSR(csr)  _HOST_CSR(csr)
+#define _HOST_CSR(csr) host_csr_##csr
+
+/******************************************************************************
+ * @brief set bits in the csr variable
+ * @param csr register identifier
+ * @param bits to set in the register
+ * @return none
+ ******************************************************************************/
+#define csr_set(csr, bits) ((void)(HOST_CSR(csr) |= (unsigned long)(bits)))
+
+/******************************************************************************
+ * @brief clear bits in the csr variable
+ * @param csr register identifier
+ * @param bits to clear in the register
+ * @return none
+ ******************************************************************************/
+#define csr_clear(csr, bits) ((void)(HOST_CSR(csr) &= ~(unsigned long)(bits)))
+
+/******************************************************************************
+ * @brief clear bits in the csr variable and return its previous value
+ * @param csr register identifier
+ * @param bits to clear in the register
+ * @return csr value before bits are cleared
+ ******************************************************************************/
+#define csr_read_clear(csr, bits)                \
+  ({                                             \
+    unsigned long __v = HOST_CSR(csr);           \
+    HOST_CSR(csr) &= ~(unsigned long)(bits);     \
+    __v;                                         \
+  })
+
+/******************************************************************************
+ * @brief write a 64bits value to the csr variable
+ * @param csr register identifier
+ * @param value to write to registers
+ * @return None
+ ******************************************************************************/
+#define csr_write(csr, val) ((void)(HOST_CSR(csr) = (unsigned long)(val)))
+
+/******************************************************************************
+ * @brief read a 64bits value from the csr variable
+ * @param csr register identifier
+ * @return value
+ ******************************************************************************/
+#define csr_read(csr) (HOST_CSR(csr))
+
+#endif
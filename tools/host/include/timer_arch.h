@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+#ifndef TIMER_ARCH_H
+#define TIMER_ARCH_H
+
+#include "common.h"
+#include "irq_arch.h"
+
+/******************************************************************************
+ * Host stand-in of arch/include/timer_arch.h: mtime runs at the rate of the
+ * target, from the host monotonic clock or from the virtual clock of the
+ * fuzzer
+ ******************************************************************************/
+#define TIMER_ARCH_RATE         10000000UL
+#define TIMER_ARCH_TICKS_PER_US (TIMER_ARCH_RATE / 1000000UL)
+#define TIMER_ARCH_NS_PER_TICK  (1000000000UL / TIMER_ARCH_RATE)
+
+#define TIMER_ARCH_US_MULT  0xCCCCCCCCCCCCCCCDUL
+#define TIMER_ARCH_US_SHIFT 3
+
+#define TIMER_ARCH_NEVER 0xFFFFFFFFFFFFFFFFUL
+
+/******************************************************************************
+ * comparator of the host hart, the timer interrupt is pending once the time
+ * reaches it
+ ******************************************************************************/
+extern uint64_t host_timer_compare;
+
+uint64_t host_time_get(void);
+
+/******************************************************************************
+ * @brief read the host machine timer counter
+ * @param none
+ * @return mtime ticks
+ ******************************************************************************/
+static inline uint64_t timer_arch_get_time() {
+  return host_time_get();
+}
+
+/******************************************************************************
+ * @brief convert machine timer ticks in microseconds
+ * @param number of ticks
+ * @return duration in us
+ ******************************************************************************/
+static inline uint64_t timer_arch_ticks_to_us(uint64_t ticks) {
+  uint64_t high = (uint64_t)(((unsigned __int128)ticks * TIMER_ARCH_US_MULT) >>
+                             64);
+
+  return high >> TIMER_ARCH_US_SHIFT;
+}
+
+/******************************************************************************
+ * @brief program the comparator of the host hart
+ * @param date of the next timer interrupt in ticks
+ * @return none
+ ******************************************************************************/
+static inline void timer_arch_set_compare(uint64_t date) {
+  host_timer_compare = date;
+  csr_clear(CSR_MIP, MACHINE_TIMER_INTERRUPT_ENABLE);
+}
+
+/******************************************************************************
+ * @brief stop the comparator of the host hart
+ * @param none
+ * @return none
+ ******************************************************************************/
+static inline void timer_arch_stop() {
+  timer_arch_set_compare(TIMER_ARCH_NEVER);
+}
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2023 Qoda, engineering
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms and conditions of the GNU General Public License,
+ * version 3 or later, as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+
+ * You should have received copies of the GNU General Public License and
+ * the GNU Lesser General Public License along with this program.  If
+ * not, see https://www.gnu.org/licenses/
+ */
+
+// the host headers come first, common.h defines the fixed width types as
+// macros
+#ifdef HOST_UCONTEXT
+// the signal stack of the C library takes the name of the kernel stacks
+#define stack_t host_signal_stack_t
+#include <ucontext.h>
+#undef stack_t
+#endif
+
+#include "host.h"
+
+#include "host_offsets.h"
+#include "irq_arch.h"
+#include "processor.h"
+#include "sched.h"
+#include "task.h"
+
+/******************************************************************************
+ * @brief start a new task, reached from its first switch
+ *
+ * It replaces _ret_from_switch and the return from the trap frame of the
+ * target: the kernel lock inherited from the scheduler is released, then the
+ * task runs its entry with interrupts enabled.
+ *
+ * @param function to run in the task context
+ * @return none
+ ******************************************************************************/
+void host_task_start(void (*task_entry)(void)) {
+  sched_task_start();
+
+  irq_arch_enable();
+
+  task_runtime(task_entry);
+}
+
+#ifdef HOST_UCONTEXT
+/******************************************************************************
+ * context of the idle task, the one of a task is at the top of its stack
+ ******************************************************************************/
+static ucontext_t host_idle_context;
+
+/******************************************************************************
+ * @brief split the task entry in the int arguments of makecontext()
+ * @param high half of the task entry address
+ * @param low half of the task entry address
+ * @return none
+ ******************************************************************************/
+static void host_task_trampoline(uint32_t high, uint32_t low) {
+  host_task_start((void (*)(void))(((uint64_t)high << 32) | low));
+}
+
+/******************************************************************************
+ * @brief switch from a previous thread context to the next one
+ *
+ * sp holds the address of the ucontext of the thread. The thread pointer is
+ * loaded with the next task before the switch, as the target does.
+ *
+ * @param thread_t to store
+ * @param thread_t to load
+ * @return none
+ ******************************************************************************/
+void _switch_to(thread_t *prev_thread, thread_t *next_thread) {
+  host_thread_pointer = (uint64_t)next_thread;
+
+  swapcontext((ucontext_t *)prev_thread->sp, (ucontext_t *)next_thread->sp);
+}
+
+/******************************************************************************
+ * @brief give the idle task the storage of its context
+ * @param idle task of the host hart
+ * @return none
+ ******************************************************************************/
+void host_context_init(task_t *idle) {
+  idle->thread.sp = (uint64_t)&host_idle_context;
+}
+
+/******************************************************************************
+ * @brief initialize task stack
+ *
+ * The ucontext of the task is saved at the top of its stack, the task runs on
+ * the rest of it:
+ *
+ * ----------------------- stack_start
+ * ...
+ * task frames
+ * -----------
+ * ucontext  <--- SP
+ * ----------------------- stack_end
+ *
+ * @param task owning the stack
+ * @param function to run in the task context
+ * @return none
+ ******************************************************************************/
+void task_stack_init(task_t *task, void (*task_entry)(void)) {
+  uint64_t    top     = (uint64_t)task->stack + task->stack_size;
+  ucontext_t *context = (ucontext_t *)((top - sizeof(ucontext_t)) &
+                                       ~(uint64_t)(LWORD_SIZE - 1));
+
+  task->thread.sp            = (uint64_t)context;
+  task->thread.msg_deposited = 0;
+
+  getcontext(context);
+  context->uc_stack.ss_sp   = task->stack;
+  context->uc_stack.ss_size = (uint64_t)context - (uint64_t)task->stack;
+  context->uc_link          = NULL;
+
+  makecontext(context, (void (*)(void))host_task_trampoline, 2,
+              (uint32_t)((uint64_t)task_entry >> 32),
+              (uint32_t)(uint64_t)task_entry);
+}
+
+#else
+/******************************************************************************
+ * @brief first return address of a task, in context_<arch>.S
+ ******************************************************************************/
+extern void _ret_from_switch(void);
+
+/******************************************************************************
+ * @brief give the idle task the storage of its context
+ *
+ * _switch_to saves the stack pointer of the idle task in its thread, it needs
+ * no other storage.
+ *
+ * @param idle task of the host hart
+ * @return none
+ ******************************************************************************/
+void host_context_init(task_t *idle) {
+  (void)idle;
+}
+
+/******************************************************************************
+ * @brief initialize task stack
+ *
+ * The first switch to the task pops the callee saved registers and returns to
+ * _ret_from_switch, which calls host_task_start() with the task entry found in
+ * the rbx slot:
+ *
+ * ----------------------- stack_start
+ * ...
+ * r15 <--- SP
+ * r14
+ * r13
+ * r12
+ * rbx: task_entry
+ * rbp
+ * _ret_from_switch
+ * padding
+ * ----------------------- stack_end
+ *
+ * @param task owning the stack
+ * @param function to run in the task context
+ * @return none
+ ******************************************************************************/
+void task_stack_init(task_t *task, void (*task_entry)(void)) {
+  uint64_t *frame;
+
+  // the frame ends 16-bytes aligned at the top of the stack
+  task->thread.sp = ((uint64_t)task->stack + task->stack_size) &
+                    ~(uint64_t)(LWORD_SIZE - 1);
+  task->thread.sp -= HOST_SWITCH_FRAME_WORDS * DWORD_SIZE;
+
+  // no message is waiting for the task
+  task->thread.msg_deposited = 0;
+
+  frame = (uint64_t *)task->thread.sp;
+  for (uint64_t word = 0; word < HOST_SWITCH_FRAME_WORDS; word++) {
+    frame[word] = 0;
+  }
+
+  frame[HOST_SWITCH_FRAME_ENTRY] = (uint64_t)task_entry;
+  frame[HOST_SWITCH_FRAME_RET]   = (uint64_t)_ret_from_switch;
+}
+#endif
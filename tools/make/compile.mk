@@ -18,17 +18,33 @@ BUILD_DIR := build
 CC := riscv64-unknown-elf-gcc
 GLOBAL_CFLAGS := -Wall -march=rv64gc -mabi=lp64 -fpie -ffreestanding
 
+# kernel options selected with Kconfig are visible as CONFIG_* macros
+GLOBAL_CFLAGS += -include tools/generated/autoconf.h
+
 ifeq ($(config_build_debug),y)
 	MODULE_CFLAGS += -Og -ggdb
 else 
 	MODULE_CFLAGS += -O1
 endif
 
+# the profiler walks the stacks with the frame pointers
+ifeq ($(config_profile),y)
+	MODULE_CFLAGS += -fno-omit-frame-pointer
+endif
+
 # manage dependencies
 MODULE_DEPS_INCS := $(addsuffix /include,$(addprefix -I, $(MODULE_DEPS)))
 MODULE_INCS := $(MODULE_DEPS_INCS)
 MODULE_INCS += -I$(MODULE_ID)/include
 
+# generate the stubs of the interfaces described in the module, see
+# doc/api/idl.md, each <name>.idl declares the interface <name>
+MODULE_IDLS := $(wildcard $(MODULE_ID)/*.idl)
+MODULE_IDLDIR := $(BUILD_DIR)/$(MODULE_ID)/idl
+MODULE_IDLSRCS := $(patsubst $(MODULE_ID)/%.idl,$(MODULE_IDLDIR)/%_idl.c,$(MODULE_IDLS))
+MODULE_IDLHDRS := $(MODULE_IDLSRCS:.c=.h)
+MODULE_INCS += -I$(MODULE_IDLDIR)
+
 # add sources for the current module
 MODULE_CSRCS := $(wildcard $(MODULE_ID)/*.c)
 MODULE_ASMSRCS := $(wildcard $(MODULE_ID)/*.S)
@@ -41,11 +57,13 @@ MODULE_ASMOBJS := $(MODULE_ASMSRCS:.S=.o)
 
 MODULE_CTARGETS := $(addprefix $(BUILD_DIR)/, $(MODULE_COBJS))
 MODULE_ASMTARGETS := $(addprefix $(BUILD_DIR)/, $(MODULE_ASMOBJS))
+MODULE_IDLTARGETS := $(MODULE_IDLSRCS:.c=.o)
 
 # update global module list
 MODULE_TARGET_LIST += $(MODULE_ID)
 GLOBAL_OBJECTS_LIST += $(MODULE_CTARGETS)
 GLOBAL_OBJECTS_LIST += $(MODULE_ASMTARGETS)
+GLOBAL_OBJECTS_LIST += $(MODULE_IDLTARGETS)
 
 # use target specific variables to set module specific variables
 $(MODULE_ID): MODULE_CINCS := $(MODULE_CINCS)
@@ -65,7 +83,19 @@ $(BUILD_DIR)/$(MODULE_ID)/%.o: $(MODULE_ID)/%.S
 	$(info compiling $<)
 	@$(CC) $(GLOBAL_CFLAGS) $(MODULE_CFLAGS) $(MODULE_ASMINCS) -c $< -o $@
 
-$(MODULE_ID): $(MODULE_CTARGETS) $(MODULE_ASMTARGETS)
+$(MODULE_IDLDIR)/%_idl.c $(MODULE_IDLDIR)/%_idl.h: $(MODULE_ID)/%.idl
+	@$(MKDIR)
+	$(info generating stubs of $<)
+	@python3 tools/cli/src/idl.py $< --output $(@D)
+
+$(MODULE_IDLDIR)/%.o: $(MODULE_IDLDIR)/%.c
+	$(info compiling $<)
+	@$(CC) $(GLOBAL_CFLAGS) $(MODULE_CFLAGS) $(MODULE_CINCS) -c $< -o $@
+
+# module sources include the generated headers
+$(MODULE_CTARGETS): $(MODULE_IDLHDRS)
+
+$(MODULE_ID): $(MODULE_CTARGETS) $(MODULE_ASMTARGETS) $(MODULE_IDLTARGETS)
 
 # reset variables set here
 MODULE_DEPS :=
@@ -79,4 +109,9 @@ MODULE_COBJS :=
 MODULE_ASMOBJS :=
 MODULE_CFLAGS := 
 MODULE_CTARGETS :=
-MODULE_ASMTARGETS :=
\ No newline at end of file
+MODULE_ASMTARGETS :=
+MODULE_IDLS :=
+MODULE_IDLDIR :=
+MODULE_IDLSRCS :=
+MODULE_IDLHDRS :=
+MODULE_IDLTARGETS :=
\ No newline at end of file
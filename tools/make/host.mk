@@ -0,0 +1,110 @@
+# Copyright (c) 2023 Qoda, engineering
+
+# This program is free software; you can redistribute it and/or modify 
+# it under the terms and conditions of the GNU General Public License,
+# version 3 or later, as published by the Free Software Foundation.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+
+# You should have received copies of the GNU General Public License and
+# the GNU Lesser General Public License along with this program.  If
+# not, see https://www.gnu.org/licenses/
+
+
+# host build of the scheduler and channel core, see doc/arch/adr-036.md
+#
+# the portable kernel sources are compiled for the development machine
+# against the shim of tools/host, to run microbenchmarks and fuzzing in
+# seconds without QEMU:
+#   make -f tools/make/host.mk bench
+#   make -f tools/make/host.mk fuzz HOST_FUZZ_RUNS=10000
+
+include tools/make/macros.mk
+
+HOST_CC ?= gcc
+HOST_BUILD_DIR := build/host
+HOST_ARCH := $(shell uname -m)
+
+# the switch is hand-written where a stub exists, ucontext elsewhere;
+# swapcontext() makes a system call, its numbers are not comparable
+ifneq ($(wildcard tools/host/context_$(HOST_ARCH).S),)
+	HOST_SWITCH ?= native
+else
+	HOST_SWITCH ?= ucontext
+endif
+
+HOST_FUZZ_RUNS ?= 1000
+HOST_FUZZ_SEED ?= 1
+
+# the configuration of the host hart replaces tools/generated/autoconf.h,
+# the headers of tools/host/include take the place of the arch ones
+HOST_CFLAGS := -Wall -O2 -g -fno-strict-aliasing
+HOST_CFLAGS += -include tools/host/include/host_autoconf.h
+HOST_CFLAGS += -iquote tools/host/include
+HOST_CFLAGS += -iquote kernel/include
+HOST_CFLAGS += -iquote lib/sys/include
+HOST_CFLAGS += -iquote lib/libc/include
+HOST_CFLAGS += -iquote arch/include
+HOST_CFLAGS += -iquote tests/bench/include
+
+# e.g. HOST_SANITIZE=undefined for the fuzzing runs
+ifneq ($(HOST_SANITIZE),)
+	HOST_CFLAGS += -fsanitize=$(HOST_SANITIZE)
+	HOST_LDFLAGS += -fsanitize=$(HOST_SANITIZE)
+endif
+
+# portable kernel core
+HOST_CSRCS := kernel/buddy.c kernel/channel.c kernel/inherit.c
+HOST_CSRCS += kernel/kmutex.c kernel/ktimer.c kernel/notify.c
+HOST_CSRCS += kernel/sched.c kernel/slab.c kernel/smp.c kernel/task.c
+HOST_CSRCS += kernel/wait_any.c
+
+# shim of the arch layer
+HOST_CSRCS += tools/host/host.c tools/host/task_host.c
+HOST_CSRCS += tools/host/channel_host.c
+
+ifeq ($(HOST_SWITCH),ucontext)
+	HOST_CFLAGS += -DHOST_UCONTEXT
+else
+	HOST_ASMSRCS := tools/host/context_$(HOST_ARCH).S
+endif
+
+HOST_OBJECTS := $(addprefix $(HOST_BUILD_DIR)/$(HOST_SWITCH)/, \
+	$(HOST_CSRCS:.c=.o) $(HOST_ASMSRCS:.S=.o))
+
+HOST_BENCH := $(HOST_BUILD_DIR)/$(HOST_SWITCH)/bench
+HOST_FUZZ := $(HOST_BUILD_DIR)/$(HOST_SWITCH)/fuzz
+
+.PHONY: host bench fuzz clean
+
+host: $(HOST_BENCH) $(HOST_FUZZ)
+
+bench: $(HOST_BENCH)
+	@$(HOST_BENCH)
+
+fuzz: $(HOST_FUZZ)
+	@$(HOST_FUZZ) --seed $(HOST_FUZZ_SEED) --runs $(HOST_FUZZ_RUNS)
+
+$(HOST_BUILD_DIR)/$(HOST_SWITCH)/%.o: %.c
+	@$(MKDIR)
+	$(info compiling $<)
+	@$(HOST_CC) $(HOST_CFLAGS) -c $< -o $@
+
+$(HOST_BUILD_DIR)/$(HOST_SWITCH)/%.o: %.S
+	@$(MKDIR)
+	$(info compiling $<)
+	@$(HOST_CC) $(HOST_CFLAGS) -c $< -o $@
+
+$(HOST_BENCH): $(HOST_OBJECTS) $(HOST_BUILD_DIR)/$(HOST_SWITCH)/tools/host/bench.o
+	$(info linking $@)
+	@$(HOST_CC) $(HOST_LDFLAGS) $^ -o $@
+
+$(HOST_FUZZ): $(HOST_OBJECTS) $(HOST_BUILD_DIR)/$(HOST_SWITCH)/tools/host/fuzz.o
+	$(info linking $@)
+	@$(HOST_CC) $(HOST_LDFLAGS) $^ -o $@
+
+clean:
+	@rm -rf $(HOST_BUILD_DIR)